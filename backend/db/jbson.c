@@ -111,6 +111,36 @@ _error:
 	return FALSE;
 }
 
+/**
+ * Checks whether the current key is reserved.
+ * Reserved keys start with an underscore and carry selector options such as the mode or the returned fields.
+ **/
+G_GNUC_UNUSED
+static gboolean
+j_bson_iter_key_reserved(bson_iter_t* iter, gboolean* reserved, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (G_UNLIKELY(!iter))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_NULL, "bson iter must not be NULL");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!reserved))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_EQUALS_NULL, "reserved must not be NULL");
+		goto _error;
+	}
+
+	*reserved = (bson_iter_key(iter)[0] == '_');
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 G_GNUC_UNUSED
 static const char*
 j_bson_iter_key(bson_iter_t* iter, GError** error)
@@ -560,6 +590,184 @@ _error:
 	return FALSE;
 }
 
+/**
+ * Checks whether a selector contains at least one condition, i.e., a key that is not reserved.
+ **/
+G_GNUC_UNUSED
+static gboolean
+j_bson_selector_has_conditions(const bson_t* bson)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+
+	if (bson == NULL || !bson_iter_init(&iter, bson))
+	{
+		return FALSE;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		if (bson_iter_key(&iter)[0] != '_')
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Checks whether a selector can be used to update or delete entries.
+ * Only the mode may be given as an option, since limits, orders, joins and field lists cannot be honoured by these operations.
+ * Updates additionally require at least one condition to avoid modifying all entries by accident.
+ **/
+G_GNUC_UNUSED
+static gboolean
+j_bson_selector_check_modify(const bson_t* bson, gboolean require_conditions, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+
+	if (bson != NULL && bson_iter_init(&iter, bson))
+	{
+		while (bson_iter_next(&iter))
+		{
+			gchar const* key = bson_iter_key(&iter);
+
+			if (key[0] == '_' && g_strcmp0(key, "_mode") != 0)
+			{
+				g_set_error(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "selector option %s is not supported for updates and deletes", key);
+				return FALSE;
+			}
+		}
+	}
+
+	if (require_conditions && !j_bson_selector_has_conditions(bson))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "selector must contain at least one condition");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * A join of a query, see j_db_selector_add_join.
+ **/
+struct JBsonJoin
+{
+	gchar const* schema;
+	gchar const* name;
+	gchar const* join_name;
+
+	/// The joined selector, only valid if has_selector is TRUE
+	bson_t selector;
+	gboolean has_selector;
+
+	/// The joined fields, only valid if has_fields is TRUE
+	bson_iter_t fields;
+	gboolean has_fields;
+};
+
+typedef struct JBsonJoin JBsonJoin;
+
+/**
+ * Parses a join of a query, iter has to point to one of the documents contained in the _join document.
+ * The join's strings and selector point into the query and are valid as long as the query is.
+ **/
+G_GNUC_UNUSED
+static gboolean
+j_bson_selector_join(bson_iter_t* iter, JBsonJoin* join, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter_join;
+	JDBTypeValue value;
+	gboolean has_next;
+	gchar const* key;
+
+	join->schema = NULL;
+	join->name = NULL;
+	join->join_name = NULL;
+	join->has_selector = FALSE;
+	join->has_fields = FALSE;
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iter_join, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_join, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!(key = j_bson_iter_key(&iter_join, error))))
+		{
+			goto _error;
+		}
+
+		if (g_strcmp0(key, "_selector") == 0)
+		{
+			if (G_UNLIKELY(!j_bson_iter_copy_document(&iter_join, &join->selector, error)))
+			{
+				goto _error;
+			}
+
+			join->has_selector = TRUE;
+		}
+		else if (g_strcmp0(key, "_fields") == 0)
+		{
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_join, &join->fields, error)))
+			{
+				goto _error;
+			}
+
+			join->has_fields = TRUE;
+		}
+		else
+		{
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_join, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (g_strcmp0(key, "_schema") == 0)
+			{
+				join->schema = value.val_string;
+			}
+			else if (g_strcmp0(key, "_name") == 0)
+			{
+				join->name = value.val_string;
+			}
+			else if (g_strcmp0(key, "_join_name") == 0)
+			{
+				join->join_name = value.val_string;
+			}
+		}
+	}
+
+	if (G_UNLIKELY(join->schema == NULL || join->name == NULL || join->join_name == NULL))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "join incomplete");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 G_GNUC_UNUSED
 static void
 j_bson_destroy(bson_t* bson)
@@ -22,30 +22,2335 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <julea.h>
+#include <julea-db.h>
+
+#include "jbson.c"
+
+/*
+ * Tables store their rows column by column, each column being a packed array of native values.
+ * Deleted rows are marked with an id of 0 and compacted once they make up most of a table.
+ * Indexes only cover the first field of each index declared in the schema:
+ * String fields use a hash index, numeric fields use an ordered index that also answers range conditions.
+ * Batches keep an undo log, a failed operation rolls back all previous operations of its batch.
+ */
+
+enum JMemoryIndexType
+{
+	J_MEMORY_INDEX_NONE,
+	J_MEMORY_INDEX_HASH,
+	J_MEMORY_INDEX_ORDERED
+};
+
+typedef enum JMemoryIndexType JMemoryIndexType;
+
+struct JMemoryBlob
+{
+	gchar* data;
+	guint32 length;
+};
+
+typedef struct JMemoryBlob JMemoryBlob;
+
+struct JMemoryColumn
+{
+	gchar* name;
+	JDBType type;
+
+	/// Values of all rows, see memory_type_size()
+	GArray* values;
+	/// Whether a row's value has been set (guint8)
+	GArray* set;
+
+	JMemoryIndexType index_type;
+	/// Maps string values to the rows containing them (GArray of guint)
+	GHashTable* index_hash;
+	/// Rows sorted by their values, stored as row + 1
+	GSequence* index_ordered;
+};
+
+typedef struct JMemoryColumn JMemoryColumn;
+
+struct JMemoryTable
+{
+	gint ref_count;
+	GMutex lock;
+
+	/// The fields and their types as returned by schema_get
+	bson_t* schema;
+
+	GPtrArray* columns;
+	GHashTable* columns_by_name;
+
+	/// Ids of all rows, 0 for deleted rows
+	GArray* ids;
+	/// Maps ids to rows, stored as row + 1
+	GHashTable* rows_by_id;
+	guint rows_live;
+	guint32 next_id;
+};
+
+typedef struct JMemoryTable JMemoryTable;
+
+struct JMemoryData
+{
+	/// Maps namespaces to hash tables mapping names to tables
+	GHashTable* namespaces;
+	GRWLock lock;
+};
+
+typedef struct JMemoryData JMemoryData;
+
+struct JMemoryBatch
+{
+	gchar* namespace;
+
+	/// Undo log of all operations applied so far (JMemoryUndo)
+	GPtrArray* undo;
+};
+
+typedef struct JMemoryBatch JMemoryBatch;
+
+enum JMemoryUndoType
+{
+	J_MEMORY_UNDO_SCHEMA_CREATE,
+	J_MEMORY_UNDO_SCHEMA_DELETE,
+	J_MEMORY_UNDO_INSERT,
+	J_MEMORY_UNDO_UPDATE,
+	J_MEMORY_UNDO_DELETE
+};
+
+typedef enum JMemoryUndoType JMemoryUndoType;
+
+/**
+ * Reverts a single change, rows are referred to by their ids since compacting moves them.
+ **/
+struct JMemoryUndo
+{
+	JMemoryUndoType type;
+	JMemoryTable* table;
+
+	/// The schema's name for schema operations
+	gchar* name;
+
+	guint32 id;
+	/// The row's previous values for updates and deletes
+	bson_t* row;
+};
+
+typedef struct JMemoryUndo JMemoryUndo;
+
+/**
+ * A parsed selector, either a group of nested predicates or a single condition.
+ **/
+struct JMemoryPredicate
+{
+	JDBSelectorMode mode;
+	/// Nested predicates, NULL for conditions
+	GPtrArray* children;
+
+	/// The compared column, NULL compares the id
+	JMemoryColumn* column;
+	JDBSelectorOperator operator_;
+	JDBTypeValue value;
+};
+
+typedef struct JMemoryPredicate JMemoryPredicate;
+
+struct JMemorySearch
+{
+	JMemoryColumn const* column;
+	/// The value searched for, represented by NULL
+	JDBTypeValue const* value;
+	/// Whether the searched value sorts before (-1) or after (1) equal values
+	gint bias;
+};
+
+typedef struct JMemorySearch JMemorySearch;
+
+struct JMemorySort
+{
+	JMemoryColumn const* column;
+	gboolean descending;
+};
+
+typedef struct JMemorySort JMemorySort;
+
+/**
+ * A joined table's matching rows, hashed by the values they are joined on.
+ * The hash table is built before the joining table is locked, so that at most one table is locked at a time.
+ **/
+struct JMemoryJoin
+{
+	/// The joining table's field, "_id" joins on the id
+	gchar* name;
+
+	/// Maps join keys to the joined rows' fields (GPtrArray of bson_t)
+	GHashTable* rows;
+};
+
+typedef struct JMemoryJoin JMemoryJoin;
+
+struct JMemoryIterator
+{
+	JMemoryTable* table;
+
+	/// Ids of the matching rows, rows are looked up again since compaction may move them
+	GArray* ids;
+	guint position;
+
+	/// Fields requested by the selector, NULL returns all fields
+	GHashTable* fields;
+
+	/// Aggregated results, NULL if the query does not aggregate
+	GPtrArray* results;
+};
+
+typedef struct JMemoryIterator JMemoryIterator;
+
+struct JMemoryAggregate
+{
+	JDBAggregateFunction function;
+	gchar const* name;
+	JDBType type;
+	JDBType result_type;
+};
+
+typedef struct JMemoryAggregate JMemoryAggregate;
+
+struct JMemoryGroup
+{
+	// The values of the group_by fields
+	bson_t* key;
+
+	JDBTypeValue* values;
+	gboolean* valid;
+	// Copies of string values since the rows may go away
+	gchar** strings;
+};
+
+typedef struct JMemoryGroup JMemoryGroup;
+
+/**
+ * Computes aggregates natively, the selector's aggregates and group_by fields are borrowed from the query.
+ **/
+struct JMemoryAggregation
+{
+	GArray* aggregates;
+	GPtrArray* group_by;
+
+	// Maps the serialized group_by values to a JMemoryGroup
+	GHashTable* groups;
+	// Groups in order of appearance
+	GPtrArray* order;
+};
+
+typedef struct JMemoryAggregation JMemoryAggregation;
+
+static void
+memory_aggregation_init(JMemoryAggregation* aggregation, bson_t const* selector)
+{
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	bson_iter_t iter_aggregate;
+
+	aggregation->aggregates = g_array_new(FALSE, FALSE, sizeof(JMemoryAggregate));
+	aggregation->group_by = g_ptr_array_new();
+	aggregation->groups = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+	aggregation->order = g_ptr_array_new();
+
+	if (bson_iter_init_find(&iter, selector, "_group_by") && bson_iter_recurse(&iter, &iter_child))
+	{
+		while (bson_iter_next(&iter_child))
+		{
+			if (BSON_ITER_HOLDS_UTF8(&iter_child))
+			{
+				g_ptr_array_add(aggregation->group_by, (gpointer)bson_iter_utf8(&iter_child, NULL));
+			}
+		}
+	}
+
+	if (bson_iter_init_find(&iter, selector, "_aggregate") && bson_iter_recurse(&iter, &iter_child))
+	{
+		while (bson_iter_next(&iter_child))
+		{
+			JMemoryAggregate aggregate = { J_DB_AGGREGATE_COUNT, NULL, J_DB_TYPE_ID, J_DB_TYPE_UINT64 };
+
+			if (!bson_iter_recurse(&iter_child, &iter_aggregate))
+			{
+				continue;
+			}
+
+			while (bson_iter_next(&iter_aggregate))
+			{
+				gchar const* key = bson_iter_key(&iter_aggregate);
+
+				if (g_strcmp0(key, "_function") == 0)
+				{
+					aggregate.function = bson_iter_int32(&iter_aggregate);
+				}
+				else if (g_strcmp0(key, "_name") == 0)
+				{
+					aggregate.name = bson_iter_utf8(&iter_aggregate, NULL);
+				}
+				else if (g_strcmp0(key, "_type") == 0)
+				{
+					aggregate.type = bson_iter_int32(&iter_aggregate);
+				}
+				else if (g_strcmp0(key, "_result_type") == 0)
+				{
+					aggregate.result_type = bson_iter_int32(&iter_aggregate);
+				}
+			}
+
+			g_array_append_val(aggregation->aggregates, aggregate);
+		}
+	}
+}
+
+static JMemoryGroup*
+memory_aggregation_get_group(JMemoryAggregation* aggregation, bson_t const* row)
+{
+	JMemoryGroup* group;
+	GBytes* bytes;
+	bson_t key;
+	bson_iter_t iter;
+
+	bson_init(&key);
+
+	for (guint i = 0; i < aggregation->group_by->len; i++)
+	{
+		if (row != NULL && bson_iter_init_find(&iter, row, g_ptr_array_index(aggregation->group_by, i)))
+		{
+			bson_append_iter(&key, NULL, 0, &iter);
+		}
+	}
+
+	bytes = g_bytes_new(bson_get_data(&key), key.len);
+
+	if ((group = g_hash_table_lookup(aggregation->groups, bytes)) == NULL)
+	{
+		group = g_slice_new(JMemoryGroup);
+		group->key = bson_copy(&key);
+		group->values = g_new0(JDBTypeValue, aggregation->aggregates->len);
+		group->valid = g_new0(gboolean, aggregation->aggregates->len);
+		group->strings = g_new0(gchar*, aggregation->aggregates->len);
+
+		for (guint i = 0; i < aggregation->aggregates->len; i++)
+		{
+			JMemoryAggregate* aggregate = &g_array_index(aggregation->aggregates, JMemoryAggregate, i);
+
+			// COUNT and SUM return 0 for empty groups, MIN and MAX return nothing
+			group->valid[i] = (aggregate->function == J_DB_AGGREGATE_COUNT || aggregate->function == J_DB_AGGREGATE_SUM);
+		}
+
+		g_hash_table_insert(aggregation->groups, g_bytes_ref(bytes), group);
+		g_ptr_array_add(aggregation->order, group);
+	}
+
+	g_bytes_unref(bytes);
+	bson_destroy(&key);
+
+	return group;
+}
+
+static gint
+memory_value_compare(JDBType type, JDBTypeValue const* a, JDBTypeValue const* b)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			return (a->val_sint32 > b->val_sint32) - (a->val_sint32 < b->val_sint32);
+		case J_DB_TYPE_UINT32:
+			return (a->val_uint32 > b->val_uint32) - (a->val_uint32 < b->val_uint32);
+		case J_DB_TYPE_FLOAT32:
+			return (a->val_float32 > b->val_float32) - (a->val_float32 < b->val_float32);
+		case J_DB_TYPE_SINT64:
+			return (a->val_sint64 > b->val_sint64) - (a->val_sint64 < b->val_sint64);
+		case J_DB_TYPE_UINT64:
+			return (a->val_uint64 > b->val_uint64) - (a->val_uint64 < b->val_uint64);
+		case J_DB_TYPE_FLOAT64:
+			return (a->val_float64 > b->val_float64) - (a->val_float64 < b->val_float64);
+		case J_DB_TYPE_STRING:
+			return g_strcmp0(a->val_string, b->val_string);
+		case J_DB_TYPE_BLOB:
+		{
+			guint32 length = MIN(a->val_blob_length, b->val_blob_length);
+			gint cmp = (length > 0) ? memcmp(a->val_blob, b->val_blob, length) : 0;
+
+			return (cmp != 0) ? cmp : (a->val_blob_length > b->val_blob_length) - (a->val_blob_length < b->val_blob_length);
+		}
+		case J_DB_TYPE_ID:
+		default:
+			return 0;
+	}
+}
+
+static void
+memory_aggregate_update(JMemoryAggregate const* aggregate, JDBTypeValue* result, gboolean* valid, gchar** string, bson_t const* row)
+{
+	bson_iter_t iter;
+	JDBTypeValue value;
+	gint cmp;
+
+	if (aggregate->name == NULL)
+	{
+		// COUNT(*)
+		result->val_uint64++;
+		return;
+	}
+
+	if (!bson_iter_init_find(&iter, row, aggregate->name) || BSON_ITER_HOLDS_NULL(&iter) || !j_bson_iter_value(&iter, aggregate->type, &value, NULL))
+	{
+		return;
+	}
+
+	switch (aggregate->function)
+	{
+		case J_DB_AGGREGATE_COUNT:
+			result->val_uint64++;
+			break;
+		case J_DB_AGGREGATE_SUM:
+			switch (aggregate->type)
+			{
+				case J_DB_TYPE_SINT32:
+					result->val_sint64 += value.val_sint32;
+					break;
+				case J_DB_TYPE_SINT64:
+					result->val_sint64 += value.val_sint64;
+					break;
+				case J_DB_TYPE_UINT32:
+					result->val_uint64 += value.val_uint32;
+					break;
+				case J_DB_TYPE_UINT64:
+					result->val_uint64 += value.val_uint64;
+					break;
+				case J_DB_TYPE_FLOAT32:
+					result->val_float64 += value.val_float32;
+					break;
+				case J_DB_TYPE_FLOAT64:
+					result->val_float64 += value.val_float64;
+					break;
+				case J_DB_TYPE_STRING:
+				case J_DB_TYPE_BLOB:
+				case J_DB_TYPE_ID:
+				default:
+					break;
+			}
+			break;
+		case J_DB_AGGREGATE_MIN:
+		case J_DB_AGGREGATE_MAX:
+			if (*valid)
+			{
+				cmp = memory_value_compare(aggregate->type, &value, result);
+
+				if ((aggregate->function == J_DB_AGGREGATE_MIN && cmp >= 0) || (aggregate->function == J_DB_AGGREGATE_MAX && cmp <= 0))
+				{
+					break;
+				}
+			}
+
+			if (aggregate->type == J_DB_TYPE_STRING)
+			{
+				g_free(*string);
+				*string = g_strdup(value.val_string);
+				value.val_string = *string;
+			}
+
+			*result = value;
+			*valid = TRUE;
+			break;
+		default:
+			break;
+	}
+}
+
+static void
+memory_aggregation_add(JMemoryAggregation* aggregation, bson_t const* row)
+{
+	JMemoryGroup* group;
+
+	group = memory_aggregation_get_group(aggregation, row);
+
+	for (guint i = 0; i < aggregation->aggregates->len; i++)
+	{
+		memory_aggregate_update(&g_array_index(aggregation->aggregates, JMemoryAggregate, i), &group->values[i], &group->valid[i], &group->strings[i], row);
+	}
+}
+
+/**
+ * Returns one result per group and frees the aggregation.
+ **/
+static GPtrArray*
+memory_aggregation_finish(JMemoryAggregation* aggregation)
+{
+	GPtrArray* results;
+
+	results = g_ptr_array_new_full(aggregation->order->len, (GDestroyNotify)bson_destroy);
+
+	// Aggregating nothing without grouping still returns a single result
+	if (aggregation->order->len == 0 && aggregation->group_by->len == 0)
+	{
+		memory_aggregation_get_group(aggregation, NULL);
+	}
+
+	for (guint i = 0; i < aggregation->order->len; i++)
+	{
+		JMemoryGroup* group = g_ptr_array_index(aggregation->order, i);
+		bson_t* result;
+
+		result = bson_copy(group->key);
+
+		for (guint j = 0; j < aggregation->aggregates->len; j++)
+		{
+			JMemoryAggregate* aggregate = &g_array_index(aggregation->aggregates, JMemoryAggregate, j);
+			char key[32];
+
+			if (group->valid[j])
+			{
+				snprintf(key, sizeof(key), "_aggregate_%u", j);
+				j_bson_append_value(result, key, aggregate->result_type, &group->values[j], NULL);
+			}
+
+			g_free(group->strings[j]);
+		}
+
+		g_ptr_array_add(results, result);
+
+		bson_destroy(group->key);
+		g_free(group->values);
+		g_free(group->valid);
+		g_free(group->strings);
+		g_slice_free(JMemoryGroup, group);
+	}
+
+	g_hash_table_unref(aggregation->groups);
+	g_ptr_array_unref(aggregation->order);
+	g_ptr_array_unref(aggregation->group_by);
+	g_array_unref(aggregation->aggregates);
+
+	return results;
+}
+
+static GHashTable*
+memory_selector_get_fields(bson_t const* selector)
+{
+	bson_iter_t iter;
+	bson_iter_t iter_fields;
+	GHashTable* fields;
+
+	if (selector == NULL || !bson_iter_init_find(&iter, selector, "_fields") || !bson_iter_recurse(&iter, &iter_fields))
+	{
+		return NULL;
+	}
+
+	fields = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	g_hash_table_add(fields, g_strdup("_id"));
+
+	while (bson_iter_next(&iter_fields))
+	{
+		if (BSON_ITER_HOLDS_UTF8(&iter_fields))
+		{
+			g_hash_table_add(fields, g_strdup(bson_iter_utf8(&iter_fields, NULL)));
+		}
+	}
+
+	return fields;
+}
+
+static gsize
+memory_type_size(JDBType type)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_UINT32:
+			return sizeof(guint32);
+		case J_DB_TYPE_FLOAT32:
+			return sizeof(gfloat);
+		case J_DB_TYPE_SINT64:
+		case J_DB_TYPE_UINT64:
+			return sizeof(guint64);
+		case J_DB_TYPE_FLOAT64:
+			return sizeof(gdouble);
+		case J_DB_TYPE_STRING:
+			return sizeof(gchar*);
+		case J_DB_TYPE_BLOB:
+			return sizeof(JMemoryBlob);
+		case J_DB_TYPE_ID:
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Returns FALSE and a zeroed value if the row's value has not been set.
+ **/
+static gboolean
+memory_column_get(JMemoryColumn const* column, guint row, JDBTypeValue* value)
+{
+	memset(value, 0, sizeof(*value));
+
+	if (!g_array_index(column->set, guint8, row))
+	{
+		return FALSE;
+	}
+
+	switch (column->type)
+	{
+		case J_DB_TYPE_SINT32:
+			value->val_sint32 = g_array_index(column->values, gint32, row);
+			break;
+		case J_DB_TYPE_UINT32:
+			value->val_uint32 = g_array_index(column->values, guint32, row);
+			break;
+		case J_DB_TYPE_FLOAT32:
+			value->val_float32 = g_array_index(column->values, gfloat, row);
+			break;
+		case J_DB_TYPE_SINT64:
+			value->val_sint64 = g_array_index(column->values, gint64, row);
+			break;
+		case J_DB_TYPE_UINT64:
+			value->val_uint64 = g_array_index(column->values, guint64, row);
+			break;
+		case J_DB_TYPE_FLOAT64:
+			value->val_float64 = g_array_index(column->values, gdouble, row);
+			break;
+		case J_DB_TYPE_STRING:
+			value->val_string = g_array_index(column->values, gchar*, row);
+			break;
+		case J_DB_TYPE_BLOB:
+			value->val_blob = g_array_index(column->values, JMemoryBlob, row).data;
+			value->val_blob_length = g_array_index(column->values, JMemoryBlob, row).length;
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			break;
+	}
+
+	return TRUE;
+}
+
+static void
+memory_column_clear(JMemoryColumn* column, guint row)
+{
+	gsize size;
+
+	if (!g_array_index(column->set, guint8, row))
+	{
+		return;
+	}
+
+	if (column->type == J_DB_TYPE_STRING)
+	{
+		g_free(g_array_index(column->values, gchar*, row));
+	}
+	else if (column->type == J_DB_TYPE_BLOB)
+	{
+		g_free(g_array_index(column->values, JMemoryBlob, row).data);
+	}
+
+	size = memory_type_size(column->type);
+	memset(column->values->data + (row * size), 0, size);
+	g_array_index(column->set, guint8, row) = FALSE;
+}
+
+static void
+memory_column_set(JMemoryColumn* column, guint row, JDBTypeValue const* value)
+{
+	memory_column_clear(column, row);
+
+	switch (column->type)
+	{
+		case J_DB_TYPE_SINT32:
+			g_array_index(column->values, gint32, row) = value->val_sint32;
+			break;
+		case J_DB_TYPE_UINT32:
+			g_array_index(column->values, guint32, row) = value->val_uint32;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			g_array_index(column->values, gfloat, row) = value->val_float32;
+			break;
+		case J_DB_TYPE_SINT64:
+			g_array_index(column->values, gint64, row) = value->val_sint64;
+			break;
+		case J_DB_TYPE_UINT64:
+			g_array_index(column->values, guint64, row) = value->val_uint64;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			g_array_index(column->values, gdouble, row) = value->val_float64;
+			break;
+		case J_DB_TYPE_STRING:
+			g_array_index(column->values, gchar*, row) = g_strdup(value->val_string);
+			break;
+		case J_DB_TYPE_BLOB:
+			if (value->val_blob != NULL)
+			{
+				JMemoryBlob* blob = &g_array_index(column->values, JMemoryBlob, row);
+
+				blob->data = g_malloc(value->val_blob_length);
+				blob->length = value->val_blob_length;
+				memcpy(blob->data, value->val_blob, value->val_blob_length);
+			}
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			break;
+	}
+
+	g_array_index(column->set, guint8, row) = TRUE;
+}
+
+static gint
+memory_index_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JMemorySearch const* search = data;
+	JDBTypeValue value_a;
+	JDBTypeValue value_b;
+	guint row_a = GPOINTER_TO_UINT(a);
+	guint row_b = GPOINTER_TO_UINT(b);
+	gint cmp;
+
+	if (a == NULL)
+	{
+		value_a = *search->value;
+	}
+	else
+	{
+		memory_column_get(search->column, row_a - 1, &value_a);
+	}
+
+	if (b == NULL)
+	{
+		value_b = *search->value;
+	}
+	else
+	{
+		memory_column_get(search->column, row_b - 1, &value_b);
+	}
+
+	cmp = memory_value_compare(search->column->type, &value_a, &value_b);
+
+	if (cmp != 0)
+	{
+		return cmp;
+	}
+
+	// Equal values are ordered by row, the searched value goes before or after all of them
+	if (a == NULL)
+	{
+		return search->bias;
+	}
+
+	if (b == NULL)
+	{
+		return -search->bias;
+	}
+
+	return (row_a > row_b) - (row_a < row_b);
+}
+
+static void
+memory_index_insert(JMemoryColumn* column, guint row)
+{
+	JDBTypeValue value;
+
+	if (column->index_type == J_MEMORY_INDEX_NONE || !memory_column_get(column, row, &value))
+	{
+		return;
+	}
+
+	if (column->index_type == J_MEMORY_INDEX_HASH)
+	{
+		GArray* rows;
+
+		if ((rows = g_hash_table_lookup(column->index_hash, value.val_string)) == NULL)
+		{
+			rows = g_array_new(FALSE, FALSE, sizeof(guint));
+			g_hash_table_insert(column->index_hash, g_strdup(value.val_string), rows);
+		}
+
+		g_array_append_val(rows, row);
+	}
+	else
+	{
+		JMemorySearch search = { column, NULL, 0 };
+
+		g_sequence_insert_sorted(column->index_ordered, GUINT_TO_POINTER(row + 1), memory_index_compare, &search);
+	}
+}
+
+/**
+ * Has to be called before the row's value changes.
+ **/
+static void
+memory_index_remove(JMemoryColumn* column, guint row)
+{
+	JDBTypeValue value;
+
+	if (column->index_type == J_MEMORY_INDEX_NONE || !memory_column_get(column, row, &value))
+	{
+		return;
+	}
+
+	if (column->index_type == J_MEMORY_INDEX_HASH)
+	{
+		GArray* rows;
+
+		if ((rows = g_hash_table_lookup(column->index_hash, value.val_string)) == NULL)
+		{
+			return;
+		}
+
+		for (guint i = 0; i < rows->len; i++)
+		{
+			if (g_array_index(rows, guint, i) == row)
+			{
+				g_array_remove_index_fast(rows, i);
+				break;
+			}
+		}
+
+		if (rows->len == 0)
+		{
+			g_hash_table_remove(column->index_hash, value.val_string);
+		}
+	}
+	else
+	{
+		JMemorySearch search = { column, NULL, 0 };
+		GSequenceIter* iter;
+
+		if ((iter = g_sequence_lookup(column->index_ordered, GUINT_TO_POINTER(row + 1), memory_index_compare, &search)) != NULL)
+		{
+			g_sequence_remove(iter);
+		}
+	}
+}
+
+static void
+memory_index_clear(JMemoryColumn* column)
+{
+	if (column->index_type == J_MEMORY_INDEX_HASH)
+	{
+		g_hash_table_remove_all(column->index_hash);
+	}
+	else if (column->index_type == J_MEMORY_INDEX_ORDERED)
+	{
+		g_sequence_remove_range(g_sequence_get_begin_iter(column->index_ordered), g_sequence_get_end_iter(column->index_ordered));
+	}
+}
+
+/**
+ * Returns the range of the ordered index matching a condition.
+ **/
+static void
+memory_index_range(JMemoryColumn const* column, JMemoryPredicate const* condition, GSequenceIter** begin, GSequenceIter** end)
+{
+	JMemorySearch search = { column, &condition->value, -1 };
+	GSequenceIter* lower;
+	GSequenceIter* upper;
+
+	// First row with a value >= the condition's value
+	lower = g_sequence_search(column->index_ordered, NULL, memory_index_compare, &search);
+	search.bias = 1;
+	// First row with a value > the condition's value
+	upper = g_sequence_search(column->index_ordered, NULL, memory_index_compare, &search);
+
+	*begin = g_sequence_get_begin_iter(column->index_ordered);
+	*end = g_sequence_get_end_iter(column->index_ordered);
+
+	switch (condition->operator_)
+	{
+		case J_DB_SELECTOR_OPERATOR_LT:
+			*end = lower;
+			break;
+		case J_DB_SELECTOR_OPERATOR_LE:
+			*end = upper;
+			break;
+		case J_DB_SELECTOR_OPERATOR_GT:
+			*begin = upper;
+			break;
+		case J_DB_SELECTOR_OPERATOR_GE:
+			*begin = lower;
+			break;
+		case J_DB_SELECTOR_OPERATOR_EQ:
+			*begin = lower;
+			*end = upper;
+			break;
+		case J_DB_SELECTOR_OPERATOR_NE:
+		default:
+			break;
+	}
+}
+
+static void
+memory_column_free(JMemoryColumn* column)
+{
+	for (guint row = 0; row < column->set->len; row++)
+	{
+		memory_column_clear(column, row);
+	}
+
+	if (column->index_hash != NULL)
+	{
+		g_hash_table_unref(column->index_hash);
+	}
+
+	if (column->index_ordered != NULL)
+	{
+		g_sequence_free(column->index_ordered);
+	}
+
+	g_array_unref(column->values);
+	g_array_unref(column->set);
+	g_free(column->name);
+	g_slice_free(JMemoryColumn, column);
+}
+
+static void
+memory_table_free(JMemoryTable* table)
+{
+	g_hash_table_unref(table->rows_by_id);
+	g_array_unref(table->ids);
+	g_hash_table_unref(table->columns_by_name);
+	g_ptr_array_unref(table->columns);
+	bson_destroy(table->schema);
+	g_mutex_clear(&(table->lock));
+	g_slice_free(JMemoryTable, table);
+}
+
+static JMemoryTable*
+memory_table_ref(JMemoryTable* table)
+{
+	g_atomic_int_inc(&(table->ref_count));
+
+	return table;
+}
+
+static void
+memory_table_unref(JMemoryTable* table)
+{
+	if (g_atomic_int_dec_and_test(&(table->ref_count)))
+	{
+		memory_table_free(table);
+	}
+}
+
+static JMemoryTable*
+memory_table_new(bson_t const* schema, GError** error)
+{
+	JMemoryTable* table;
+	JDBTypeValue value;
+	bson_iter_t iter;
+	bson_iter_t iter_index;
+	bson_iter_t iter_fields;
+
+	table = g_slice_new(JMemoryTable);
+	table->ref_count = 1;
+	g_mutex_init(&(table->lock));
+	table->schema = bson_new();
+	table->columns = g_ptr_array_new_with_free_func((GDestroyNotify)memory_column_free);
+	table->columns_by_name = g_hash_table_new(g_str_hash, g_str_equal);
+	table->ids = g_array_new(FALSE, FALSE, sizeof(guint32));
+	table->rows_by_id = g_hash_table_new(g_direct_hash, g_direct_equal);
+	table->rows_live = 0;
+	table->next_id = 1;
+
+	value.val_uint32 = J_DB_TYPE_UINT32;
+
+	if (!j_bson_append_value(table->schema, "_id", J_DB_TYPE_UINT32, &value, error))
+	{
+		goto _error;
+	}
+
+	if (!bson_iter_init(&iter, schema))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INIT, "bson iter init failed");
+		goto _error;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		JMemoryColumn* column;
+		gchar const* key = bson_iter_key(&iter);
+
+		if (key[0] == '_')
+		{
+			continue;
+		}
+
+		if (!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error))
+		{
+			goto _error;
+		}
+
+		if (value.val_uint32 == J_DB_TYPE_ID)
+		{
+			value.val_uint32 = J_DB_TYPE_UINT32;
+		}
+
+		if (memory_type_size(value.val_uint32) == 0)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
+			goto _error;
+		}
+
+		column = g_slice_new(JMemoryColumn);
+		column->name = g_strdup(key);
+		column->type = value.val_uint32;
+		column->values = g_array_new(FALSE, TRUE, memory_type_size(column->type));
+		column->set = g_array_new(FALSE, TRUE, sizeof(guint8));
+		column->index_type = J_MEMORY_INDEX_NONE;
+		column->index_hash = NULL;
+		column->index_ordered = NULL;
+
+		g_ptr_array_add(table->columns, column);
+		g_hash_table_insert(table->columns_by_name, column->name, column);
+
+		if (!j_bson_append_value(table->schema, key, J_DB_TYPE_UINT32, &value, error))
+		{
+			goto _error;
+		}
+	}
+
+	if (table->columns->len == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_EMPTY, "schema empty");
+		goto _error;
+	}
+
+	if (bson_iter_init_find(&iter, schema, "_index") && bson_iter_recurse(&iter, &iter_index))
+	{
+		while (bson_iter_next(&iter_index))
+		{
+			JMemoryColumn* column;
+
+			// Only the first field of an index can be used for lookups
+			if (!bson_iter_recurse(&iter_index, &iter_fields) || !bson_iter_next(&iter_fields) || !BSON_ITER_HOLDS_UTF8(&iter_fields))
+			{
+				continue;
+			}
+
+			if ((column = g_hash_table_lookup(table->columns_by_name, bson_iter_utf8(&iter_fields, NULL))) == NULL)
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+
+			if (column->index_type != J_MEMORY_INDEX_NONE)
+			{
+				continue;
+			}
+
+			if (column->type == J_DB_TYPE_STRING)
+			{
+				column->index_type = J_MEMORY_INDEX_HASH;
+				column->index_hash = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_array_unref);
+			}
+			else if (column->type != J_DB_TYPE_BLOB)
+			{
+				column->index_type = J_MEMORY_INDEX_ORDERED;
+				column->index_ordered = g_sequence_new(NULL);
+			}
+		}
+	}
+
+	return table;
+
+_error:
+	memory_table_free(table);
+
+	return NULL;
+}
+
+/**
+ * Returns a new reference to the table.
+ **/
+static JMemoryTable*
+memory_table_lookup(JMemoryData* bd, gchar const* namespace, gchar const* name, GError** error)
+{
+	JMemoryTable* table = NULL;
+	GHashTable* tables;
+
+	g_rw_lock_reader_lock(&(bd->lock));
+
+	if ((tables = g_hash_table_lookup(bd->namespaces, namespace)) != NULL && (table = g_hash_table_lookup(tables, name)) != NULL)
+	{
+		memory_table_ref(table);
+	}
+
+	g_rw_lock_reader_unlock(&(bd->lock));
+
+	if (table == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND, "schema not found");
+	}
+
+	return table;
+}
+
+static void
+memory_predicate_free(JMemoryPredicate* predicate)
+{
+	if (predicate->children != NULL)
+	{
+		g_ptr_array_unref(predicate->children);
+	}
+
+	g_slice_free(JMemoryPredicate, predicate);
+}
+
+static JMemoryPredicate*
+memory_condition_new(JMemoryTable const* table, bson_iter_t* iter, GError** error)
+{
+	JMemoryPredicate* condition;
+	JDBType type = J_DB_TYPE_UINT32;
+	gchar const* name = NULL;
+	gboolean has_operator = FALSE;
+	gboolean has_value = FALSE;
+	bson_iter_t iter_value;
+
+	condition = g_slice_new0(JMemoryPredicate);
+
+	while (bson_iter_next(iter))
+	{
+		gchar const* key = bson_iter_key(iter);
+
+		if (g_strcmp0(key, "_name") == 0 && BSON_ITER_HOLDS_UTF8(iter))
+		{
+			name = bson_iter_utf8(iter, NULL);
+		}
+		else if (g_strcmp0(key, "_operator") == 0 && BSON_ITER_HOLDS_INT32(iter))
+		{
+			condition->operator_ = bson_iter_int32(iter);
+			has_operator = TRUE;
+		}
+		else if (g_strcmp0(key, "_value") == 0)
+		{
+			iter_value = *iter;
+			has_value = TRUE;
+		}
+	}
+
+	if (name == NULL || !has_operator || !has_value)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+		goto _error;
+	}
+
+	if (condition->operator_ > J_DB_SELECTOR_OPERATOR_NE)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+		goto _error;
+	}
+
+	if (g_strcmp0(name, "_id") != 0)
+	{
+		if ((condition->column = g_hash_table_lookup(table->columns_by_name, name)) == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		type = condition->column->type;
+	}
+
+	if (!j_bson_iter_value(&iter_value, type, &(condition->value), error))
+	{
+		goto _error;
+	}
+
+	return condition;
+
+_error:
+	memory_predicate_free(condition);
+
+	return NULL;
+}
+
+/**
+ * Parses a selector, string and blob values are borrowed from it.
+ **/
+static JMemoryPredicate*
+memory_predicate_new(JMemoryTable const* table, bson_iter_t* iter, GError** error)
+{
+	JMemoryPredicate* predicate;
+	bson_iter_t iter_child;
+	bson_iter_t iter_mode;
+
+	predicate = g_slice_new0(JMemoryPredicate);
+	predicate->mode = J_DB_SELECTOR_MODE_AND;
+	predicate->children = g_ptr_array_new_with_free_func((GDestroyNotify)memory_predicate_free);
+
+	while (bson_iter_next(iter))
+	{
+		JMemoryPredicate* child;
+		gchar const* key = bson_iter_key(iter);
+
+		if (g_strcmp0(key, "_mode") == 0 && BSON_ITER_HOLDS_INT32(iter))
+		{
+			predicate->mode = bson_iter_int32(iter);
+			continue;
+		}
+
+		// Skips _fields, _aggregate and other reserved keys
+		if (key[0] == '_')
+		{
+			continue;
+		}
+
+		if (!j_bson_iter_recurse_document(iter, &iter_child, error))
+		{
+			goto _error;
+		}
+
+		iter_mode = iter_child;
+
+		if (bson_iter_find(&iter_mode, "_mode"))
+		{
+			child = memory_predicate_new(table, &iter_child, error);
+		}
+		else
+		{
+			child = memory_condition_new(table, &iter_child, error);
+		}
+
+		if (child == NULL)
+		{
+			goto _error;
+		}
+
+		g_ptr_array_add(predicate->children, child);
+	}
+
+	return predicate;
+
+_error:
+	memory_predicate_free(predicate);
+
+	return NULL;
+}
+
+static gboolean
+memory_predicate_match(JMemoryTable const* table, JMemoryPredicate const* predicate, guint row)
+{
+	JDBTypeValue value;
+	JDBType type = J_DB_TYPE_UINT32;
+	gint cmp;
+
+	if (predicate->children != NULL)
+	{
+		for (guint i = 0; i < predicate->children->len; i++)
+		{
+			gboolean match = memory_predicate_match(table, g_ptr_array_index(predicate->children, i), row);
+
+			if (predicate->mode == J_DB_SELECTOR_MODE_AND && !match)
+			{
+				return FALSE;
+			}
+
+			if (predicate->mode == J_DB_SELECTOR_MODE_OR && match)
+			{
+				return TRUE;
+			}
+		}
+
+		return (predicate->mode == J_DB_SELECTOR_MODE_AND);
+	}
+
+	if (predicate->column == NULL)
+	{
+		value.val_uint32 = g_array_index(table->ids, guint32, row);
+	}
+	else if (memory_column_get(predicate->column, row, &value))
+	{
+		type = predicate->column->type;
+	}
+	else
+	{
+		// Like NULL in SQL, unset values never match
+		return FALSE;
+	}
+
+	cmp = memory_value_compare(type, &value, &(predicate->value));
+
+	switch (predicate->operator_)
+	{
+		case J_DB_SELECTOR_OPERATOR_LT:
+			return (cmp < 0);
+		case J_DB_SELECTOR_OPERATOR_LE:
+			return (cmp <= 0);
+		case J_DB_SELECTOR_OPERATOR_GT:
+			return (cmp > 0);
+		case J_DB_SELECTOR_OPERATOR_GE:
+			return (cmp >= 0);
+		case J_DB_SELECTOR_OPERATOR_EQ:
+			return (cmp == 0);
+		case J_DB_SELECTOR_OPERATOR_NE:
+			return (cmp != 0);
+		default:
+			return FALSE;
+	}
+}
+
+/**
+ * Estimates how many rows the indexes return for a predicate.
+ * Returns FALSE if the predicate cannot be answered using the indexes.
+ **/
+static gboolean
+memory_predicate_estimate(JMemoryTable const* table, JMemoryPredicate const* predicate, guint* estimate)
+{
+	if (predicate->children != NULL)
+	{
+		gboolean indexed = FALSE;
+		guint64 sum = 0;
+
+		*estimate = G_MAXUINT;
+
+		for (guint i = 0; i < predicate->children->len; i++)
+		{
+			guint estimate_child;
+
+			if (!memory_predicate_estimate(table, g_ptr_array_index(predicate->children, i), &estimate_child))
+			{
+				// All conditions of a disjunction have to be indexed
+				if (predicate->mode == J_DB_SELECTOR_MODE_OR)
+				{
+					return FALSE;
+				}
+
+				continue;
+			}
+
+			indexed = TRUE;
+
+			if (predicate->mode == J_DB_SELECTOR_MODE_AND)
+			{
+				// Any condition of a conjunction narrows down the rows, use the most selective one
+				*estimate = MIN(*estimate, estimate_child);
+			}
+			else
+			{
+				sum += estimate_child;
+				*estimate = MIN(sum, G_MAXUINT);
+			}
+		}
+
+		return indexed;
+	}
+
+	if (predicate->column == NULL)
+	{
+		if (predicate->operator_ != J_DB_SELECTOR_OPERATOR_EQ)
+		{
+			return FALSE;
+		}
+
+		*estimate = g_hash_table_contains(table->rows_by_id, GUINT_TO_POINTER(predicate->value.val_uint32)) ? 1 : 0;
+
+		return TRUE;
+	}
+
+	if (predicate->column->index_type == J_MEMORY_INDEX_HASH && predicate->operator_ == J_DB_SELECTOR_OPERATOR_EQ)
+	{
+		GArray* rows = g_hash_table_lookup(predicate->column->index_hash, predicate->value.val_string);
+
+		*estimate = (rows != NULL) ? rows->len : 0;
+
+		return TRUE;
+	}
+
+	if (predicate->column->index_type == J_MEMORY_INDEX_ORDERED && predicate->operator_ != J_DB_SELECTOR_OPERATOR_NE)
+	{
+		GSequenceIter* begin;
+		GSequenceIter* end;
+
+		memory_index_range(predicate->column, predicate, &begin, &end);
+		*estimate = g_sequence_iter_get_position(end) - g_sequence_iter_get_position(begin);
+
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * Appends the candidate rows of an indexed predicate, rows may be appended more than once.
+ **/
+static void
+memory_predicate_collect(JMemoryTable const* table, JMemoryPredicate const* predicate, GArray* rows)
+{
+	if (predicate->children != NULL)
+	{
+		JMemoryPredicate const* best = NULL;
+		guint estimate_best = G_MAXUINT;
+
+		for (guint i = 0; i < predicate->children->len; i++)
+		{
+			JMemoryPredicate const* child = g_ptr_array_index(predicate->children, i);
+
+			if (predicate->mode == J_DB_SELECTOR_MODE_OR)
+			{
+				memory_predicate_collect(table, child, rows);
+			}
+			else
+			{
+				guint estimate;
+
+				if (memory_predicate_estimate(table, child, &estimate) && (best == NULL || estimate < estimate_best))
+				{
+					best = child;
+					estimate_best = estimate;
+				}
+			}
+		}
+
+		if (best != NULL)
+		{
+			memory_predicate_collect(table, best, rows);
+		}
+	}
+	else if (predicate->column == NULL)
+	{
+		guint row = GPOINTER_TO_UINT(g_hash_table_lookup(table->rows_by_id, GUINT_TO_POINTER(predicate->value.val_uint32)));
+
+		if (row > 0)
+		{
+			row--;
+			g_array_append_val(rows, row);
+		}
+	}
+	else if (predicate->column->index_type == J_MEMORY_INDEX_HASH)
+	{
+		GArray* rows_index = g_hash_table_lookup(predicate->column->index_hash, predicate->value.val_string);
+
+		if (rows_index != NULL)
+		{
+			g_array_append_vals(rows, rows_index->data, rows_index->len);
+		}
+	}
+	else
+	{
+		GSequenceIter* begin;
+		GSequenceIter* end;
+
+		memory_index_range(predicate->column, predicate, &begin, &end);
+
+		for (GSequenceIter* iter = begin; iter != end; iter = g_sequence_iter_next(iter))
+		{
+			guint row = GPOINTER_TO_UINT(g_sequence_get(iter)) - 1;
+
+			g_array_append_val(rows, row);
+		}
+	}
+}
+
+static gint
+memory_row_compare(gconstpointer a, gconstpointer b)
+{
+	guint row_a = *(guint const*)a;
+	guint row_b = *(guint const*)b;
+
+	return (row_a > row_b) - (row_a < row_b);
+}
+
+/**
+ * Returns the rows matching a predicate in insertion order.
+ * The indexes are used if they return fewer rows than a full scan, the remaining conditions are checked row by row.
+ **/
+static GArray*
+memory_table_select(JMemoryTable const* table, JMemoryPredicate const* predicate)
+{
+	GArray* rows;
+	guint estimate;
+
+	rows = g_array_new(FALSE, FALSE, sizeof(guint));
+
+	if (predicate != NULL && memory_predicate_estimate(table, predicate, &estimate) && estimate < table->rows_live)
+	{
+		g_autoptr(GArray) candidates = NULL;
+
+		candidates = g_array_sized_new(FALSE, FALSE, sizeof(guint), estimate);
+		memory_predicate_collect(table, predicate, candidates);
+		g_array_sort(candidates, memory_row_compare);
+
+		for (guint i = 0; i < candidates->len; i++)
+		{
+			guint row = g_array_index(candidates, guint, i);
+
+			if (i > 0 && row == g_array_index(candidates, guint, i - 1))
+			{
+				continue;
+			}
+
+			if (memory_predicate_match(table, predicate, row))
+			{
+				g_array_append_val(rows, row);
+			}
+		}
+	}
+	else
+	{
+		for (guint row = 0; row < table->ids->len; row++)
+		{
+			if (g_array_index(table->ids, guint32, row) == 0)
+			{
+				continue;
+			}
+
+			if (predicate == NULL || memory_predicate_match(table, predicate, row))
+			{
+				g_array_append_val(rows, row);
+			}
+		}
+	}
+
+	return rows;
+}
+
+/**
+ * Returns the rows matching a selector, NULL if the selector is invalid.
+ **/
+static GArray*
+memory_table_select_bson(JMemoryTable const* table, bson_t const* selector, GError** error)
+{
+	JMemoryPredicate* predicate = NULL;
+	GArray* rows;
+	bson_iter_t iter;
+
+	if (selector != NULL && j_bson_selector_has_conditions(selector))
+	{
+		if (!bson_iter_init(&iter, selector))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INIT, "bson iter init failed");
+			return NULL;
+		}
+
+		if ((predicate = memory_predicate_new(table, &iter, error)) == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	rows = memory_table_select(table, predicate);
+
+	if (predicate != NULL)
+	{
+		memory_predicate_free(predicate);
+	}
+
+	return rows;
+}
+
+static gint
+memory_sort_compare(gconstpointer a, gconstpointer b, gpointer data)
+{
+	GArray const* sorts = data;
+	guint row_a = *(guint const*)a;
+	guint row_b = *(guint const*)b;
+
+	for (guint i = 0; i < sorts->len; i++)
+	{
+		JMemorySort const* sort = &g_array_index(sorts, JMemorySort, i);
+		JDBTypeValue value_a;
+		JDBTypeValue value_b;
+		gboolean set_a;
+		gboolean set_b;
+		gint cmp;
+
+		set_a = memory_column_get(sort->column, row_a, &value_a);
+		set_b = memory_column_get(sort->column, row_b, &value_b);
+
+		// Like NULL in SQL, unset values sort first
+		cmp = (set_a && set_b) ? memory_value_compare(sort->column->type, &value_a, &value_b) : set_a - set_b;
+
+		if (cmp != 0)
+		{
+			return sort->descending ? -cmp : cmp;
+		}
+	}
+
+	// Entries with equal sort keys keep their insertion order
+	return (row_a > row_b) - (row_a < row_b);
+}
+
+/**
+ * Sorts rows by the selector's sort keys.
+ **/
+static gboolean
+memory_table_sort(JMemoryTable const* table, bson_t const* selector, GArray* rows, GError** error)
+{
+	g_autoptr(GArray) sorts = NULL;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	bson_iter_t iter_sort;
+
+	if (selector == NULL || !bson_iter_init_find(&iter, selector, "_order") || !bson_iter_recurse(&iter, &iter_child))
+	{
+		return TRUE;
+	}
+
+	sorts = g_array_new(FALSE, FALSE, sizeof(JMemorySort));
+
+	while (bson_iter_next(&iter_child))
+	{
+		JMemorySort sort = { NULL, FALSE };
+
+		if (!bson_iter_recurse(&iter_child, &iter_sort))
+		{
+			continue;
+		}
+
+		while (bson_iter_next(&iter_sort))
+		{
+			gchar const* key = bson_iter_key(&iter_sort);
+
+			if (g_strcmp0(key, "_name") == 0 && BSON_ITER_HOLDS_UTF8(&iter_sort))
+			{
+				sort.column = g_hash_table_lookup(table->columns_by_name, bson_iter_utf8(&iter_sort, NULL));
+			}
+			else if (g_strcmp0(key, "_order") == 0 && BSON_ITER_HOLDS_INT32(&iter_sort))
+			{
+				sort.descending = (bson_iter_int32(&iter_sort) == J_DB_SELECTOR_ORDER_DESCENDING);
+			}
+		}
+
+		if (sort.column == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			return FALSE;
+		}
+
+		g_array_append_val(sorts, sort);
+	}
+
+	g_array_sort_with_data(rows, memory_sort_compare, sorts);
+
+	return TRUE;
+}
+
+/**
+ * Returns the selector's limit and offset, a limit of 0 returns all results.
+ **/
+static void
+memory_selector_get_limit(bson_t const* selector, guint64* limit, guint64* offset)
+{
+	bson_iter_t iter;
+
+	*limit = 0;
+	*offset = 0;
+
+	if (selector == NULL)
+	{
+		return;
+	}
+
+	if (bson_iter_init_find(&iter, selector, "_limit") && BSON_ITER_HOLDS_INT64(&iter))
+	{
+		*limit = bson_iter_int64(&iter);
+	}
+
+	if (bson_iter_init_find(&iter, selector, "_offset") && BSON_ITER_HOLDS_INT64(&iter))
+	{
+		*offset = bson_iter_int64(&iter);
+	}
+}
+
+/**
+ * Checks that all fields exist and have the correct type.
+ **/
+static gboolean
+memory_table_check(JMemoryTable const* table, bson_t const* metadata, GError** error)
+{
+	bson_iter_t iter;
+	JDBTypeValue value;
+
+	if (!bson_iter_init(&iter, metadata))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INIT, "bson iter init failed");
+		return FALSE;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		JMemoryColumn const* column;
+		gchar const* key = bson_iter_key(&iter);
+
+		if (key[0] == '_')
+		{
+			continue;
+		}
+
+		if ((column = g_hash_table_lookup(table->columns_by_name, key)) == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			return FALSE;
+		}
+
+		if (!j_bson_iter_value(&iter, column->type, &value, error))
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Sets a row's fields, the metadata has to be checked using memory_table_check().
+ **/
+static void
+memory_table_set(JMemoryTable* table, guint row, bson_t const* metadata)
+{
+	bson_iter_t iter;
+	JDBTypeValue value;
+
+	bson_iter_init(&iter, metadata);
+
+	while (bson_iter_next(&iter))
+	{
+		JMemoryColumn* column;
+		gchar const* key = bson_iter_key(&iter);
+
+		if (key[0] == '_')
+		{
+			continue;
+		}
+
+		column = g_hash_table_lookup(table->columns_by_name, key);
+		j_bson_iter_value(&iter, column->type, &value, NULL);
+
+		memory_index_remove(column, row);
+		memory_column_set(column, row, &value);
+		memory_index_insert(column, row);
+	}
+}
+
+static void
+memory_table_insert_id(JMemoryTable* table, guint32 id, bson_t const* metadata)
+{
+	guint row = table->ids->len;
+
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(table->columns, i);
+
+		g_array_set_size(column->values, row + 1);
+		g_array_set_size(column->set, row + 1);
+	}
+
+	g_array_append_val(table->ids, id);
+	g_hash_table_insert(table->rows_by_id, GUINT_TO_POINTER(id), GUINT_TO_POINTER(row + 1));
+	table->rows_live++;
+
+	memory_table_set(table, row, metadata);
+}
+
+static guint32
+memory_table_insert(JMemoryTable* table, bson_t const* metadata)
+{
+	guint32 id = table->next_id++;
+
+	memory_table_insert_id(table, id, metadata);
+
+	return id;
+}
+
+/**
+ * Removes deleted rows once they make up most of the table, this moves rows and therefore rebuilds the indexes.
+ **/
+static void
+memory_table_compact(JMemoryTable* table)
+{
+	guint rows_deleted = table->ids->len - table->rows_live;
+	guint row_new = 0;
+
+	if (rows_deleted < 1024 || rows_deleted < table->rows_live)
+	{
+		return;
+	}
+
+	g_hash_table_remove_all(table->rows_by_id);
+
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		memory_index_clear(g_ptr_array_index(table->columns, i));
+	}
+
+	for (guint row = 0; row < table->ids->len; row++)
+	{
+		guint32 id = g_array_index(table->ids, guint32, row);
+
+		if (id == 0)
+		{
+			continue;
+		}
+
+		if (row != row_new)
+		{
+			for (guint i = 0; i < table->columns->len; i++)
+			{
+				JMemoryColumn* column = g_ptr_array_index(table->columns, i);
+				gsize size = memory_type_size(column->type);
+
+				// Deleted rows have already been cleared, so values can simply be moved
+				memcpy(column->values->data + (row_new * size), column->values->data + (row * size), size);
+				g_array_index(column->set, guint8, row_new) = g_array_index(column->set, guint8, row);
+			}
+
+			g_array_index(table->ids, guint32, row_new) = id;
+		}
+
+		g_hash_table_insert(table->rows_by_id, GUINT_TO_POINTER(id), GUINT_TO_POINTER(row_new + 1));
+		row_new++;
+	}
+
+	g_array_set_size(table->ids, row_new);
+
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(table->columns, i);
+
+		g_array_set_size(column->values, row_new);
+		g_array_set_size(column->set, row_new);
+
+		for (guint row = 0; row < row_new; row++)
+		{
+			memory_index_insert(column, row);
+		}
+	}
+}
+
+static void
+memory_table_delete(JMemoryTable* table, guint row)
+{
+	guint32 id = g_array_index(table->ids, guint32, row);
+
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		JMemoryColumn* column = g_ptr_array_index(table->columns, i);
+
+		memory_index_remove(column, row);
+		memory_column_clear(column, row);
+	}
+
+	g_hash_table_remove(table->rows_by_id, GUINT_TO_POINTER(id));
+	g_array_index(table->ids, guint32, row) = 0;
+	table->rows_live--;
+}
+
+/**
+ * Appends a row, unset values are returned like NULL values by the SQL backends.
+ * If skip_unset is TRUE, unset values are left out completely.
+ **/
+static void
+memory_table_append_row(JMemoryTable const* table, guint row, GHashTable* fields, gboolean skip_unset, bson_t* bson)
+{
+	JDBTypeValue value;
+
+	value.val_uint32 = g_array_index(table->ids, guint32, row);
+	j_bson_append_value(bson, "_id", J_DB_TYPE_UINT32, &value, NULL);
+
+	for (guint i = 0; i < table->columns->len; i++)
+	{
+		JMemoryColumn const* column = g_ptr_array_index(table->columns, i);
+
+		if (fields != NULL && !g_hash_table_contains(fields, column->name))
+		{
+			continue;
+		}
+
+		if (!memory_column_get(column, row, &value) && (skip_unset || column->type == J_DB_TYPE_STRING))
+		{
+			continue;
+		}
+
+		j_bson_append_value(bson, column->name, column->type, &value, NULL);
+	}
+}
+
+/**
+ * Returns the key of a row's value used to join tables, NULL if the value has not been set.
+ * A NULL column refers to the id.
+ **/
+static GBytes*
+memory_join_key(JMemoryTable const* table, JMemoryColumn const* column, guint row)
+{
+	JDBTypeValue value;
+
+	if (column == NULL)
+	{
+		guint32 id = g_array_index(table->ids, guint32, row);
+
+		return g_bytes_new(&id, sizeof(id));
+	}
+
+	if (!memory_column_get(column, row, &value))
+	{
+		return NULL;
+	}
+
+	switch (column->type)
+	{
+		case J_DB_TYPE_STRING:
+			return g_bytes_new(value.val_string, strlen(value.val_string));
+		case J_DB_TYPE_BLOB:
+			return g_bytes_new(value.val_blob, value.val_blob_length);
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_FLOAT32:
+		case J_DB_TYPE_SINT64:
+		case J_DB_TYPE_UINT64:
+		case J_DB_TYPE_FLOAT64:
+		case J_DB_TYPE_ID:
+		default:
+			return g_bytes_new(&value, memory_type_size(column->type));
+	}
+}
+
+static void
+memory_join_free(JMemoryJoin* join)
+{
+	g_free(join->name);
+	g_hash_table_unref(join->rows);
+	g_slice_free(JMemoryJoin, join);
+}
+
+/**
+ * Builds the hash table of a join (build phase of a hash join).
+ **/
+static JMemoryJoin*
+memory_join_new(JMemoryData* bd, gchar const* namespace, JBsonJoin* join, GError** error)
+{
+	JMemoryJoin* memory_join = NULL;
+	JMemoryTable* table;
+	JMemoryColumn const* column = NULL;
+	g_autoptr(GArray) rows = NULL;
+	g_autoptr(GHashTable) fields = NULL;
+
+	if ((table = memory_table_lookup(bd, namespace, join->schema, error)) == NULL)
+	{
+		return NULL;
+	}
+
+	if (join->has_fields)
+	{
+		fields = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		g_hash_table_add(fields, g_strdup("_id"));
+
+		while (bson_iter_next(&join->fields))
+		{
+			if (BSON_ITER_HOLDS_UTF8(&join->fields))
+			{
+				g_hash_table_add(fields, g_strdup(bson_iter_utf8(&join->fields, NULL)));
+			}
+		}
+	}
+
+	g_mutex_lock(&(table->lock));
+
+	if (g_strcmp0(join->join_name, "_id") != 0 && (column = g_hash_table_lookup(table->columns_by_name, join->join_name)) == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+		goto _error;
+	}
+
+	if ((rows = memory_table_select_bson(table, join->has_selector ? &join->selector : NULL, error)) == NULL)
+	{
+		goto _error;
+	}
+
+	memory_join = g_slice_new(JMemoryJoin);
+	memory_join->name = g_strdup(join->name);
+	memory_join->rows = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, (GDestroyNotify)g_ptr_array_unref);
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint row = g_array_index(rows, guint, i);
+		GBytes* key;
+		GPtrArray* matches;
+		bson_t entry;
+		bson_t* joined;
+		bson_iter_t iter;
+
+		// Like NULL in SQL, unset values do not match anything
+		if ((key = memory_join_key(table, column, row)) == NULL)
+		{
+			continue;
+		}
+
+		if ((matches = g_hash_table_lookup(memory_join->rows, key)) == NULL)
+		{
+			matches = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+			g_hash_table_insert(memory_join->rows, g_bytes_ref(key), matches);
+		}
+
+		g_bytes_unref(key);
+
+		bson_init(&entry);
+		memory_table_append_row(table, row, fields, FALSE, &entry);
+
+		// Joined fields are named after their table
+		joined = bson_new();
+
+		if (bson_iter_init(&iter, &entry))
+		{
+			while (bson_iter_next(&iter))
+			{
+				g_autofree gchar* name = g_strdup_printf("%s.%s", join->schema, bson_iter_key(&iter));
+
+				bson_append_value(joined, name, -1, bson_iter_value(&iter));
+			}
+		}
+
+		bson_destroy(&entry);
+		g_ptr_array_add(matches, joined);
+	}
+
+	g_mutex_unlock(&(table->lock));
+	memory_table_unref(table);
+
+	return memory_join;
+
+_error:
+	g_mutex_unlock(&(table->lock));
+	memory_table_unref(table);
+
+	return NULL;
+}
+
+/**
+ * Builds the hash tables of all of a selector's joins.
+ **/
+static GPtrArray*
+memory_selector_get_joins(JMemoryData* bd, gchar const* namespace, bson_t const* selector, GError** error)
+{
+	g_autoptr(GPtrArray) joins = NULL;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+
+	joins = g_ptr_array_new_with_free_func((GDestroyNotify)memory_join_free);
+
+	if (!bson_iter_init_find(&iter, selector, "_join") || !bson_iter_recurse(&iter, &iter_child))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_RECOURSE, "bson iter recourse failed");
+		return NULL;
+	}
+
+	while (bson_iter_next(&iter_child))
+	{
+		JBsonJoin join;
+		JMemoryJoin* memory_join;
+
+		if (!j_bson_selector_join(&iter_child, &join, error))
+		{
+			return NULL;
+		}
+
+		if ((memory_join = memory_join_new(bd, namespace, &join, error)) == NULL)
+		{
+			return NULL;
+		}
+
+		g_ptr_array_add(joins, memory_join);
+	}
+
+	return g_steal_pointer(&joins);
+}
+
+/**
+ * Combines the rows with their joined rows (probe phase of a hash join).
+ * The results keep the order of the rows, offset and limit are applied to the combined results.
+ **/
+static gboolean
+memory_table_join(JMemoryTable const* table, GArray* rows, GHashTable* fields, GPtrArray* joins, guint64 offset, guint64 limit, GPtrArray** results, GError** error)
+{
+	g_autoptr(GPtrArray) columns = NULL;
+	guint64 skipped = 0;
+
+	columns = g_ptr_array_sized_new(joins->len);
+
+	for (guint i = 0; i < joins->len; i++)
+	{
+		JMemoryJoin* join = g_ptr_array_index(joins, i);
+		JMemoryColumn* column = NULL;
+
+		if (g_strcmp0(join->name, "_id") != 0 && (column = g_hash_table_lookup(table->columns_by_name, join->name)) == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			return FALSE;
+		}
+
+		g_ptr_array_add(columns, column);
+	}
+
+	*results = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+
+	for (guint i = 0; i < rows->len && (limit == 0 || (*results)->len < limit); i++)
+	{
+		g_autoptr(GPtrArray) combined = NULL;
+		guint row = g_array_index(rows, guint, i);
+		bson_t* entry;
+
+		combined = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+		entry = bson_new();
+		memory_table_append_row(table, row, fields, FALSE, entry);
+		g_ptr_array_add(combined, entry);
+
+		for (guint j = 0; j < joins->len && combined->len > 0; j++)
+		{
+			JMemoryJoin* join = g_ptr_array_index(joins, j);
+			GPtrArray* matches = NULL;
+			GPtrArray* next;
+			GBytes* key;
+
+			if ((key = memory_join_key(table, g_ptr_array_index(columns, j), row)) != NULL)
+			{
+				matches = g_hash_table_lookup(join->rows, key);
+				g_bytes_unref(key);
+			}
+
+			next = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+
+			for (guint k = 0; matches != NULL && k < combined->len; k++)
+			{
+				for (guint l = 0; l < matches->len; l++)
+				{
+					bson_t* result;
+
+					result = bson_copy(g_ptr_array_index(combined, k));
+					bson_concat(result, g_ptr_array_index(matches, l));
+					g_ptr_array_add(next, result);
+				}
+			}
+
+			g_ptr_array_unref(combined);
+			combined = next;
+		}
+
+		for (guint j = 0; j < combined->len && (limit == 0 || (*results)->len < limit); j++)
+		{
+			if (skipped < offset)
+			{
+				skipped++;
+				continue;
+			}
+
+			g_ptr_array_add(*results, bson_copy(g_ptr_array_index(combined, j)));
+		}
+	}
+
+	return TRUE;
+}
+
+static void
+memory_iterator_free(JMemoryIterator* iterator)
+{
+	if (iterator->fields != NULL)
+	{
+		g_hash_table_unref(iterator->fields);
+	}
+
+	if (iterator->results != NULL)
+	{
+		g_ptr_array_unref(iterator->results);
+	}
 
-struct JMemoryData
+	if (iterator->ids != NULL)
+	{
+		g_array_unref(iterator->ids);
+	}
+
+	memory_table_unref(iterator->table);
+	g_slice_free(JMemoryIterator, iterator);
+}
+
+static gboolean
+memory_append_id(bson_t* id, guint32 value, GError** error)
 {
-	bson_t* schema_cache;
-	bson_t* entry_cache;
-	guint32 entry_counter;
+	JDBTypeValue val;
 
-	GMutex lock[1];
-};
+	val.val_uint32 = value;
 
-typedef struct JMemoryData JMemoryData;
+	if (!j_bson_append_value(id, "_value", J_DB_TYPE_UINT32, &val, error))
+	{
+		return FALSE;
+	}
+
+	val.val_uint32 = J_DB_TYPE_UINT32;
+
+	return j_bson_append_value(id, "_value_type", J_DB_TYPE_UINT32, &val, error);
+}
+
+static void
+memory_undo_free(JMemoryUndo* undo)
+{
+	if (undo->row != NULL)
+	{
+		bson_destroy(undo->row);
+	}
+
+	memory_table_unref(undo->table);
+	g_free(undo->name);
+	g_slice_free(JMemoryUndo, undo);
+}
+
+/**
+ * Records how to revert a change, the table's lock has to be held for row operations.
+ * Takes ownership of row.
+ **/
+static void
+memory_batch_log(JMemoryBatch* batch, JMemoryUndoType type, JMemoryTable* table, gchar const* name, guint32 id, bson_t* row)
+{
+	JMemoryUndo* undo;
+
+	undo = g_slice_new(JMemoryUndo);
+	undo->type = type;
+	undo->table = memory_table_ref(table);
+	undo->name = g_strdup(name);
+	undo->id = id;
+	undo->row = row;
+
+	g_ptr_array_add(batch->undo, undo);
+}
+
+/**
+ * Returns a copy of all set values of a row.
+ **/
+static bson_t*
+memory_table_snapshot(JMemoryTable const* table, guint row)
+{
+	bson_t* bson;
+
+	bson = bson_new();
+	memory_table_append_row(table, row, NULL, TRUE, bson);
+
+	return bson;
+}
+
+static gboolean
+memory_table_lookup_row(JMemoryTable const* table, guint32 id, guint* row)
+{
+	gpointer value;
+
+	if ((value = g_hash_table_lookup(table->rows_by_id, GUINT_TO_POINTER(id))) == NULL)
+	{
+		return FALSE;
+	}
+
+	*row = GPOINTER_TO_UINT(value) - 1;
+
+	return TRUE;
+}
+
+/**
+ * Reverts all operations of a batch in reverse order, no table lock must be held.
+ * Changes made by other batches in the meantime are not detected, since there is no isolation between batches.
+ **/
+static void
+memory_batch_rollback(JMemoryData* bd, JMemoryBatch* batch)
+{
+	for (guint i = batch->undo->len; i > 0; i--)
+	{
+		JMemoryUndo* undo = g_ptr_array_index(batch->undo, i - 1);
+		GHashTable* tables;
+		guint row;
+
+		switch (undo->type)
+		{
+			case J_MEMORY_UNDO_SCHEMA_CREATE:
+				g_rw_lock_writer_lock(&(bd->lock));
+
+				if ((tables = g_hash_table_lookup(bd->namespaces, batch->namespace)) != NULL && g_hash_table_lookup(tables, undo->name) == undo->table)
+				{
+					g_hash_table_remove(tables, undo->name);
+				}
+
+				g_rw_lock_writer_unlock(&(bd->lock));
+				break;
+			case J_MEMORY_UNDO_SCHEMA_DELETE:
+				g_rw_lock_writer_lock(&(bd->lock));
+
+				if ((tables = g_hash_table_lookup(bd->namespaces, batch->namespace)) == NULL)
+				{
+					tables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)memory_table_unref);
+					g_hash_table_insert(bd->namespaces, g_strdup(batch->namespace), tables);
+				}
+
+				if (!g_hash_table_contains(tables, undo->name))
+				{
+					g_hash_table_insert(tables, g_strdup(undo->name), memory_table_ref(undo->table));
+				}
+
+				g_rw_lock_writer_unlock(&(bd->lock));
+				break;
+			case J_MEMORY_UNDO_INSERT:
+				g_mutex_lock(&(undo->table->lock));
+
+				if (memory_table_lookup_row(undo->table, undo->id, &row))
+				{
+					memory_table_delete(undo->table, row);
+					memory_table_compact(undo->table);
+				}
+
+				g_mutex_unlock(&(undo->table->lock));
+				break;
+			case J_MEMORY_UNDO_UPDATE:
+				g_mutex_lock(&(undo->table->lock));
+
+				if (memory_table_lookup_row(undo->table, undo->id, &row))
+				{
+					for (guint j = 0; j < undo->table->columns->len; j++)
+					{
+						JMemoryColumn* column = g_ptr_array_index(undo->table->columns, j);
+
+						memory_index_remove(column, row);
+						memory_column_clear(column, row);
+					}
+
+					memory_table_set(undo->table, row, undo->row);
+				}
+
+				g_mutex_unlock(&(undo->table->lock));
+				break;
+			case J_MEMORY_UNDO_DELETE:
+				g_mutex_lock(&(undo->table->lock));
+
+				if (!memory_table_lookup_row(undo->table, undo->id, &row))
+				{
+					memory_table_insert_id(undo->table, undo->id, undo->row);
+				}
+
+				g_mutex_unlock(&(undo->table->lock));
+				break;
+			default:
+				g_warn_if_reached();
+		}
+	}
+
+	g_ptr_array_set_size(batch->undo, 0);
+}
 
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* batch, GError** error)
 {
+	JMemoryBatch* memory_batch;
+
 	(void)backend_data;
 	(void)semantics;
-	(void)namespace;
-	(void)batch;
 	(void)error;
 
-	// Return something != NULL
-	*batch = batch;
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	memory_batch = g_slice_new(JMemoryBatch);
+	memory_batch->namespace = g_strdup(namespace);
+	memory_batch->undo = g_ptr_array_new_with_free_func((GDestroyNotify)memory_undo_free);
+
+	*batch = memory_batch;
 
 	return TRUE;
 }
@@ -53,10 +2358,16 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 static gboolean
 backend_batch_execute(gpointer backend_data, gpointer batch, GError** error)
 {
+	JMemoryBatch* memory_batch = batch;
+
 	(void)backend_data;
-	(void)batch;
 	(void)error;
 
+	// Operations have already been applied, committing only discards the undo log
+	g_ptr_array_unref(memory_batch->undo);
+	g_free(memory_batch->namespace);
+	g_slice_free(JMemoryBatch, memory_batch);
+
 	return TRUE;
 }
 
@@ -64,71 +2375,106 @@ static gboolean
 backend_schema_create(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* schema, GError** error)
 {
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	GHashTable* tables;
+	gboolean ret = FALSE;
 
-	(void)batch;
-	(void)name;
-	(void)schema;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if ((table = memory_table_new(schema, error)) == NULL)
+	{
+		goto end;
+	}
 
-	g_mutex_lock(bd->lock);
+	g_rw_lock_writer_lock(&(bd->lock));
+
+	if ((tables = g_hash_table_lookup(bd->namespaces, memory_batch->namespace)) == NULL)
+	{
+		tables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)memory_table_unref);
+		g_hash_table_insert(bd->namespaces, g_strdup(memory_batch->namespace), tables);
+	}
 
-	if (bd->schema_cache != NULL)
+	if (g_hash_table_contains(tables, name))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "schema already exists");
+	}
+	else
 	{
-		bson_destroy(bd->schema_cache);
+		memory_batch_log(memory_batch, J_MEMORY_UNDO_SCHEMA_CREATE, table, name, 0, NULL);
+		g_hash_table_insert(tables, g_strdup(name), table);
+		table = NULL;
+		ret = TRUE;
 	}
 
-	bd->schema_cache = bson_copy(schema);
+	g_rw_lock_writer_unlock(&(bd->lock));
 
-	g_mutex_unlock(bd->lock);
+	if (table != NULL)
+	{
+		memory_table_unref(table);
+	}
 
-	return TRUE;
+end:
+	if (!ret)
+	{
+		memory_batch_rollback(bd, memory_batch);
+	}
+
+	return ret;
 }
 
 static gboolean
 backend_schema_get(gpointer backend_data, gpointer batch, gchar const* name, bson_t* schema, GError** error)
 {
-	gboolean ret = FALSE;
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
 
-	(void)batch;
-	(void)name;
-	(void)schema;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
 
-	g_mutex_lock(bd->lock);
+	if ((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL)
+	{
+		return FALSE;
+	}
 
-	if (bd->schema_cache != NULL)
+	if (schema != NULL)
 	{
-		// FIXME schema is uninitialized if backend is running on the server but initialized if running on the client
-		// bson_copy_to requires the destination to be uninitialized
-		//bson_destroy(schema);
-		bson_copy_to(bd->schema_cache, schema);
-		ret = TRUE;
+		// The schema is immutable, no need to lock the table
+		bson_init(schema);
+		bson_concat(schema, table->schema);
 	}
 
-	g_mutex_unlock(bd->lock);
+	memory_table_unref(table);
 
-	return ret;
+	return TRUE;
 }
 
 static gboolean
 backend_schema_delete(gpointer backend_data, gpointer batch, gchar const* name, GError** error)
 {
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	GHashTable* tables;
 
-	(void)batch;
-	(void)name;
 	(void)error;
 
-	g_mutex_lock(bd->lock);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
 
-	if (bd->schema_cache != NULL)
+	g_rw_lock_writer_lock(&(bd->lock));
+
+	// Open iterators keep their own reference to the table
+	if ((tables = g_hash_table_lookup(bd->namespaces, memory_batch->namespace)) != NULL && (table = g_hash_table_lookup(tables, name)) != NULL)
 	{
-		bson_destroy(bd->schema_cache);
-		bd->schema_cache = NULL;
+		memory_batch_log(memory_batch, J_MEMORY_UNDO_SCHEMA_DELETE, table, name, 0, NULL);
+		g_hash_table_remove(tables, name);
 	}
 
-	g_mutex_unlock(bd->lock);
+	g_rw_lock_writer_unlock(&(bd->lock));
 
 	return TRUE;
 }
@@ -137,96 +2483,355 @@ static gboolean
 backend_insert(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
 {
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	guint32 value = 0;
+	gboolean ret = FALSE;
 
-	(void)batch;
-	(void)name;
-	(void)metadata;
-	(void)id;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if ((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
 
-	g_mutex_lock(bd->lock);
+	g_mutex_lock(&(table->lock));
 
-	if (bd->entry_cache != NULL)
+	if (memory_table_check(table, metadata, error))
 	{
-		bson_destroy(bd->entry_cache);
+		value = memory_table_insert(table, metadata);
+		memory_batch_log(memory_batch, J_MEMORY_UNDO_INSERT, table, NULL, value, NULL);
+		ret = TRUE;
 	}
 
-	bd->entry_cache = bson_copy(metadata);
-	bd->entry_counter++;
+	g_mutex_unlock(&(table->lock));
+	memory_table_unref(table);
 
-	g_mutex_unlock(bd->lock);
+	if (ret && id != NULL)
+	{
+		ret = memory_append_id(id, value, error);
+	}
 
-	return TRUE;
+end:
+	if (!ret)
+	{
+		memory_batch_rollback(bd, memory_batch);
+	}
+
+	return ret;
 }
 
 static gboolean
-backend_update(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
+backend_insert_many(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* const* metadata, bson_t* ids, guint count, GError** error)
 {
-	(void)backend_data;
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)metadata;
-	(void)error;
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	guint32 value = 0;
+	gboolean ret = TRUE;
 
-	return TRUE;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if ((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL)
+	{
+		ret = FALSE;
+		goto end;
+	}
+
+	g_mutex_lock(&(table->lock));
+
+	// Check all entries first, so that a failed insert leaves the table untouched
+	for (guint i = 0; i < count && ret; i++)
+	{
+		ret = memory_table_check(table, metadata[i], error);
+	}
+
+	for (guint i = 0; i < count && ret; i++)
+	{
+		value = memory_table_insert(table, metadata[i]);
+		memory_batch_log(memory_batch, J_MEMORY_UNDO_INSERT, table, NULL, value, NULL);
+
+		if (ids != NULL && !memory_append_id(&ids[i], value, error))
+		{
+			ret = FALSE;
+		}
+	}
+
+	g_mutex_unlock(&(table->lock));
+	memory_table_unref(table);
+
+end:
+	if (!ret)
+	{
+		memory_batch_rollback(bd, memory_batch);
+	}
+
+	return ret;
 }
 
 static gboolean
-backend_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, GError** error)
+backend_update(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, guint64* count, GError** error)
 {
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	g_autoptr(GArray) rows = NULL;
+	gboolean ret = FALSE;
 
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (!j_bson_selector_check_modify(selector, TRUE, error))
+	{
+		goto end;
+	}
+
+	if ((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
+
+	g_mutex_lock(&(table->lock));
 
-	g_mutex_lock(bd->lock);
+	if (!memory_table_check(table, metadata, error))
+	{
+		goto unlock;
+	}
 
-	if (bd->entry_cache != NULL)
+	if ((rows = memory_table_select_bson(table, selector, error)) == NULL)
 	{
-		bson_destroy(bd->entry_cache);
-		bd->entry_cache = NULL;
+		goto unlock;
 	}
 
-	bd->entry_counter--;
+	if (rows->len == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto unlock;
+	}
 
-	g_mutex_unlock(bd->lock);
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint row = g_array_index(rows, guint, i);
 
-	return TRUE;
+		memory_batch_log(memory_batch, J_MEMORY_UNDO_UPDATE, table, NULL, g_array_index(table->ids, guint32, row), memory_table_snapshot(table, row));
+		memory_table_set(table, row, metadata);
+	}
+
+	*count = rows->len;
+	ret = TRUE;
+
+unlock:
+	g_mutex_unlock(&(table->lock));
+	memory_table_unref(table);
+
+end:
+	if (!ret)
+	{
+		memory_batch_rollback(bd, memory_batch);
+	}
+
+	return ret;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, guint64* count, GError** error)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	g_autoptr(GArray) rows = NULL;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (!j_bson_selector_check_modify(selector, FALSE, error))
+	{
+		goto end;
+	}
+
+	if ((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL)
+	{
+		goto end;
+	}
+
+	g_mutex_lock(&(table->lock));
+
+	if ((rows = memory_table_select_bson(table, selector, error)) == NULL)
+	{
+		goto unlock;
+	}
+
+	if (rows->len == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto unlock;
+	}
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint row = g_array_index(rows, guint, i);
+
+		memory_batch_log(memory_batch, J_MEMORY_UNDO_DELETE, table, NULL, g_array_index(table->ids, guint32, row), memory_table_snapshot(table, row));
+		memory_table_delete(table, row);
+	}
+
+	memory_table_compact(table);
+
+	*count = rows->len;
+	ret = TRUE;
+
+unlock:
+	g_mutex_unlock(&(table->lock));
+	memory_table_unref(table);
+
+end:
+	if (!ret)
+	{
+		memory_batch_rollback(bd, memory_batch);
+	}
+
+	return ret;
 }
 
 static gboolean
 backend_query(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
 {
 	JMemoryData* bd = backend_data;
-	guint32* counter;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryIterator* it;
+	JMemoryTable* table;
+	g_autoptr(GArray) rows = NULL;
+	g_autoptr(GPtrArray) joins = NULL;
+	guint64 limit;
+	guint64 offset;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (selector != NULL && bson_has_field(selector, "_join"))
+	{
+		if (bson_has_field(selector, "_aggregate"))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "joins can not be aggregated");
+			return FALSE;
+		}
+
+		// The joined tables are hashed before locking the table, locking them in any order could deadlock
+		if ((joins = memory_selector_get_joins(bd, memory_batch->namespace, selector, error)) == NULL)
+		{
+			return FALSE;
+		}
+	}
 
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)error;
+	if ((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL)
+	{
+		return FALSE;
+	}
+
+	g_mutex_lock(&(table->lock));
+
+	if ((rows = memory_table_select_bson(table, selector, error)) == NULL)
+	{
+		g_mutex_unlock(&(table->lock));
+		memory_table_unref(table);
+
+		return FALSE;
+	}
+
+	if (!memory_table_sort(table, selector, rows, error))
+	{
+		g_mutex_unlock(&(table->lock));
+		memory_table_unref(table);
 
-	counter = g_new(guint32, 1);
-	*iterator = counter;
+		return FALSE;
+	}
+
+	memory_selector_get_limit(selector, &limit, &offset);
 
-	g_mutex_lock(bd->lock);
+	it = g_slice_new(JMemoryIterator);
+	it->table = table;
+	it->ids = NULL;
+	it->position = 0;
+	it->fields = memory_selector_get_fields(selector);
+	it->results = NULL;
 
-	if (bd->entry_cache == NULL)
+	if (selector != NULL && bson_has_field(selector, "_aggregate"))
 	{
-		*counter = 0;
+		JMemoryAggregation aggregation;
+		g_autoptr(GHashTable) fields = NULL;
+
+		memory_aggregation_init(&aggregation, selector);
+
+		// Only the aggregated and grouped fields are needed
+		fields = g_hash_table_new(g_str_hash, g_str_equal);
+
+		for (guint i = 0; i < aggregation.group_by->len; i++)
+		{
+			g_hash_table_add(fields, g_ptr_array_index(aggregation.group_by, i));
+		}
+
+		for (guint i = 0; i < aggregation.aggregates->len; i++)
+		{
+			JMemoryAggregate* aggregate = &g_array_index(aggregation.aggregates, JMemoryAggregate, i);
+
+			if (aggregate->name != NULL)
+			{
+				g_hash_table_add(fields, (gpointer)aggregate->name);
+			}
+		}
+
+		for (guint i = 0; i < rows->len; i++)
+		{
+			bson_t row;
+
+			bson_init(&row);
+			memory_table_append_row(table, g_array_index(rows, guint, i), fields, TRUE, &row);
+			memory_aggregation_add(&aggregation, &row);
+			bson_destroy(&row);
+		}
+
+		it->results = memory_aggregation_finish(&aggregation);
+
+		// Groups appear in the order of the sorted rows, so limits can only be applied to the results
+		g_ptr_array_remove_range(it->results, 0, MIN(offset, it->results->len));
+
+		if (limit > 0 && it->results->len > limit)
+		{
+			g_ptr_array_set_size(it->results, limit);
+		}
 	}
-	else if (selector != NULL)
+	else if (joins != NULL)
 	{
-		*counter = 1;
+		if (!memory_table_join(table, rows, it->fields, joins, offset, limit, &it->results, error))
+		{
+			g_mutex_unlock(&(table->lock));
+			memory_iterator_free(it);
+
+			return FALSE;
+		}
 	}
 	else
 	{
-		*counter = bd->entry_counter;
+		it->ids = g_array_sized_new(FALSE, FALSE, sizeof(guint32), rows->len);
+
+		for (guint i = MIN(offset, rows->len); i < rows->len && (limit == 0 || it->ids->len < limit); i++)
+		{
+			guint32 id = g_array_index(table->ids, guint32, g_array_index(rows, guint, i));
+
+			g_array_append_val(it->ids, id);
+		}
 	}
 
-	g_mutex_unlock(bd->lock);
+	g_mutex_unlock(&(table->lock));
+
+	*iterator = it;
 
 	return TRUE;
 }
@@ -234,33 +2839,94 @@ backend_query(gpointer backend_data, gpointer batch, gchar const* name, bson_t c
 static gboolean
 backend_iterate(gpointer backend_data, gpointer iterator, bson_t* metadata, GError** error)
 {
-	gboolean ret = TRUE;
-	guint32* counter = iterator;
+	JMemoryIterator* it = iterator;
+	JMemoryTable* table = it->table;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+
+	if (it->results != NULL)
+	{
+		if (it->position < it->results->len)
+		{
+			bson_concat(metadata, g_ptr_array_index(it->results, it->position));
+			it->position++;
+
+			return TRUE;
+		}
+	}
+	else
+	{
+		g_mutex_lock(&(table->lock));
+
+		while (it->position < it->ids->len)
+		{
+			guint32 id = g_array_index(it->ids, guint32, it->position);
+			guint row;
+
+			it->position++;
+
+			// Rows deleted since the query are skipped
+			if ((row = GPOINTER_TO_UINT(g_hash_table_lookup(table->rows_by_id, GUINT_TO_POINTER(id)))) == 0)
+			{
+				continue;
+			}
+
+			memory_table_append_row(table, row - 1, it->fields, FALSE, metadata);
+			g_mutex_unlock(&(table->lock));
+
+			return TRUE;
+		}
+
+		g_mutex_unlock(&(table->lock));
+	}
+
+	memory_iterator_free(it);
+	g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+
+	return FALSE;
+}
+
+static gboolean
+backend_statistics(gpointer backend_data, gchar** statistics)
+{
 	JMemoryData* bd = backend_data;
+	GHashTableIter iter;
+	GHashTableIter iter_tables;
+	gpointer tables;
+	gpointer table;
+	guint schemas = 0;
+	guint64 entries = 0;
 
-	(void)iterator;
-	(void)metadata;
-	(void)error;
+	g_return_val_if_fail(statistics != NULL, FALSE);
 
-	g_mutex_lock(bd->lock);
+	g_rw_lock_reader_lock(&(bd->lock));
 
-	if (*counter <= 0 || bd->entry_cache == NULL)
+	g_hash_table_iter_init(&iter, bd->namespaces);
+
+	while (g_hash_table_iter_next(&iter, NULL, &tables))
 	{
-		g_free(counter);
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-		ret = FALSE;
-		goto end;
+		g_hash_table_iter_init(&iter_tables, tables);
+
+		while (g_hash_table_iter_next(&iter_tables, NULL, &table))
+		{
+			JMemoryTable* memory_table = table;
+
+			g_mutex_lock(&(memory_table->lock));
+			entries += memory_table->rows_live;
+			g_mutex_unlock(&(memory_table->lock));
+
+			schemas++;
+		}
 	}
 
-	(*counter)--;
-	// bson_copy_to requires the destination to be uninitialized
-	bson_destroy(metadata);
-	bson_copy_to(bd->entry_cache, metadata);
+	g_rw_lock_reader_unlock(&(bd->lock));
 
-end:
-	g_mutex_unlock(bd->lock);
+	*statistics = g_strdup_printf("memory.schemas: %u\nmemory.entries: %" G_GUINT64_FORMAT "\n", schemas, entries);
 
-	return ret;
+	return TRUE;
 }
 
 static gboolean
@@ -271,10 +2937,8 @@ backend_init(gchar const* path, gpointer* backend_data)
 	(void)path;
 
 	bd = g_slice_new(JMemoryData);
-	bd->schema_cache = NULL;
-	bd->entry_cache = NULL;
-	bd->entry_counter = 0;
-	g_mutex_init(bd->lock);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
+	g_rw_lock_init(&(bd->lock));
 
 	*backend_data = bd;
 
@@ -286,17 +2950,8 @@ backend_fini(gpointer backend_data)
 {
 	JMemoryData* bd = backend_data;
 
-	if (bd->schema_cache != NULL)
-	{
-		bson_destroy(bd->schema_cache);
-	}
-
-	if (bd->entry_cache != NULL)
-	{
-		bson_destroy(bd->entry_cache);
-	}
-
-	g_mutex_clear(bd->lock);
+	g_hash_table_unref(bd->namespaces);
+	g_rw_lock_clear(&(bd->lock));
 	g_slice_free(JMemoryData, bd);
 }
 
@@ -310,12 +2965,14 @@ static JBackend memory_backend = {
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
 		.backend_insert = backend_insert,
+		.backend_insert_many = backend_insert_many,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
 		.backend_iterate = backend_iterate,
 		.backend_batch_start = backend_batch_start,
-		.backend_batch_execute = backend_batch_execute }
+		.backend_batch_execute = backend_batch_execute,
+		.backend_statistics = backend_statistics }
 };
 
 G_MODULE_EXPORT
@@ -37,6 +37,13 @@
 #define SQL_AUTOINCREMENT_STRING " NOT NULL AUTO_INCREMENT "
 #define SQL_UINT64_TYPE " BIGINT UNSIGNED "
 #define SQL_LAST_INSERT_ID_STRING " SELECT LAST_INSERT_ID() "
+// LAST_INSERT_ID() returns the id of the first row inserted by a multi-row INSERT
+#define SQL_LAST_INSERT_ID_FIRST_ROW TRUE
+// With innodb_autoinc_lock_mode=2 (the default since MySQL 8.0), the ids of a multi-row INSERT can be interleaved with concurrent inserts
+#define SQL_INSERT_IDS_CONSECUTIVE FALSE
+// Maximum number of parameters per statement and rows per multi-row INSERT
+#define SQL_VARIABLES_MAX 65535
+#define SQL_INSERT_ROWS_MAX 256
 #define SQL_QUOTE "`"
 
 struct JMySQLData
@@ -420,6 +427,18 @@ j_sql_reset(MYSQL* backend_db, void* _stmt, GError** error)
 	return TRUE;
 }
 
+static guint64
+j_sql_changes(MYSQL* backend_db, void* _stmt)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	mysql_stmt_wrapper* wrapper = _stmt;
+
+	(void)backend_db;
+
+	return mysql_stmt_affected_rows(wrapper->stmt);
+}
+
 static gboolean
 j_sql_exec(MYSQL* backend_db, const char* sql, GError** error)
 {
@@ -587,7 +606,7 @@ j_sql_open(gpointer backend_data)
 				bd->db_database, //database name
 				3306, //port number
 				NULL, //unix socket
-				0 //client flags
+				CLIENT_FOUND_ROWS //client flags, affected rows include matched rows that were not changed
 				))
 	{
 		goto _error;
@@ -649,6 +668,19 @@ j_sql_abort_transaction(MYSQL* backend_db, GError** error)
 	return TRUE;
 }
 
+static gboolean
+j_sql_set_safety(MYSQL* backend_db, JSemanticsSafety safety, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)backend_db;
+	(void)safety;
+	(void)error;
+
+	// The durability of commits is configured server-wide (innodb_flush_log_at_trx_commit)
+	return TRUE;
+}
+
 #include "sql-generic.c"
 
 static gboolean
@@ -712,12 +744,14 @@ static JBackend mysql_backend = {
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
 		.backend_insert = backend_insert,
+		.backend_insert_many = backend_insert_many,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
 		.backend_iterate = backend_iterate,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_statistics = backend_statistics,
 	},
 };
 
@@ -98,25 +98,27 @@ backend_insert(gpointer backend_data, gpointer batch, gchar const* name, bson_t
 }
 
 static gboolean
-backend_update(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
+backend_update(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, guint64* count, GError** error)
 {
 	(void)backend_data;
 	(void)batch;
 	(void)name;
 	(void)selector;
 	(void)metadata;
+	(void)count;
 	(void)error;
 
 	return TRUE;
 }
 
 static gboolean
-backend_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, GError** error)
+backend_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, guint64* count, GError** error)
 {
 	(void)backend_data;
 	(void)batch;
 	(void)name;
 	(void)selector;
+	(void)count;
 	(void)error;
 
 	return TRUE;
@@ -23,11 +23,24 @@
  * this file does not care which sql-database is actually in use, and uses only defines sql-syntax to allow fast and easy implementations for any new sql-database backend
 */
 
+/*
+ * Connections are pooled and bound to a thread while it uses them, that is,
+ * from the start of a batch until its end or until the last open iterator has been consumed.
+ * Prepared statements and cached schemas belong to a connection and can therefore be reused by all threads.
+ */
 struct JThreadVariables
 {
 	gboolean initialized;
 	void* sql_backend;
 	GHashTable* namespaces;
+	// Prepared statements, most recently used first
+	GQueue statements;
+	// Number of batches and iterators using the connection
+	guint users;
+	// Value of schema_generation the cached schemas and statements are valid for
+	gint generation;
+	// Safety the connection's transactions are committed with, -1 if it has not been set yet
+	gint safety;
 };
 
 typedef struct JThreadVariables JThreadVariables;
@@ -42,7 +55,7 @@ typedef struct JSqlCacheNames JSqlCacheNames;
 struct JSqlCacheSQLQueries
 {
 	GHashTable* types; // variablename(char*) -> variabletype(JDBType)
-	GHashTable* queries; //sql(char*) -> (JSqlCacheSQLPrepared*)
+	GHashTable* queries; //key(char*) -> (JSqlCacheSQLPrepared*)
 };
 
 typedef struct JSqlCacheSQLQueries JSqlCacheSQLQueries;
@@ -53,10 +66,19 @@ struct JSqlCacheSQLPrepared
 	void* stmt;
 	guint variables_count;
 	GHashTable* variables_index;
+	// Types of the result columns, only set for queries
+	GArray* variables_types;
 	gboolean initialized;
+	// Whether an iterator is using the statement, which prevents it from being evicted
+	gboolean in_use;
 	gchar* namespace;
 	gchar* name;
 	gpointer backend_data;
+	JThreadVariables* connection;
+	// The hash table containing the statement and its key
+	GHashTable* queries;
+	gchar const* key;
+	GList link;
 };
 
 typedef struct JSqlCacheSQLPrepared JSqlCacheSQLPrepared;
@@ -65,35 +87,71 @@ struct JSqlBatch
 {
 	const gchar* namespace;
 	JSemantics* semantics;
+	JThreadVariables* connection;
 	gboolean open;
 	gboolean aborted;
 };
 
 typedef struct JSqlBatch JSqlBatch;
 
-struct JSqlIterator
-{
-	char* namespace;
-	char* name;
-	GArray* arr;
-	guint index;
-};
+/**
+ * Default number of prepared statements cached per connection.
+ * Can be changed using the statement-cache-size backend option.
+ **/
+#define SQL_STATEMENT_CACHE_SIZE 128
 
-typedef struct JSqlIterator JSqlIterator;
+/**
+ * Minimum number of prepared statements cached per connection.
+ * A single operation uses up to two statements, which must not evict each other.
+ **/
+#define SQL_STATEMENT_CACHE_SIZE_MIN 8
 
 static void thread_variables_fini(void* ptr);
 static GPrivate thread_variables_global = G_PRIVATE_INIT(thread_variables_fini);
 
+G_LOCK_DEFINE_STATIC(sql_connections_lock);
+static GQueue sql_connections_idle = G_QUEUE_INIT;
+
+// Incremented whenever a schema is deleted, invalidating the caches of other connections
+static gint schema_generation = 0;
+
+static guint statement_cache_size = SQL_STATEMENT_CACHE_SIZE;
+
+static guint64 volatile statistics_hits = 0;
+static guint64 volatile statistics_misses = 0;
+static guint64 volatile statistics_prepares = 0;
+static guint64 volatile statistics_evictions = 0;
+
 static void
 sql_generic_init(void)
 {
 	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JConfiguration) configuration = NULL;
+
+	if ((configuration = j_configuration_new()) != NULL)
+	{
+		statement_cache_size = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_DB, "statement-cache-size", SQL_STATEMENT_CACHE_SIZE);
+	}
+
+	statement_cache_size = MAX(statement_cache_size, SQL_STATEMENT_CACHE_SIZE_MIN);
 }
 
 static void
 sql_generic_fini(void)
 {
 	J_TRACE_FUNCTION(NULL);
+
+	JThreadVariables* thread_variables;
+
+	G_LOCK(sql_connections_lock);
+
+	while ((thread_variables = g_queue_pop_head(&sql_connections_idle)) != NULL)
+	{
+		thread_variables_fini(thread_variables);
+	}
+
+	G_UNLOCK(sql_connections_lock);
 }
 
 static void
@@ -117,42 +175,82 @@ thread_variables_fini(void* ptr)
 
 static void freeJSqlCacheNames(void* ptr);
 
+/**
+ * Opens a new connection.
+ **/
 static JThreadVariables*
-thread_variables_get(gpointer backend_data, GError** error)
+thread_variables_new(gpointer backend_data, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JThreadVariables* thread_variables = NULL;
 
-	thread_variables = g_private_get(&thread_variables_global);
+	thread_variables = g_new0(JThreadVariables, 1);
+	thread_variables->initialized = FALSE;
+	thread_variables->sql_backend = j_sql_open(backend_data);
+	g_queue_init(&(thread_variables->statements));
+	thread_variables->users = 0;
+	thread_variables->generation = g_atomic_int_get(&schema_generation);
+	thread_variables->safety = -1;
 
-	if (!thread_variables)
+	if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend,
+				   "CREATE TABLE IF NOT EXISTS schema_structure ("
+				   "namespace VARCHAR(255),"
+				   "name VARCHAR(255),"
+				   "varname VARCHAR(255),"
+				   "vartype INTEGER"
+				   // FIXME figure out whether we should add an index instead
+				   //"PRIMARY KEY (namespace, name, varname)"
+				   ")",
+				   error)))
 	{
-		thread_variables = g_new0(JThreadVariables, 1);
-		thread_variables->initialized = FALSE;
+		goto _error;
 	}
 
-	if (!thread_variables->initialized)
+	thread_variables->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheNames);
+	thread_variables->initialized = TRUE;
+
+	return thread_variables;
+
+_error:
+	thread_variables_fini(thread_variables);
+
+	return NULL;
+}
+
+/**
+ * Returns the connection bound to the calling thread.
+ * If there is none, an idle connection is bound to the thread or a new one is opened.
+ **/
+static JThreadVariables*
+thread_variables_get(gpointer backend_data, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JThreadVariables* thread_variables = NULL;
+
+	thread_variables = g_private_get(&thread_variables_global);
+
+	if (!thread_variables)
 	{
-		thread_variables->sql_backend = j_sql_open(backend_data);
+		G_LOCK(sql_connections_lock);
+		thread_variables = g_queue_pop_head(&sql_connections_idle);
+		G_UNLOCK(sql_connections_lock);
 
-		if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend,
-					   "CREATE TABLE IF NOT EXISTS schema_structure ("
-					   "namespace VARCHAR(255),"
-					   "name VARCHAR(255),"
-					   "varname VARCHAR(255),"
-					   "vartype INTEGER"
-					   // FIXME figure out whether we should add an index instead
-					   //"PRIMARY KEY (namespace, name, varname)"
-					   ")",
-					   error)))
+		if (thread_variables == NULL && G_UNLIKELY(!(thread_variables = thread_variables_new(backend_data, error))))
 		{
 			goto _error;
 		}
 
-		thread_variables->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheNames);
-		thread_variables->initialized = TRUE;
-		g_private_replace(&thread_variables_global, thread_variables);
+		if (thread_variables->generation != g_atomic_int_get(&schema_generation))
+		{
+			// Schemas have been deleted using other connections, the cached schemas and statements might be stale
+			// No statement is in use since the connection was idle
+			thread_variables->generation = g_atomic_int_get(&schema_generation);
+			g_hash_table_remove_all(thread_variables->namespaces);
+		}
+
+		g_private_set(&thread_variables_global, thread_variables);
 	}
 
 	return thread_variables;
@@ -161,19 +259,47 @@ _error:
 	return NULL;
 }
 
+/**
+ * Marks the connection bound to the calling thread as used by a batch or an iterator.
+ **/
+static JThreadVariables*
+thread_variables_acquire(gpointer backend_data, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JThreadVariables* thread_variables = NULL;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		return NULL;
+	}
+
+	thread_variables->users++;
+
+	return thread_variables;
+}
+
+/**
+ * Releases a connection acquired using thread_variables_acquire.
+ * The connection is returned to the pool once it is not used anymore.
+ **/
 static void
-freeJSqlIterator(gpointer ptr)
+thread_variables_release(JThreadVariables* thread_variables)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlIterator* iter = ptr;
+	g_return_if_fail(thread_variables->users > 0);
+	g_return_if_fail(g_private_get(&thread_variables_global) == thread_variables);
 
-	if (ptr)
+	thread_variables->users--;
+
+	if (thread_variables->users == 0)
 	{
-		g_free(iter->namespace);
-		g_free(iter->name);
-		g_array_free(iter->arr, TRUE);
-		g_free(iter);
+		g_private_set(&thread_variables_global, NULL);
+
+		G_LOCK(sql_connections_lock);
+		g_queue_push_head(&sql_connections_idle, thread_variables);
+		G_UNLOCK(sql_connections_lock);
 	}
 }
 
@@ -218,35 +344,48 @@ freeJSqlCacheSQLQueries(void* ptr)
 	}
 }
 
+/**
+ * Frees the data describing a statement, which might be left over from a failed preparation.
+ **/
+static void
+clearJSqlCacheSQLPrepared(JSqlCacheSQLPrepared* p)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (p->variables_index)
+	{
+		g_hash_table_destroy(p->variables_index);
+		p->variables_index = NULL;
+	}
+
+	if (p->variables_types)
+	{
+		g_array_unref(p->variables_types);
+		p->variables_types = NULL;
+	}
+
+	if (p->sql)
+	{
+		g_string_free(p->sql, TRUE);
+		p->sql = NULL;
+	}
+}
+
 static void
 freeJSqlCacheSQLPrepared(void* ptr)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSqlCacheSQLPrepared* p = ptr;
-	JThreadVariables* thread_variables = NULL;
-
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(p->backend_data, NULL))))
-		g_assert_not_reached();
 
 	if (ptr)
 	{
-		if (p->initialized)
-		{
-			if (p->variables_index)
-			{
-				g_hash_table_destroy(p->variables_index);
-			}
-
-			if (p->sql)
-			{
-				g_string_free(p->sql, TRUE);
-			}
+		g_queue_unlink(&(p->connection->statements), &(p->link));
+		clearJSqlCacheSQLPrepared(p);
 
-			if (p->stmt)
-			{
-				j_sql_finalize(thread_variables->sql_backend, p->stmt, NULL);
-			}
+		if (p->initialized && p->stmt)
+		{
+			j_sql_finalize(p->connection->sql_backend, p->stmt, NULL);
 		}
 
 		g_free(p->namespace);
@@ -255,6 +394,19 @@ freeJSqlCacheSQLPrepared(void* ptr)
 	}
 }
 
+/**
+ * Prepares a statement and counts it in the statistics.
+ **/
+static gboolean
+sql_prepare(JThreadVariables* thread_variables, gchar const* sql, void* stmt, GArray* arr_types_in, GArray* arr_types_out, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_helper_atomic_add(&statistics_prepares, 1);
+
+	return j_sql_prepare(thread_variables->sql_backend, sql, stmt, arr_types_in, arr_types_out, error);
+}
+
 static JSqlCacheSQLQueries*
 _getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, GError** error)
 {
@@ -396,14 +548,20 @@ _error:
 	return NULL;
 }
 
+/**
+ * Returns the cached statement for key, creating an uninitialized entry if there is none.
+ * The least recently used statements are evicted if the cache is full.
+ **/
 static JSqlCacheSQLPrepared*
-getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, gchar const* query, GError** error)
+getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, gchar const* key, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSqlCacheSQLQueries* cacheQueries = NULL;
 	JSqlCacheSQLPrepared* cachePrepared = NULL;
 	JThreadVariables* thread_variables = NULL;
+	GList* iter;
+	GList* iter_prev;
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
@@ -415,17 +573,61 @@ getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* nam
 		goto _error;
 	}
 
-	if (!(cachePrepared = g_hash_table_lookup(cacheQueries->queries, query)))
+	if ((cachePrepared = g_hash_table_lookup(cacheQueries->queries, key)) != NULL)
+	{
+		g_queue_unlink(&(thread_variables->statements), &(cachePrepared->link));
+		g_queue_push_head_link(&(thread_variables->statements), &(cachePrepared->link));
+
+		if (!cachePrepared->initialized)
+		{
+			clearJSqlCacheSQLPrepared(cachePrepared);
+		}
+	}
+	else
 	{
+		gchar* key_copy;
+
 		cachePrepared = g_new0(JSqlCacheSQLPrepared, 1);
 		cachePrepared->namespace = g_strdup(namespace);
 		cachePrepared->name = g_strdup(name);
 		cachePrepared->backend_data = backend_data;
+		cachePrepared->connection = thread_variables;
+		cachePrepared->queries = cacheQueries->queries;
+		cachePrepared->key = key_copy = g_strdup(key);
+		cachePrepared->link.data = cachePrepared;
 
-		if (G_UNLIKELY(!g_hash_table_insert(cacheQueries->queries, g_strdup(query), cachePrepared)))
+		if (G_UNLIKELY(!g_hash_table_insert(cacheQueries->queries, key_copy, cachePrepared)))
 		{
 			g_assert_not_reached();
 		}
+
+		g_queue_push_head_link(&(thread_variables->statements), &(cachePrepared->link));
+
+		// Statements used by iterators are skipped, the new statement is at the head
+		for (iter = thread_variables->statements.tail; iter != &(cachePrepared->link) && thread_variables->statements.length > statement_cache_size; iter = iter_prev)
+		{
+			JSqlCacheSQLPrepared* evicted = iter->data;
+
+			iter_prev = iter->prev;
+
+			if (evicted->in_use)
+			{
+				continue;
+			}
+
+			// Also unlinks the statement
+			g_hash_table_remove(evicted->queries, evicted->key);
+			j_helper_atomic_add(&statistics_evictions, 1);
+		}
+	}
+
+	if (cachePrepared->initialized)
+	{
+		j_helper_atomic_add(&statistics_hits, 1);
+	}
+	else
+	{
+		j_helper_atomic_add(&statistics_misses, 1);
 	}
 
 	return cachePrepared;
@@ -434,6 +636,17 @@ _error:
 	return NULL;
 }
 
+/**
+ * Checks whether a statement's key contains the given join.
+ **/
+static gboolean
+matchCachePreparedJoin(gpointer key, gpointer value, gpointer user_data)
+{
+	(void)value;
+
+	return strstr(key, user_data) != NULL;
+}
+
 static void
 deleteCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name)
 {
@@ -441,6 +654,9 @@ deleteCachePrepared(gpointer backend_data, gchar const* namespace, gchar const*
 
 	JSqlCacheNames* cacheNames = NULL;
 	JThreadVariables* thread_variables = NULL;
+	GHashTableIter iter;
+	gpointer cacheQueries;
+	g_autofree gchar* join = NULL;
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, NULL))))
 	{
@@ -449,11 +665,26 @@ deleteCachePrepared(gpointer backend_data, gchar const* namespace, gchar const*
 
 	g_return_if_fail(thread_variables->namespaces != NULL);
 
+	// Other connections drop their caches before they are used next
+	if (g_atomic_int_add(&schema_generation, 1) == thread_variables->generation)
+	{
+		thread_variables->generation++;
+	}
+
 	if (G_UNLIKELY(!(cacheNames = g_hash_table_lookup(thread_variables->namespaces, namespace))))
 	{
 		goto _error;
 	}
 
+	// Queries joining the schema are cached with the joining schema, the join is part of their keys (see build_selector_key)
+	join = g_strdup_printf("7:_schema=%u:%s,", (guint)strlen(name), name);
+	g_hash_table_iter_init(&iter, cacheNames->names);
+
+	while (g_hash_table_iter_next(&iter, NULL, &cacheQueries))
+	{
+		g_hash_table_foreach_remove(((JSqlCacheSQLQueries*)cacheQueries)->queries, matchCachePreparedJoin, join);
+	}
+
 	g_hash_table_remove(cacheNames->names, name);
 
 	return;
@@ -468,6 +699,7 @@ _backend_batch_start(gpointer backend_data, JSqlBatch* batch, GError** error)
 	J_TRACE_FUNCTION(NULL);
 
 	JThreadVariables* thread_variables = NULL;
+	gint safety;
 
 	g_return_val_if_fail(!batch->open, FALSE);
 
@@ -476,6 +708,19 @@ _backend_batch_start(gpointer backend_data, JSqlBatch* batch, GError** error)
 		goto _error;
 	}
 
+	safety = j_semantics_get(batch->semantics, J_SEMANTICS_SAFETY);
+
+	// Connections are shared by batches with different semantics, only change the safety if it differs
+	if (thread_variables->safety != safety)
+	{
+		if (!j_sql_set_safety(thread_variables->sql_backend, safety, error))
+		{
+			goto _error;
+		}
+
+		thread_variables->safety = safety;
+	}
+
 	if (!j_sql_start_transaction(thread_variables->sql_backend, error))
 	{
 		goto _error;
@@ -566,6 +811,11 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 	batch->semantics = j_semantics_ref(semantics);
 	batch->open = FALSE;
 
+	if (G_UNLIKELY(!(batch->connection = thread_variables_acquire(backend_data, error))))
+	{
+		goto _error;
+	}
+
 	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
 	{
 		goto _error;
@@ -574,6 +824,11 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 	return TRUE;
 
 _error:
+	if (batch->connection != NULL)
+	{
+		thread_variables_release(batch->connection);
+	}
+
 	j_semantics_unref(batch->semantics);
 	g_free(batch);
 
@@ -597,6 +852,7 @@ backend_batch_execute(gpointer backend_data, gpointer _batch, GError** error)
 		goto _error;
 	}
 
+	thread_variables_release(batch->connection);
 	j_semantics_unref(batch->semantics);
 	g_free(batch);
 
@@ -606,6 +862,7 @@ backend_batch_execute(gpointer backend_data, gpointer _batch, GError** error)
 	return TRUE;
 
 _error:
+	thread_variables_release(batch->connection);
 	j_semantics_unref(batch->semantics);
 	g_free(batch);
 
@@ -665,7 +922,7 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 		type = J_DB_TYPE_UINT32;
 		g_array_append_val(arr_types_in, type);
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "INSERT INTO schema_structure(namespace, name, varname, vartype) VALUES (?, ?, ?, ?)", &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!sql_prepare(thread_variables, "INSERT INTO schema_structure(namespace, name, varname, vartype) VALUES (?, ?, ?, ?)", &prepared->stmt, arr_types_in, NULL, error)))
 		{
 			goto _error;
 		}
@@ -1028,7 +1285,7 @@ _backend_schema_get(gpointer backend_data, gpointer _batch, gchar const* name, b
 		type = J_DB_TYPE_UINT32;
 		g_array_append_val(arr_types_out, type);
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "SELECT varname, vartype FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, arr_types_out, error)))
+		if (G_UNLIKELY(!sql_prepare(thread_variables, "SELECT varname, vartype FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, arr_types_out, error)))
 		{
 			goto _error;
 		}
@@ -1178,7 +1435,7 @@ backend_schema_delete(gpointer backend_data, gpointer _batch, gchar const* name,
 		g_array_append_val(arr_types_in, type);
 		g_array_append_val(arr_types_in, type);
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "DELETE FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!sql_prepare(thread_variables, "DELETE FROM schema_structure WHERE namespace=? AND name=?", &prepared->stmt, arr_types_in, NULL, error)))
 		{
 			goto _error;
 		}
@@ -1247,82 +1504,43 @@ _error2:
 	return FALSE;
 }
 
-static gboolean
-backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+/**
+ * Returns the prepared statement inserting rows entries at once.
+ * The parameters of the i-th entry start at i * variables_count + 1.
+ **/
+static JSqlCacheSQLPrepared*
+getCacheInsert(gpointer backend_data, JSqlBatch* batch, gchar const* name, GHashTable* schema_cache, guint rows, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlBatch* batch = _batch;
-	guint i;
-	bson_iter_t iter;
-	gpointer type_tmp;
-	JDBType type;
 	GHashTableIter schema_iter;
-	GHashTable* schema_cache = NULL;
-	const char* string_tmp;
-	gboolean found;
 	JSqlCacheSQLPrepared* prepared = NULL;
-	JSqlCacheSQLPrepared* prepared_id = NULL;
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) id_arr_types_out = NULL;
-	gboolean has_next;
-	guint index;
-	guint count = 0;
-	JDBTypeValue value;
-
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
-	g_return_val_if_fail(metadata != NULL, FALSE);
-
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	id_arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	g_autoptr(GArray) arr_types_row = NULL;
+	g_autofree gchar* cache_key = NULL;
+	gpointer type_tmp;
+	JDBType type;
+	gchar* key;
+	guint i;
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_has_enough_keys(metadata, 1, error)))
-	{
-		goto _error;
-	}
-
-	prepared_id = getCachePrepared(backend_data, batch->namespace, name, "_insert_id", error);
-
-	if (G_UNLIKELY(!prepared_id))
-	{
-		goto _error;
-	}
-
-	if (!prepared_id->initialized)
-	{
-		type = J_DB_TYPE_UINT32;
-		g_array_append_val(id_arr_types_out, type);
-
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, SQL_LAST_INSERT_ID_STRING, &prepared_id->stmt, NULL, id_arr_types_out, error)))
-		{
-			goto _error;
-		}
-
-		prepared_id->initialized = TRUE;
-	}
-
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_insert", error);
+	cache_key = (rows == 1) ? g_strdup("_insert") : g_strdup_printf("_insert_%u", rows);
+	prepared = getCachePrepared(backend_data, batch->namespace, name, cache_key, error);
 
 	if (G_UNLIKELY(!prepared))
 	{
 		goto _error;
 	}
 
-	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
-	{
-		goto _error;
-	}
-
 	if (!prepared->initialized)
 	{
-		gchar* key;
+		arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		arr_types_row = g_array_new(FALSE, FALSE, sizeof(JDBType));
 
 		prepared->sql = g_string_new(NULL);
 		prepared->variables_count = 0;
@@ -1341,25 +1559,31 @@ backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 			prepared->variables_count++;
 			g_string_append_printf(prepared->sql, SQL_QUOTE "%s" SQL_QUOTE, key);
-			g_array_append_val(arr_types_in, type);
+			g_array_append_val(arr_types_row, type);
 			g_hash_table_insert(prepared->variables_index, g_strdup(key), GINT_TO_POINTER(prepared->variables_count));
 		}
 
-		g_string_append(prepared->sql, ") VALUES (");
+		g_string_append(prepared->sql, ") VALUES ");
 
-		if (prepared->variables_count)
+		for (guint row = 0; row < rows; row++)
 		{
-			g_string_append_printf(prepared->sql, " ?");
-		}
+			g_string_append(prepared->sql, (row > 0) ? ", (" : "(");
 
-		for (i = 1; i < prepared->variables_count; i++)
-		{
-			g_string_append_printf(prepared->sql, ", ?");
-		}
+			if (prepared->variables_count)
+			{
+				g_string_append_printf(prepared->sql, " ?");
+			}
+
+			for (i = 1; i < prepared->variables_count; i++)
+			{
+				g_string_append_printf(prepared->sql, ", ?");
+			}
 
-		g_string_append(prepared->sql, " )");
+			g_string_append(prepared->sql, " )");
+			g_array_append_vals(arr_types_in, arr_types_row->data, arr_types_row->len);
+		}
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!sql_prepare(thread_variables, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
 		{
 			goto _error;
 		}
@@ -1367,6 +1591,43 @@ backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		prepared->initialized = TRUE;
 	}
 
+	return prepared;
+
+_error:
+	return NULL;
+}
+
+/**
+ * Binds the values of metadata as the row-th entry of an insert statement.
+ **/
+static gboolean
+bind_insert_row(gpointer backend_data, JSqlCacheSQLPrepared* prepared, GHashTable* schema_cache, bson_t const* metadata, guint row, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JThreadVariables* thread_variables = NULL;
+	bson_iter_t iter;
+	gboolean has_next;
+	const char* string_tmp;
+	JDBTypeValue value;
+	JDBType type;
+	guint offset;
+	guint index;
+	guint count = 0;
+	guint i;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_has_enough_keys(metadata, 1, error)))
+	{
+		goto _error;
+	}
+
+	offset = row * prepared->variables_count;
+
 	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
 	{
 		goto _error;
@@ -1374,7 +1635,7 @@ backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 	for (i = 0; i < prepared->variables_count; i++)
 	{
-		if (G_UNLIKELY(!j_sql_bind_null(thread_variables->sql_backend, prepared->stmt, i + 1, error)))
+		if (G_UNLIKELY(!j_sql_bind_null(thread_variables->sql_backend, prepared->stmt, offset + i + 1, error)))
 		{
 			goto _error;
 		}
@@ -1415,7 +1676,7 @@ backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
+		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, offset + index, type, &value, error)))
 		{
 			goto _error;
 		}
@@ -1427,19 +1688,62 @@ backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
-	{
-		goto _error;
-	}
+	return TRUE;
 
-	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared_id->stmt, &found, error)))
-	{
-		goto _error;
-	}
+_error:
+	return FALSE;
+}
 
-	if (!found)
-	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+/**
+ * Returns the id generated by the last insert statement.
+ * Depending on SQL_LAST_INSERT_ID_FIRST_ROW, this is the id of the statement's first or last entry.
+ **/
+static gboolean
+get_last_insert_id(gpointer backend_data, JSqlBatch* batch, gchar const* name, guint32* id, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLPrepared* prepared_id = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) id_arr_types_out = NULL;
+	JDBTypeValue value;
+	JDBType type;
+	gboolean found;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	prepared_id = getCachePrepared(backend_data, batch->namespace, name, "_insert_id", error);
+
+	if (G_UNLIKELY(!prepared_id))
+	{
+		goto _error;
+	}
+
+	if (!prepared_id->initialized)
+	{
+		id_arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(id_arr_types_out, type);
+
+		if (G_UNLIKELY(!sql_prepare(thread_variables, SQL_LAST_INSERT_ID_STRING, &prepared_id->stmt, NULL, id_arr_types_out, error)))
+		{
+			goto _error;
+		}
+
+		prepared_id->initialized = TRUE;
+	}
+
+	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared_id->stmt, &found, error)))
+	{
+		goto _error;
+	}
+
+	if (!found)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
 		goto _error;
 	}
 
@@ -1453,18 +1757,192 @@ backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_append_value(id, "_value", J_DB_TYPE_UINT32, &value, error)))
+	*id = value.val_uint32;
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+append_insert_id(bson_t* id, guint32 value, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBTypeValue val;
+
+	val.val_uint32 = value;
+
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	val.val_uint32 = J_DB_TYPE_UINT32;
+
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value_type", J_DB_TYPE_UINT32, &val, error)))
 	{
 		goto _error;
 	}
 
-	value.val_uint32 = J_DB_TYPE_UINT32;
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlBatch* batch = _batch;
+	GHashTable* schema_cache = NULL;
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+	guint32 value;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!(prepared = getCacheInsert(backend_data, batch, name, schema_cache, 1, error))))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!bind_insert_row(backend_data, prepared, schema_cache, metadata, 0, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!get_last_insert_id(backend_data, batch, name, &value, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!append_insert_id(id, value, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
+}
+
+static gboolean
+backend_insert_many(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* const* metadata, bson_t* ids, guint count, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlBatch* batch = _batch;
+	GHashTable* schema_cache = NULL;
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+	guint rows_max;
+	guint32 value;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(ids != NULL, FALSE);
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
 
-	if (G_UNLIKELY(!j_bson_append_value(id, "_value_type", J_DB_TYPE_UINT32, &value, error)))
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
+	// Each statement must not exceed the database's limit of parameters
+	rows_max = MAX(1, MIN(SQL_INSERT_ROWS_MAX, SQL_VARIABLES_MAX / MAX(1, g_hash_table_size(schema_cache))));
+
+	// The ids of a multi-row INSERT can only be derived from the last insert id if they are consecutive
+	if (!SQL_INSERT_IDS_CONSECUTIVE)
+	{
+		rows_max = 1;
+	}
+
+	for (guint i = 0; i < count;)
+	{
+		guint rows = 1;
+
+		// Only statements for powers of two are prepared to keep the number of cached statements small
+		while (rows * 2 <= MIN(rows_max, count - i))
+		{
+			rows *= 2;
+		}
+
+		if (G_UNLIKELY(!(prepared = getCacheInsert(backend_data, batch, name, schema_cache, rows, error))))
+		{
+			goto _error;
+		}
+
+		for (guint row = 0; row < rows; row++)
+		{
+			if (G_UNLIKELY(!bind_insert_row(backend_data, prepared, schema_cache, metadata[i + row], row, error)))
+			{
+				goto _error;
+			}
+		}
+
+		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!get_last_insert_id(backend_data, batch, name, &value, error)))
+		{
+			goto _error;
+		}
+
+		// A single statement generates consecutive ids
+		if (!SQL_LAST_INSERT_ID_FIRST_ROW)
+		{
+			value -= rows - 1;
+		}
+
+		for (guint row = 0; row < rows; row++)
+		{
+			if (G_UNLIKELY(!append_insert_id(&ids[i + row], value + row, error)))
+			{
+				goto _error;
+			}
+		}
+
+		i += rows;
+	}
+
 	return TRUE;
 
 _error:
@@ -1481,12 +1959,12 @@ _error2:
 }
 
 static gboolean
-build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDBSelectorMode mode, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
+build_selector_query(gpointer backend_data, bson_iter_t* iter, gchar const* table, GString* sql, JDBSelectorMode mode, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JDBSelectorMode mode_child;
-	gboolean equals;
+	gboolean reserved;
 	gboolean has_next;
 	JDBSelectorOperator op;
 	gboolean first = TRUE;
@@ -1515,12 +1993,12 @@ build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDB
 			break;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		if (G_UNLIKELY(!j_bson_iter_key_reserved(iter, &reserved, error)))
 		{
 			goto _error;
 		}
 
-		if (equals)
+		if (reserved)
 		{
 			continue;
 		}
@@ -1562,7 +2040,7 @@ build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDB
 				goto _error;
 			}
 
-			if (G_UNLIKELY(!build_selector_query(backend_data, &iterchild, sql, mode_child, variables_count, arr_types_in, schema_cache, error)))
+			if (G_UNLIKELY(!build_selector_query(backend_data, &iterchild, table, sql, mode_child, variables_count, arr_types_in, schema_cache, error)))
 			{
 				goto _error;
 			}
@@ -1585,6 +2063,13 @@ build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDB
 			}
 
 			string_tmp = value.val_string;
+
+			// Columns are qualified by their table if the query joins other tables
+			if (table != NULL)
+			{
+				g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE ".", table);
+			}
+
 			g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " ", string_tmp);
 
 			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
@@ -1671,7 +2156,7 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 	JDBTypeValue value;
 	JDBType type;
 	gboolean has_next;
-	gboolean equals;
+	gboolean reserved;
 	JThreadVariables* thread_variables = NULL;
 	char const* string_tmp;
 
@@ -1692,12 +2177,12 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 			break;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		if (G_UNLIKELY(!j_bson_iter_key_reserved(iter, &reserved, error)))
 		{
 			goto _error;
 		}
 
-		if (equals)
+		if (reserved)
 		{
 			continue;
 		}
@@ -1769,195 +2254,403 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 _error:
 	return FALSE;
 }
+/**
+ * Translates a selector into a WHERE clause.
+ *
+ * \param backend_data     The backend data.
+ * \param selector         The selector, may be NULL.
+ * \param table            The table qualifying the selector's columns, NULL if the statement only uses a single table.
+ * \param sql              The SQL statement to append to.
+ * \param variables_count  The number of variables preceding the selector's variables, returns the total number of variables.
+ * \param arr_types_in     The variables' types.
+ * \param schema_cache     The schema cache.
+ * \param error            A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
 static gboolean
-_backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
+build_selector_where(gpointer backend_data, bson_t const* selector, gchar const* table, GString* sql, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JDBSelectorMode mode_child;
-	JSqlBatch* batch = _batch;
-	gboolean sql_found;
 	JDBTypeValue value;
-	guint count = 0;
 	bson_iter_t iter;
-	guint variables_count;
-	JSqlCacheSQLPrepared* prepared = NULL;
-	GString* sql = g_string_new(NULL);
-	JSqlIterator* iteratorOut = NULL;
-	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) arr_types_out = NULL;
-	JDBType type;
-	GHashTable* schema_cache = NULL;
 
-	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	if (!j_bson_selector_has_conditions(selector))
 	{
-		goto _error;
+		return TRUE;
 	}
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_out, type);
+	g_string_append(sql, " WHERE ");
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 	{
 		goto _error;
 	}
 
-	*iterator = NULL;
-	iteratorOut = g_new(JSqlIterator, 1);
-	iteratorOut->namespace = g_strdup(batch->namespace);
-	iteratorOut->name = g_strdup(name);
-	iteratorOut->index = 0;
-	iteratorOut->arr = g_array_new(FALSE, FALSE, sizeof(guint64));
-
-	g_string_append_printf(sql, "SELECT DISTINCT _id FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
+	{
+		goto _error;
+	}
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
 	{
-		g_string_append(sql, " WHERE ");
+		goto _error;
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
+	mode_child = value.val_uint32;
 
-		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
-		{
-			goto _error;
-		}
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		goto _error;
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
-		{
-			goto _error;
-		}
+	if (G_UNLIKELY(!build_selector_query(backend_data, &iter, table, sql, mode_child, variables_count, arr_types_in, schema_cache, error)))
+	{
+		goto _error;
+	}
 
-		mode_child = value.val_uint32;
+	return TRUE;
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
+_error:
+	return FALSE;
+}
 
-		variables_count = 0;
+/**
+ * Binds a selector's variables.
+ *
+ * \param backend_data    The backend data.
+ * \param selector        The selector, may be NULL.
+ * \param prepared        The prepared statement.
+ * \param variables_count The number of variables preceding the selector's variables, returns the total number of variables.
+ * \param schema_cache    The schema cache.
+ * \param error           A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+bind_selector_where(gpointer backend_data, bson_t const* selector, JSqlCacheSQLPrepared* prepared, guint* variables_count, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count, arr_types_in, schema_cache, error)))
-		{
-			goto _error;
-		}
-	}
+	bson_iter_t iter;
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
+	if (!j_bson_selector_has_conditions(selector))
+	{
+		return TRUE;
+	}
 
-	if (G_UNLIKELY(!prepared))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 	{
 		goto _error;
 	}
 
-	if (!prepared->initialized)
+	if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, variables_count, schema_cache, error)))
 	{
-		prepared->sql = g_string_new(sql->str);
-		prepared->variables_count = variables_count;
+		goto _error;
+	}
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
-		{
-			goto _error;
-		}
+	return TRUE;
 
-		prepared->initialized = TRUE;
-	}
+_error:
+	return FALSE;
+}
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
-	{
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
+/**
+ * Appends a selector's ORDER BY, LIMIT and OFFSET clauses.
+ * Limit and offset are bound as variables, so that paging through results reuses the statement.
+ *
+ * \param selector        The selector, may be NULL.
+ * \param table           The table qualifying the sort keys, NULL if the statement only uses a single table.
+ * \param sql             The SQL statement to append to.
+ * \param grouped         Whether the statement groups its results.
+ * \param variables_count The number of variables preceding the limit, returns the total number of variables.
+ * \param arr_types_in    The variables' types.
+ * \param schema_cache    The schema cache.
+ * \param error           A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+build_selector_order(bson_t const* selector, gchar const* table, GString* sql, gboolean grouped, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		variables_count = 0;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	bson_iter_t iter_sort;
+	gboolean has_next;
+	gboolean first = TRUE;
+	JDBTypeValue value;
+	JDBType type;
+	gchar const* name;
 
-		if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &variables_count, schema_cache, error)))
-		{
-			goto _error;
-		}
+	if (selector == NULL)
+	{
+		return TRUE;
 	}
 
-	while (TRUE)
+	if (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_order", NULL))
 	{
-		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
 		{
 			goto _error;
 		}
 
-		if (!sql_found)
+		while (TRUE)
 		{
-			break;
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_sort, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iter_sort, "_name", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_sort, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			name = value.val_string;
+
+			if (G_UNLIKELY(!g_hash_table_contains(schema_cache, name)))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_sort, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iter_sort, "_order", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_sort, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			g_string_append(sql, first ? " ORDER BY " : ", ");
+
+			if (table != NULL)
+			{
+				g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE ".", table);
+			}
+
+			g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE "%s", name, (value.val_uint32 == J_DB_SELECTOR_ORDER_DESCENDING) ? " DESC" : " ASC");
+			first = FALSE;
 		}
-		count++;
 
-		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
+		// Entries with equal sort keys are returned in insertion order, which keeps pages stable
+		if (!first && !grouped)
 		{
-			goto _error;
+			if (table != NULL)
+			{
+				g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE "._id ASC", table);
+			}
+			else
+			{
+				g_string_append(sql, ", _id ASC");
+			}
 		}
+	}
 
-		g_array_append_val(iteratorOut->arr, value.val_uint32);
+	if (bson_has_field(selector, "_limit") || bson_has_field(selector, "_offset"))
+	{
+		g_string_append(sql, " LIMIT ? OFFSET ?");
+		type = J_DB_TYPE_SINT64;
+		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_in, type);
+		*variables_count += 2;
 	}
 
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Binds a selector's limit and offset.
+ *
+ * \param backend_data    The backend data.
+ * \param selector        The selector, may be NULL.
+ * \param prepared        The prepared statement.
+ * \param variables_count The number of variables preceding the limit.
+ * \param error           A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+bind_selector_limit(gpointer backend_data, bson_t const* selector, JSqlCacheSQLPrepared* prepared, guint variables_count, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	JDBTypeValue limit;
+	JDBTypeValue offset;
+	JThreadVariables* thread_variables = NULL;
+
+	if (selector == NULL || (!bson_has_field(selector, "_limit") && !bson_has_field(selector, "_offset")))
+	{
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (!count)
+	// A missing limit returns all remaining results
+	limit.val_sint64 = G_MAXINT64;
+	offset.val_sint64 = 0;
+
+	if (bson_iter_init_find(&iter, selector, "_limit") && G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_SINT64, &limit, error)))
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
 		goto _error;
 	}
 
-	if (sql)
+	if (bson_iter_init_find(&iter, selector, "_offset") && G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_SINT64, &offset, error)))
 	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, variables_count + 1, J_DB_TYPE_SINT64, &limit, error)))
+	{
+		goto _error;
 	}
 
-	*iterator = iteratorOut;
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, variables_count + 2, J_DB_TYPE_SINT64, &offset, error)))
+	{
+		goto _error;
+	}
 
 	return TRUE;
 
 _error:
-	if (sql)
+	return FALSE;
+}
+
+/**
+ * Appends a name to a statement cache key.
+ * Names are prefixed with their length to keep keys unambiguous.
+ **/
+static void
+build_key_name(GString* key, gchar const* name)
+{
+	g_string_append_printf(key, "%" G_GSIZE_FORMAT ":%s", strlen(name), name);
+}
+
+static void
+build_selector_key_iter(bson_iter_t* iter, GString* key)
+{
+	bson_iter_t iter_child;
+	gchar const* string_tmp;
+	guint32 length;
+
+	while (bson_iter_next(iter))
 	{
-		g_string_free(sql, TRUE);
+		build_key_name(key, bson_iter_key(iter));
+
+		// Values, limits and offsets are bound as parameters and do not change the statement
+		if (strcmp(bson_iter_key(iter), "_value") == 0 || strcmp(bson_iter_key(iter), "_limit") == 0 || strcmp(bson_iter_key(iter), "_offset") == 0)
+		{
+			g_string_append_c(key, ',');
+			continue;
+		}
+
+		switch (bson_iter_type(iter))
+		{
+			case BSON_TYPE_DOCUMENT:
+			case BSON_TYPE_ARRAY:
+				if (bson_iter_recurse(iter, &iter_child))
+				{
+					g_string_append_c(key, '{');
+					build_selector_key_iter(&iter_child, key);
+					g_string_append_c(key, '}');
+				}
+				break;
+			case BSON_TYPE_UTF8:
+				string_tmp = bson_iter_utf8(iter, &length);
+				g_string_append_printf(key, "=%u:", length);
+				g_string_append_len(key, string_tmp, length);
+				break;
+			case BSON_TYPE_INT32:
+				g_string_append_printf(key, "=%d", bson_iter_int32(iter));
+				break;
+			case BSON_TYPE_INT64:
+				g_string_append_printf(key, "=%" G_GINT64_FORMAT, bson_iter_int64(iter));
+				break;
+			case BSON_TYPE_BOOL:
+				g_string_append_printf(key, "=%d", bson_iter_bool(iter));
+				break;
+			default:
+				g_string_append_printf(key, "=t%d", bson_iter_type(iter));
+				break;
+		}
+
+		g_string_append_c(key, ',');
 	}
+}
 
-	freeJSqlIterator(iteratorOut);
+/**
+ * Appends the structure of a selector to a statement cache key.
+ * The values compared against are omitted, so that all selectors of the same shape share a prepared statement.
+ *
+ * \param selector The selector, may be NULL.
+ * \param key      The key to append to.
+ **/
+static void
+build_selector_key(bson_t const* selector, GString* key)
+{
+	bson_iter_t iter;
 
-	return FALSE;
+	if (selector != NULL && bson_iter_init(&iter, selector))
+	{
+		build_selector_key_iter(&iter, key);
+	}
 }
+
 static gboolean
-backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
+backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* metadata, guint64* count, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSqlBatch* batch = _batch;
-	guint count;
 	gboolean equals;
 	JDBType type;
 	JDBTypeValue value;
-	JSqlIterator* iterator = NULL;
 	guint variables_count;
+	guint64 changes;
 	bson_iter_t iter;
 	guint index;
-	guint j;
 	GHashTable* schema_cache = NULL;
 	const char* string_tmp;
 	gboolean has_next;
-	GString* sql = g_string_new(NULL);
+	GString* sql = NULL;
 	JSqlCacheSQLPrepared* prepared = NULL;
 	GHashTable* variables_index = NULL;
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
+	g_autoptr(GString) key = NULL;
 
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
@@ -1969,21 +2662,18 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		goto _error;
 	}
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_has_enough_keys(selector, 2, error)))
+	if (G_UNLIKELY(!j_bson_selector_check_modify(selector, TRUE, error)))
 	{
 		goto _error;
 	}
 
-	variables_count = 0;
-	variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-	g_string_append_printf(sql, "UPDATE " SQL_QUOTE "%s_%s" SQL_QUOTE " SET ", batch->namespace, name);
+	// The statement only depends on the updated fields and the selector's structure
+	key = g_string_new("UPDATE ");
 
 	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
 	{
@@ -2002,56 +2692,92 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 			break;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+		build_key_name(key, bson_iter_key(&iter));
+	}
+
+	g_string_append(key, " WHERE ");
+	build_selector_key(selector, key);
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, key->str, error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		sql = g_string_new(NULL);
+		variables_count = 0;
+		variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		g_string_append_printf(sql, "UPDATE " SQL_QUOTE "%s_%s" SQL_QUOTE " SET ", batch->namespace, name);
+
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
 		{
 			goto _error;
 		}
 
-		if (equals)
+		while (TRUE)
 		{
-			continue;
+			if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+			{
+				goto _error;
+			}
+
+			if (equals)
+			{
+				continue;
+			}
+
+			if (variables_count)
+			{
+				g_string_append(sql, ", ");
+			}
+
+			variables_count++;
+			string_tmp = j_bson_iter_key(&iter, error);
+
+			if (G_UNLIKELY(!string_tmp))
+			{
+				goto _error;
+			}
+
+			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+			g_array_append_val(arr_types_in, type);
+			g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " = ?", string_tmp);
+			g_hash_table_insert(variables_index, g_strdup(string_tmp), GINT_TO_POINTER(variables_count));
 		}
 
-		if (variables_count)
+		if (!variables_count)
 		{
-			g_string_append(sql, ", ");
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+			goto _error;
 		}
 
-		variables_count++;
-		string_tmp = j_bson_iter_key(&iter, error);
-
-		if (G_UNLIKELY(!string_tmp))
+		// The selector's variables follow the updated fields
+		if (G_UNLIKELY(!build_selector_where(backend_data, selector, NULL, sql, &variables_count, arr_types_in, schema_cache, error)))
 		{
 			goto _error;
 		}
 
-		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-		g_array_append_val(arr_types_in, type);
-		g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " = ?", string_tmp);
-		g_hash_table_insert(variables_index, g_strdup(string_tmp), GINT_TO_POINTER(variables_count));
-	}
-
-	variables_count++;
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_in, type);
-	g_string_append_printf(sql, " WHERE _id = ?");
-	g_hash_table_insert(variables_index, g_strdup("_id"), GINT_TO_POINTER(variables_count));
-	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
-
-	if (G_UNLIKELY(!prepared))
-	{
-		goto _error;
-	}
-
-	if (!prepared->initialized)
-	{
 		prepared->sql = sql;
 		sql = NULL;
 		prepared->variables_count = variables_count;
 		prepared->variables_index = variables_index;
 		variables_index = NULL;
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!sql_prepare(thread_variables, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
 		{
 			goto _error;
 		}
@@ -2059,207 +2785,673 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		prepared->initialized = TRUE;
 	}
 
-	if (G_UNLIKELY(!_backend_query(backend_data, batch, name, selector, (gpointer*)&iterator, error)))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
 	{
 		goto _error;
 	}
 
-	for (j = 0; j < iterator->arr->len; j++)
+	while (TRUE)
 	{
-		count = 0;
-		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, "_id"));
-
-		if (G_UNLIKELY(!index))
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
 		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
 			goto _error;
 		}
 
-		value.val_uint32 = g_array_index(iterator->arr, guint64, j);
-
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, J_DB_TYPE_UINT32, &value, error)))
+		if (!has_next)
 		{
-			goto _error;
+			break;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
 		{
 			goto _error;
 		}
 
-		while (TRUE)
+		if (equals)
 		{
-			if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
-			{
-				goto _error;
-			}
+			continue;
+		}
 
-			if (!has_next)
-			{
+		string_tmp = j_bson_iter_key(&iter, error);
+
+		if (G_UNLIKELY(!string_tmp))
+		{
+			goto _error;
+		}
+
+		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+
+		if (G_UNLIKELY(!index))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
+		{
+			goto _error;
+		}
+	}
+
+	variables_count = g_hash_table_size(prepared->variables_index);
+
+	if (G_UNLIKELY(!bind_selector_where(backend_data, selector, prepared, &variables_count, schema_cache, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	changes = j_sql_changes(thread_variables->sql_backend, prepared->stmt);
+	*count = changes;
+
+	if (!changes)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+		sql = NULL;
+	}
+
+	if (variables_index)
+		g_hash_table_destroy(variables_index);
+
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, guint64* count, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlBatch* batch = _batch;
+	guint variables_count;
+	guint64 changes;
+	GHashTable* schema_cache = NULL;
+	GString* sql = NULL;
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_in = NULL;
+	g_autoptr(GString) key = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_selector_check_modify(selector, FALSE, error)))
+	{
+		goto _error;
+	}
+
+	key = g_string_new("DELETE WHERE ");
+	build_selector_key(selector, key);
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, key->str, error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		sql = g_string_new(NULL);
+		variables_count = 0;
+		g_string_append_printf(sql, "DELETE FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+
+		if (G_UNLIKELY(!build_selector_where(backend_data, selector, NULL, sql, &variables_count, arr_types_in, schema_cache, error)))
+		{
+			goto _error;
+		}
+
+		prepared->sql = sql;
+		sql = NULL;
+		prepared->variables_count = variables_count;
+
+		if (G_UNLIKELY(!sql_prepare(thread_variables, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		{
+			goto _error;
+		}
+
+		prepared->initialized = TRUE;
+	}
+
+	variables_count = 0;
+
+	if (G_UNLIKELY(!bind_selector_where(backend_data, selector, prepared, &variables_count, schema_cache, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	changes = j_sql_changes(thread_variables->sql_backend, prepared->stmt);
+	*count = changes;
+
+	if (!changes)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+	}
+
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
+}
+
+/**
+ * Appends the grouping columns and aggregates of selector to sql.
+ * The grouping columns are also appended to sql_group_by as a GROUP BY clause.
+ **/
+static gboolean
+build_aggregate_columns(bson_t const* selector, GString* sql, GString* sql_group_by, GHashTable* variables_index, GArray* arr_types_out, guint* variables_count, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	bson_iter_t iter_aggregate;
+	gboolean has_next;
+	gboolean first = TRUE;
+	gpointer type_tmp;
+	JDBType type;
+	JDBTypeValue value;
+	JDBAggregateFunction function;
+	const char* field;
+	guint i;
+
+	if (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_group_by", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+		{
+			goto _error;
+		}
+
+		while (TRUE)
+		{
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
 				break;
 			}
 
-			string_tmp = j_bson_iter_key(&iter, error);
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_child, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
 
-			if (G_UNLIKELY(!string_tmp))
+			if (G_UNLIKELY(!g_hash_table_lookup_extended(schema_cache, value.val_string, NULL, &type_tmp)))
 			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
 				goto _error;
 			}
 
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-			index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+			type = GPOINTER_TO_INT(type_tmp);
+
+			g_string_append_printf(sql, "%s" SQL_QUOTE "%s" SQL_QUOTE, first ? "" : ", ", value.val_string);
+			g_string_append_printf(sql_group_by, "%s" SQL_QUOTE "%s" SQL_QUOTE, first ? " GROUP BY " : ", ", value.val_string);
+			g_hash_table_insert(variables_index, GINT_TO_POINTER(*variables_count), g_strdup(value.val_string));
+			g_array_append_val(arr_types_out, type);
+			(*variables_count)++;
+			first = FALSE;
+		}
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_aggregate", error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+	{
+		goto _error;
+	}
+
+	for (i = 0;; i++)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_aggregate, error)))
+		{
+			goto _error;
+		}
+
+		function = J_DB_AGGREGATE_COUNT;
+		field = NULL;
+		type = J_DB_TYPE_UINT64;
+
+		while (TRUE)
+		{
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_aggregate, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (g_strcmp0(j_bson_iter_key(&iter_aggregate, NULL), "_function") == 0)
+			{
+				if (G_UNLIKELY(!j_bson_iter_value(&iter_aggregate, J_DB_TYPE_UINT32, &value, error)))
+				{
+					goto _error;
+				}
+
+				function = value.val_uint32;
+			}
+			else if (g_strcmp0(j_bson_iter_key(&iter_aggregate, NULL), "_name") == 0)
+			{
+				if (G_UNLIKELY(!j_bson_iter_value(&iter_aggregate, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto _error;
+				}
+
+				field = value.val_string;
+			}
+			else if (g_strcmp0(j_bson_iter_key(&iter_aggregate, NULL), "_result_type") == 0)
+			{
+				if (G_UNLIKELY(!j_bson_iter_value(&iter_aggregate, J_DB_TYPE_UINT32, &value, error)))
+				{
+					goto _error;
+				}
+
+				type = value.val_uint32;
+			}
+		}
+
+		if (field != NULL && G_UNLIKELY(!g_hash_table_contains(schema_cache, field)))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		if (!first)
+		{
+			g_string_append(sql, ", ");
+		}
+
+		switch (function)
+		{
+			case J_DB_AGGREGATE_COUNT:
+				g_string_append(sql, "COUNT");
+				break;
+			case J_DB_AGGREGATE_MIN:
+				g_string_append(sql, "MIN");
+				break;
+			case J_DB_AGGREGATE_MAX:
+				g_string_append(sql, "MAX");
+				break;
+			case J_DB_AGGREGATE_SUM:
+				g_string_append(sql, "SUM");
+				break;
+			default:
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+				goto _error;
+		}
+
+		if (field != NULL)
+		{
+			g_string_append_printf(sql, "(" SQL_QUOTE "%s" SQL_QUOTE ")", field);
+		}
+		else if (G_LIKELY(function == J_DB_AGGREGATE_COUNT))
+		{
+			g_string_append(sql, "(*)");
+		}
+		else
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		g_hash_table_insert(variables_index, GINT_TO_POINTER(*variables_count), g_strdup_printf("_aggregate_%u", i));
+		g_array_append_val(arr_types_out, type);
+		(*variables_count)++;
+		first = FALSE;
+	}
+
+	if (G_UNLIKELY(first))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "selector empty");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Appends a joined column to a query's columns.
+ **/
+static void
+build_join_column(GString* sql, gchar const* table, gchar const* schema, gchar const* field, JDBType type, GHashTable* variables_index, GArray* arr_types_out, guint* variables_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE "." SQL_QUOTE "%s" SQL_QUOTE, table, field);
+	g_hash_table_insert(variables_index, GINT_TO_POINTER(*variables_count), g_strdup_printf("%s.%s", schema, field));
+	g_array_append_val(arr_types_out, type);
+	(*variables_count)++;
+}
+
+/**
+ * Appends the columns and JOIN clauses of a query's joins.
+ * The conditions of the joined selectors are part of the JOIN clauses, their variables therefore precede the WHERE clause's variables.
+ *
+ * \param backend_data       The backend data.
+ * \param batch              The batch.
+ * \param selector           The selector containing the joins.
+ * \param table              The table of the selector's schema.
+ * \param sql                The columns to append to.
+ * \param sql_join           The JOIN clauses to append to.
+ * \param variables_index    The result columns' names.
+ * \param arr_types_out      The result columns' types.
+ * \param variables_count    The number of result columns.
+ * \param variables_count_in The number of variables.
+ * \param arr_types_in       The variables' types.
+ * \param schema_cache       The schema cache of the selector's schema.
+ * \param error              A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+build_selector_joins(gpointer backend_data, JSqlBatch* batch, bson_t const* selector, gchar const* table, GString* sql, GString* sql_join, GHashTable* variables_index, GArray* arr_types_out, guint* variables_count, guint* variables_count_in, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GHashTableIter schema_iter;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	gboolean has_next;
+	JBsonJoin join;
+	JDBTypeValue value;
+	gpointer type_tmp;
+	gchar* string_tmp;
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_join", error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		g_autofree gchar* join_table = NULL;
+		GHashTable* join_cache;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_selector_join(&iter_child, &join, error)))
+		{
+			goto _error;
+		}
+
+		if (!(join_cache = getCacheSchema(backend_data, batch, join.schema, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY((strcmp(join.name, "_id") != 0 && !g_hash_table_contains(schema_cache, join.name)) || (strcmp(join.join_name, "_id") != 0 && !g_hash_table_contains(join_cache, join.join_name))))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		join_table = g_strdup_printf("%s_%s", batch->namespace, join.schema);
+
+		build_join_column(sql, join_table, join.schema, "_id", J_DB_TYPE_UINT32, variables_index, arr_types_out, variables_count);
+
+		if (join.has_fields)
+		{
+			while (TRUE)
+			{
+				if (G_UNLIKELY(!j_bson_iter_next(&join.fields, &has_next, error)))
+				{
+					goto _error;
+				}
+
+				if (!has_next)
+				{
+					break;
+				}
+
+				if (G_UNLIKELY(!j_bson_iter_value(&join.fields, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto _error;
+				}
+
+				if (strcmp(value.val_string, "_id") == 0)
+				{
+					continue;
+				}
+
+				if (G_UNLIKELY(!g_hash_table_lookup_extended(join_cache, value.val_string, NULL, &type_tmp)))
+				{
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+					goto _error;
+				}
+
+				build_join_column(sql, join_table, join.schema, value.val_string, GPOINTER_TO_INT(type_tmp), variables_index, arr_types_out, variables_count);
+			}
+		}
+		else
+		{
+			g_hash_table_iter_init(&schema_iter, join_cache);
+
+			while (g_hash_table_iter_next(&schema_iter, (gpointer*)&string_tmp, &type_tmp))
+			{
+				if (strcmp(string_tmp, "_id") == 0)
+				{
+					continue;
+				}
+
+				build_join_column(sql, join_table, join.schema, string_tmp, GPOINTER_TO_INT(type_tmp), variables_index, arr_types_out, variables_count);
+			}
+		}
+
+		g_string_append_printf(sql_join, " JOIN " SQL_QUOTE "%s" SQL_QUOTE " ON " SQL_QUOTE "%s" SQL_QUOTE "." SQL_QUOTE "%s" SQL_QUOTE " = " SQL_QUOTE "%s" SQL_QUOTE "." SQL_QUOTE "%s" SQL_QUOTE, join_table, table, join.name, join_table, join.join_name);
+
+		if (join.has_selector && j_bson_selector_has_conditions(&join.selector))
+		{
+			if (G_UNLIKELY(!j_bson_iter_init(&iter, &join.selector, error)))
+			{
+				goto _error;
+			}
 
-			if (G_UNLIKELY(!index))
+			if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
 			{
-				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
 				goto _error;
 			}
 
-			count++;
-
-			if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
+			if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
 			{
 				goto _error;
 			}
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
+			if (G_UNLIKELY(!j_bson_iter_init(&iter, &join.selector, error)))
 			{
 				goto _error;
 			}
-		}
 
-		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
-		{
-			goto _error;
-		}
+			g_string_append(sql_join, " AND ");
 
-		if (!count)
-		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-			goto _error;
+			if (G_UNLIKELY(!build_selector_query(backend_data, &iter, join_table, sql_join, value.val_uint32, variables_count_in, arr_types_in, join_cache, error)))
+			{
+				goto _error;
+			}
 		}
 	}
 
-	if (sql)
-	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
-	}
-
-	if (variables_index)
-		g_hash_table_destroy(variables_index);
-
-	freeJSqlIterator(iterator);
-
 	return TRUE;
 
 _error:
-	if (sql)
-	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
-	}
-
-	if (variables_index)
-		g_hash_table_destroy(variables_index);
-
-	freeJSqlIterator(iterator);
-
-	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
-	{
-		goto _error2;
-	}
-
-	return FALSE;
-
-_error2:
-	/*something failed very hard*/
 	return FALSE;
 }
 
+/**
+ * Binds the variables of a query's joins.
+ *
+ * \param backend_data    The backend data.
+ * \param batch           The batch.
+ * \param selector        The selector containing the joins.
+ * \param prepared        The prepared statement.
+ * \param variables_count The number of variables preceding the joins' variables, returns the total number of variables.
+ * \param error           A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
 static gboolean
-backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, GError** error)
+bind_selector_joins(gpointer backend_data, JSqlBatch* batch, bson_t const* selector, JSqlCacheSQLPrepared* prepared, guint* variables_count, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBType type;
-	JSqlBatch* batch = _batch;
-	JSqlIterator* iterator = NULL;
-	guint j;
-	JDBTypeValue value;
-	JSqlCacheSQLPrepared* prepared = NULL;
-	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
-
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
-
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_in, type);
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	gboolean has_next;
+	JBsonJoin join;
+	GHashTable* schema_cache;
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!_backend_query(backend_data, batch, name, selector, (gpointer*)&iterator, error)))
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_join", error)))
 	{
 		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_delete", error);
-
-	if (G_UNLIKELY(!prepared))
+	if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
 	{
 		goto _error;
 	}
 
-	if (!prepared->initialized)
+	while (TRUE)
 	{
-		prepared->sql = g_string_new(NULL);
-		prepared->variables_count = 1;
-		g_string_append_printf(prepared->sql, "DELETE FROM " SQL_QUOTE "%s_%s" SQL_QUOTE " WHERE _id = ?", batch->namespace, name);
-
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
 		{
 			goto _error;
 		}
 
-		prepared->initialized = TRUE;
-	}
+		if (!has_next)
+		{
+			break;
+		}
 
-	for (j = 0; j < iterator->arr->len; j++)
-	{
-		value.val_uint32 = g_array_index(iterator->arr, guint64, j);
+		if (G_UNLIKELY(!j_bson_selector_join(&iter_child, &join, error)))
+		{
+			goto _error;
+		}
+
+		if (!join.has_selector)
+		{
+			continue;
+		}
 
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_UINT32, &value, error)))
+		if (!(schema_cache = getCacheSchema(backend_data, batch, join.schema, error)))
 		{
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+		if (G_UNLIKELY(!bind_selector_where(backend_data, &join.selector, prepared, variables_count, schema_cache, error)))
 		{
 			goto _error;
 		}
 	}
 
-	freeJSqlIterator(iterator);
-
 	return TRUE;
 
 _error:
-	freeJSqlIterator(iterator);
-
-	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
-	{
-		goto _error2;
-	}
-
-	return FALSE;
-
-_error2:
-	/*something failed very hard*/
 	return FALSE;
 }
 
@@ -2268,22 +3460,28 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBSelectorMode mode_child;
 	GHashTableIter schema_iter;
 
 	GHashTable* schema_cache = NULL;
 	JDBType type;
+	JDBTypeValue value;
 	gpointer type_tmp;
+	bson_iter_t iter;
+	bson_iter_t iter_fields;
+	gboolean has_next;
 
 	JSqlBatch* batch = _batch;
-	bson_iter_t iter;
 	guint variables_count;
 	guint variables_count2;
-	JDBTypeValue value;
 	char* string_tmp;
 	JSqlCacheSQLPrepared* prepared = NULL;
 	GHashTable* variables_index = NULL;
-	GString* sql = g_string_new(NULL);
+	GString* sql = NULL;
+	g_autoptr(GString) sql_group_by = NULL;
+	g_autoptr(GString) sql_join = NULL;
+	g_autofree gchar* table = NULL;
+	g_autofree gchar* column_prefix = NULL;
+	g_autoptr(GString) key = NULL;
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
 	g_autoptr(GArray) arr_types_out = NULL;
@@ -2291,128 +3489,217 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
-
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	variables_index = g_hash_table_new_full(g_direct_hash, NULL, NULL, g_free);
-	g_string_append(sql, "SELECT ");
-	variables_count = 0;
-
 	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
 	{
 		goto _error;
 	}
 
-	g_hash_table_iter_init(&schema_iter, schema_cache);
+	// Projections, aggregates, sort keys and conditions are part of the selector's structure
+	key = g_string_new("SELECT WHERE ");
+	build_selector_key(selector, key);
 
-	g_string_append(sql, "_id");
-	g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup("_id"));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_out, type);
-	variables_count++;
+	prepared = getCachePrepared(backend_data, batch->namespace, name, key->str, error);
 
-	while (g_hash_table_iter_next(&schema_iter, (gpointer*)&string_tmp, &type_tmp))
+	if (G_UNLIKELY(!prepared))
 	{
-		type = GPOINTER_TO_INT(type_tmp);
+		goto _error;
+	}
 
-		if (strcmp(string_tmp, "_id") == 0)
-			continue;
+	if (prepared->in_use)
+	{
+		// The statement is still used by another iterator, which would be invalidated by binding new values
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_THREADING_ERROR, "statement in use");
+		goto _error;
+	}
 
-		g_string_append_printf(sql, ", " SQL_QUOTE "%s" SQL_QUOTE, string_tmp);
-		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(string_tmp));
-		g_array_append_val(arr_types_out, type);
-		variables_count++;
+	if (prepared->initialized)
+	{
+		goto _bind;
 	}
 
-	g_string_append_printf(sql, " FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	variables_index = g_hash_table_new_full(g_direct_hash, NULL, NULL, g_free);
+	sql = g_string_new("SELECT ");
+	variables_count = 0;
+	variables_count2 = 0;
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	if (selector != NULL && bson_has_field(selector, "_join"))
 	{
-		g_string_append(sql, " WHERE ");
-
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+		if (G_UNLIKELY(bson_has_field(selector, "_aggregate")))
 		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "joins can not be aggregated");
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
+		// Columns of joined tables may have the same names, all columns are therefore qualified by their table
+		table = g_strdup_printf("%s_%s", batch->namespace, name);
+		column_prefix = g_strdup_printf(SQL_QUOTE "%s" SQL_QUOTE ".", table);
+		sql_join = g_string_new(NULL);
+	}
+	else
+	{
+		column_prefix = g_strdup("");
+	}
+
+	if (selector != NULL && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_aggregate", NULL))
+	{
+		// Aggregates are computed by the database, only the results are transferred
+		sql_group_by = g_string_new(NULL);
+
+		if (G_UNLIKELY(!build_aggregate_columns(selector, sql, sql_group_by, variables_index, arr_types_out, &variables_count, schema_cache, error)))
 		{
 			goto _error;
 		}
+	}
+	else if (selector != NULL && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_fields", NULL))
+	{
+		g_string_append_printf(sql, "%s_id", column_prefix);
+		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup("_id"));
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(arr_types_out, type);
+		variables_count++;
 
-		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+		// Only transfer the requested columns
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_fields, error)))
 		{
 			goto _error;
 		}
 
-		mode_child = value.val_uint32;
-
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+		while (TRUE)
 		{
-			goto _error;
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_fields, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_fields, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (strcmp(value.val_string, "_id") == 0)
+			{
+				continue;
+			}
+
+			if (G_UNLIKELY(!g_hash_table_lookup_extended(schema_cache, value.val_string, NULL, &type_tmp)))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+
+			type = GPOINTER_TO_INT(type_tmp);
+
+			g_string_append_printf(sql, ", %s" SQL_QUOTE "%s" SQL_QUOTE, column_prefix, value.val_string);
+			g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(value.val_string));
+			g_array_append_val(arr_types_out, type);
+			variables_count++;
 		}
+	}
+	else
+	{
+		g_string_append_printf(sql, "%s_id", column_prefix);
+		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup("_id"));
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(arr_types_out, type);
+		variables_count++;
 
-		variables_count2 = 0;
+		g_hash_table_iter_init(&schema_iter, schema_cache);
 
-		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count2, arr_types_in, schema_cache, error)))
+		while (g_hash_table_iter_next(&schema_iter, (gpointer*)&string_tmp, &type_tmp))
 		{
-			goto _error;
+			type = GPOINTER_TO_INT(type_tmp);
+
+			if (strcmp(string_tmp, "_id") == 0)
+				continue;
+
+			g_string_append_printf(sql, ", %s" SQL_QUOTE "%s" SQL_QUOTE, column_prefix, string_tmp);
+			g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(string_tmp));
+			g_array_append_val(arr_types_out, type);
+			variables_count++;
 		}
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
-
-	if (G_UNLIKELY(!prepared))
+	if (sql_join != NULL && G_UNLIKELY(!build_selector_joins(backend_data, batch, selector, table, sql, sql_join, variables_index, arr_types_out, &variables_count, &variables_count2, arr_types_in, schema_cache, error)))
 	{
 		goto _error;
 	}
 
-	if (!prepared->initialized)
+	g_string_append_printf(sql, " FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+
+	if (sql_join != NULL)
 	{
-		prepared->sql = g_string_new(sql->str);
-		prepared->variables_index = variables_index;
-		prepared->variables_count = variables_count;
+		g_string_append(sql, sql_join->str);
+	}
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
-		{
-			goto _error;
-		}
-		prepared->initialized = TRUE;
+	if (G_UNLIKELY(!build_selector_where(backend_data, selector, table, sql, &variables_count2, arr_types_in, schema_cache, error)))
+	{
+		goto _error;
 	}
-	else
+
+	if (sql_group_by != NULL)
 	{
-		g_hash_table_destroy(variables_index);
-		variables_index = NULL;
+		g_string_append(sql, sql_group_by->str);
 	}
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	if (G_UNLIKELY(!build_selector_order(selector, table, sql, sql_group_by != NULL, &variables_count2, arr_types_in, schema_cache, error)))
 	{
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
+		goto _error;
+	}
 
-		variables_count2 = 0;
+	prepared->sql = sql;
+	sql = NULL;
+	prepared->variables_index = variables_index;
+	variables_index = NULL;
+	prepared->variables_count = variables_count;
+	prepared->variables_types = g_array_ref(arr_types_out);
 
-		if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &variables_count2, schema_cache, error)))
-		{
-			goto _error;
-		}
+	if (G_UNLIKELY(!sql_prepare(thread_variables, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
+	{
+		goto _error;
 	}
 
-	*iterator = prepared;
+	prepared->initialized = TRUE;
 
-	if (sql)
+_bind:
+	variables_count2 = 0;
+
+	// The joined selectors' variables precede the selector's variables
+	if (selector != NULL && bson_has_field(selector, "_join") && G_UNLIKELY(!bind_selector_joins(backend_data, batch, selector, prepared, &variables_count2, error)))
 	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!bind_selector_where(backend_data, selector, prepared, &variables_count2, schema_cache, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!bind_selector_limit(backend_data, selector, prepared, variables_count2, error)))
+	{
+		goto _error;
+	}
+
+	// The connection and the statement are kept until all rows have been returned
+	if (G_UNLIKELY(!thread_variables_acquire(backend_data, error)))
+	{
+		goto _error;
 	}
 
+	prepared->in_use = TRUE;
+	*iterator = prepared;
+
 	return TRUE;
 
 _error:
@@ -2430,36 +3717,53 @@ _error:
 	return FALSE;
 }
 
+static gboolean
+backend_statistics(gpointer backend_data, gchar** statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint connections_idle;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(statistics != NULL, FALSE);
+
+	G_LOCK(sql_connections_lock);
+	connections_idle = sql_connections_idle.length;
+	G_UNLOCK(sql_connections_lock);
+
+	*statistics = g_strdup_printf("sql.connections-idle: %u\n"
+				      "sql.statement-cache-size: %u\n"
+				      "sql.statement-cache-hits: %" G_GUINT64_FORMAT "\n"
+				      "sql.statement-cache-misses: %" G_GUINT64_FORMAT "\n"
+				      "sql.statement-cache-evictions: %" G_GUINT64_FORMAT "\n"
+				      "sql.statement-prepares: %" G_GUINT64_FORMAT "\n",
+				      connections_idle,
+				      statement_cache_size,
+				      j_helper_atomic_add(&statistics_hits, 0),
+				      j_helper_atomic_add(&statistics_misses, 0),
+				      j_helper_atomic_add(&statistics_evictions, 0),
+				      j_helper_atomic_add(&statistics_prepares, 0));
+
+	return TRUE;
+}
+
 static gboolean
 backend_iterate(gpointer backend_data, gpointer _iterator, bson_t* metadata, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GHashTable* schema_cache = NULL;
 	const char* string_tmp;
 	guint i;
-	JSqlCacheSQLQueries* queries = NULL;
 	JDBTypeValue value;
 	JDBType type;
 	gboolean sql_found;
 	JSqlCacheSQLPrepared* prepared = _iterator;
 	gboolean found = FALSE;
-	JThreadVariables* thread_variables = NULL;
-
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
-	{
-		goto _error;
-	}
-
-	if (!(queries = _getCachePrepared(backend_data, prepared->namespace, prepared->name, error)))
-	{
-		goto _error;
-	}
+	gboolean ret;
+	JThreadVariables* thread_variables = prepared->connection;
 
-	if (!(schema_cache = queries->types))
-	{
-		goto _error;
-	}
+	(void)backend_data;
 
 	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
 	{
@@ -2473,13 +3777,19 @@ backend_iterate(gpointer backend_data, gpointer _iterator, bson_t* metadata, GEr
 		for (i = 0; i < prepared->variables_count; i++)
 		{
 			string_tmp = g_hash_table_lookup(prepared->variables_index, GINT_TO_POINTER(i));
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+			type = g_array_index(prepared->variables_types, JDBType, i);
 
 			if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, i, type, &value, error)))
 			{
 				goto _error;
 			}
 
+			// Aggregates over no entries are NULL
+			if (type == J_DB_TYPE_STRING && value.val_string == NULL)
+			{
+				continue;
+			}
+
 			if (G_UNLIKELY(!j_bson_append_value(metadata, string_tmp, type, &value, error)))
 			{
 				goto _error;
@@ -2496,7 +3806,13 @@ backend_iterate(gpointer backend_data, gpointer _iterator, bson_t* metadata, GEr
 	return TRUE;
 
 _error:
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL)))
+	ret = j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL);
+
+	// The iterator is done, allow the statement to be evicted and the connection to be reused
+	prepared->in_use = FALSE;
+	thread_variables_release(thread_variables);
+
+	if (G_UNLIKELY(!ret))
 	{
 		goto _error3;
 	}
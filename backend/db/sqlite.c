@@ -41,12 +41,40 @@
 #define SQL_AUTOINCREMENT_STRING " "
 #define SQL_UINT64_TYPE " UNSIGNED BIGINT "
 #define SQL_LAST_INSERT_ID_STRING " SELECT last_insert_rowid() "
+// last_insert_rowid() returns the id of the last row inserted by a multi-row INSERT
+#define SQL_LAST_INSERT_ID_FIRST_ROW FALSE
+// Writers are serialized, so a multi-row INSERT generates consecutive ids
+#define SQL_INSERT_IDS_CONSECUTIVE TRUE
+// Maximum number of parameters per statement and rows per multi-row INSERT
+#define SQL_VARIABLES_MAX 999
+#define SQL_INSERT_ROWS_MAX 256
 #define SQL_QUOTE "\""
 
+// Defaults for the backend options (see doc/configuration.md)
+#define SQLITE_MMAP_SIZE (256 * 1024 * 1024)
+#define SQLITE_CACHE_SIZE (16 * 1024)
+#define SQLITE_CHECKPOINT_INTERVAL 1000
+
 struct JSQLiteData
 {
 	gchar* path;
 	sqlite3* db;
+
+	// Number of bytes of the database file to memory-map
+	guint64 mmap_size;
+	// Size of each connection's page cache in KiB
+	guint64 cache_size;
+	// Interval in milliseconds between checkpoints of the write-ahead log, 0 to let sqlite checkpoint on commit
+	guint64 checkpoint_interval;
+
+	struct
+	{
+		sqlite3* db;
+		GThread* thread;
+		GMutex mutex;
+		GCond cond;
+		gboolean stop;
+	} checkpoint;
 };
 
 typedef struct JSQLiteData JSQLiteData;
@@ -289,6 +317,16 @@ _error:
 	return FALSE;
 }
 
+static guint64
+j_sql_changes(sqlite3* backend_db, void* _stmt)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)_stmt;
+
+	return sqlite3_changes(backend_db);
+}
+
 static gboolean
 j_sql_exec(sqlite3* backend_db, const char* sql, GError** error)
 {
@@ -393,6 +431,37 @@ j_sql_open(gpointer backend_data)
 		goto _error;
 	}
 
+	if (g_strcmp0(bd->path, ":memory:") != 0)
+	{
+		g_autofree gchar* mmap_size = NULL;
+		g_autofree gchar* cache_size = NULL;
+
+		// Readers do not block the writer in WAL mode and commits only append to the log.
+		if (G_UNLIKELY(!j_sql_exec(backend_db, "PRAGMA journal_mode = WAL", NULL)))
+		{
+			goto _error;
+		}
+
+		mmap_size = g_strdup_printf("PRAGMA mmap_size = %" G_GUINT64_FORMAT, bd->mmap_size);
+		cache_size = g_strdup_printf("PRAGMA cache_size = -%" G_GUINT64_FORMAT, bd->cache_size);
+
+		if (G_UNLIKELY(!j_sql_exec(backend_db, mmap_size, NULL)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_exec(backend_db, cache_size, NULL)))
+		{
+			goto _error;
+		}
+
+		// The log is checkpointed by a background thread instead of the committing connection.
+		if (bd->checkpoint.thread != NULL && G_UNLIKELY(!j_sql_exec(backend_db, "PRAGMA wal_autocheckpoint = 0", NULL)))
+		{
+			goto _error;
+		}
+	}
+
 	return backend_db;
 
 _error:
@@ -433,24 +502,112 @@ j_sql_abort_transaction(sqlite3* backend_db, GError** error)
 	return j_sql_exec(backend_db, "ROLLBACK", error);
 }
 
+static gboolean
+j_sql_set_safety(sqlite3* backend_db, JSemanticsSafety safety, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* sql;
+
+	// In WAL mode, NORMAL only syncs during checkpoints, which may lose the latest commits on power failure but never corrupts the database.
+	switch (safety)
+	{
+		case J_SEMANTICS_SAFETY_NONE:
+			sql = "PRAGMA synchronous = OFF";
+			break;
+		case J_SEMANTICS_SAFETY_STORAGE:
+			sql = "PRAGMA synchronous = FULL";
+			break;
+		case J_SEMANTICS_SAFETY_NETWORK:
+		default:
+			sql = "PRAGMA synchronous = NORMAL";
+			break;
+	}
+
+	return j_sql_exec(backend_db, sql, error);
+}
+
 #include "sql-generic.c"
 
+static gpointer
+sqlite_checkpoint_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSQLiteData* bd = data;
+
+	g_mutex_lock(&(bd->checkpoint.mutex));
+
+	while (!bd->checkpoint.stop)
+	{
+		gint64 end_time;
+
+		end_time = g_get_monotonic_time() + bd->checkpoint_interval * G_TIME_SPAN_MILLISECOND;
+
+		if (!g_cond_wait_until(&(bd->checkpoint.cond), &(bd->checkpoint.mutex), end_time))
+		{
+			// A passive checkpoint does not wait for readers or writers, it simply copies as much of the log as possible.
+			g_mutex_unlock(&(bd->checkpoint.mutex));
+			sqlite3_wal_checkpoint_v2(bd->checkpoint.db, NULL, SQLITE_CHECKPOINT_PASSIVE, NULL, NULL);
+			g_mutex_lock(&(bd->checkpoint.mutex));
+		}
+	}
+
+	g_mutex_unlock(&(bd->checkpoint.mutex));
+
+	return NULL;
+}
+
 static gboolean
 backend_init(gchar const* _path, gpointer* backend_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSQLiteData* bd;
+	g_autoptr(JConfiguration) configuration = NULL;
 
 	bd = g_slice_new(JSQLiteData);
 	bd->path = g_strdup(_path);
 	bd->db = NULL;
+	bd->mmap_size = SQLITE_MMAP_SIZE;
+	bd->cache_size = SQLITE_CACHE_SIZE;
+	bd->checkpoint_interval = SQLITE_CHECKPOINT_INTERVAL;
+	bd->checkpoint.db = NULL;
+	bd->checkpoint.thread = NULL;
+	bd->checkpoint.stop = FALSE;
+	g_mutex_init(&(bd->checkpoint.mutex));
+	g_cond_init(&(bd->checkpoint.cond));
+
+	if ((configuration = j_configuration_new()) != NULL)
+	{
+		bd->mmap_size = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_DB, "mmap-size", SQLITE_MMAP_SIZE);
+		bd->cache_size = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_DB, "cache-size", SQLITE_CACHE_SIZE);
+		bd->checkpoint_interval = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_DB, "checkpoint-interval", SQLITE_CHECKPOINT_INTERVAL);
+	}
 
 	if (g_strcmp0(bd->path, ":memory:") == 0)
 	{
 		// Hold an extra reference to the shared in-memory database to make sure it is not freed.
 		sqlite3_open_v2("file:julea-db", &(bd->db), SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_URI | SQLITE_OPEN_MEMORY | SQLITE_OPEN_SHAREDCACHE, NULL);
 	}
+	else if (bd->checkpoint_interval > 0)
+	{
+		g_autofree gchar* dirname = NULL;
+
+		dirname = g_path_get_dirname(bd->path);
+		g_mkdir_with_parents(dirname, 0700);
+
+		// The checkpointer uses its own connection to not interfere with the pooled ones.
+		if (sqlite3_open(bd->path, &(bd->checkpoint.db)) == SQLITE_OK && j_sql_exec(bd->checkpoint.db, "PRAGMA journal_mode = WAL", NULL))
+		{
+			bd->checkpoint.thread = g_thread_new("julea-sqlite-checkpoint", sqlite_checkpoint_thread, bd);
+		}
+		else
+		{
+			sqlite3_close(bd->checkpoint.db);
+			bd->checkpoint.db = NULL;
+		}
+	}
 
 	*backend_data = bd;
 
@@ -468,6 +625,27 @@ backend_fini(gpointer backend_data)
 
 	sql_generic_fini();
 
+	if (bd->checkpoint.thread != NULL)
+	{
+		g_mutex_lock(&(bd->checkpoint.mutex));
+		bd->checkpoint.stop = TRUE;
+		g_cond_signal(&(bd->checkpoint.cond));
+		g_mutex_unlock(&(bd->checkpoint.mutex));
+
+		g_thread_join(bd->checkpoint.thread);
+
+		// All other connections are closed, so the log can be copied completely and truncated.
+		sqlite3_wal_checkpoint_v2(bd->checkpoint.db, NULL, SQLITE_CHECKPOINT_TRUNCATE, NULL, NULL);
+	}
+
+	if (bd->checkpoint.db != NULL)
+	{
+		sqlite3_close(bd->checkpoint.db);
+	}
+
+	g_mutex_clear(&(bd->checkpoint.mutex));
+	g_cond_clear(&(bd->checkpoint.cond));
+
 	if (bd->db != NULL)
 	{
 		sqlite3_close(bd->db);
@@ -487,12 +665,14 @@ static JBackend sqlite_backend = {
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
 		.backend_insert = backend_insert,
+		.backend_insert_many = backend_insert_many,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
 		.backend_iterate = backend_iterate,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_statistics = backend_statistics,
 	},
 };
 
@@ -0,0 +1,731 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+/**
+ * The number of lock stripes per namespace.
+ * Each stripe protects a part of the namespace's hash map.
+ */
+#define J_MEMORY_STRIPES 64
+
+/**
+ * The maximum height of the skip list.
+ */
+#define J_MEMORY_SKIP_LIST_LEVELS 16
+
+/**
+ * A reference-counted value.
+ * Values are immutable, a put replaces the whole value.
+ */
+struct JMemoryValue
+{
+	gint ref_count;
+	guint32 len;
+	gchar data[];
+};
+
+typedef struct JMemoryValue JMemoryValue;
+
+struct JMemorySkipListNode
+{
+	gchar* key;
+	guint height;
+	struct JMemorySkipListNode* next[];
+};
+
+typedef struct JMemorySkipListNode JMemorySkipListNode;
+
+struct JMemoryStripe
+{
+	GRWLock lock;
+
+	/**
+	 * Maps keys to JMemoryValue.
+	 */
+	GHashTable* values;
+};
+
+typedef struct JMemoryStripe JMemoryStripe;
+
+struct JMemoryNamespace
+{
+	JMemoryStripe stripes[J_MEMORY_STRIPES];
+
+	/**
+	 * The ordered index used for prefix iteration.
+	 * Only the keys are stored, values are looked up in the stripes.
+	 */
+	JMemorySkipListNode* index;
+	guint index_height;
+	GRWLock index_lock;
+};
+
+typedef struct JMemoryNamespace JMemoryNamespace;
+
+struct JMemoryData
+{
+	GHashTable* namespaces;
+	GRWLock namespaces_lock;
+
+	/**
+	 * The memory used by keys and values (in bytes).
+	 */
+	guint64 volatile memory_used;
+
+	/**
+	 * The memory limit (in bytes, 0 if unlimited).
+	 */
+	guint64 memory_limit;
+};
+
+typedef struct JMemoryData JMemoryData;
+
+struct JMemoryBatch
+{
+	gchar* namespace;
+};
+
+typedef struct JMemoryBatch JMemoryBatch;
+
+struct JMemoryIterator
+{
+	/**
+	 * A snapshot of the matching keys.
+	 */
+	GPtrArray* keys;
+
+	/**
+	 * A snapshot of the matching values (JMemoryValue).
+	 */
+	GPtrArray* values;
+
+	guint position;
+};
+
+typedef struct JMemoryIterator JMemoryIterator;
+
+static JMemoryValue*
+value_new(gconstpointer data, guint32 len)
+{
+	JMemoryValue* value;
+
+	value = g_malloc(sizeof(JMemoryValue) + len);
+	value->ref_count = 1;
+	value->len = len;
+	memcpy(value->data, data, len);
+
+	return value;
+}
+
+static JMemoryValue*
+value_ref(JMemoryValue* value)
+{
+	g_atomic_int_inc(&(value->ref_count));
+
+	return value;
+}
+
+static void
+value_unref(gpointer data)
+{
+	JMemoryValue* value = data;
+
+	if (g_atomic_int_dec_and_test(&(value->ref_count)))
+	{
+		g_free(value);
+	}
+}
+
+static JMemorySkipListNode*
+skip_list_node_new(gchar const* key, guint height)
+{
+	JMemorySkipListNode* node;
+
+	node = g_malloc0(sizeof(JMemorySkipListNode) + height * sizeof(JMemorySkipListNode*));
+	node->key = g_strdup(key);
+	node->height = height;
+
+	return node;
+}
+
+static void
+skip_list_node_free(JMemorySkipListNode* node)
+{
+	g_free(node->key);
+	g_free(node);
+}
+
+/**
+ * Returns a node height for a key.
+ * Each level is used with a probability of 1/4.
+ * The height is derived from the key's hash, which avoids a shared random number generator.
+ */
+static guint
+skip_list_height(gchar const* key)
+{
+	guint32 hash;
+	guint height = 1;
+
+	hash = g_str_hash(key);
+
+	// Mix the bits since the string hash's lower bits are not well distributed
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+
+	while (height < J_MEMORY_SKIP_LIST_LEVELS && (hash & 3) == 0)
+	{
+		height++;
+		hash >>= 2;
+	}
+
+	return height;
+}
+
+/**
+ * Finds the predecessors of a key on all levels.
+ * The index lock has to be held.
+ */
+static void
+skip_list_find(JMemoryNamespace* ns, gchar const* key, JMemorySkipListNode** update)
+{
+	JMemorySkipListNode* node = ns->index;
+
+	for (gint level = J_MEMORY_SKIP_LIST_LEVELS - 1; level >= 0; level--)
+	{
+		// Levels above the current height only contain the head
+		if ((guint)level < ns->index_height)
+		{
+			while (node->next[level] != NULL && g_strcmp0(node->next[level]->key, key) < 0)
+			{
+				node = node->next[level];
+			}
+		}
+
+		update[level] = node;
+	}
+}
+
+static void
+skip_list_insert(JMemoryNamespace* ns, gchar const* key)
+{
+	JMemorySkipListNode* update[J_MEMORY_SKIP_LIST_LEVELS];
+	JMemorySkipListNode* node;
+	guint height;
+
+	g_rw_lock_writer_lock(&(ns->index_lock));
+
+	skip_list_find(ns, key, update);
+
+	if (update[0]->next[0] == NULL || g_strcmp0(update[0]->next[0]->key, key) != 0)
+	{
+		height = skip_list_height(key);
+		node = skip_list_node_new(key, height);
+
+		for (guint level = 0; level < height; level++)
+		{
+			node->next[level] = update[level]->next[level];
+			update[level]->next[level] = node;
+		}
+
+		ns->index_height = MAX(ns->index_height, height);
+	}
+
+	g_rw_lock_writer_unlock(&(ns->index_lock));
+}
+
+static void
+skip_list_remove(JMemoryNamespace* ns, gchar const* key)
+{
+	JMemorySkipListNode* update[J_MEMORY_SKIP_LIST_LEVELS];
+	JMemorySkipListNode* node;
+
+	g_rw_lock_writer_lock(&(ns->index_lock));
+
+	skip_list_find(ns, key, update);
+	node = update[0]->next[0];
+
+	if (node != NULL && g_strcmp0(node->key, key) == 0)
+	{
+		for (guint level = 0; level < node->height; level++)
+		{
+			update[level]->next[level] = node->next[level];
+		}
+
+		skip_list_node_free(node);
+	}
+
+	g_rw_lock_writer_unlock(&(ns->index_lock));
+}
+
+static JMemoryNamespace*
+namespace_new(void)
+{
+	JMemoryNamespace* ns;
+
+	ns = g_slice_new(JMemoryNamespace);
+
+	for (guint i = 0; i < J_MEMORY_STRIPES; i++)
+	{
+		g_rw_lock_init(&(ns->stripes[i].lock));
+		ns->stripes[i].values = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, value_unref);
+	}
+
+	ns->index = skip_list_node_new("", J_MEMORY_SKIP_LIST_LEVELS);
+	ns->index_height = 1;
+	g_rw_lock_init(&(ns->index_lock));
+
+	return ns;
+}
+
+static void
+namespace_free(gpointer data)
+{
+	JMemoryNamespace* ns = data;
+	JMemorySkipListNode* node;
+
+	node = ns->index;
+
+	while (node != NULL)
+	{
+		JMemorySkipListNode* next = node->next[0];
+
+		skip_list_node_free(node);
+		node = next;
+	}
+
+	g_rw_lock_clear(&(ns->index_lock));
+
+	for (guint i = 0; i < J_MEMORY_STRIPES; i++)
+	{
+		g_hash_table_unref(ns->stripes[i].values);
+		g_rw_lock_clear(&(ns->stripes[i].lock));
+	}
+
+	g_slice_free(JMemoryNamespace, ns);
+}
+
+static JMemoryNamespace*
+get_namespace(JMemoryData* bd, gchar const* namespace, gboolean create)
+{
+	JMemoryNamespace* ns;
+
+	g_rw_lock_reader_lock(&(bd->namespaces_lock));
+	ns = g_hash_table_lookup(bd->namespaces, namespace);
+	g_rw_lock_reader_unlock(&(bd->namespaces_lock));
+
+	if (ns != NULL || !create)
+	{
+		return ns;
+	}
+
+	g_rw_lock_writer_lock(&(bd->namespaces_lock));
+
+	// Another thread might have created the namespace in the meantime
+	ns = g_hash_table_lookup(bd->namespaces, namespace);
+
+	if (ns == NULL)
+	{
+		ns = namespace_new();
+		g_hash_table_insert(bd->namespaces, g_strdup(namespace), ns);
+	}
+
+	g_rw_lock_writer_unlock(&(bd->namespaces_lock));
+
+	return ns;
+}
+
+static JMemoryStripe*
+get_stripe(JMemoryNamespace* ns, gchar const* key)
+{
+	return &(ns->stripes[g_str_hash(key) % J_MEMORY_STRIPES]);
+}
+
+static JMemoryIterator*
+iterator_new(JMemoryData* bd, gchar const* namespace, gchar const* prefix)
+{
+	JMemoryIterator* iterator;
+	JMemoryNamespace* ns;
+
+	iterator = g_slice_new(JMemoryIterator);
+	iterator->keys = g_ptr_array_new_with_free_func(g_free);
+	iterator->values = g_ptr_array_new_with_free_func(value_unref);
+	iterator->position = 0;
+
+	if ((ns = get_namespace(bd, namespace, FALSE)) != NULL)
+	{
+		g_autoptr(GPtrArray) keys = NULL;
+		JMemorySkipListNode* update[J_MEMORY_SKIP_LIST_LEVELS];
+		JMemorySkipListNode* node;
+
+		keys = g_ptr_array_new_with_free_func(g_free);
+
+		// Collect the keys first to avoid holding the index lock while taking the stripe locks
+		g_rw_lock_reader_lock(&(ns->index_lock));
+
+		skip_list_find(ns, prefix, update);
+
+		for (node = update[0]->next[0]; node != NULL && g_str_has_prefix(node->key, prefix); node = node->next[0])
+		{
+			g_ptr_array_add(keys, g_strdup(node->key));
+		}
+
+		g_rw_lock_reader_unlock(&(ns->index_lock));
+
+		for (guint i = 0; i < keys->len; i++)
+		{
+			gchar* key = g_ptr_array_index(keys, i);
+			JMemoryStripe* stripe;
+			JMemoryValue* value;
+
+			stripe = get_stripe(ns, key);
+
+			g_rw_lock_reader_lock(&(stripe->lock));
+
+			// The key might have been deleted in the meantime
+			if ((value = g_hash_table_lookup(stripe->values, key)) != NULL)
+			{
+				g_ptr_array_add(iterator->keys, g_strdup(key));
+				g_ptr_array_add(iterator->values, value_ref(value));
+			}
+
+			g_rw_lock_reader_unlock(&(stripe->lock));
+		}
+	}
+
+	return iterator;
+}
+
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+{
+	JMemoryBatch* batch;
+
+	(void)backend_data;
+	(void)semantics;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	batch = g_slice_new(JMemoryBatch);
+	batch->namespace = g_strdup(namespace);
+
+	*backend_batch = batch;
+
+	return TRUE;
+}
+
+static gboolean
+backend_batch_execute(gpointer backend_data, gpointer backend_batch)
+{
+	JMemoryBatch* batch = backend_batch;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	// Operations are applied immediately, there is nothing to commit
+	g_free(batch->namespace);
+	g_slice_free(JMemoryBatch, batch);
+
+	return TRUE;
+}
+
+static gboolean
+backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryData* bd = backend_data;
+	JMemoryNamespace* ns;
+	JMemoryStripe* stripe;
+	JMemoryValue* old_value;
+	gint64 size;
+	guint64 used;
+	gboolean created;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	ns = get_namespace(bd, batch->namespace, TRUE);
+	stripe = get_stripe(ns, key);
+
+	g_rw_lock_writer_lock(&(stripe->lock));
+
+	old_value = g_hash_table_lookup(stripe->values, key);
+	created = (old_value == NULL);
+
+	size = len;
+
+	if (created)
+	{
+		size += strlen(key) + 1;
+	}
+	else
+	{
+		size -= old_value->len;
+	}
+
+	// Shrinking values result in a negative difference, which is added modulo 2^64
+	used = j_helper_atomic_add(&(bd->memory_used), size) + size;
+
+	if (bd->memory_limit > 0 && size > 0 && used > bd->memory_limit)
+	{
+		j_helper_atomic_add(&(bd->memory_used), -size);
+		g_rw_lock_writer_unlock(&(stripe->lock));
+
+		return FALSE;
+	}
+
+	g_hash_table_insert(stripe->values, g_strdup(key), value_new(value, len));
+
+	// The index is updated while holding the stripe lock to keep it consistent with the hash map
+	if (created)
+	{
+		skip_list_insert(ns, key);
+	}
+
+	g_rw_lock_writer_unlock(&(stripe->lock));
+
+	return TRUE;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryData* bd = backend_data;
+	JMemoryNamespace* ns;
+	JMemoryStripe* stripe;
+	JMemoryValue* value;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	if ((ns = get_namespace(bd, batch->namespace, FALSE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	stripe = get_stripe(ns, key);
+
+	g_rw_lock_writer_lock(&(stripe->lock));
+
+	if ((value = g_hash_table_lookup(stripe->values, key)) != NULL)
+	{
+		j_helper_atomic_add(&(bd->memory_used), -(value->len + strlen(key) + 1));
+
+		g_hash_table_remove(stripe->values, key);
+		skip_list_remove(ns, key);
+
+		ret = TRUE;
+	}
+
+	g_rw_lock_writer_unlock(&(stripe->lock));
+
+	return ret;
+}
+
+static gboolean
+backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpointer* value, guint32* len)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryData* bd = backend_data;
+	JMemoryNamespace* ns;
+	JMemoryStripe* stripe;
+	JMemoryValue* result;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	if ((ns = get_namespace(bd, batch->namespace, FALSE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	stripe = get_stripe(ns, key);
+
+	g_rw_lock_reader_lock(&(stripe->lock));
+
+	if ((result = g_hash_table_lookup(stripe->values, key)) != NULL)
+	{
+#if GLIB_CHECK_VERSION(2, 68, 0)
+		*value = g_memdup2(result->data, result->len);
+#else
+		*value = g_memdup(result->data, result->len);
+#endif
+		*len = result->len;
+
+		ret = TRUE;
+	}
+
+	g_rw_lock_reader_unlock(&(stripe->lock));
+
+	return ret;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	JMemoryData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = iterator_new(bd, namespace, "");
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JMemoryData* bd = backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	*backend_iterator = iterator_new(bd, namespace, prefix);
+
+	return TRUE;
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
+{
+	JMemoryIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	if (iterator->position < iterator->keys->len)
+	{
+		JMemoryValue* current;
+
+		current = g_ptr_array_index(iterator->values, iterator->position);
+
+		*key = g_ptr_array_index(iterator->keys, iterator->position);
+		*value = current->data;
+		*len = current->len;
+
+		iterator->position++;
+
+		return TRUE;
+	}
+
+	g_ptr_array_unref(iterator->keys);
+	g_ptr_array_unref(iterator->values);
+	g_slice_free(JMemoryIterator, iterator);
+
+	return FALSE;
+}
+
+static gboolean
+backend_statistics(gpointer backend_data, gchar** statistics)
+{
+	JMemoryData* bd = backend_data;
+	guint namespaces;
+
+	g_return_val_if_fail(statistics != NULL, FALSE);
+
+	g_rw_lock_reader_lock(&(bd->namespaces_lock));
+	namespaces = g_hash_table_size(bd->namespaces);
+	g_rw_lock_reader_unlock(&(bd->namespaces_lock));
+
+	*statistics = g_strdup_printf("memory.namespaces: %u\nmemory.used: %" G_GUINT64_FORMAT "\nmemory.limit: %" G_GUINT64_FORMAT "\n", namespaces, j_helper_atomic_add(&(bd->memory_used), 0), bd->memory_limit);
+
+	return TRUE;
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JMemoryData* bd;
+	g_autoptr(JConfiguration) configuration = NULL;
+
+	(void)path;
+
+	bd = g_slice_new(JMemoryData);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, namespace_free);
+	g_rw_lock_init(&(bd->namespaces_lock));
+	bd->memory_used = 0;
+	bd->memory_limit = 0;
+
+	if ((configuration = j_configuration_new()) != NULL)
+	{
+		bd->memory_limit = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_KV, "memory-limit", 0);
+	}
+
+	*backend_data = bd;
+
+	return TRUE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JMemoryData* bd = backend_data;
+
+	g_hash_table_unref(bd->namespaces);
+	g_rw_lock_clear(&(bd->namespaces_lock));
+
+	g_slice_free(JMemoryData, bd);
+}
+
+static JBackend memory_backend = {
+	.type = J_BACKEND_TYPE_KV,
+	.component = J_BACKEND_COMPONENT_CLIENT | J_BACKEND_COMPONENT_SERVER,
+	.kv = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_batch_start = backend_batch_start,
+		.backend_batch_execute = backend_batch_execute,
+		.backend_put = backend_put,
+		.backend_delete = backend_delete,
+		.backend_get = backend_get,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_iterate = backend_iterate,
+		.backend_statistics = backend_statistics }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &memory_backend;
+}
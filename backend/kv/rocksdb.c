@@ -38,9 +38,30 @@ struct JRocksDBData
 {
 	rocksdb_t* db;
 
+	/**
+	 * The options used for the database and all column families.
+	 */
+	rocksdb_options_t* options;
+
+	/**
+	 * The block cache shared by all column families.
+	 */
+	rocksdb_cache_t* cache;
+
 	rocksdb_readoptions_t* read_options;
 	rocksdb_writeoptions_t* write_options;
 	rocksdb_writeoptions_t* write_options_sync;
+
+	/**
+	 * Maps namespaces to column family handles.
+	 */
+	GHashTable* column_families;
+	GRWLock column_families_lock;
+
+	/**
+	 * The length of the fixed prefix used for prefix bloom filters (0 if disabled).
+	 */
+	gsize prefix_length;
 };
 
 typedef struct JRocksDBData JRocksDBData;
@@ -48,13 +69,110 @@ typedef struct JRocksDBData JRocksDBData;
 struct JRocksDBIterator
 {
 	rocksdb_iterator_t* iterator;
+	rocksdb_readoptions_t* read_options;
 	gboolean first;
 	gchar* prefix;
-	gsize namespace_len;
 };
 
 typedef struct JRocksDBIterator JRocksDBIterator;
 
+/**
+ * Returns the column family for a namespace.
+ *
+ * \param bd        The backend data.
+ * \param namespace A namespace.
+ * \param create    Whether to create the column family if it does not exist.
+ *
+ * \return The column family, or NULL if it does not exist and could not be created.
+ **/
+static rocksdb_column_family_handle_t*
+get_column_family(JRocksDBData* bd, gchar const* namespace, gboolean create)
+{
+	rocksdb_column_family_handle_t* cf;
+
+	g_rw_lock_reader_lock(&(bd->column_families_lock));
+	cf = g_hash_table_lookup(bd->column_families, namespace);
+	g_rw_lock_reader_unlock(&(bd->column_families_lock));
+
+	if (cf != NULL || !create)
+	{
+		return cf;
+	}
+
+	g_rw_lock_writer_lock(&(bd->column_families_lock));
+
+	// Another thread might have created the column family in the meantime
+	cf = g_hash_table_lookup(bd->column_families, namespace);
+
+	if (cf == NULL)
+	{
+		g_autofree gchar* error = NULL;
+
+		cf = rocksdb_create_column_family(bd->db, bd->options, namespace, &error);
+
+		if (error == NULL)
+		{
+			g_hash_table_insert(bd->column_families, g_strdup(namespace), cf);
+		}
+		else
+		{
+			g_warning("Could not create column family %s: %s", namespace, error);
+			cf = NULL;
+		}
+	}
+
+	g_rw_lock_writer_unlock(&(bd->column_families_lock));
+
+	return cf;
+}
+
+static JRocksDBIterator*
+iterator_new(JRocksDBData* bd, gchar const* namespace, gchar const* prefix)
+{
+	JRocksDBIterator* iterator;
+	rocksdb_column_family_handle_t* cf;
+
+	iterator = g_slice_new(JRocksDBIterator);
+	iterator->iterator = NULL;
+	iterator->read_options = rocksdb_readoptions_create();
+	iterator->first = TRUE;
+	iterator->prefix = g_strdup(prefix);
+
+	if (bd->prefix_length > 0)
+	{
+		// The prefix extractor can only be used if the prefix covers the whole fixed-length prefix
+		if (strlen(prefix) >= bd->prefix_length)
+		{
+			rocksdb_readoptions_set_prefix_same_as_start(iterator->read_options, 1);
+		}
+		else
+		{
+			rocksdb_readoptions_set_total_order_seek(iterator->read_options, 1);
+		}
+	}
+
+	// Namespaces without a column family do not contain any keys
+	if ((cf = get_column_family(bd, namespace, FALSE)) != NULL)
+	{
+		iterator->iterator = rocksdb_create_iterator_cf(bd->db, iterator->read_options, cf);
+	}
+
+	return iterator;
+}
+
+static void
+iterator_free(JRocksDBIterator* iterator)
+{
+	if (iterator->iterator != NULL)
+	{
+		rocksdb_iter_destroy(iterator->iterator);
+	}
+
+	rocksdb_readoptions_destroy(iterator->read_options);
+	g_free(iterator->prefix);
+	g_slice_free(JRocksDBIterator, iterator);
+}
+
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
 {
@@ -93,7 +211,10 @@ backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 		write_options = bd->write_options_sync;
 	}
 
-	rocksdb_write(bd->db, write_options, batch->batch, &rocksdb_error);
+	if (rocksdb_writebatch_count(batch->batch) > 0)
+	{
+		rocksdb_write(bd->db, write_options, batch->batch, &rocksdb_error);
+	}
 
 	j_semantics_unref(batch->semantics);
 	g_free(batch->namespace);
@@ -107,16 +228,19 @@ static gboolean
 backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
 {
 	JRocksDBBatch* batch = backend_batch;
-	g_autofree gchar* nskey = NULL;
-
-	(void)backend_data;
+	JRocksDBData* bd = backend_data;
+	rocksdb_column_family_handle_t* cf;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-	rocksdb_writebatch_put(batch->batch, nskey, strlen(nskey) + 1, value, len);
+	if ((cf = get_column_family(bd, batch->namespace, TRUE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	rocksdb_writebatch_put_cf(batch->batch, cf, key, strlen(key) + 1, value, len);
 
 	return TRUE;
 }
@@ -125,15 +249,19 @@ static gboolean
 backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
 {
 	JRocksDBBatch* batch = backend_batch;
-	g_autofree gchar* nskey = NULL;
-
-	(void)backend_data;
+	JRocksDBData* bd = backend_data;
+	rocksdb_column_family_handle_t* cf;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-	rocksdb_writebatch_delete(batch->batch, nskey, strlen(nskey) + 1);
+	// Namespaces without a column family do not contain any keys
+	if ((cf = get_column_family(bd, batch->namespace, FALSE)) == NULL)
+	{
+		return TRUE;
+	}
+
+	rocksdb_writebatch_delete_cf(batch->batch, cf, key, strlen(key) + 1);
 
 	return TRUE;
 }
@@ -143,7 +271,7 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 {
 	JRocksDBBatch* batch = backend_batch;
 	JRocksDBData* bd = backend_data;
-	g_autofree gchar* nskey = NULL;
+	rocksdb_column_family_handle_t* cf;
 	g_autofree gpointer result = NULL;
 	gsize result_len;
 
@@ -152,8 +280,12 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	nskey = g_strdup_printf("%s:%s", batch->namespace, key);
-	result = rocksdb_get(bd->db, bd->read_options, nskey, strlen(nskey) + 1, &result_len, NULL);
+	if ((cf = get_column_family(bd, batch->namespace, FALSE)) == NULL)
+	{
+		return FALSE;
+	}
+
+	result = rocksdb_get_cf(bd->db, bd->read_options, cf, key, strlen(key) + 1, &result_len, NULL);
 
 	if (result != NULL)
 	{
@@ -172,53 +304,27 @@ static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
 	JRocksDBData* bd = backend_data;
-	JRocksDBIterator* iterator = NULL;
-	rocksdb_iterator_t* it;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	it = rocksdb_create_iterator(bd->db, bd->read_options);
+	*backend_iterator = iterator_new(bd, namespace, "");
 
-	if (it != NULL)
-	{
-		iterator = g_slice_new(JRocksDBIterator);
-		iterator->iterator = it;
-		iterator->first = TRUE;
-		iterator->prefix = g_strdup_printf("%s:", namespace);
-		iterator->namespace_len = strlen(namespace) + 1;
-
-		*backend_iterator = iterator;
-	}
-
-	return (iterator != NULL);
+	return TRUE;
 }
 
 static gboolean
 backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
 {
 	JRocksDBData* bd = backend_data;
-	JRocksDBIterator* iterator = NULL;
-	rocksdb_iterator_t* it;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	it = rocksdb_create_iterator(bd->db, bd->read_options);
+	*backend_iterator = iterator_new(bd, namespace, prefix);
 
-	if (it != NULL)
-	{
-		iterator = g_slice_new(JRocksDBIterator);
-		iterator->iterator = it;
-		iterator->first = TRUE;
-		iterator->prefix = g_strdup_printf("%s:%s", namespace, prefix);
-		iterator->namespace_len = strlen(namespace) + 1;
-
-		*backend_iterator = iterator;
-	}
-
-	return (iterator != NULL);
+	return TRUE;
 }
 
 static gboolean
@@ -233,6 +339,11 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
+	if (iterator->iterator == NULL)
+	{
+		goto out;
+	}
+
 	if (iterator->first)
 	{
 		rocksdb_iter_seek(iterator->iterator, iterator->prefix, strlen(iterator->prefix));
@@ -255,7 +366,7 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 			goto out;
 		}
 
-		*key = key_ + iterator->namespace_len;
+		*key = key_;
 		*value = rocksdb_iter_value(iterator->iterator, &tmp);
 		*len = tmp;
 
@@ -263,49 +374,151 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	}
 
 out:
-	g_free(iterator->prefix);
-	rocksdb_iter_destroy(iterator->iterator);
-	g_slice_free(JRocksDBIterator, iterator);
+	iterator_free(iterator);
 
 	return FALSE;
 }
 
+static gboolean
+backend_statistics(gpointer backend_data, gchar** statistics)
+{
+	JRocksDBData* bd = backend_data;
+	GString* str;
+	g_autofree gchar* stats = NULL;
+
+	g_return_val_if_fail(statistics != NULL, FALSE);
+
+	str = g_string_new(NULL);
+
+	g_string_append_printf(str, "rocksdb.block-cache-usage: %" G_GSIZE_FORMAT "\n", rocksdb_cache_get_usage(bd->cache));
+	g_string_append_printf(str, "rocksdb.column-families: %u\n", g_hash_table_size(bd->column_families));
+
+	if ((stats = rocksdb_property_value(bd->db, "rocksdb.stats")) != NULL)
+	{
+		g_string_append(str, stats);
+	}
+
+	*statistics = g_string_free(str, FALSE);
+
+	return TRUE;
+}
+
 static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
 	JRocksDBData* bd;
-	rocksdb_options_t* options;
+	g_autoptr(JConfiguration) configuration = NULL;
+	rocksdb_block_based_table_options_t* table_options;
 	g_autofree gchar* dirname = NULL;
 	gint const compressions[] = { rocksdb_lz4_compression, rocksdb_snappy_compression, rocksdb_no_compression };
+	guint64 cache_size = 64 * 1024 * 1024;
+	guint64 write_buffer_size = 64 * 1024 * 1024;
+	guint64 bloom_bits = 10;
+	guint64 prefix_length = 0;
+	gchar** cf_names = NULL;
+	gsize cf_names_len = 0;
+	gboolean cf_names_allocated = FALSE;
+	gchar default_cf_name[] = "default";
+	gchar* default_cf_names[] = { default_cf_name };
 
 	g_return_val_if_fail(path != NULL, FALSE);
 
+	if ((configuration = j_configuration_new()) != NULL)
+	{
+		cache_size = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_KV, "cache-size", cache_size);
+		write_buffer_size = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_KV, "write-buffer-size", write_buffer_size);
+		bloom_bits = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_KV, "bloom-bits-per-key", bloom_bits);
+		prefix_length = j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_KV, "prefix-length", prefix_length);
+	}
+
 	dirname = g_path_get_dirname(path);
 	g_mkdir_with_parents(dirname, 0700);
 
 	bd = g_slice_new(JRocksDBData);
+	bd->db = NULL;
 	bd->read_options = rocksdb_readoptions_create();
 	bd->write_options = rocksdb_writeoptions_create();
 	bd->write_options_sync = rocksdb_writeoptions_create();
 	rocksdb_writeoptions_set_sync(bd->write_options_sync, 1);
+	bd->column_families = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)rocksdb_column_family_handle_destroy);
+	g_rw_lock_init(&(bd->column_families_lock));
+	bd->prefix_length = prefix_length;
+
+	bd->cache = rocksdb_cache_create_lru(cache_size);
+
+	table_options = rocksdb_block_based_options_create();
+	rocksdb_block_based_options_set_block_cache(table_options, bd->cache);
+
+	if (bloom_bits > 0)
+	{
+		// The filter policy is owned by the table options
+		rocksdb_block_based_options_set_filter_policy(table_options, rocksdb_filterpolicy_create_bloom(bloom_bits));
+	}
+
+	bd->options = rocksdb_options_create();
+	rocksdb_options_set_create_if_missing(bd->options, 1);
+	rocksdb_options_set_create_missing_column_families(bd->options, 1);
+	rocksdb_options_set_write_buffer_size(bd->options, write_buffer_size);
+	rocksdb_options_set_block_based_table_factory(bd->options, table_options);
+
+	if (prefix_length > 0)
+	{
+		// The prefix extractor is owned by the options
+		rocksdb_options_set_prefix_extractor(bd->options, rocksdb_slicetransform_create_fixed_prefix(prefix_length));
+	}
+
+	rocksdb_block_based_options_destroy(table_options);
+
+	{
+		g_autofree gchar* error = NULL;
 
-	options = rocksdb_options_create();
-	rocksdb_options_set_create_if_missing(options, 1);
+		// Every namespace is stored in its own column family, reopen all of them
+		cf_names = rocksdb_list_column_families(bd->options, path, &cf_names_len, &error);
+
+		if (error == NULL && cf_names != NULL)
+		{
+			cf_names_allocated = TRUE;
+		}
+		else
+		{
+			cf_names = default_cf_names;
+			cf_names_len = 1;
+		}
+	}
 
 	for (guint i = 0; i < G_N_ELEMENTS(compressions); i++)
 	{
+		g_autofree rocksdb_column_family_handle_t** cf_handles = NULL;
+		g_autofree rocksdb_options_t const** cf_options = NULL;
 		g_autofree gchar* error = NULL;
 
-		rocksdb_options_set_compression(options, compressions[i]);
-		bd->db = rocksdb_open(options, path, &error);
+		rocksdb_options_set_compression(bd->options, compressions[i]);
+
+		cf_handles = g_new(rocksdb_column_family_handle_t*, cf_names_len);
+		cf_options = g_new(rocksdb_options_t const*, cf_names_len);
+
+		for (gsize j = 0; j < cf_names_len; j++)
+		{
+			cf_options[j] = bd->options;
+		}
+
+		bd->db = rocksdb_open_column_families(bd->options, path, cf_names_len, (gchar const* const*)cf_names, cf_options, cf_handles, &error);
 
 		if (bd->db != NULL)
 		{
+			for (gsize j = 0; j < cf_names_len; j++)
+			{
+				g_hash_table_insert(bd->column_families, g_strdup(cf_names[j]), cf_handles[j]);
+			}
+
 			break;
 		}
 	}
 
-	rocksdb_options_destroy(options);
+	if (cf_names_allocated)
+	{
+		rocksdb_list_column_families_destroy(cf_names, cf_names_len);
+	}
 
 	*backend_data = bd;
 
@@ -317,6 +530,10 @@ backend_fini(gpointer backend_data)
 {
 	JRocksDBData* bd = backend_data;
 
+	// Column family handles have to be destroyed before closing the database
+	g_hash_table_unref(bd->column_families);
+	g_rw_lock_clear(&(bd->column_families_lock));
+
 	rocksdb_readoptions_destroy(bd->read_options);
 	rocksdb_writeoptions_destroy(bd->write_options);
 	rocksdb_writeoptions_destroy(bd->write_options_sync);
@@ -326,6 +543,9 @@ backend_fini(gpointer backend_data)
 		rocksdb_close(bd->db);
 	}
 
+	rocksdb_options_destroy(bd->options);
+	rocksdb_cache_destroy(bd->cache);
+
 	g_slice_free(JRocksDBData, bd);
 }
 
@@ -342,7 +562,8 @@ static JBackend rocksdb_backend = {
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_iterate = backend_iterate,
+		.backend_statistics = backend_statistics }
 };
 
 G_MODULE_EXPORT
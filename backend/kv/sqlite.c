@@ -21,62 +21,319 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <sqlite3.h>
 
 #include <julea.h>
 
+enum JSQLiteStatement
+{
+	J_SQLITE_STATEMENT_BEGIN,
+	J_SQLITE_STATEMENT_COMMIT,
+	J_SQLITE_STATEMENT_ROLLBACK,
+	J_SQLITE_STATEMENT_PUT,
+	J_SQLITE_STATEMENT_DELETE,
+	J_SQLITE_STATEMENT_GET,
+	J_SQLITE_STATEMENT_GET_ALL,
+	J_SQLITE_STATEMENT_GET_BY_PREFIX,
+	J_SQLITE_STATEMENT_GET_BY_PREFIX_UNBOUNDED,
+	J_SQLITE_STATEMENT_COUNT
+};
+
+typedef enum JSQLiteStatement JSQLiteStatement;
+
+static gchar const* const j_sqlite_statements[J_SQLITE_STATEMENT_COUNT] = {
+	[J_SQLITE_STATEMENT_BEGIN] = "BEGIN IMMEDIATE;",
+	[J_SQLITE_STATEMENT_COMMIT] = "COMMIT;",
+	[J_SQLITE_STATEMENT_ROLLBACK] = "ROLLBACK;",
+	[J_SQLITE_STATEMENT_PUT] = "INSERT OR REPLACE INTO julea (namespace, key, value) VALUES (?, ?, ?);",
+	[J_SQLITE_STATEMENT_DELETE] = "DELETE FROM julea WHERE namespace = ? AND key = ?;",
+	[J_SQLITE_STATEMENT_GET] = "SELECT value FROM julea WHERE namespace = ? AND key = ?;",
+	[J_SQLITE_STATEMENT_GET_ALL] = "SELECT key, value FROM julea WHERE namespace = ?;",
+	// Prefix scans are expressed as key ranges so that they can use the (namespace, key) index
+	[J_SQLITE_STATEMENT_GET_BY_PREFIX] = "SELECT key, value FROM julea WHERE namespace = ? AND key >= ? AND key < ?;",
+	[J_SQLITE_STATEMENT_GET_BY_PREFIX_UNBOUNDED] = "SELECT key, value FROM julea WHERE namespace = ? AND key >= ?;",
+};
+
 struct JSQLiteBatch
 {
 	gchar* namespace;
 	JSemantics* semantics;
+
+	/**
+	 * Whether a transaction has been started.
+	 * Transactions are only started for modifying operations to not block other writers.
+	 **/
+	gboolean transaction;
 };
 
 typedef struct JSQLiteBatch JSQLiteBatch;
 
+struct JSQLiteIterator
+{
+	sqlite3_stmt* stmt;
+
+	/**
+	 * Whether the statement belongs to the statement cache and has to be reset instead of finalized.
+	 **/
+	gboolean cached;
+};
+
+typedef struct JSQLiteIterator JSQLiteIterator;
+
 struct JSQLiteData
 {
+	gchar* path;
 	sqlite3* db;
 };
 
 typedef struct JSQLiteData JSQLiteData;
 
+/**
+ * Each thread uses its own connection and prepared statements.
+ * In WAL mode, readers do not block writers and vice versa.
+ **/
+struct JSQLiteThreadVariables
+{
+	sqlite3* db;
+	sqlite3_stmt* statements[J_SQLITE_STATEMENT_COUNT];
+	gint synchronous;
+};
+
+typedef struct JSQLiteThreadVariables JSQLiteThreadVariables;
+
+static void thread_variables_fini(gpointer ptr);
+static GPrivate thread_variables_global = G_PRIVATE_INIT(thread_variables_fini);
+
+static void
+thread_variables_fini(gpointer ptr)
+{
+	JSQLiteThreadVariables* thread_variables = ptr;
+
+	if (thread_variables != NULL)
+	{
+		for (guint i = 0; i < J_SQLITE_STATEMENT_COUNT; i++)
+		{
+			sqlite3_finalize(thread_variables->statements[i]);
+		}
+
+		sqlite3_close(thread_variables->db);
+		g_slice_free(JSQLiteThreadVariables, thread_variables);
+	}
+}
+
 static gboolean
-backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+open_database(gchar const* path, sqlite3** db, gint flags)
 {
-	JSQLiteBatch* batch = NULL;
-	JSQLiteData* bd = backend_data;
+	if (sqlite3_open_v2(path, db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | flags, NULL) != SQLITE_OK)
+	{
+		goto error;
+	}
 
-	g_return_val_if_fail(namespace != NULL, FALSE);
-	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	// Writers are serialized by SQLite, wait for other connections instead of failing immediately
+	if (sqlite3_busy_timeout(*db, 10000) != SQLITE_OK)
+	{
+		goto error;
+	}
+
+	return TRUE;
+
+error:
+	sqlite3_close(*db);
+	*db = NULL;
+
+	return FALSE;
+}
+
+static JSQLiteThreadVariables*
+thread_variables_get(JSQLiteData* bd)
+{
+	JSQLiteThreadVariables* thread_variables;
+
+	thread_variables = g_private_get(&thread_variables_global);
+
+	if (G_UNLIKELY(thread_variables == NULL))
+	{
+		thread_variables = g_slice_new0(JSQLiteThreadVariables);
+		thread_variables->synchronous = -1;
+
+		// Connections are never shared between threads, so SQLite's mutexes are not necessary
+		if (!open_database(bd->path, &(thread_variables->db), SQLITE_OPEN_NOMUTEX))
+		{
+			g_slice_free(JSQLiteThreadVariables, thread_variables);
+			return NULL;
+		}
+
+		g_private_replace(&thread_variables_global, thread_variables);
+	}
+
+	return thread_variables;
+}
+
+/**
+ * Returns a reset prepared statement from the thread's statement cache.
+ *
+ * \param thread_variables The thread variables.
+ * \param statement        The statement.
+ *
+ * \return The prepared statement or NULL on error.
+ **/
+static sqlite3_stmt*
+get_statement(JSQLiteThreadVariables* thread_variables, JSQLiteStatement statement)
+{
+	sqlite3_stmt* stmt;
+
+	stmt = thread_variables->statements[statement];
+
+	if (G_UNLIKELY(stmt == NULL))
+	{
+		if (sqlite3_prepare_v3(thread_variables->db, j_sqlite_statements[statement], -1, SQLITE_PREPARE_PERSISTENT, &stmt, NULL) != SQLITE_OK)
+		{
+			return NULL;
+		}
+
+		thread_variables->statements[statement] = stmt;
+	}
+
+	return stmt;
+}
+
+static gboolean
+step_statement(sqlite3_stmt* stmt)
+{
+	gint ret;
+
+	ret = sqlite3_step(stmt);
+
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
+
+	return (ret == SQLITE_DONE || ret == SQLITE_ROW);
+}
+
+static gboolean
+execute_statement(JSQLiteThreadVariables* thread_variables, JSQLiteStatement statement)
+{
+	sqlite3_stmt* stmt;
+
+	if ((stmt = get_statement(thread_variables, statement)) == NULL)
+	{
+		return FALSE;
+	}
+
+	return step_statement(stmt);
+}
+
+static gboolean
+set_synchronous(JSQLiteThreadVariables* thread_variables, JSemantics* semantics)
+{
+	gint synchronous;
+
+	switch (j_semantics_get(semantics, J_SEMANTICS_SAFETY))
+	{
+		case J_SEMANTICS_SAFETY_NONE:
+			// OFF
+			synchronous = 0;
+			break;
+		case J_SEMANTICS_SAFETY_NETWORK:
+			// NORMAL, the database can not be corrupted in WAL mode but the last transactions might be lost
+			synchronous = 1;
+			break;
+		case J_SEMANTICS_SAFETY_STORAGE:
+		default:
+			// FULL
+			synchronous = 2;
+			break;
+	}
+
+	if (synchronous != thread_variables->synchronous)
+	{
+		g_autofree gchar* sql = NULL;
 
-	if (sqlite3_exec(bd->db, "BEGIN TRANSACTION;", NULL, NULL, NULL) == SQLITE_OK)
+		sql = g_strdup_printf("PRAGMA synchronous = %d;", synchronous);
+
+		if (sqlite3_exec(thread_variables->db, sql, NULL, NULL, NULL) != SQLITE_OK)
+		{
+			return FALSE;
+		}
+
+		thread_variables->synchronous = synchronous;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Starts the batch's transaction if necessary.
+ **/
+static gboolean
+begin_transaction(JSQLiteThreadVariables* thread_variables, JSQLiteBatch* batch)
+{
+	if (batch->transaction)
 	{
-		batch = g_slice_new(JSQLiteBatch);
+		return TRUE;
+	}
 
-		batch->namespace = g_strdup(namespace);
-		batch->semantics = j_semantics_ref(semantics);
+	if (!set_synchronous(thread_variables, batch->semantics))
+	{
+		return FALSE;
 	}
 
+	if (!execute_statement(thread_variables, J_SQLITE_STATEMENT_BEGIN))
+	{
+		return FALSE;
+	}
+
+	batch->transaction = TRUE;
+
+	return TRUE;
+}
+
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+{
+	JSQLiteBatch* batch;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	batch = g_slice_new(JSQLiteBatch);
+	batch->namespace = g_strdup(namespace);
+	batch->semantics = j_semantics_ref(semantics);
+	batch->transaction = FALSE;
+
 	*backend_batch = batch;
 
-	return (batch != NULL);
+	return TRUE;
 }
 
 static gboolean
 backend_batch_execute(gpointer backend_data, gpointer backend_batch)
 {
-	gboolean ret = FALSE;
+	gboolean ret = TRUE;
 
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThreadVariables* thread_variables;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 
-	// FIXME do something with batch->semantics
-
-	if (sqlite3_exec(bd->db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK)
+	if (batch->transaction)
 	{
-		ret = TRUE;
+		ret = FALSE;
+
+		if ((thread_variables = thread_variables_get(bd)) != NULL)
+		{
+			ret = execute_statement(thread_variables, J_SQLITE_STATEMENT_COMMIT);
+
+			if (!ret)
+			{
+				execute_statement(thread_variables, J_SQLITE_STATEMENT_ROLLBACK);
+			}
+		}
 	}
 
 	j_semantics_unref(batch->semantics);
@@ -91,22 +348,28 @@ backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gco
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThreadVariables* thread_variables;
 	sqlite3_stmt* stmt;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 	g_return_val_if_fail(value != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "INSERT OR REPLACE INTO julea (namespace, key, value) VALUES (?, ?, ?);", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
-	sqlite3_bind_blob(stmt, 3, value, len, NULL);
+	if ((thread_variables = thread_variables_get(bd)) == NULL || !begin_transaction(thread_variables, batch))
+	{
+		return FALSE;
+	}
 
-	sqlite3_step(stmt);
-	sqlite3_finalize(stmt);
+	if ((stmt = get_statement(thread_variables, J_SQLITE_STATEMENT_PUT)) == NULL)
+	{
+		return FALSE;
+	}
 
-	// FIXME
-	return TRUE;
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+	sqlite3_bind_blob(stmt, 3, value, len, SQLITE_STATIC);
+
+	return step_statement(stmt);
 }
 
 static gboolean
@@ -114,20 +377,26 @@ backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThreadVariables* thread_variables;
 	sqlite3_stmt* stmt;
 
 	g_return_val_if_fail(backend_batch != NULL, FALSE);
 	g_return_val_if_fail(key != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "DELETE FROM julea WHERE namespace = ? AND key = ?;", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
+	if ((thread_variables = thread_variables_get(bd)) == NULL || !begin_transaction(thread_variables, batch))
+	{
+		return FALSE;
+	}
 
-	sqlite3_step(stmt);
-	sqlite3_finalize(stmt);
+	if ((stmt = get_statement(thread_variables, J_SQLITE_STATEMENT_DELETE)) == NULL)
+	{
+		return FALSE;
+	}
 
-	// FIXME
-	return TRUE;
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+
+	return step_statement(stmt);
 }
 
 static gboolean
@@ -135,6 +404,7 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 {
 	JSQLiteBatch* batch = backend_batch;
 	JSQLiteData* bd = backend_data;
+	JSQLiteThreadVariables* thread_variables;
 	sqlite3_stmt* stmt;
 	gint ret;
 	gconstpointer result = NULL;
@@ -145,9 +415,19 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	sqlite3_prepare_v2(bd->db, "SELECT value FROM julea WHERE namespace = ? AND key = ?;", -1, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, batch->namespace, -1, NULL);
-	sqlite3_bind_text(stmt, 2, key, -1, NULL);
+	// Reads do not start a transaction and see the batch's previous writes if there are any
+	if ((thread_variables = thread_variables_get(bd)) == NULL)
+	{
+		return FALSE;
+	}
+
+	if ((stmt = get_statement(thread_variables, J_SQLITE_STATEMENT_GET)) == NULL)
+	{
+		return FALSE;
+	}
+
+	sqlite3_bind_text(stmt, 1, batch->namespace, -1, SQLITE_STATIC);
+	sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
 
 	ret = sqlite3_step(stmt);
 
@@ -165,55 +445,145 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 		*len = result_len;
 	}
 
-	sqlite3_finalize(stmt);
+	sqlite3_reset(stmt);
+	sqlite3_clear_bindings(stmt);
 
 	return (result != NULL);
 }
 
+/**
+ * Creates an iterator for the given statement.
+ * If the cached statement is still in use by another iterator, a new one is prepared.
+ **/
+static JSQLiteIterator*
+iterator_new(JSQLiteThreadVariables* thread_variables, JSQLiteStatement statement)
+{
+	JSQLiteIterator* iterator;
+	sqlite3_stmt* stmt;
+	gboolean cached = TRUE;
+
+	if ((stmt = get_statement(thread_variables, statement)) == NULL)
+	{
+		return NULL;
+	}
+
+	if (sqlite3_stmt_busy(stmt))
+	{
+		if (sqlite3_prepare_v2(thread_variables->db, j_sqlite_statements[statement], -1, &stmt, NULL) != SQLITE_OK)
+		{
+			return NULL;
+		}
+
+		cached = FALSE;
+	}
+
+	iterator = g_slice_new(JSQLiteIterator);
+	iterator->stmt = stmt;
+	iterator->cached = cached;
+
+	return iterator;
+}
+
+static void
+iterator_free(JSQLiteIterator* iterator)
+{
+	if (iterator->cached)
+	{
+		sqlite3_reset(iterator->stmt);
+		sqlite3_clear_bindings(iterator->stmt);
+	}
+	else
+	{
+		sqlite3_finalize(iterator->stmt);
+	}
+
+	g_slice_free(JSQLiteIterator, iterator);
+}
+
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
 	JSQLiteData* bd = backend_data;
-	sqlite3_stmt* stmt = NULL;
+	JSQLiteThreadVariables* thread_variables;
+	JSQLiteIterator* iterator = NULL;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	if (sqlite3_prepare_v2(bd->db, "SELECT key, value FROM julea WHERE namespace = ?;", -1, &stmt, NULL) == SQLITE_OK)
+	if ((thread_variables = thread_variables_get(bd)) != NULL)
+	{
+		iterator = iterator_new(thread_variables, J_SQLITE_STATEMENT_GET_ALL);
+	}
+
+	if (iterator != NULL)
 	{
-		sqlite3_bind_text(stmt, 1, namespace, -1, NULL);
+		sqlite3_bind_text(iterator->stmt, 1, namespace, -1, SQLITE_TRANSIENT);
 	}
 
-	*backend_iterator = stmt;
+	*backend_iterator = iterator;
 
-	return (stmt != NULL);
+	return (iterator != NULL);
 }
 
 static gboolean
 backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
 {
 	JSQLiteData* bd = backend_data;
-	sqlite3_stmt* stmt = NULL;
+	JSQLiteThreadVariables* thread_variables;
+	JSQLiteIterator* iterator = NULL;
+	gchar* upper_bound;
+	gsize upper_bound_len;
 
 	g_return_val_if_fail(namespace != NULL, FALSE);
 	g_return_val_if_fail(prefix != NULL, FALSE);
 	g_return_val_if_fail(backend_iterator != NULL, FALSE);
 
-	if (sqlite3_prepare_v2(bd->db, "SELECT key, value FROM julea WHERE namespace = ? AND key LIKE ? || '%';", -1, &stmt, NULL) == SQLITE_OK)
+	if ((thread_variables = thread_variables_get(bd)) == NULL)
+	{
+		goto end;
+	}
+
+	// The exclusive upper bound is the shortest string greater than all strings starting with the prefix
+	upper_bound = g_strdup(prefix);
+	upper_bound_len = strlen(upper_bound);
+
+	while (upper_bound_len > 0 && (guchar)upper_bound[upper_bound_len - 1] == 0xff)
 	{
-		sqlite3_bind_text(stmt, 1, namespace, -1, NULL);
-		sqlite3_bind_text(stmt, 2, prefix, -1, NULL);
+		upper_bound_len--;
 	}
 
-	*backend_iterator = stmt;
+	if (upper_bound_len > 0)
+	{
+		upper_bound[upper_bound_len - 1]++;
 
-	return (stmt != NULL);
+		if ((iterator = iterator_new(thread_variables, J_SQLITE_STATEMENT_GET_BY_PREFIX)) != NULL)
+		{
+			sqlite3_bind_text(iterator->stmt, 3, upper_bound, upper_bound_len, SQLITE_TRANSIENT);
+		}
+	}
+	else
+	{
+		iterator = iterator_new(thread_variables, J_SQLITE_STATEMENT_GET_BY_PREFIX_UNBOUNDED);
+	}
+
+	if (iterator != NULL)
+	{
+		sqlite3_bind_text(iterator->stmt, 1, namespace, -1, SQLITE_TRANSIENT);
+		sqlite3_bind_text(iterator->stmt, 2, prefix, -1, SQLITE_TRANSIENT);
+	}
+
+	g_free(upper_bound);
+
+end:
+	*backend_iterator = iterator;
+
+	return (iterator != NULL);
 }
 
 static gboolean
 backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
 {
-	sqlite3_stmt* stmt = backend_iterator;
+	JSQLiteIterator* iterator = backend_iterator;
 
 	(void)backend_data;
 
@@ -221,16 +591,16 @@ backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const**
 	g_return_val_if_fail(value != NULL, FALSE);
 	g_return_val_if_fail(len != NULL, FALSE);
 
-	if (sqlite3_step(stmt) == SQLITE_ROW)
+	if (sqlite3_step(iterator->stmt) == SQLITE_ROW)
 	{
-		*key = (gchar const*)sqlite3_column_text(stmt, 0);
-		*value = sqlite3_column_blob(stmt, 1);
-		*len = sqlite3_column_bytes(stmt, 1);
+		*key = (gchar const*)sqlite3_column_text(iterator->stmt, 0);
+		*value = sqlite3_column_blob(iterator->stmt, 1);
+		*len = sqlite3_column_bytes(iterator->stmt, 1);
 
 		return TRUE;
 	}
 
-	sqlite3_finalize(stmt);
+	iterator_free(iterator);
 
 	return FALSE;
 }
@@ -247,28 +617,33 @@ backend_init(gchar const* path, gpointer* backend_data)
 	g_mkdir_with_parents(dirname, 0700);
 
 	bd = g_slice_new(JSQLiteData);
+	bd->path = g_strdup(path);
 
-	if (sqlite3_open(path, &(bd->db)) != SQLITE_OK)
+	if (!open_database(path, &(bd->db), 0))
 	{
 		goto error;
 	}
 
-	if (sqlite3_exec(bd->db, "CREATE TABLE IF NOT EXISTS julea (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL);", NULL, NULL, NULL) != SQLITE_OK)
+	// The journal mode is persistent and applies to all connections
+	if (sqlite3_exec(bd->db, "PRAGMA journal_mode = WAL;", NULL, NULL, NULL) != SQLITE_OK)
 	{
 		goto error;
 	}
 
-	if (sqlite3_exec(bd->db, "CREATE UNIQUE INDEX IF NOT EXISTS julea_namespace_key ON julea (namespace, key);", NULL, NULL, NULL) != SQLITE_OK)
+	// The primary key doubles as a covering index on (namespace, key), lookups do not need a separate rowid access
+	// Databases created by earlier versions use a unique index on (namespace, key) instead, which is left untouched
+	if (sqlite3_exec(bd->db, "CREATE TABLE IF NOT EXISTS julea (namespace TEXT NOT NULL, key TEXT NOT NULL, value BLOB NOT NULL, PRIMARY KEY (namespace, key)) WITHOUT ROWID;", NULL, NULL, NULL) != SQLITE_OK)
 	{
 		goto error;
 	}
 
 	*backend_data = bd;
 
-	return (bd->db != NULL);
+	return TRUE;
 
 error:
 	sqlite3_close(bd->db);
+	g_free(bd->path);
 	g_slice_free(JSQLiteData, bd);
 
 	return FALSE;
@@ -279,11 +654,15 @@ backend_fini(gpointer backend_data)
 {
 	JSQLiteData* bd = backend_data;
 
+	// Closes the current thread's connection, other threads close theirs when they exit
+	g_private_replace(&thread_variables_global, NULL);
+
 	if (bd->db != NULL)
 	{
 		sqlite3_close(bd->db);
 	}
 
+	g_free(bd->path);
 	g_slice_free(JSQLiteData, bd);
 }
 
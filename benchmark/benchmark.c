@@ -51,6 +51,8 @@ j_benchmark_timer_start(BenchmarkRun* run)
 {
 	g_return_if_fail(run != NULL);
 
+	run->messages_start = j_message_get_written();
+
 	if (!run->timer_started)
 	{
 		g_timer_start(run->timer);
@@ -68,6 +70,8 @@ j_benchmark_timer_stop(BenchmarkRun* run)
 	g_return_if_fail(run != NULL);
 
 	g_timer_stop(run->timer);
+
+	run->messages += j_message_get_written() - run->messages_start;
 }
 
 gboolean
@@ -115,6 +119,8 @@ j_benchmark_add(gchar const* name, BenchmarkFunc benchmark_func)
 	run->iterations = 0;
 	run->operations = 0;
 	run->bytes = 0;
+	run->messages_start = 0;
+	run->messages = 0;
 
 	j_benchmarks = g_list_prepend(j_benchmarks, run);
 }
@@ -202,6 +208,11 @@ j_benchmark_run_one(BenchmarkRun* run)
 			g_print(" (%s/s)", size);
 		}
 
+		if (run->operations != 0)
+		{
+			g_print(" {%.1f}", (gdouble)run->messages / run->operations);
+		}
+
 		g_print(" [%.3f seconds]\n", elapsed_total);
 	}
 	else
@@ -226,6 +237,15 @@ j_benchmark_run_one(BenchmarkRun* run)
 			g_print("%s-", opt_machine_separator);
 		}
 
+		if (run->operations != 0)
+		{
+			g_print("%s%f", opt_machine_separator, (gdouble)run->messages / run->operations);
+		}
+		else
+		{
+			g_print("%s-", opt_machine_separator);
+		}
+
 		g_print("%s%f\n", opt_machine_separator, elapsed_total);
 	}
 
@@ -252,7 +272,7 @@ j_benchmark_run_all(void)
 		gsize pad;
 
 		left = "Name";
-		right = "Duration (Operations/s) (Throughput/s) [Total Duration]";
+		right = "Duration (Operations/s) (Throughput/s) {Messages/Operation} [Total Duration]";
 		pad = j_benchmark_name_max + 2 - strlen(left);
 
 		g_print("Name");
@@ -273,7 +293,7 @@ j_benchmark_run_all(void)
 	}
 	else
 	{
-		g_print("name%selapsed%soperations%sbytes%stotal_elapsed\n", opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator);
+		g_print("name%selapsed%soperations%sbytes%smessages%stotal_elapsed\n", opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator, opt_machine_separator);
 	}
 
 	j_benchmarks = g_list_reverse(j_benchmarks);
@@ -364,6 +384,7 @@ main(int argc, char** argv)
 	// HDF5 client
 	benchmark_hdf();
 	benchmark_hdf_dai();
+	benchmark_hdf_pattern();
 
 	j_benchmark_run_all();
 
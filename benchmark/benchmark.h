@@ -30,6 +30,9 @@ struct BenchmarkRun
 	guint iterations;
 	guint64 operations;
 	guint64 bytes;
+	// Messages sent while the timer was running, approximating the number of round trips
+	guint32 messages_start;
+	guint64 messages;
 };
 
 typedef struct BenchmarkRun BenchmarkRun;
@@ -66,5 +69,6 @@ void benchmark_item(void);
 
 void benchmark_hdf(void);
 void benchmark_hdf_dai(void);
+void benchmark_hdf_pattern(void);
 
 #endif
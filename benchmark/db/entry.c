@@ -64,7 +64,7 @@ _benchmark_db_delete(BenchmarkRun* run, gchar const* namespace, gboolean use_bat
 			g_assert_true(ret);
 			g_assert_null(b_s_error);
 
-			ret = j_db_entry_delete(entry, selector, batch, &b_s_error);
+			ret = j_db_entry_delete(entry, selector, NULL, batch, &b_s_error);
 			g_assert_true(ret);
 			g_assert_null(b_s_error);
 
@@ -132,7 +132,7 @@ _benchmark_db_update(BenchmarkRun* run, gchar const* namespace, gboolean use_bat
 			g_assert_true(ret);
 			g_assert_null(b_s_error);
 
-			ret = j_db_entry_update(entry, selector, batch, &b_s_error);
+			ret = j_db_entry_update(entry, selector, NULL, batch, &b_s_error);
 			g_assert_true(ret);
 			g_assert_null(b_s_error);
 
@@ -431,6 +431,210 @@ benchmark_hdf_dai_db_iterator(BenchmarkRun* run)
 	run->operations = attrs / iter;
 }
 
+static void
+benchmark_hdf_dai_query(BenchmarkRun* run)
+{
+	guint const n = 1024 * 1024;
+	guint const chunk = 16 * 1024;
+	guint const threshold = n - chunk;
+
+	g_autofree int* data = NULL;
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t dcpl;
+	hid_t file;
+	hsize_t dims[1];
+	hsize_t chunk_dims[1];
+	guint iter = 0;
+
+	set_semantics();
+
+	data = g_new(int, n);
+
+	for (guint i = 0; i < n; i++)
+	{
+		data[i] = i;
+	}
+
+	dims[0] = n;
+	chunk_dims[0] = chunk;
+
+	while (j_benchmark_iterate(run))
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("benchmark-dai-query-%u.h5", iter);
+		file = H5Fcreate(name, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+		dataspace = H5Screate_simple(1, dims, NULL);
+		dcpl = H5Pcreate(H5P_DATASET_CREATE);
+		H5Pset_chunk(dcpl, 1, chunk_dims);
+
+		dataset = H5Dcreate2(file, "benchmark-dai-query", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+		H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < 100; i++)
+		{
+			hid_t memspace;
+			hid_t selection;
+			hsize_t mem_dims[1];
+			guint matches = 0;
+
+			// Only the last chunk can contain matching values, the query avoids reading the others
+			selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_GE, threshold);
+			g_assert_cmpint(selection, >=, 0);
+
+			mem_dims[0] = H5Sget_select_npoints(selection);
+			memspace = H5Screate_simple(1, mem_dims, NULL);
+			H5Dread(dataset, H5T_NATIVE_INT, memspace, selection, H5P_DEFAULT, data);
+
+			for (guint j = 0; j < mem_dims[0]; j++)
+			{
+				if ((guint)data[j] >= threshold)
+				{
+					matches++;
+				}
+			}
+
+			g_assert_cmpuint(matches, ==, n - threshold);
+
+			H5Sclose(memspace);
+			H5Sclose(selection);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		// The buffer has been overwritten by the reads
+		for (guint i = 0; i < n; i++)
+		{
+			data[i] = i;
+		}
+
+		H5Dclose(dataset);
+		H5Pclose(dcpl);
+		H5Sclose(dataspace);
+		H5Fclose(file);
+
+		iter++;
+	}
+
+	run->operations = 100;
+}
+
+static void
+_benchmark_hdf_dai_query_files(BenchmarkRun* run, guint matching_chunks)
+{
+	guint const n = 25;
+	guint const elements = 64 * 1024;
+	guint const chunk = 4 * 1024;
+	guint const threshold = elements - (matching_chunks * chunk);
+
+	g_autofree int* data = NULL;
+	hsize_t dims[1];
+	hsize_t chunk_dims[1];
+	guint iter = 0;
+
+	set_semantics();
+
+	data = g_new(int, elements);
+
+	dims[0] = elements;
+	chunk_dims[0] = chunk;
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < elements; i++)
+		{
+			data[i] = i;
+		}
+
+		for (guint i = 0; i < n; i++)
+		{
+			hid_t dataset;
+			hid_t dataspace;
+			hid_t dcpl;
+			hid_t file;
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-dai-query-files-%u-%u.h5", matching_chunks, i + (iter * n));
+			file = H5Fcreate(name, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+			dataspace = H5Screate_simple(1, dims, NULL);
+			dcpl = H5Pcreate(H5P_DATASET_CREATE);
+			H5Pset_chunk(dcpl, 1, chunk_dims);
+
+			dataset = H5Dcreate2(file, "benchmark-dai-query-files", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+			H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+
+			H5Dclose(dataset);
+			H5Pclose(dcpl);
+			H5Sclose(dataspace);
+			H5Fclose(file);
+		}
+
+		j_benchmark_timer_start(run);
+
+		// Every file is opened and queried, as when searching a collection of files for interesting data
+		for (guint i = 0; i < n; i++)
+		{
+			hid_t dataset;
+			hid_t file;
+			hid_t memspace;
+			hid_t selection;
+			hsize_t mem_dims[1];
+			guint matches = 0;
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-dai-query-files-%u-%u.h5", matching_chunks, i + (iter * n));
+			file = H5Fopen(name, H5F_ACC_RDONLY, H5P_DEFAULT);
+			dataset = H5Dopen2(file, "benchmark-dai-query-files", H5P_DEFAULT);
+
+			selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_GE, threshold);
+			g_assert_cmpint(selection, >=, 0);
+
+			mem_dims[0] = H5Sget_select_npoints(selection);
+			memspace = H5Screate_simple(1, mem_dims, NULL);
+			H5Dread(dataset, H5T_NATIVE_INT, memspace, selection, H5P_DEFAULT, data);
+
+			for (guint j = 0; j < mem_dims[0]; j++)
+			{
+				if ((guint)data[j] >= threshold)
+				{
+					matches++;
+				}
+			}
+
+			g_assert_cmpuint(matches, ==, elements - threshold);
+
+			H5Sclose(memspace);
+			H5Sclose(selection);
+			H5Dclose(dataset);
+			H5Fclose(file);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		iter++;
+	}
+
+	run->operations = n;
+	run->bytes = n * (elements - threshold) * sizeof(int);
+}
+
+static void
+benchmark_hdf_dai_query_files_narrow(BenchmarkRun* run)
+{
+	_benchmark_hdf_dai_query_files(run, 1);
+}
+
+static void
+benchmark_hdf_dai_query_files_wide(BenchmarkRun* run)
+{
+	_benchmark_hdf_dai_query_files(run, 8);
+}
+
 #endif
 
 void
@@ -456,6 +660,9 @@ benchmark_hdf_dai(void)
 	else if (g_strcmp0(vol_connector, "julea-db") == 0)
 	{
 		j_benchmark_add("/hdf5/dai/db-iterator", benchmark_hdf_dai_db_iterator);
+		j_benchmark_add("/hdf5/dai/query", benchmark_hdf_dai_query);
+		j_benchmark_add("/hdf5/dai/query-files/narrow", benchmark_hdf_dai_query_files_narrow);
+		j_benchmark_add("/hdf5/dai/query-files/wide", benchmark_hdf_dai_query_files_wide);
 	}
 #endif
 }
@@ -0,0 +1,699 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Access patterns that stress the VOL plugins: strided hyperslabs, many tiny datasets, deep group hierarchies and concurrent readers.
+ * Every pattern is run for several shapes and sizes.
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "benchmark.h"
+
+#ifdef HAVE_HDF5
+
+#include <julea-hdf5.h>
+
+#include <hdf5.h>
+
+static gchar const* vol_connector = NULL;
+
+// FIXME redundant (see hdf.c)
+static void
+set_semantics(void)
+{
+	g_autoptr(JSemantics) semantics = NULL;
+
+	semantics = j_benchmark_get_semantics();
+	j_hdf5_set_semantics(semantics);
+}
+
+// FIXME redundant (see hdf.c)
+static void
+sync_file(gchar const* path)
+{
+	if (g_strcmp0(vol_connector, "native") == 0)
+	{
+		g_autoptr(JSemantics) semantics = NULL;
+
+		semantics = j_benchmark_get_semantics();
+
+		if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_NONE)
+		{
+			return;
+		}
+
+		j_helper_file_sync(path);
+	}
+}
+
+// FIXME redundant (see hdf.c)
+static void
+discard_file(gchar const* path)
+{
+	if (g_strcmp0(vol_connector, "native") == 0)
+	{
+		j_helper_file_discard(path);
+	}
+}
+
+static hid_t
+create_dataset(hid_t file, gchar const* name, guint ndims, hsize_t const* dims, hsize_t const* chunk_dims)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t dcpl = H5P_DEFAULT;
+
+	dataspace = H5Screate_simple(ndims, dims, NULL);
+
+	if (chunk_dims != NULL)
+	{
+		dcpl = H5Pcreate(H5P_DATASET_CREATE);
+		H5Pset_chunk(dcpl, ndims, chunk_dims);
+	}
+
+	dataset = H5Dcreate2(file, name, H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+	if (dcpl != H5P_DEFAULT)
+	{
+		H5Pclose(dcpl);
+	}
+
+	H5Sclose(dataspace);
+
+	return dataset;
+}
+
+/**
+ * Selects every stride-th row or column of a square dataset.
+ **/
+static hid_t
+select_hyperslab(guint size, guint stride, gboolean columns, hsize_t* elements)
+{
+	hid_t dataspace;
+
+	hsize_t dims[2] = { size, size };
+	hsize_t start[2] = { 0, 0 };
+	hsize_t strides[2] = { 1, 1 };
+	hsize_t count[2] = { 1, 1 };
+	hsize_t block[2] = { size, size };
+
+	// Columns result in many small ranges, rows in few large ones
+	if (columns)
+	{
+		strides[1] = stride;
+		count[1] = size / stride;
+		block[1] = 1;
+	}
+	else
+	{
+		strides[0] = stride;
+		count[0] = size / stride;
+		block[0] = 1;
+	}
+
+	dataspace = H5Screate_simple(2, dims, NULL);
+	H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, start, strides, count, block);
+
+	*elements = H5Sget_select_npoints(dataspace);
+
+	return dataspace;
+}
+
+static void
+_benchmark_hdf_hyperslab(BenchmarkRun* run, guint stride, gboolean columns, gboolean write)
+{
+	guint const n = 10;
+	guint const size = 1024;
+
+	g_autofree gchar* path = NULL;
+	g_autofree int* data = NULL;
+	hid_t file;
+	hid_t memspace;
+	hid_t selection;
+	hsize_t dims[2] = { size, size };
+	hsize_t chunk_dims[2] = { 128, 128 };
+	hsize_t elements;
+	guint iter = 0;
+
+	set_semantics();
+
+	path = g_strdup_printf("benchmark-hyperslab-%s-%u-%s.h5", (columns) ? "columns" : "rows", stride, (write) ? "write" : "read");
+	file = H5Fcreate(path, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+
+	data = g_new(int, size * size);
+
+	for (guint i = 0; i < size * size; i++)
+	{
+		data[i] = i;
+	}
+
+	selection = select_hyperslab(size, stride, columns, &elements);
+	memspace = H5Screate_simple(1, &elements, NULL);
+
+	while (j_benchmark_iterate(run))
+	{
+		if (!write)
+		{
+			for (guint i = 0; i < n; i++)
+			{
+				hid_t dataset;
+				g_autofree gchar* name = NULL;
+
+				name = g_strdup_printf("benchmark-hyperslab-%u", i + (iter * n));
+				dataset = create_dataset(file, name, 2, dims, chunk_dims);
+				H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+				H5Dclose(dataset);
+			}
+
+			discard_file(path);
+		}
+
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < n; i++)
+		{
+			hid_t dataset;
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-hyperslab-%u", i + (iter * n));
+
+			if (write)
+			{
+				dataset = create_dataset(file, name, 2, dims, chunk_dims);
+				H5Dwrite(dataset, H5T_NATIVE_INT, memspace, selection, H5P_DEFAULT, data);
+			}
+			else
+			{
+				dataset = H5Dopen2(file, name, H5P_DEFAULT);
+				H5Dread(dataset, H5T_NATIVE_INT, memspace, selection, H5P_DEFAULT, data);
+			}
+
+			H5Dclose(dataset);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		if (!write)
+		{
+			// The buffer has been overwritten by the reads
+			for (guint i = 0; i < size * size; i++)
+			{
+				data[i] = i;
+			}
+		}
+
+		iter++;
+	}
+
+	H5Sclose(memspace);
+	H5Sclose(selection);
+
+	// Closing the file sends deferred metadata, which is part of writing
+	if (write)
+	{
+		j_benchmark_timer_start(run);
+	}
+
+	H5Fclose(file);
+
+	if (write)
+	{
+		sync_file(path);
+		j_benchmark_timer_stop(run);
+	}
+
+	run->operations = n;
+	run->bytes = n * elements * sizeof(int);
+}
+
+static void
+benchmark_hdf_hyperslab_rows_2_write(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 2, FALSE, TRUE);
+}
+
+static void
+benchmark_hdf_hyperslab_rows_2_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 2, FALSE, FALSE);
+}
+
+static void
+benchmark_hdf_hyperslab_rows_16_write(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 16, FALSE, TRUE);
+}
+
+static void
+benchmark_hdf_hyperslab_rows_16_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 16, FALSE, FALSE);
+}
+
+static void
+benchmark_hdf_hyperslab_columns_2_write(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 2, TRUE, TRUE);
+}
+
+static void
+benchmark_hdf_hyperslab_columns_2_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 2, TRUE, FALSE);
+}
+
+static void
+benchmark_hdf_hyperslab_columns_16_write(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 16, TRUE, TRUE);
+}
+
+static void
+benchmark_hdf_hyperslab_columns_16_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_hyperslab(run, 16, TRUE, FALSE);
+}
+
+static void
+_benchmark_hdf_tiny_dataset(BenchmarkRun* run, guint elements, gboolean write)
+{
+	guint const n = 1000;
+
+	g_autofree gchar* path = NULL;
+	g_autofree int* data = NULL;
+	hid_t file;
+	hsize_t dims[1] = { elements };
+	guint iter = 0;
+
+	set_semantics();
+
+	path = g_strdup_printf("benchmark-tiny-dataset-%u-%s.h5", elements, (write) ? "write" : "read");
+	file = H5Fcreate(path, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+
+	data = g_new(int, elements);
+
+	for (guint i = 0; i < elements; i++)
+	{
+		data[i] = i;
+	}
+
+	while (j_benchmark_iterate(run))
+	{
+		if (!write)
+		{
+			for (guint i = 0; i < n; i++)
+			{
+				hid_t dataset;
+				g_autofree gchar* name = NULL;
+
+				name = g_strdup_printf("benchmark-tiny-dataset-%u", i + (iter * n));
+				dataset = create_dataset(file, name, 1, dims, NULL);
+				H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+				H5Dclose(dataset);
+			}
+
+			discard_file(path);
+		}
+
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < n; i++)
+		{
+			hid_t dataset;
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-tiny-dataset-%u", i + (iter * n));
+
+			// Every dataset is created or opened, written or read and closed, so metadata dominates
+			if (write)
+			{
+				dataset = create_dataset(file, name, 1, dims, NULL);
+				H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+			}
+			else
+			{
+				dataset = H5Dopen2(file, name, H5P_DEFAULT);
+				H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+			}
+
+			H5Dclose(dataset);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		iter++;
+	}
+
+	if (write)
+	{
+		j_benchmark_timer_start(run);
+	}
+
+	H5Fclose(file);
+
+	if (write)
+	{
+		sync_file(path);
+		j_benchmark_timer_stop(run);
+	}
+
+	run->operations = n;
+	run->bytes = n * elements * sizeof(int);
+}
+
+static void
+benchmark_hdf_tiny_dataset_1_write(BenchmarkRun* run)
+{
+	_benchmark_hdf_tiny_dataset(run, 1, TRUE);
+}
+
+static void
+benchmark_hdf_tiny_dataset_1_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_tiny_dataset(run, 1, FALSE);
+}
+
+static void
+benchmark_hdf_tiny_dataset_64_write(BenchmarkRun* run)
+{
+	_benchmark_hdf_tiny_dataset(run, 64, TRUE);
+}
+
+static void
+benchmark_hdf_tiny_dataset_64_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_tiny_dataset(run, 64, FALSE);
+}
+
+/**
+ * Creates or opens a chain of nested groups.
+ * The groups are opened level by level, which requires one lookup per level.
+ **/
+static void
+walk_groups(hid_t file, gchar const* name, guint depth, gboolean create)
+{
+	hid_t group;
+
+	if (create)
+	{
+		group = H5Gcreate2(file, name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	}
+	else
+	{
+		group = H5Gopen2(file, name, H5P_DEFAULT);
+	}
+
+	for (guint i = 1; i < depth; i++)
+	{
+		hid_t child;
+		g_autofree gchar* child_name = NULL;
+
+		child_name = g_strdup_printf("level-%u", i);
+
+		if (create)
+		{
+			child = H5Gcreate2(group, child_name, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		}
+		else
+		{
+			child = H5Gopen2(group, child_name, H5P_DEFAULT);
+		}
+
+		H5Gclose(group);
+		group = child;
+	}
+
+	H5Gclose(group);
+}
+
+static void
+_benchmark_hdf_group_deep(BenchmarkRun* run, guint depth, gboolean create)
+{
+	guint const n = 100;
+
+	g_autofree gchar* path = NULL;
+	hid_t file;
+	guint iter = 0;
+
+	set_semantics();
+
+	path = g_strdup_printf("benchmark-group-deep-%u-%s.h5", depth, (create) ? "create" : "open");
+	file = H5Fcreate(path, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+
+	while (j_benchmark_iterate(run))
+	{
+		if (!create)
+		{
+			for (guint i = 0; i < n; i++)
+			{
+				g_autofree gchar* name = NULL;
+
+				name = g_strdup_printf("benchmark-group-deep-%u", i + (iter * n));
+				walk_groups(file, name, depth, TRUE);
+			}
+
+			discard_file(path);
+		}
+
+		j_benchmark_timer_start(run);
+
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-group-deep-%u", i + (iter * n));
+			walk_groups(file, name, depth, create);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		iter++;
+	}
+
+	if (create)
+	{
+		j_benchmark_timer_start(run);
+	}
+
+	H5Fclose(file);
+
+	if (create)
+	{
+		sync_file(path);
+		j_benchmark_timer_stop(run);
+	}
+
+	run->operations = n * depth;
+}
+
+static void
+benchmark_hdf_group_deep_8_create(BenchmarkRun* run)
+{
+	_benchmark_hdf_group_deep(run, 8, TRUE);
+}
+
+static void
+benchmark_hdf_group_deep_8_open(BenchmarkRun* run)
+{
+	_benchmark_hdf_group_deep(run, 8, FALSE);
+}
+
+static void
+benchmark_hdf_group_deep_32_create(BenchmarkRun* run)
+{
+	_benchmark_hdf_group_deep(run, 32, TRUE);
+}
+
+static void
+benchmark_hdf_group_deep_32_open(BenchmarkRun* run)
+{
+	_benchmark_hdf_group_deep(run, 32, FALSE);
+}
+
+#ifdef H5_HAVE_THREADSAFE
+
+struct ReaderData
+{
+	hid_t file;
+	guint first;
+	guint count;
+};
+
+typedef struct ReaderData ReaderData;
+
+static gpointer
+reader_thread(gpointer data)
+{
+	ReaderData* reader = data;
+	int buf[1024];
+
+	for (guint i = 0; i < reader->count; i++)
+	{
+		hid_t dataset;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("benchmark-threads-%u", reader->first + i);
+		dataset = H5Dopen2(reader->file, name, H5P_DEFAULT);
+		H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf);
+		H5Dclose(dataset);
+	}
+
+	return NULL;
+}
+
+static void
+_benchmark_hdf_threads_read(BenchmarkRun* run, guint threads)
+{
+	guint const n = 100;
+
+	g_autofree gchar* path = NULL;
+	g_autofree GThread** thread = NULL;
+	g_autofree ReaderData* reader = NULL;
+	hid_t file;
+	hsize_t dims[1] = { 1024 };
+	int data[1024];
+	guint iter = 0;
+
+	set_semantics();
+
+	path = g_strdup_printf("benchmark-threads-%u-read.h5", threads);
+	file = H5Fcreate(path, H5F_ACC_EXCL, H5P_DEFAULT, H5P_DEFAULT);
+
+	thread = g_new(GThread*, threads);
+	reader = g_new(ReaderData, threads);
+
+	for (guint i = 0; i < 1024; i++)
+	{
+		data[i] = i;
+	}
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < n * threads; i++)
+		{
+			hid_t dataset;
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-threads-%u", i + (iter * n * threads));
+			dataset = create_dataset(file, name, 1, dims, NULL);
+			H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+			H5Dclose(dataset);
+		}
+
+		discard_file(path);
+
+		j_benchmark_timer_start(run);
+
+		// Every thread reads its own datasets from the shared file
+		for (guint i = 0; i < threads; i++)
+		{
+			reader[i].file = file;
+			reader[i].first = (iter * n * threads) + (i * n);
+			reader[i].count = n;
+
+			thread[i] = g_thread_new("benchmark-reader", reader_thread, &reader[i]);
+		}
+
+		for (guint i = 0; i < threads; i++)
+		{
+			g_thread_join(thread[i]);
+		}
+
+		j_benchmark_timer_stop(run);
+
+		iter++;
+	}
+
+	H5Fclose(file);
+
+	run->operations = n * threads;
+	run->bytes = n * threads * sizeof(data);
+}
+
+static void
+benchmark_hdf_threads_1_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_threads_read(run, 1);
+}
+
+static void
+benchmark_hdf_threads_4_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_threads_read(run, 4);
+}
+
+static void
+benchmark_hdf_threads_16_read(BenchmarkRun* run)
+{
+	_benchmark_hdf_threads_read(run, 16);
+}
+
+#endif
+
+#endif
+
+void
+benchmark_hdf_pattern(void)
+{
+#ifdef HAVE_HDF5
+	vol_connector = g_getenv("HDF5_VOL_CONNECTOR");
+
+	if (vol_connector == NULL)
+	{
+		// Make sure we do not accidentally run benchmarks for native HDF5
+		// If comparisons with native HDF5 are necessary, set HDF5_VOL_CONNECTOR to "native"
+		return;
+	}
+
+	// The julea plugin does not support partial I/O
+	if (g_strcmp0(vol_connector, "julea") != 0)
+	{
+		j_benchmark_add("/hdf5/pattern/hyperslab/rows-2/write", benchmark_hdf_hyperslab_rows_2_write);
+		j_benchmark_add("/hdf5/pattern/hyperslab/rows-2/read", benchmark_hdf_hyperslab_rows_2_read);
+		j_benchmark_add("/hdf5/pattern/hyperslab/rows-16/write", benchmark_hdf_hyperslab_rows_16_write);
+		j_benchmark_add("/hdf5/pattern/hyperslab/rows-16/read", benchmark_hdf_hyperslab_rows_16_read);
+		j_benchmark_add("/hdf5/pattern/hyperslab/columns-2/write", benchmark_hdf_hyperslab_columns_2_write);
+		j_benchmark_add("/hdf5/pattern/hyperslab/columns-2/read", benchmark_hdf_hyperslab_columns_2_read);
+		j_benchmark_add("/hdf5/pattern/hyperslab/columns-16/write", benchmark_hdf_hyperslab_columns_16_write);
+		j_benchmark_add("/hdf5/pattern/hyperslab/columns-16/read", benchmark_hdf_hyperslab_columns_16_read);
+	}
+
+	j_benchmark_add("/hdf5/pattern/tiny-dataset/1/write", benchmark_hdf_tiny_dataset_1_write);
+	j_benchmark_add("/hdf5/pattern/tiny-dataset/1/read", benchmark_hdf_tiny_dataset_1_read);
+	j_benchmark_add("/hdf5/pattern/tiny-dataset/64/write", benchmark_hdf_tiny_dataset_64_write);
+	j_benchmark_add("/hdf5/pattern/tiny-dataset/64/read", benchmark_hdf_tiny_dataset_64_read);
+	j_benchmark_add("/hdf5/pattern/group-deep/8/create", benchmark_hdf_group_deep_8_create);
+	j_benchmark_add("/hdf5/pattern/group-deep/8/open", benchmark_hdf_group_deep_8_open);
+	j_benchmark_add("/hdf5/pattern/group-deep/32/create", benchmark_hdf_group_deep_32_create);
+	j_benchmark_add("/hdf5/pattern/group-deep/32/open", benchmark_hdf_group_deep_32_open);
+
+#ifdef H5_HAVE_THREADSAFE
+	// Concurrent HDF5 calls require a thread-safe HDF5 library
+	j_benchmark_add("/hdf5/pattern/threads/1/read", benchmark_hdf_threads_1_read);
+	j_benchmark_add("/hdf5/pattern/threads/4/read", benchmark_hdf_threads_4_read);
+	j_benchmark_add("/hdf5/pattern/threads/16/read", benchmark_hdf_threads_16_read);
+#endif
+#endif
+}
@@ -19,6 +19,7 @@
 #include <julea-config.h>
 
 #include <glib.h>
+#include <gmodule.h>
 
 #include <string.h>
 
@@ -302,6 +303,264 @@ benchmark_kv_unordered_put_delete_batch(BenchmarkRun* run)
 	_benchmark_kv_unordered_put_delete(run, TRUE);
 }
 
+/**
+ * The memory backend is benchmarked directly to measure its own overhead without the network.
+ * A private copy of the backend is used because the module's backend might already be used by the KV client.
+ **/
+static JBackend*
+_benchmark_kv_memory_new(GModule** module)
+{
+	JBackend* backend = NULL;
+	JBackend* memory_backend;
+	gboolean ret;
+
+	ret = j_backend_load_server("memory", "server", J_BACKEND_TYPE_KV, module, &backend);
+	g_assert_true(ret);
+
+	memory_backend = g_new(JBackend, 1);
+	memcpy(memory_backend, backend, sizeof(JBackend));
+
+	ret = j_backend_kv_init(memory_backend, "");
+	g_assert_true(ret);
+
+	return memory_backend;
+}
+
+static void
+_benchmark_kv_memory_free(JBackend* memory_backend, GModule* module)
+{
+	j_backend_kv_fini(memory_backend);
+	g_free(memory_backend);
+	g_module_close(module);
+}
+
+static void
+_benchmark_kv_memory_put_all(JBackend* memory_backend, gchar const* namespace, gchar const* prefix, guint n)
+{
+	gpointer batch = NULL;
+	gboolean ret;
+
+	ret = j_backend_kv_batch_start(memory_backend, namespace, NULL, &batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("%s%d", prefix, i);
+		ret = j_backend_kv_put(memory_backend, batch, name, name, strlen(name) + 1);
+		g_assert_true(ret);
+	}
+
+	ret = j_backend_kv_batch_execute(memory_backend, batch);
+	g_assert_true(ret);
+}
+
+static void
+_benchmark_kv_memory_delete_all(JBackend* memory_backend, gchar const* namespace, gchar const* prefix, guint n)
+{
+	gpointer batch = NULL;
+	gboolean ret;
+
+	ret = j_backend_kv_batch_start(memory_backend, namespace, NULL, &batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("%s%d", prefix, i);
+		ret = j_backend_kv_delete(memory_backend, batch, name);
+		g_assert_true(ret);
+	}
+
+	ret = j_backend_kv_batch_execute(memory_backend, batch);
+	g_assert_true(ret);
+}
+
+static void
+benchmark_kv_memory_put(BenchmarkRun* run)
+{
+	guint const n = 100000;
+
+	GModule* module = NULL;
+	JBackend* memory_backend;
+
+	memory_backend = _benchmark_kv_memory_new(&module);
+
+	while (j_benchmark_iterate(run))
+	{
+		j_benchmark_timer_start(run);
+		_benchmark_kv_memory_put_all(memory_backend, "benchmark", "benchmark-", n);
+		j_benchmark_timer_stop(run);
+
+		_benchmark_kv_memory_delete_all(memory_backend, "benchmark", "benchmark-", n);
+	}
+
+	_benchmark_kv_memory_free(memory_backend, module);
+
+	run->operations = n;
+}
+
+static void
+benchmark_kv_memory_get(BenchmarkRun* run)
+{
+	guint const n = 100000;
+
+	GModule* module = NULL;
+	JBackend* memory_backend;
+	gboolean ret;
+
+	memory_backend = _benchmark_kv_memory_new(&module);
+	_benchmark_kv_memory_put_all(memory_backend, "benchmark", "benchmark-", n);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		gpointer batch = NULL;
+
+		ret = j_backend_kv_batch_start(memory_backend, "benchmark", NULL, &batch);
+		g_assert_true(ret);
+
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree gchar* name = NULL;
+			gpointer value = NULL;
+			guint32 len;
+
+			name = g_strdup_printf("benchmark-%d", i);
+			ret = j_backend_kv_get(memory_backend, batch, name, &value, &len);
+			g_assert_true(ret);
+
+			g_free(value);
+		}
+
+		ret = j_backend_kv_batch_execute(memory_backend, batch);
+		g_assert_true(ret);
+	}
+
+	j_benchmark_timer_stop(run);
+
+	_benchmark_kv_memory_free(memory_backend, module);
+
+	run->operations = n;
+}
+
+static void
+benchmark_kv_memory_iterate_prefix(BenchmarkRun* run)
+{
+	guint const n = 100000;
+
+	GModule* module = NULL;
+	JBackend* memory_backend;
+	gboolean ret;
+
+	memory_backend = _benchmark_kv_memory_new(&module);
+	_benchmark_kv_memory_put_all(memory_backend, "benchmark", "benchmark-", n);
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		gpointer iterator = NULL;
+		gchar const* key;
+		gconstpointer value;
+		guint32 len;
+		guint count = 0;
+
+		// All keys share the prefix, so the iteration covers every stripe
+		ret = j_backend_kv_get_by_prefix(memory_backend, "benchmark", "benchmark-", &iterator);
+		g_assert_true(ret);
+
+		while (j_backend_kv_iterate(memory_backend, iterator, &key, &value, &len))
+		{
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, n);
+	}
+
+	j_benchmark_timer_stop(run);
+
+	_benchmark_kv_memory_free(memory_backend, module);
+
+	run->operations = n;
+}
+
+struct BenchmarkKVMemoryThreadData
+{
+	JBackend* memory_backend;
+	gchar* prefix;
+	guint n;
+};
+
+typedef struct BenchmarkKVMemoryThreadData BenchmarkKVMemoryThreadData;
+
+static gpointer
+_benchmark_kv_memory_put_delete_thread(gpointer data)
+{
+	BenchmarkKVMemoryThreadData* thread_data = data;
+
+	_benchmark_kv_memory_put_all(thread_data->memory_backend, "benchmark", thread_data->prefix, thread_data->n);
+	_benchmark_kv_memory_delete_all(thread_data->memory_backend, "benchmark", thread_data->prefix, thread_data->n);
+
+	return NULL;
+}
+
+static void
+benchmark_kv_memory_put_delete_concurrent(BenchmarkRun* run)
+{
+	guint const n = 10000;
+
+	g_autofree GThread** threads = NULL;
+	g_autofree BenchmarkKVMemoryThreadData* thread_data = NULL;
+	GModule* module = NULL;
+	JBackend* memory_backend;
+	guint thread_count;
+
+	thread_count = g_get_num_processors();
+
+	memory_backend = _benchmark_kv_memory_new(&module);
+
+	threads = g_new(GThread*, thread_count);
+	thread_data = g_new(BenchmarkKVMemoryThreadData, thread_count);
+
+	// The threads share one namespace to contend on the stripes and the index
+	for (guint i = 0; i < thread_count; i++)
+	{
+		thread_data[i].memory_backend = memory_backend;
+		thread_data[i].prefix = g_strdup_printf("benchmark-%u-", i);
+		thread_data[i].n = n;
+	}
+
+	j_benchmark_timer_start(run);
+
+	while (j_benchmark_iterate(run))
+	{
+		for (guint i = 0; i < thread_count; i++)
+		{
+			threads[i] = g_thread_new("benchmark-kv-memory", _benchmark_kv_memory_put_delete_thread, &thread_data[i]);
+		}
+
+		for (guint i = 0; i < thread_count; i++)
+		{
+			g_thread_join(threads[i]);
+		}
+	}
+
+	j_benchmark_timer_stop(run);
+
+	for (guint i = 0; i < thread_count; i++)
+	{
+		g_free(thread_data[i].prefix);
+	}
+
+	_benchmark_kv_memory_free(memory_backend, module);
+
+	run->operations = n * 2 * thread_count;
+}
+
 void
 benchmark_kv(void)
 {
@@ -313,4 +572,8 @@ benchmark_kv(void)
 	j_benchmark_add("/kv/delete-batch", benchmark_kv_delete_batch);
 	j_benchmark_add("/kv/unordered-put-delete", benchmark_kv_unordered_put_delete);
 	j_benchmark_add("/kv/unordered-put-delete-batch", benchmark_kv_unordered_put_delete_batch);
+	j_benchmark_add("/kv/memory/put", benchmark_kv_memory_put);
+	j_benchmark_add("/kv/memory/get", benchmark_kv_memory_get);
+	j_benchmark_add("/kv/memory/iterate-prefix", benchmark_kv_memory_iterate_prefix);
+	j_benchmark_add("/kv/memory/put-delete-concurrent", benchmark_kv_memory_put_delete_concurrent);
 }
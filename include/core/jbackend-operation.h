@@ -103,6 +103,13 @@ struct JBackendOperation
 	guint in_param_count;
 	guint out_param_count;
 	guint unref_func_count;
+
+	/**
+	 * Maximum number of rows returned by a query at once, 0 returns all rows.
+	 * If there are more rows, the backend iterator is stored in backend_iterator.
+	 **/
+	guint batch_size;
+	gpointer backend_iterator;
 };
 
 typedef struct JBackendOperation JBackendOperation;
@@ -121,6 +128,9 @@ gboolean j_backend_operation_unwrap_db_update(JBackend*, gpointer, JBackendOpera
 gboolean j_backend_operation_unwrap_db_delete(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_query(JBackend*, gpointer, JBackendOperation*);
 
+gboolean j_backend_operation_db_query_next(JBackend*, JBackendOperation*);
+void j_backend_operation_db_query_close(JBackend*, JBackendOperation*);
+
 gboolean j_backend_operation_to_message(JMessage* message, JBackendOperationParam* data, guint len);
 gboolean j_backend_operation_from_message(JMessage* message, JBackendOperationParam* data, guint len);
 gboolean j_backend_operation_from_message_static(JMessage* message, JBackendOperationParam* data, guint len);
@@ -209,11 +219,16 @@ static const JBackendOperation j_backend_operation_db_update = {
 		},
 	},
 	.out_param = {
+		// The number of updated entries
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
 		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_ERROR },
 	},
 	.backend_func = j_backend_operation_unwrap_db_update,
 	.in_param_count = 4,
-	.out_param_count = 1,
+	.out_param_count = 2,
 };
 
 static const JBackendOperation j_backend_operation_db_delete = {
@@ -226,11 +241,16 @@ static const JBackendOperation j_backend_operation_db_delete = {
 		},
 	},
 	.out_param = {
+		// The number of deleted entries
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
 		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_ERROR },
 	},
 	.backend_func = j_backend_operation_unwrap_db_delete,
 	.in_param_count = 3,
-	.out_param_count = 1,
+	.out_param_count = 2,
 };
 
 static const JBackendOperation j_backend_operation_db_query = {
@@ -243,6 +263,12 @@ static const JBackendOperation j_backend_operation_db_query = {
 		},
 	},
 	.out_param = {
+		// Rows
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+		// Cursor, contains whether more rows are available
 		{
 			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
 			.bson_initialized = TRUE,
@@ -251,7 +277,7 @@ static const JBackendOperation j_backend_operation_db_query = {
 	},
 	.backend_func = j_backend_operation_unwrap_db_query,
 	.in_param_count = 3,
-	.out_param_count = 2,
+	.out_param_count = 3,
 };
 
 G_END_DECLS
@@ -167,6 +167,15 @@ struct JBackend
 			gboolean (*backend_get_all)(gpointer, gchar const*, gpointer*);
 			gboolean (*backend_get_by_prefix)(gpointer, gchar const*, gchar const*, gpointer*);
 			gboolean (*backend_iterate)(gpointer, gpointer, gchar const**, gconstpointer*, guint32*);
+
+			/**
+			* Obtains backend-internal statistics (optional)
+			*
+			* \param[out] statistics A human-readable description of the statistics. Should be freed with g_free().
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_statistics)(gpointer, gchar**);
 		} kv;
 
 		struct
@@ -251,6 +260,21 @@ struct JBackend
 			**/
 			gboolean (*backend_insert)(gpointer, gpointer, gchar const*, bson_t const*, bson_t*, GError**);
 
+			/**
+			* Insert multiple entries into a schema (optional)
+			*
+			* \param[in]  namespace Different use cases (e.g., "adios", "hdf5")
+			* \param[in]  name      Schema name to insert into (e.g., "files")
+			* \param[in]  metadata  An array of count entries as passed to backend_insert
+			* \param[out] ids       An array of count initialized BSONs, returns the ids of the inserted entries
+			* \param[in]  count     The number of entries
+			*
+			* If this is NULL, backend_insert is called for each entry.
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_insert_many)(gpointer, gpointer, gchar const*, bson_t const* const*, bson_t*, guint, GError**);
+
 			/**
 			* Updates data
 			*
@@ -285,9 +309,11 @@ struct JBackend
 			* }
 			* \endcode
 			*
+			* \param[out] count    The number of updated entries.
+			*
 			* \return TRUE on success, FALSE otherwise.
 			**/
-			gboolean (*backend_update)(gpointer, gpointer, gchar const*, bson_t const*, bson_t const*, GError**);
+			gboolean (*backend_update)(gpointer, gpointer, gchar const*, bson_t const*, bson_t const*, guint64*, GError**);
 
 			/**
 			* Deletes data
@@ -316,9 +342,11 @@ struct JBackend
 			* }
 			* \endcode
 			*
+			* \param[out] count    The number of deleted entries.
+			*
 			* \return TRUE on success, FALSE otherwise.
 			**/
-			gboolean (*backend_delete)(gpointer, gpointer, gchar const*, bson_t const*, GError**);
+			gboolean (*backend_delete)(gpointer, gpointer, gchar const*, bson_t const*, guint64*, GError**);
 
 			/**
 			* Creates an iterator
@@ -373,6 +401,15 @@ struct JBackend
 			* \return TRUE on success, FALSE otherwise.
 			**/
 			gboolean (*backend_iterate)(gpointer, gpointer, bson_t*, GError**);
+
+			/**
+			* Obtains backend-internal statistics (optional)
+			*
+			* \param[out] statistics A human-readable description of the statistics. Should be freed with g_free().
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_statistics)(gpointer, gchar**);
 		} db;
 	};
 };
@@ -421,6 +458,12 @@ gboolean j_backend_kv_get_all(JBackend*, gchar const*, gpointer*);
 gboolean j_backend_kv_get_by_prefix(JBackend*, gchar const*, gchar const*, gpointer*);
 gboolean j_backend_kv_iterate(JBackend*, gpointer, gchar const**, gconstpointer*, guint32*);
 
+gboolean j_backend_kv_statistics(JBackend*, gchar**);
+
+gboolean j_backend_kv_compare_and_swap(JBackend*, gchar const*, JSemantics*, gchar const*, gconstpointer, guint32, gconstpointer, guint32);
+gboolean j_backend_kv_fetch_add(JBackend*, gchar const*, JSemantics*, gchar const*, gint64, gint64*);
+gboolean j_backend_kv_append(JBackend*, gchar const*, JSemantics*, gchar const*, gconstpointer, guint32);
+
 gboolean j_backend_db_init(JBackend*, gchar const*);
 void j_backend_db_fini(JBackend*);
 
@@ -432,12 +475,15 @@ gboolean j_backend_db_schema_get(JBackend*, gpointer, gchar const*, bson_t*, GEr
 gboolean j_backend_db_schema_delete(JBackend*, gpointer, gchar const*, GError**);
 
 gboolean j_backend_db_insert(JBackend*, gpointer, gchar const*, bson_t const*, bson_t*, GError**);
-gboolean j_backend_db_update(JBackend*, gpointer, gchar const*, bson_t const*, bson_t const*, GError**);
-gboolean j_backend_db_delete(JBackend*, gpointer, gchar const*, bson_t const*, GError**);
+gboolean j_backend_db_insert_many(JBackend*, gpointer, gchar const*, bson_t const* const*, bson_t*, guint, GError**);
+gboolean j_backend_db_update(JBackend*, gpointer, gchar const*, bson_t const*, bson_t const*, guint64*, GError**);
+gboolean j_backend_db_delete(JBackend*, gpointer, gchar const*, bson_t const*, guint64*, GError**);
 
 gboolean j_backend_db_query(JBackend*, gpointer, gchar const*, bson_t const*, gpointer*, GError**);
 gboolean j_backend_db_iterate(JBackend*, gpointer, bson_t*, GError**);
 
+gboolean j_backend_db_statistics(JBackend*, gchar**);
+
 G_END_DECLS
 
 #endif
@@ -54,6 +54,9 @@ gchar const* j_configuration_get_backend(JConfiguration*, JBackendType);
 gchar const* j_configuration_get_backend_component(JConfiguration*, JBackendType);
 gchar const* j_configuration_get_backend_path(JConfiguration*, JBackendType);
 
+gchar* j_configuration_get_backend_option(JConfiguration*, JBackendType, gchar const*);
+guint64 j_configuration_get_backend_option_uint64(JConfiguration*, JBackendType, gchar const*, guint64);
+
 guint64 j_configuration_get_max_operation_size(JConfiguration*);
 guint32 j_configuration_get_max_connections(JConfiguration*);
 guint64 j_configuration_get_stripe_size(JConfiguration*);
@@ -37,6 +37,9 @@ G_BEGIN_DECLS
 gpointer j_connection_pool_pop(JBackendType, guint);
 void j_connection_pool_push(JBackendType, guint, gpointer);
 
+gboolean j_connection_pool_detach(JBackendType, guint);
+void j_connection_pool_attach(JBackendType, guint, gpointer);
+
 G_END_DECLS
 
 #endif
@@ -50,13 +50,18 @@ enum JMessageType
 	J_MESSAGE_KV_GET,
 	J_MESSAGE_KV_GET_ALL,
 	J_MESSAGE_KV_GET_BY_PREFIX,
+	J_MESSAGE_KV_COMPARE_AND_SWAP,
+	J_MESSAGE_KV_FETCH_ADD,
+	J_MESSAGE_KV_APPEND,
 	J_MESSAGE_DB_SCHEMA_CREATE,
 	J_MESSAGE_DB_SCHEMA_GET,
 	J_MESSAGE_DB_SCHEMA_DELETE,
 	J_MESSAGE_DB_INSERT,
 	J_MESSAGE_DB_UPDATE,
 	J_MESSAGE_DB_DELETE,
-	J_MESSAGE_DB_QUERY
+	J_MESSAGE_DB_QUERY,
+	J_MESSAGE_DB_QUERY_NEXT,
+	J_MESSAGE_DB_QUERY_CLOSE
 };
 
 typedef enum JMessageType JMessageType;
@@ -99,6 +104,8 @@ gboolean j_message_receive(JMessage*, gpointer);
 gboolean j_message_read(JMessage*, GInputStream*);
 gboolean j_message_write(JMessage*, GOutputStream*);
 
+guint32 j_message_get_written(void);
+
 void j_message_add_send(JMessage*, gconstpointer, guint64);
 void j_message_add_operation(JMessage*, gsize);
 
@@ -123,6 +123,7 @@ gboolean j_db_entry_insert(JDBEntry* entry, JBatch* batch, GError** error);
  *
  * \param[in] entry the entry defining the final values of all matched entrys
  * \param[in] selector the selector defines which entrys should be modifies
+ * \param[out] count the number of updated entries, set when the batch is executed (may be NULL)
  * \param[in] batch the batch to append this operation to
  * \pre entry != NULL
  * \pre entry has a least 1 value set to not NULL
@@ -133,7 +134,7 @@ gboolean j_db_entry_insert(JDBEntry* entry, JBatch* batch, GError** error);
  * \return TRUE on success, FALSE otherwise
  **/
 
-gboolean j_db_entry_update(JDBEntry* entry, JDBSelector* selector, JBatch* batch, GError** error);
+gboolean j_db_entry_update(JDBEntry* entry, JDBSelector* selector, guint64* count, JBatch* batch, GError** error);
 
 /**
  * Delete the entry from the backend.
@@ -143,6 +144,7 @@ gboolean j_db_entry_update(JDBEntry* entry, JDBSelector* selector, JBatch* batch
  *
  * \param[in] entry specifies the schema to use
  * \param[in] selector the selector defines what should be deleted
+ * \param[out] count the number of deleted entries, set when the batch is executed (may be NULL)
  * \param[in] batch the batch to append this operation to
  * \pre entry != NULL
  * \pre batch != NULL
@@ -150,7 +152,7 @@ gboolean j_db_entry_update(JDBEntry* entry, JDBSelector* selector, JBatch* batch
  * \return TRUE on success, FALSE otherwise
  **/
 
-gboolean j_db_entry_delete(JDBEntry* entry, JDBSelector* selector, JBatch* batch, GError** error);
+gboolean j_db_entry_delete(JDBEntry* entry, JDBSelector* selector, guint64* count, JBatch* batch, GError** error);
 
 G_END_DECLS
 
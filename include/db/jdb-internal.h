@@ -91,15 +91,75 @@ struct JDBSchema
 	gboolean server_side;
 };
 
+struct JDBSelectorAggregate
+{
+	JDBAggregateFunction function;
+	gchar* name;
+
+	// The type of the aggregated field and the type of the result
+	JDBType type;
+	JDBType result_type;
+};
+
+typedef struct JDBSelectorAggregate JDBSelectorAggregate;
+
+struct JDBSelectorSort
+{
+	gchar* name;
+	JDBSelectorOrder order;
+};
+
+typedef struct JDBSelectorSort JDBSelectorSort;
+
+struct JDBSelectorJoin
+{
+	// The field of the selector's schema and the field of the joined schema that have to be equal
+	gchar* name;
+	gchar* join_name;
+
+	JDBSchema* schema;
+
+	// The conditions of the joined entries, NULL joins all entries
+	bson_t* selector;
+	// Fields of the joined entries returned by queries, NULL returns all fields
+	gchar** fields;
+};
+
+typedef struct JDBSelectorJoin JDBSelectorJoin;
+
 struct JDBSelector
 {
 	bson_t bson;
 
+	/**
+	 * The selector's conditions combined with its query options.
+	 * It is built on demand by j_db_selector_get_query_bson.
+	 **/
+	bson_t bson_query;
+
 	JDBSelectorMode mode;
 	JDBSchema* schema;
 
+	// Fields returned by queries, NULL returns all fields
+	gchar** fields;
+
+	// Aggregates computed by queries, contains JDBSelectorAggregate
+	GArray* aggregates;
+	gchar** group_by;
+
+	// Sort keys of queries, contains JDBSelectorSort
+	GArray* order;
+	// Number of results to return and skip, a limit of 0 returns all results
+	guint64 limit;
+	guint64 offset;
+
+	// Schemas joined by queries, contains JDBSelectorJoin
+	GArray* joins;
+
 	guint bson_count;
 	gint ref_count;
+
+	gboolean bson_query_valid;
 };
 
 union JDBTypeValue
@@ -124,15 +184,20 @@ gboolean j_db_internal_schema_create(JDBSchema* j_db_schema, JBatch* batch, GErr
 gboolean j_db_internal_schema_get(JDBSchema* j_db_schema, JBatch* batch, GError** error);
 gboolean j_db_internal_schema_delete(JDBSchema* j_db_schema, JBatch* batch, GError** error);
 gboolean j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** error);
-gboolean j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
-gboolean j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
+gboolean j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, guint64* count, JBatch* batch, GError** error);
+gboolean j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, guint64* count, JBatch* batch, GError** error);
 gboolean j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error);
 gboolean j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error);
+void j_db_internal_iterator_close(JDBIterator* j_db_iterator);
 
 // Client-side additional internal functions
 bson_t* j_db_selector_get_bson(JDBSelector* selector);
+bson_t* j_db_selector_get_query_bson(JDBSelector* selector);
+gboolean j_db_selector_get_join_field(JDBSelector* selector, gchar const* name, JDBType* type, GError** error);
+gboolean j_db_selector_set_aggregates(JDBSelector* selector, JDBAggregate const* aggregates, guint aggregates_count, gchar const** group_by, GError** error);
 
 G_GNUC_INTERNAL JBackend* j_db_get_backend(void);
+G_GNUC_INTERNAL guint32 j_db_internal_get_server_index(gchar const* namespace);
 
 G_END_DECLS
 
@@ -35,6 +35,28 @@ struct JDBIterator;
 
 typedef struct JDBIterator JDBIterator;
 
+enum JDBAggregateFunction
+{
+	// COUNT, counts all entries if no field is given
+	J_DB_AGGREGATE_COUNT,
+	// MIN
+	J_DB_AGGREGATE_MIN,
+	// MAX
+	J_DB_AGGREGATE_MAX,
+	// SUM
+	J_DB_AGGREGATE_SUM
+};
+
+typedef enum JDBAggregateFunction JDBAggregateFunction;
+
+struct JDBAggregate
+{
+	JDBAggregateFunction function;
+	gchar const* name;
+};
+
+typedef struct JDBAggregate JDBAggregate;
+
 G_END_DECLS
 
 #include <db/jdb-schema.h>
@@ -57,6 +79,28 @@ G_BEGIN_DECLS
 
 JDBIterator* j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error);
 
+/**
+ * Allocates a new iterator over aggregated values.
+ * The aggregation is computed by the backend, only the results are transferred.
+ * The iterator returns one entry per group or a single entry if group_by is NULL.
+ * The values of the group_by fields can be retrieved using j_db_iterator_get_field.
+ * The selector's sort keys, limit and offset apply to the groups.
+ *
+ * \param[in] schema The schema defines the structure of the iterator
+ * \param[in] selector The selector defines which entrys to aggregate, NULL aggregates all entries
+ * \param[in] aggregates The aggregates to compute
+ * \param[in] aggregates_count The number of aggregates
+ * \param[in] group_by A NULL-terminated array of field names to group by or NULL
+ * \pre schema != NULL
+ * \pre schema is initialized
+ * \pre aggregates_count > 0 or group_by != NULL
+ * \pre only COUNT may omit the field name, SUM requires a numeric field
+ *
+ * \return the new iterator or NULL on failure
+ **/
+
+JDBIterator* j_db_iterator_new_aggregate(JDBSchema* schema, JDBSelector* selector, JDBAggregate const* aggregates, guint aggregates_count, gchar const** group_by, GError** error);
+
 /**
  * Increase the ref_count of the given iterator.
  *
@@ -91,6 +135,7 @@ gboolean j_db_iterator_next(JDBIterator* iterator, GError** error);
 
 /**
  * Get a single value from the current entry of the iterator.
+ * Fields of joined schemas are named "<schema name>.<field name>", see j_db_selector_add_join.
  *
  * \param[in] iterator to query
  * \param[in] name the name of the value to retrieve
@@ -111,6 +156,29 @@ gboolean j_db_iterator_next(JDBIterator* iterator, GError** error);
 
 gboolean j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error);
 
+/**
+ * Get an aggregated value from the current entry of the iterator.
+ * COUNT returns J_DB_TYPE_UINT64, SUM returns J_DB_TYPE_SINT64, J_DB_TYPE_UINT64 or J_DB_TYPE_FLOAT64 depending on the field's type, MIN and MAX return the field's type.
+ *
+ * \param[in] iterator to query
+ * \param[in] index the index of the aggregate as passed to j_db_iterator_new_aggregate
+ * \param[out] type the type of the retrieved value
+ * \param[out] value the retieved value
+ * \param[out] length the length of the retrieved value
+ * \pre iterator != NULL
+ * \pre iterator was created using j_db_iterator_new_aggregate
+ * \pre type != NULL
+ * \pre value != NULL
+ * \pre *value should not be initialized
+ * \pre length != NULL
+ * \post *value points to a new allocated memory region. The caller must free this later using g_free.
+ * \post *length contains the length of the allocated memory region
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_iterator_get_aggregate(JDBIterator* iterator, guint index, JDBType* type, gpointer* value, guint64* length, GError** error);
+
 G_END_DECLS
 
 #endif
@@ -57,6 +57,14 @@ enum JDBSelectorOperator
 
 typedef enum JDBSelectorOperator JDBSelectorOperator;
 
+enum JDBSelectorOrder
+{
+	J_DB_SELECTOR_ORDER_ASCENDING,
+	J_DB_SELECTOR_ORDER_DESCENDING
+};
+
+typedef enum JDBSelectorOrder JDBSelectorOrder;
+
 struct JDBSelector;
 
 typedef struct JDBSelector JDBSelector;
@@ -138,6 +146,87 @@ gboolean j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSe
 
 gboolean j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GError** error);
 
+/**
+ * Restricts the fields returned by queries using the selector.
+ * Only the given fields are transferred and can be read using j_db_iterator_get_field.
+ * The selector's conditions may refer to other fields.
+ *
+ * \param[in] selector the selector
+ * \param[in] names a NULL-terminated array of field names or NULL to return all fields
+ *
+ * \pre selector != NULL
+ * \pre all names must exist in the schema
+ * \post the names may be freed or modified by the caller immediately after calling this function
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_set_fields(JDBSelector* selector, gchar const** names, GError** error);
+
+/**
+ * Sorts the results of queries using the selector by a field.
+ * Calling this function multiple times adds further sort keys, which are used to order entries with equal values.
+ * Entries with equal values for all sort keys are returned in insertion order.
+ * When aggregating, only fields that are grouped by can be used for sorting.
+ *
+ * \param[in] selector the selector
+ * \param[in] name the name of the field to sort by
+ * \param[in] order whether to sort in ascending or descending order
+ *
+ * \pre selector != NULL
+ * \pre name must exist in the schema
+ * \post the name may be freed or modified by the caller immediately after calling this function
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_order(JDBSelector* selector, gchar const* name, JDBSelectorOrder order, GError** error);
+
+/**
+ * Restricts the number of results returned by queries using the selector.
+ * The results are sorted before the offset and limit are applied.
+ * For stable pages, sort by a unique field or use its last value as a condition for the next page (keyset pagination).
+ *
+ * \param[in] selector the selector
+ * \param[in] limit the maximum number of results, 0 returns all results
+ * \param[in] offset the number of results to skip
+ *
+ * \pre selector != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_set_limit(JDBSelector* selector, guint64 limit, guint64 offset, GError** error);
+
+/**
+ * Joins the entries of another schema to the results of queries using the selector.
+ * Each result combines an entry of the selector's schema with an entry of the joined schema whose join_name field equals the entry's name field.
+ * Entries without a matching joined entry are not returned (inner join).
+ * The joined entries are restricted by the conditions of sub_selector, its fields set by j_db_selector_set_fields are returned.
+ * Joined fields are named "<schema name>.<field name>", including the joined entry's "_id".
+ *
+ * Joins are evaluated by the backend, so that related entries are retrieved using a single query.
+ * Both schemas therefore have to be stored in the same namespace, since all schemas of a namespace are stored by the same server.
+ * Joins only apply to queries and can not be aggregated.
+ * Sort keys and limits refer to the selector's schema.
+ *
+ * \param[in] selector the selector
+ * \param[in] name the name of the field of the selector's schema, "_id" joins on the entries' IDs
+ * \param[in] sub_selector the selector of the joined schema
+ * \param[in] join_name the name of the field of the joined schema, "_id" joins on the joined entries' IDs
+ *
+ * \pre selector != NULL
+ * \pre name must exist in the selector's schema
+ * \pre sub_selector != NULL
+ * \pre join_name must exist in the joined schema and have the same type as name
+ * \pre each schema can only be joined once
+ * \post the sub_selector may be modified or freed by the caller immediately after calling this function
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_join(JDBSelector* selector, gchar const* name, JDBSelector* sub_selector, gchar const* join_name, GError** error);
+
 G_END_DECLS
 
 #endif
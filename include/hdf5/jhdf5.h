@@ -35,8 +35,46 @@
 
 G_BEGIN_DECLS
 
+enum JHDF5QueryOperator
+{
+	// <
+	J_HDF5_QUERY_OPERATOR_LT,
+	// <=
+	J_HDF5_QUERY_OPERATOR_LE,
+	// >
+	J_HDF5_QUERY_OPERATOR_GT,
+	// >=
+	J_HDF5_QUERY_OPERATOR_GE,
+	// =
+	J_HDF5_QUERY_OPERATOR_EQ
+};
+
+typedef enum JHDF5QueryOperator JHDF5QueryOperator;
+
+/**
+ * Name of the dataset operation of the VOL plugins for j_hdf5_dataset_query().
+ * Its value is registered dynamically and can be looked up using H5VLfind_opt_operation().
+ *
+ * Its arguments are the operator (JHDF5QueryOperator), the value (gdouble) and a pointer to the resulting dataspace (hid_t*).
+ **/
+#define J_HDF5_DATASET_OPTIONAL_QUERY "julea_dataset_query"
+
 void j_hdf5_set_semantics(JSemantics*);
 
+/**
+ * Selects the parts of a dataset that may contain values matching a predicate.
+ *
+ * The selection is computed from the minimum and maximum values stored for the dataset and its chunks, no data is read.
+ * It is a superset of the matching elements and can be used as the file dataspace for H5Dread.
+ *
+ * \param[in] dataset A dataset.
+ * \param[in] op      The operator to compare the dataset's values with.
+ * \param[in] value   The value, integers are compared as doubles.
+ *
+ * \return A dataspace that has to be closed using H5Sclose, H5I_INVALID_HID if the VOL plugin does not support queries.
+ **/
+hid_t j_hdf5_dataset_query(hid_t dataset, JHDF5QueryOperator op, gdouble value);
+
 G_END_DECLS
 
 #endif
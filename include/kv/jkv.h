@@ -57,6 +57,10 @@ void j_kv_delete(JKV*, JBatch*);
 void j_kv_get(JKV*, gpointer*, guint32*, JBatch*);
 void j_kv_get_callback(JKV*, JKVGetFunc, gpointer, JBatch*);
 
+void j_kv_compare_and_swap(JKV*, gconstpointer, guint32, gconstpointer, guint32, gboolean*, JBatch*);
+void j_kv_fetch_add(JKV*, gint64, gint64*, JBatch*);
+void j_kv_append(JKV*, gconstpointer, guint32, JBatch*);
+
 G_END_DECLS
 
 #endif
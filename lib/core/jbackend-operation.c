@@ -89,7 +89,25 @@ j_backend_operation_unwrap_db_update(JBackend* backend, gpointer batch, JBackend
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_update(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->in_param[3].ptr, data->out_param[0].ptr);
+	bson_t* bson = data->out_param[0].ptr;
+	guint64 count;
+
+	bson_init(bson);
+
+	if (!j_backend_db_update(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->in_param[3].ptr, &count, data->out_param[1].ptr))
+	{
+		goto _error;
+	}
+
+	// The number of updated entries is returned as the "count" field
+	bson_append_int64(bson, "count", -1, count);
+
+	return TRUE;
+
+_error:
+	bson_destroy(bson);
+
+	return FALSE;
 }
 
 gboolean
@@ -97,52 +115,138 @@ j_backend_operation_unwrap_db_delete(JBackend* backend, gpointer batch, JBackend
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_delete(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->out_param[0].ptr);
+	bson_t* bson = data->out_param[0].ptr;
+	guint64 count;
+
+	bson_init(bson);
+
+	if (!j_backend_db_delete(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, &count, data->out_param[1].ptr))
+	{
+		goto _error;
+	}
+
+	bson_append_int64(bson, "count", -1, count);
+
+	return TRUE;
+
+_error:
+	bson_destroy(bson);
+
+	return FALSE;
 }
 
-// FIXME clean up
 gboolean
 j_backend_operation_unwrap_db_query(JBackend* backend, gpointer batch, JBackendOperation* data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	GError** error;
-	gboolean ret;
+	data->backend_iterator = NULL;
+
+	if (!j_backend_db_query(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, &(data->backend_iterator), data->out_param[2].ptr))
+	{
+		return FALSE;
+	}
+
+	return j_backend_operation_db_query_next(backend, data);
+}
+
+/**
+ * Fetches the next rows of a query.
+ * The rows are stored in a document keyed "0", "1", etc.
+ * The cursor document's "more" field tells whether more rows are available.
+ *
+ * \param backend A backend.
+ * \param data    A query operation whose backend iterator is valid.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_backend_operation_db_query_next(JBackend* backend, JBackendOperation* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError** error = data->out_param[2].ptr;
+	gboolean ret = TRUE;
 	gpointer iter;
-	guint i;
 	char str_buf[16];
 	const char* key;
 	bson_t* bson = data->out_param[0].ptr;
+	bson_t* cursor = data->out_param[1].ptr;
 	bson_t tmp[1];
 
+	g_return_val_if_fail(data->backend_iterator != NULL, FALSE);
+
+	iter = data->backend_iterator;
+	data->backend_iterator = NULL;
+
 	bson_init(bson);
-	ret = j_backend_db_query(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, &iter, data->out_param[1].ptr);
-	if (!ret)
-	{
-		goto _error;
-	}
-	i = 0;
-	do
+
+	for (guint i = 0; data->batch_size == 0 || i < data->batch_size; i++)
 	{
 		bson_uint32_to_string(i, &key, str_buf, sizeof(str_buf));
 		bson_init(tmp);
-		ret = j_backend_db_iterate(backend, iter, tmp, data->out_param[1].ptr);
-		i++;
+		ret = j_backend_db_iterate(backend, iter, tmp, error);
+
 		if (ret)
 		{
 			bson_append_document(bson, key, -1, tmp);
 		}
+
 		bson_destroy(tmp);
-	} while (ret); //TODO handle the no more elements error here
-	error = data->out_param[1].ptr;
-	if (error && (*error)->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+
+		if (!ret)
+		{
+			break;
+		}
+	}
+
+	if (ret)
+	{
+		// The batch is full, the iterator is kept for the next call
+		data->backend_iterator = iter;
+	}
+	else if (error != NULL && *error != NULL && (*error)->code == J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
 	{
 		g_error_free(*error);
 		*error = NULL;
 	}
+
+	bson_init(cursor);
+	bson_append_bool(cursor, "more", -1, data->backend_iterator != NULL);
+
 	return TRUE;
-_error:
-	return FALSE;
+}
+
+/**
+ * Closes a query's backend iterator if it still has rows.
+ *
+ * \param backend A backend.
+ * \param data    A query operation.
+ **/
+void
+j_backend_operation_db_query_close(JBackend* backend, JBackendOperation* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t tmp[1];
+	gboolean ret;
+
+	if (data->backend_iterator == NULL)
+	{
+		return;
+	}
+
+	// Backends release their iterators once all rows have been returned
+	do
+	{
+		g_autoptr(GError) error = NULL;
+
+		bson_init(tmp);
+		ret = j_backend_db_iterate(backend, data->backend_iterator, tmp, &error);
+		bson_destroy(tmp);
+	} while (ret);
+
+	data->backend_iterator = NULL;
 }
 
 gboolean
@@ -25,6 +25,8 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <jbackend.h>
 
 #include <jtrace.h>
@@ -722,6 +724,240 @@ j_backend_kv_iterate(JBackend* backend, gpointer iterator, gchar const** key, gc
 	return ret;
 }
 
+gboolean
+j_backend_kv_statistics(JBackend* backend, gchar** statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(statistics != NULL, FALSE);
+
+	if (backend->kv.backend_statistics != NULL)
+	{
+		J_TRACE("backend_statistics", "%p", (gpointer)statistics);
+		ret = backend->kv.backend_statistics(backend->data, statistics);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns the lock protecting atomic operations on a key.
+ * Locks are striped to avoid a global lock without requiring one lock per key.
+ *
+ * \param namespace A namespace.
+ * \param key       A key.
+ *
+ * \return A lock.
+ **/
+static GMutex*
+j_backend_kv_get_lock(gchar const* namespace, gchar const* key)
+{
+	static GMutex locks[64];
+
+	guint hash;
+
+	hash = g_str_hash(namespace) * 31 + g_str_hash(key);
+
+	return &(locks[hash % G_N_ELEMENTS(locks)]);
+}
+
+/**
+ * Atomically replaces a value if it matches an expected value.
+ *
+ * The operation is executed in its own backend batch.
+ * It is atomic with respect to other atomic operations on the same key.
+ *
+ * \param namespace     A namespace.
+ * \param semantics     The semantics to use for the backend batch.
+ * \param key           A key.
+ * \param old_value     The expected value, or NULL if the key must not exist.
+ * \param old_value_len The expected value's length.
+ * \param new_value     The new value.
+ * \param new_value_len The new value's length.
+ *
+ * \return TRUE if the value has been replaced, FALSE otherwise.
+ **/
+gboolean
+j_backend_kv_compare_and_swap(JBackend* backend, gchar const* namespace, JSemantics* semantics, gchar const* key, gconstpointer old_value, guint32 old_value_len, gconstpointer new_value, guint32 new_value_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMutex* lock;
+	gpointer batch;
+	g_autofree gpointer value = NULL;
+	guint32 value_len = 0;
+	gboolean exists;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(new_value != NULL, FALSE);
+
+	lock = j_backend_kv_get_lock(namespace, key);
+	g_mutex_lock(lock);
+
+	if (!j_backend_kv_batch_start(backend, namespace, semantics, &batch))
+	{
+		goto end;
+	}
+
+	exists = j_backend_kv_get(backend, batch, key, &value, &value_len);
+
+	if ((old_value == NULL && !exists)
+	    || (old_value != NULL && exists && value_len == old_value_len && memcmp(value, old_value, value_len) == 0))
+	{
+		ret = j_backend_kv_put(backend, batch, key, new_value, new_value_len);
+	}
+
+	ret = j_backend_kv_batch_execute(backend, batch) && ret;
+
+end:
+	g_mutex_unlock(lock);
+
+	return ret;
+}
+
+/**
+ * Atomically adds to a 64-bit integer value.
+ *
+ * Values are stored as 8 bytes in little endian byte order.
+ * Keys that do not exist are treated as having a value of 0.
+ *
+ * \param namespace A namespace.
+ * \param semantics The semantics to use for the backend batch.
+ * \param key       A key.
+ * \param delta     The value to add.
+ * \param old_value Returns the value before the addition.
+ *
+ * \return TRUE on success, FALSE if the existing value is not a 64-bit integer or an error occurred.
+ **/
+gboolean
+j_backend_kv_fetch_add(JBackend* backend, gchar const* namespace, JSemantics* semantics, gchar const* key, gint64 delta, gint64* old_value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMutex* lock;
+	gpointer batch;
+	g_autofree gpointer value = NULL;
+	guint32 value_len = 0;
+	gint64 current = 0;
+	gint64 new_value;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(old_value != NULL, FALSE);
+
+	lock = j_backend_kv_get_lock(namespace, key);
+	g_mutex_lock(lock);
+
+	if (!j_backend_kv_batch_start(backend, namespace, semantics, &batch))
+	{
+		goto end;
+	}
+
+	if (j_backend_kv_get(backend, batch, key, &value, &value_len))
+	{
+		if (value_len != sizeof(gint64))
+		{
+			j_backend_kv_batch_execute(backend, batch);
+			goto end;
+		}
+
+		memcpy(&current, value, sizeof(gint64));
+		current = GINT64_FROM_LE(current);
+	}
+
+	new_value = GINT64_TO_LE(current + delta);
+	ret = j_backend_kv_put(backend, batch, key, &new_value, sizeof(gint64));
+	ret = j_backend_kv_batch_execute(backend, batch) && ret;
+
+	if (ret)
+	{
+		*old_value = current;
+	}
+
+end:
+	g_mutex_unlock(lock);
+
+	return ret;
+}
+
+/**
+ * Atomically appends to a value.
+ * Keys that do not exist are created.
+ *
+ * \param namespace A namespace.
+ * \param semantics The semantics to use for the backend batch.
+ * \param key       A key.
+ * \param data      The data to append.
+ * \param data_len  The data's length.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_backend_kv_append(JBackend* backend, gchar const* namespace, JSemantics* semantics, gchar const* key, gconstpointer data, guint32 data_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GMutex* lock;
+	gpointer batch;
+	g_autofree gpointer value = NULL;
+	g_autofree gchar* new_value = NULL;
+	guint32 value_len = 0;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	lock = j_backend_kv_get_lock(namespace, key);
+	g_mutex_lock(lock);
+
+	if (!j_backend_kv_batch_start(backend, namespace, semantics, &batch))
+	{
+		goto end;
+	}
+
+	if (!j_backend_kv_get(backend, batch, key, &value, &value_len))
+	{
+		value_len = 0;
+	}
+
+	if ((guint64)value_len + data_len > G_MAXUINT32)
+	{
+		j_backend_kv_batch_execute(backend, batch);
+		goto end;
+	}
+
+	new_value = g_malloc(value_len + data_len);
+
+	if (value_len > 0)
+	{
+		memcpy(new_value, value, value_len);
+	}
+
+	memcpy(new_value + value_len, data, data_len);
+
+	ret = j_backend_kv_put(backend, batch, key, new_value, value_len + data_len);
+	ret = j_backend_kv_batch_execute(backend, batch) && ret;
+
+end:
+	g_mutex_unlock(lock);
+
+	return ret;
+}
+
 gboolean
 j_backend_db_init(JBackend* backend, gchar const* path)
 {
@@ -885,7 +1121,39 @@ j_backend_db_insert(JBackend* backend, gpointer batch, gchar const* name, bson_t
 }
 
 gboolean
-j_backend_db_update(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
+j_backend_db_insert_many(JBackend* backend, gpointer batch, gchar const* name, bson_t const* const* metadata, bson_t* ids, guint count, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(ids != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_insert_many != NULL)
+	{
+		J_TRACE("backend_insert_many", "%p, %s, %p, %p, %u, %p", batch, name, (gconstpointer)metadata, (gpointer)ids, count, (gpointer)error);
+		ret = backend->db.backend_insert_many(backend->data, batch, name, metadata, ids, count, error);
+	}
+	else
+	{
+		for (guint i = 0; i < count && ret; i++)
+		{
+			J_TRACE("backend_insert", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)metadata[i], (gpointer)&ids[i], (gpointer)error);
+			ret = backend->db.backend_insert(backend->data, batch, name, metadata[i], &ids[i], error);
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_db_update(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, guint64* count, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -897,18 +1165,21 @@ j_backend_db_update(JBackend* backend, gpointer batch, gchar const* name, bson_t
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(selector != NULL, FALSE);
 	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(count != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
+	*count = 0;
+
 	{
-		J_TRACE("backend_update", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)selector, (gconstpointer)metadata, (gpointer)error);
-		ret = backend->db.backend_update(backend->data, batch, name, selector, metadata, error);
+		J_TRACE("backend_update", "%p, %s, %p, %p, %p, %p", batch, name, (gconstpointer)selector, (gconstpointer)metadata, (gpointer)count, (gpointer)error);
+		ret = backend->db.backend_update(backend->data, batch, name, selector, metadata, count, error);
 	}
 
 	return ret;
 }
 
 gboolean
-j_backend_db_delete(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, GError** error)
+j_backend_db_delete(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, guint64* count, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -918,11 +1189,14 @@ j_backend_db_delete(JBackend* backend, gpointer batch, gchar const* name, bson_t
 	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
 	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(count != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
+	*count = 0;
+
 	{
-		J_TRACE("backend_delete", "%p, %s, %p, %p", batch, name, (gconstpointer)selector, (gpointer)error);
-		ret = backend->db.backend_delete(backend->data, batch, name, selector, error);
+		J_TRACE("backend_delete", "%p, %s, %p, %p, %p", batch, name, (gconstpointer)selector, (gpointer)count, (gpointer)error);
+		ret = backend->db.backend_delete(backend->data, batch, name, selector, count, error);
 	}
 
 	return ret;
@@ -971,6 +1245,26 @@ j_backend_db_iterate(JBackend* backend, gpointer iterator, bson_t* metadata, GEr
 	return ret;
 }
 
+gboolean
+j_backend_db_statistics(JBackend* backend, gchar** statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(statistics != NULL, FALSE);
+
+	if (backend->db.backend_statistics != NULL)
+	{
+		J_TRACE("backend_statistics", "%p", (gpointer)statistics);
+		ret = backend->db.backend_statistics(backend->data, statistics);
+	}
+
+	return ret;
+}
+
 /**
  * @}
  **/
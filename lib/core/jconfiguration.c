@@ -143,6 +143,12 @@ struct JConfiguration
 	guint32 max_connections;
 	guint64 stripe_size;
 
+	/**
+	 * The configuration data.
+	 * Backend-specific options are looked up here.
+	 */
+	GKeyFile* key_file;
+
 	/**
 	 * The reference count.
 	 */
@@ -151,6 +157,24 @@ struct JConfiguration
 
 static JConfiguration* j_config = NULL;
 
+static gchar const*
+j_configuration_get_backend_group(JBackendType backend)
+{
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			return "object";
+		case J_BACKEND_TYPE_KV:
+			return "kv";
+		case J_BACKEND_TYPE_DB:
+			return "db";
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
 /**
  * Initializes the configuration.
  */
@@ -271,7 +295,7 @@ j_configuration_new(void)
 	path = NULL;
 
 out:
-	g_key_file_free(key_file);
+	g_key_file_unref(key_file);
 
 	g_free(path);
 	g_free(config_name);
@@ -377,6 +401,7 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	configuration->max_operation_size = max_operation_size;
 	configuration->max_connections = max_connections;
 	configuration->stripe_size = stripe_size;
+	configuration->key_file = g_key_file_ref(key_file);
 	configuration->ref_count = 1;
 
 	if (configuration->max_operation_size == 0)
@@ -456,6 +481,8 @@ j_configuration_unref(JConfiguration* configuration)
 		g_strfreev(configuration->servers.kv);
 		g_strfreev(configuration->servers.db);
 
+		g_key_file_unref(configuration->key_file);
+
 		g_slice_free(JConfiguration, configuration);
 	}
 }
@@ -573,6 +600,65 @@ j_configuration_get_backend_path(JConfiguration* configuration, JBackendType bac
 	return NULL;
 }
 
+/**
+ * Returns a backend-specific option.
+ * Options are read from the backend's section (for example, [kv]) of the configuration.
+ *
+ * \code
+ * \endcode
+ *
+ * \param configuration A configuration.
+ * \param backend       A backend type.
+ * \param option        An option name.
+ *
+ * \return The option's value, or NULL if it is not set. Should be freed with g_free().
+ **/
+gchar*
+j_configuration_get_backend_option(JConfiguration* configuration, JBackendType backend, gchar const* option)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, NULL);
+	g_return_val_if_fail(option != NULL, NULL);
+
+	return g_key_file_get_string(configuration->key_file, j_configuration_get_backend_group(backend), option, NULL);
+}
+
+/**
+ * Returns a backend-specific numeric option.
+ *
+ * \code
+ * \endcode
+ *
+ * \param configuration A configuration.
+ * \param backend       A backend type.
+ * \param option        An option name.
+ * \param default_value The value to return if the option is not set or invalid.
+ *
+ * \return The option's value.
+ **/
+guint64
+j_configuration_get_backend_option_uint64(JConfiguration* configuration, JBackendType backend, gchar const* option, guint64 default_value)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError* error = NULL;
+	guint64 value;
+
+	g_return_val_if_fail(configuration != NULL, default_value);
+	g_return_val_if_fail(option != NULL, default_value);
+
+	value = g_key_file_get_uint64(configuration->key_file, j_configuration_get_backend_group(backend), option, &error);
+
+	if (error != NULL)
+	{
+		g_error_free(error);
+		value = default_value;
+	}
+
+	return value;
+}
+
 guint64
 j_configuration_get_max_operation_size(JConfiguration* configuration)
 {
@@ -47,6 +47,11 @@ struct JConnectionPoolQueue
 {
 	GAsyncQueue* queue;
 	guint count;
+
+	/**
+	 * The number of detached connections, which is limited to the maximum number of pooled connections.
+	 **/
+	guint detached;
 };
 
 typedef struct JConnectionPoolQueue JConnectionPoolQueue;
@@ -93,18 +98,21 @@ j_connection_pool_init(JConfiguration* configuration)
 	{
 		pool->object_queues[i].queue = g_async_queue_new();
 		pool->object_queues[i].count = 0;
+		pool->object_queues[i].detached = 0;
 	}
 
 	for (guint i = 0; i < pool->kv_len; i++)
 	{
 		pool->kv_queues[i].queue = g_async_queue_new();
 		pool->kv_queues[i].count = 0;
+		pool->kv_queues[i].detached = 0;
 	}
 
 	for (guint i = 0; i < pool->db_len; i++)
 	{
 		pool->db_queues[i].queue = g_async_queue_new();
 		pool->db_queues[i].count = 0;
+		pool->db_queues[i].detached = 0;
 	}
 
 	g_atomic_pointer_set(&j_connection_pool, pool);
@@ -171,77 +179,88 @@ j_connection_pool_fini(void)
 }
 
 static GSocketConnection*
-j_connection_pool_pop_internal(GAsyncQueue* queue, guint* count, gchar const* server)
+j_connection_pool_connect(gchar const* server, guint count)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	GError* error = NULL;
 	GSocketConnection* connection;
+	g_autoptr(GSocketClient) client = NULL;
 
-	g_return_val_if_fail(queue != NULL, NULL);
-	g_return_val_if_fail(count != NULL, NULL);
+	g_autoptr(JMessage) message = NULL;
+	g_autoptr(JMessage) reply = NULL;
 
-	connection = g_async_queue_try_pop(queue);
+	guint op_count;
 
-	if (connection != NULL)
+	client = g_socket_client_new();
+	connection = g_socket_client_connect_to_host(client, server, 4711, NULL, &error);
+
+	if (error != NULL)
 	{
-		return connection;
+		g_critical("%s", error->message);
+		g_error_free(error);
 	}
 
-	if ((guint)g_atomic_int_get(count) < j_connection_pool->max_count)
+	if (connection == NULL)
 	{
-		if ((guint)g_atomic_int_add(count, 1) < j_connection_pool->max_count)
-		{
-			GError* error = NULL;
-			g_autoptr(GSocketClient) client = NULL;
+		g_critical("Can not connect to %s [%d].", server, count);
+	}
 
-			g_autoptr(JMessage) message = NULL;
-			g_autoptr(JMessage) reply = NULL;
+	j_helper_set_nodelay(connection, TRUE);
 
-			guint op_count;
+	message = j_message_new(J_MESSAGE_PING, 0);
+	j_message_send(message, connection);
 
-			client = g_socket_client_new();
-			connection = g_socket_client_connect_to_host(client, server, 4711, NULL, &error);
+	reply = j_message_new_reply(message);
+	j_message_receive(reply, connection);
 
-			if (error != NULL)
-			{
-				g_critical("%s", error->message);
-				g_error_free(error);
-			}
+	op_count = j_message_get_count(reply);
 
-			if (connection == NULL)
-			{
-				g_critical("Can not connect to %s [%d].", server, g_atomic_int_get(count));
-			}
+	for (guint i = 0; i < op_count; i++)
+	{
+		gchar const* backend;
 
-			j_helper_set_nodelay(connection, TRUE);
+		backend = j_message_get_string(reply);
 
-			message = j_message_new(J_MESSAGE_PING, 0);
-			j_message_send(message, connection);
+		if (g_strcmp0(backend, "object") == 0)
+		{
+			//g_print("Server has object backend.\n");
+		}
+		else if (g_strcmp0(backend, "kv") == 0)
+		{
+			//g_print("Server has kv backend.\n");
+		}
+		else if (g_strcmp0(backend, "db") == 0)
+		{
+			//g_print("Server has db backend.\n");
+		}
+	}
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, connection);
+	return connection;
+}
 
-			op_count = j_message_get_count(reply);
+static GSocketConnection*
+j_connection_pool_pop_internal(GAsyncQueue* queue, guint* count, gchar const* server)
+{
+	J_TRACE_FUNCTION(NULL);
 
-			for (guint i = 0; i < op_count; i++)
-			{
-				gchar const* backend;
+	GSocketConnection* connection;
 
-				backend = j_message_get_string(reply);
+	g_return_val_if_fail(queue != NULL, NULL);
+	g_return_val_if_fail(count != NULL, NULL);
+
+	connection = g_async_queue_try_pop(queue);
+
+	if (connection != NULL)
+	{
+		return connection;
+	}
 
-				if (g_strcmp0(backend, "object") == 0)
-				{
-					//g_print("Server has object backend.\n");
-				}
-				else if (g_strcmp0(backend, "kv") == 0)
-				{
-					//g_print("Server has kv backend.\n");
-				}
-				else if (g_strcmp0(backend, "db") == 0)
-				{
-					//g_print("Server has db backend.\n");
-				}
-			}
+	if ((guint)g_atomic_int_get(count) < j_connection_pool->max_count)
+	{
+		if ((guint)g_atomic_int_add(count, 1) < j_connection_pool->max_count)
+		{
+			connection = j_connection_pool_connect(server, g_atomic_int_get(count));
 		}
 		else
 		{
@@ -270,6 +289,29 @@ j_connection_pool_push_internal(GAsyncQueue* queue, GSocketConnection* connectio
 	g_async_queue_push(queue, connection);
 }
 
+static JConnectionPoolQueue*
+j_connection_pool_get_queue(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	switch (backend)
+	{
+		case J_BACKEND_TYPE_OBJECT:
+			g_return_val_if_fail(index < j_connection_pool->object_len, NULL);
+			return &(j_connection_pool->object_queues[index]);
+		case J_BACKEND_TYPE_KV:
+			g_return_val_if_fail(index < j_connection_pool->kv_len, NULL);
+			return &(j_connection_pool->kv_queues[index]);
+		case J_BACKEND_TYPE_DB:
+			g_return_val_if_fail(index < j_connection_pool->db_len, NULL);
+			return &(j_connection_pool->db_queues[index]);
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
 gpointer
 j_connection_pool_pop(JBackendType backend, guint index)
 {
@@ -322,6 +364,101 @@ j_connection_pool_push(JBackendType backend, guint index, gpointer connection)
 	}
 }
 
+/**
+ * Detaches a connection that has been popped from the pool.
+ * The pool no longer accounts for the connection and may open another one instead,
+ * which allows keeping the connection for a long time without starving other users of the pool.
+ * At most as many connections as the pool may contain can be detached per server.
+ * The connection has to be returned using j_connection_pool_attach().
+ *
+ * \param backend The backend type.
+ * \param index   The server index.
+ *
+ * \return TRUE if the connection has been detached, FALSE if too many connections are detached already.
+ **/
+gboolean
+j_connection_pool_detach(JBackendType backend, guint index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* pool_queue;
+
+	g_return_val_if_fail(j_connection_pool != NULL, FALSE);
+
+	if ((pool_queue = j_connection_pool_get_queue(backend, index)) == NULL)
+	{
+		return FALSE;
+	}
+
+	if ((guint)g_atomic_int_add(&(pool_queue->detached), 1) >= j_connection_pool->max_count)
+	{
+		g_atomic_int_add(&(pool_queue->detached), -1);
+
+		return FALSE;
+	}
+
+	g_atomic_int_add(&(pool_queue->count), -1);
+
+	// Threads already waiting for a connection would not notice that another one may be opened
+	if (g_async_queue_length(pool_queue->queue) < 0)
+	{
+		if ((guint)g_atomic_int_add(&(pool_queue->count), 1) < j_connection_pool->max_count)
+		{
+			GSocketConnection* connection;
+
+			connection = j_connection_pool_connect(j_configuration_get_server(j_connection_pool->configuration, backend, index), g_atomic_int_get(&(pool_queue->count)));
+			j_connection_pool_push_internal(pool_queue->queue, connection);
+		}
+		else
+		{
+			g_atomic_int_add(&(pool_queue->count), -1);
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns a detached connection to the pool.
+ * If the pool has opened the maximum number of connections in the meantime, the connection is closed instead.
+ *
+ * \param backend    The backend type.
+ * \param index      The server index.
+ * \param connection The connection, or NULL if it has been lost.
+ **/
+void
+j_connection_pool_attach(JBackendType backend, guint index, gpointer connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JConnectionPoolQueue* pool_queue;
+
+	g_return_if_fail(j_connection_pool != NULL);
+
+	if ((pool_queue = j_connection_pool_get_queue(backend, index)) == NULL)
+	{
+		return;
+	}
+
+	g_atomic_int_add(&(pool_queue->detached), -1);
+
+	if (connection == NULL)
+	{
+		return;
+	}
+
+	if ((guint)g_atomic_int_add(&(pool_queue->count), 1) < j_connection_pool->max_count)
+	{
+		j_connection_pool_push_internal(pool_queue->queue, connection);
+	}
+	else
+	{
+		g_atomic_int_add(&(pool_queue->count), -1);
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+		g_object_unref(connection);
+	}
+}
+
 /**
  * @}
  **/
@@ -166,6 +166,11 @@ struct JMessage
 	gint ref_count;
 };
 
+/**
+ * The number of messages written by this process.
+ **/
+static gint j_message_written = 0;
+
 /**
  * Returns a message's length.
  *
@@ -938,6 +943,8 @@ j_message_write(JMessage* message, GOutputStream* stream)
 
 	g_output_stream_flush(stream, NULL, NULL);
 
+	g_atomic_int_inc(&j_message_written);
+
 	ret = TRUE;
 
 end:
@@ -950,6 +957,28 @@ end:
 	return ret;
 }
 
+/**
+ * Returns the number of messages written by this process.
+ * Clients wait for a reply to most messages, so this approximates the number of round trips.
+ *
+ * \code
+ * guint32 before;
+ *
+ * before = j_message_get_written();
+ * ...
+ * g_print("%u\n", j_message_get_written() - before);
+ * \endcode
+ *
+ * \return The number of messages, which wraps around on overflow.
+ **/
+guint32
+j_message_get_written(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return (guint32)g_atomic_int_get(&j_message_written);
+}
+
 /**
  * Adds new data to send to a message.
  *
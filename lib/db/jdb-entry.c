@@ -33,6 +33,31 @@
 #include <julea-db.h>
 #include "../../backend/db/jbson.c"
 
+/**
+ * Checks whether a selector can be used to update or delete entries.
+ * Query options cannot be honoured by these operations and would be dropped silently otherwise.
+ *
+ * \private
+ **/
+static gboolean
+j_db_entry_check_selector(JDBSelector* selector, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (selector == NULL)
+	{
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(selector->fields != NULL || selector->aggregates != NULL || selector->order != NULL || selector->limit > 0 || selector->offset > 0 || selector->joins != NULL))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "query options are not supported for updates and deletes");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 JDBEntry*
 j_db_entry_new(JDBSchema* schema, GError** error)
 {
@@ -192,7 +217,7 @@ _error:
 }
 
 gboolean
-j_db_entry_update(JDBEntry* entry, JDBSelector* selector, JBatch* batch, GError** error)
+j_db_entry_update(JDBEntry* entry, JDBSelector* selector, guint64* count, JBatch* batch, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -212,7 +237,12 @@ j_db_entry_update(JDBEntry* entry, JDBSelector* selector, JBatch* batch, GError*
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_db_internal_update(entry, selector, batch, error)))
+	if (G_UNLIKELY(!j_db_entry_check_selector(selector, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_internal_update(entry, selector, count, batch, error)))
 	{
 		goto _error;
 	}
@@ -224,7 +254,7 @@ _error:
 }
 
 gboolean
-j_db_entry_delete(JDBEntry* entry, JDBSelector* selector, JBatch* batch, GError** error)
+j_db_entry_delete(JDBEntry* entry, JDBSelector* selector, guint64* count, JBatch* batch, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -233,7 +263,12 @@ j_db_entry_delete(JDBEntry* entry, JDBSelector* selector, JBatch* batch, GError*
 	g_return_val_if_fail((selector == NULL) || (selector->schema == entry->schema), FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (G_UNLIKELY(!j_db_internal_delete(entry, selector, batch, error)))
+	if (G_UNLIKELY(!j_db_entry_check_selector(selector, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_internal_delete(entry, selector, count, batch, error)))
 	{
 		goto _error;
 	}
@@ -37,8 +37,24 @@
 struct JDBIteratorHelper
 {
 	bson_t bson;
+	bson_t cursor;
 	bson_iter_t iter;
 	gboolean initialized;
+
+	/**
+	 * The connection to the DB server streaming the query's rows.
+	 * It is detached from the connection pool, so that nested and concurrent iterators cannot exhaust the pool.
+	 * It is NULL if all rows have been received.
+	 **/
+	GSocketConnection* connection;
+	guint32 index;
+	gboolean detached;
+
+	/**
+	 * The request for the next rows.
+	 * It is sent as soon as the previous rows have been received to overlap fetching and processing.
+	 **/
+	JMessage* request;
 };
 
 typedef struct JDBIteratorHelper JDBIteratorHelper;
@@ -51,6 +67,86 @@ j_db_error_quark(void)
 	return g_quark_from_static_string("j-db-error-quark");
 }
 
+struct JDBBackgroundData
+{
+	guint32 index;
+	JMessage* message;
+	JList* operations;
+	gboolean ret;
+};
+
+typedef struct JDBBackgroundData JDBBackgroundData;
+
+/**
+ * Returns the index of the DB server responsible for a schema.
+ * Namespaces are distributed across all DB servers by hashing their names.
+ * All schemas of a namespace are stored on the same server, allowing them to be joined.
+ *
+ * \private
+ *
+ * \param namespace The schema's namespace.
+ *
+ * \return The server index.
+ **/
+guint32
+j_db_internal_get_server_index(gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint32 server_count;
+	guint32 hash;
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+
+	if (server_count == 1)
+	{
+		return 0;
+	}
+
+	hash = j_helper_hash(namespace);
+
+	return hash % server_count;
+}
+
+/**
+ * Sends a message to a DB server and unpacks the reply into the operations' out parameters.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_backend_db_func_exec_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBBackgroundData* background_data = data;
+
+	g_autoptr(JListIterator) iter = NULL;
+	g_autoptr(JMessage) reply = NULL;
+	GSocketConnection* db_connection;
+
+	db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, background_data->index);
+	j_message_send(background_data->message, db_connection);
+	reply = j_message_new_reply(background_data->message);
+	j_message_receive(reply, db_connection);
+
+	iter = j_list_iterator_new(background_data->operations);
+
+	while (j_list_iterator_next(iter))
+	{
+		JBackendOperation* operation = j_list_iterator_get(iter);
+
+		background_data->ret = j_backend_operation_from_message(reply, operation->out_param, operation->out_param_count) && background_data->ret;
+	}
+
+	j_connection_pool_push(J_BACKEND_TYPE_DB, background_data->index, db_connection);
+
+	return data;
+}
+
 static gboolean
 j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType type)
 {
@@ -58,18 +154,17 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 	JBackendOperation* data = NULL;
 	gboolean ret = TRUE;
-	GSocketConnection* db_connection;
 	g_autoptr(JListIterator) iter_send = NULL;
-	g_autoptr(JListIterator) iter_recieve = NULL;
-	g_autoptr(JMessage) message = NULL;
-	g_autoptr(JMessage) reply = NULL;
+	g_autofree JDBBackgroundData** background_data = NULL;
 	JBackend* db_backend = j_db_get_backend();
 	gpointer batch = NULL;
 	GError* error = NULL;
+	guint32 server_count = 0;
 
 	if (db_backend == NULL)
 	{
-		message = j_message_new(type, 0);
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+		background_data = g_new0(JDBBackgroundData*, server_count);
 	}
 
 	iter_send = j_list_iterator_new(operations);
@@ -80,7 +175,22 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 		if (db_backend == NULL)
 		{
-			ret = j_backend_operation_to_message(message, data->in_param, data->in_param_count) && ret;
+			guint32 index;
+
+			// All operations refer to a schema's namespace by their first parameter
+			index = j_db_internal_get_server_index(data->in_param[0].ptr);
+
+			if (background_data[index] == NULL)
+			{
+				background_data[index] = g_slice_new(JDBBackgroundData);
+				background_data[index]->index = index;
+				background_data[index]->message = j_message_new(type, 0);
+				background_data[index]->operations = j_list_new(NULL);
+				background_data[index]->ret = TRUE;
+			}
+
+			ret = j_backend_operation_to_message(background_data[index]->message, data->in_param, data->in_param_count) && ret;
+			j_list_append(background_data[index]->operations, data);
 		}
 		else
 		{
@@ -102,19 +212,22 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 	if (db_backend == NULL)
 	{
-		db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, 0);
-		j_message_send(message, db_connection);
-		reply = j_message_new_reply(message);
-		j_message_receive(reply, db_connection);
-		iter_recieve = j_list_iterator_new(operations);
+		// Messages for different servers are sent in parallel
+		j_helper_execute_parallel(j_backend_db_func_exec_background_operation, (gpointer*)background_data, server_count);
 
-		while (j_list_iterator_next(iter_recieve))
+		for (guint32 i = 0; i < server_count; i++)
 		{
-			data = j_list_iterator_get(iter_recieve);
-			ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
-		}
+			if (background_data[i] == NULL)
+			{
+				continue;
+			}
+
+			ret = background_data[i]->ret && ret;
 
-		j_connection_pool_push(J_BACKEND_TYPE_DB, 0, db_connection);
+			j_message_unref(background_data[i]->message);
+			j_list_unref(background_data[i]->operations);
+			g_slice_free(JDBBackgroundData, background_data[i]);
+		}
 	}
 	else
 	{
@@ -315,37 +428,138 @@ j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** error)
 	return TRUE;
 }
 
+/**
+ * The number of entries modified by an update or delete.
+ **/
+struct JDBCount
+{
+	/**
+	 * The document returned by the backend, see j_backend_operation_unwrap_db_update().
+	 **/
+	bson_t bson;
+
+	/**
+	 * The caller's count, or NULL.
+	 **/
+	guint64* count;
+};
+
+typedef struct JDBCount JDBCount;
+
+static JDBCount*
+j_db_count_new(guint64* count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBCount* db_count;
+
+	db_count = g_slice_new(JDBCount);
+	memset(&db_count->bson, 0, sizeof(bson_t));
+	db_count->count = count;
+
+	if (count != NULL)
+	{
+		*count = 0;
+	}
+
+	return db_count;
+}
+
+static void
+j_db_count_free(JDBCount* db_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t zerobson;
+
+	memset(&zerobson, 0, sizeof(bson_t));
+
+	if (memcmp(&db_count->bson, &zerobson, sizeof(bson_t)) != 0)
+	{
+		bson_destroy(&db_count->bson);
+	}
+
+	g_slice_free(JDBCount, db_count);
+}
+
+/**
+ * Executes updates or deletes and passes the number of modified entries to their callers.
+ *
+ * \private
+ **/
+static gboolean
+j_db_count_exec(JList* operations, JSemantics* semantics, JMessageType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JListIterator) iter = NULL;
+	gboolean ret;
+
+	ret = j_backend_db_func_exec(operations, semantics, type);
+
+	iter = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(iter))
+	{
+		JBackendOperation* data = j_list_iterator_get(iter);
+		JDBCount* db_count = data->unref_values[2];
+		bson_t zerobson;
+		bson_iter_t iter_count;
+
+		memset(&zerobson, 0, sizeof(bson_t));
+
+		// Failed operations do not return a count
+		if (db_count->count == NULL || memcmp(&db_count->bson, &zerobson, sizeof(bson_t)) == 0)
+		{
+			continue;
+		}
+
+		if (bson_iter_init_find(&iter_count, &db_count->bson, "count"))
+		{
+			*(db_count->count) = bson_iter_as_int64(&iter_count);
+		}
+	}
+
+	return ret;
+}
+
 static gboolean
 j_db_update_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_UPDATE);
+	return j_db_count_exec(operations, semantics, J_MESSAGE_DB_UPDATE);
 }
 
 gboolean
-j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error)
+j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, guint64* count, JBatch* batch, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
 	JBackendOperation* data;
+	JDBCount* db_count;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
+	db_count = j_db_count_new(count);
+
 	data = g_slice_new(JBackendOperation);
 	memcpy(data, &j_backend_operation_db_update, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_entry->schema->namespace;
 	data->in_param[1].ptr_const = j_db_entry->schema->name;
 	data->in_param[2].ptr_const = j_db_selector_get_bson(j_db_selector);
 	data->in_param[3].ptr_const = &j_db_entry->bson;
-	data->out_param[0].ptr_const = error;
+	data->out_param[0].ptr_const = &db_count->bson;
+	data->out_param[1].ptr_const = error;
 
-	data->unref_func_count = 2;
+	data->unref_func_count = 3;
 	data->unref_funcs[0] = (GDestroyNotify)j_db_entry_unref;
 	data->unref_funcs[1] = (GDestroyNotify)j_db_selector_unref;
+	data->unref_funcs[2] = (GDestroyNotify)j_db_count_free;
 	data->unref_values[0] = j_db_entry_ref(j_db_entry);
 	data->unref_values[1] = j_db_selector_ref(j_db_selector);
+	data->unref_values[2] = db_count;
 
 	op = j_operation_new();
 	op->key = j_db_entry->schema->namespace;
@@ -363,31 +577,37 @@ j_db_delete_exec(JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_DELETE);
+	return j_db_count_exec(operations, semantics, J_MESSAGE_DB_DELETE);
 }
 
 gboolean
-j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error)
+j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, guint64* count, JBatch* batch, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JOperation* op;
 	JBackendOperation* data;
+	JDBCount* db_count;
 
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
+	db_count = j_db_count_new(count);
+
 	data = g_slice_new(JBackendOperation);
 	memcpy(data, &j_backend_operation_db_delete, sizeof(JBackendOperation));
 	data->in_param[0].ptr_const = j_db_entry->schema->namespace;
 	data->in_param[1].ptr_const = j_db_entry->schema->name;
 	data->in_param[2].ptr_const = j_db_selector_get_bson(j_db_selector);
-	data->out_param[0].ptr_const = error;
+	data->out_param[0].ptr_const = &db_count->bson;
+	data->out_param[1].ptr_const = error;
 
-	data->unref_func_count = 2;
+	data->unref_func_count = 3;
 	data->unref_funcs[0] = (GDestroyNotify)j_db_entry_unref;
 	data->unref_funcs[1] = (GDestroyNotify)j_db_selector_unref;
+	data->unref_funcs[2] = (GDestroyNotify)j_db_count_free;
 	data->unref_values[0] = j_db_entry_ref(j_db_entry);
 	data->unref_values[1] = j_db_selector_ref(j_db_selector);
+	data->unref_values[2] = db_count;
 
 	op = j_operation_new();
 	op->key = j_db_entry->schema->namespace;
@@ -401,114 +621,459 @@ j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* b
 }
 
 static gboolean
-j_db_query_exec(JList* operations, JSemantics* semantics)
+j_db_iterator_helper_bson_valid(bson_t const* bson)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_QUERY);
+	bson_t zerobson;
+
+	memset(&zerobson, 0, sizeof(bson_t));
+
+	return (memcmp(bson, &zerobson, sizeof(bson_t)) != 0);
 }
 
-gboolean
-j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error)
+/**
+ * Checks whether the server has more rows for a query.
+ *
+ * \private
+ *
+ * \param helper The iterator helper whose cursor has been received.
+ *
+ * \return TRUE if there are more rows, FALSE otherwise.
+ **/
+static gboolean
+j_db_iterator_helper_more(JDBIteratorHelper* helper)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBIteratorHelper* helper;
-	JOperation* op;
-	JBackendOperation* data;
+	bson_iter_t iter;
+	gboolean more = FALSE;
 
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	if (!j_db_iterator_helper_bson_valid(&helper->cursor))
+	{
+		return FALSE;
+	}
 
-	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
-	helper->initialized = FALSE;
-	memset(&helper->bson, 0, sizeof(bson_t));
-	j_db_iterator->iterator = helper;
+	if (bson_iter_init_find(&iter, &helper->cursor, "more"))
+	{
+		more = bson_iter_as_bool(&iter);
+	}
 
-	data = g_slice_new(JBackendOperation);
-	memcpy(data, &j_backend_operation_db_query, sizeof(JBackendOperation));
-	data->in_param[0].ptr_const = j_db_schema->namespace;
-	data->in_param[1].ptr_const = j_db_schema->name;
-	data->in_param[2].ptr_const = j_db_selector_get_bson(j_db_selector);
-	data->out_param[0].ptr_const = &helper->bson;
-	data->out_param[1].ptr_const = error;
+	bson_destroy(&helper->cursor);
+	memset(&helper->cursor, 0, sizeof(bson_t));
 
-	data->unref_func_count = 3;
-	data->unref_funcs[0] = (GDestroyNotify)j_db_schema_unref;
-	data->unref_funcs[1] = (GDestroyNotify)j_db_selector_unref;
-	data->unref_funcs[2] = (GDestroyNotify)j_db_iterator_unref;
-	data->unref_values[0] = j_db_schema_ref(j_db_schema);
-	data->unref_values[1] = j_db_selector_ref(j_db_selector);
-	data->unref_values[2] = j_db_iterator_ref(j_db_iterator);
+	return more;
+}
 
-	op = j_operation_new();
-	op->key = j_db_schema->namespace;
-	op->data = data;
-	op->exec_func = j_db_query_exec;
-	op->free_func = j_backend_db_func_free;
+/**
+ * Returns the iterator's connection.
+ *
+ * \private
+ *
+ * \param helper The iterator helper.
+ * \param lost   Whether the connection has been lost.
+ **/
+static void
+j_db_iterator_helper_release(JDBIteratorHelper* helper, gboolean lost)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	j_batch_add(batch, op);
+	if (lost)
+	{
+		g_io_stream_close(G_IO_STREAM(helper->connection), NULL, NULL);
+		g_object_unref(helper->connection);
+	}
 
-	return TRUE;
+	if (helper->detached)
+	{
+		j_connection_pool_attach(J_BACKEND_TYPE_DB, helper->index, (lost) ? NULL : helper->connection);
+	}
+	else if (!lost)
+	{
+		// FIXME The pool does not replace lost connections
+		j_connection_pool_push(J_BACKEND_TYPE_DB, helper->index, helper->connection);
+	}
+
+	helper->connection = NULL;
+	helper->detached = FALSE;
 }
 
-gboolean
-j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
+static void
+j_db_iterator_helper_request(JDBIteratorHelper* helper)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBIteratorHelper* helper = j_db_iterator->iterator;
-	gboolean has_next;
-	bson_t zerobson;
+	helper->request = j_message_new(J_MESSAGE_DB_QUERY_NEXT, 0);
+	j_message_send(helper->request, helper->connection);
+}
 
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+/**
+ * Receives the next rows of a query.
+ *
+ * \private
+ *
+ * \param helper   The iterator helper, its current rows must have been freed.
+ * \param prefetch Whether to request the following rows if there are any.
+ * \param error    A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_iterator_helper_receive(JDBIteratorHelper* helper, gboolean prefetch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	memset(&zerobson, 0, sizeof(bson_t));
+	JBackendOperationParam out_param[3];
+	g_autoptr(JMessage) reply = NULL;
+	gboolean ret;
+
+	reply = j_message_new_reply(helper->request);
+	ret = j_message_receive(reply, helper->connection);
+
+	j_message_unref(helper->request);
+	helper->request = NULL;
 
-	if (!helper->initialized)
+	if (!ret)
 	{
-		if (G_UNLIKELY(!memcmp(&helper->bson, &zerobson, sizeof(bson_t))))
+		// The server closes idle cursors together with their connection
+		j_db_iterator_helper_release(helper, TRUE);
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "cursor has been closed by the server");
+
+		return FALSE;
+	}
+
+	memcpy(out_param, j_backend_operation_db_query.out_param, sizeof(out_param));
+	out_param[0].ptr = &helper->bson;
+	out_param[1].ptr = &helper->cursor;
+	out_param[2].ptr = error;
+
+	ret = j_backend_operation_from_message(reply, out_param, 3);
+	helper->initialized = FALSE;
+
+	if (j_db_iterator_helper_more(helper))
+	{
+		if (prefetch)
 		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
-			goto error2;
+			j_db_iterator_helper_request(helper);
 		}
+	}
+	else
+	{
+		j_db_iterator_helper_release(helper, FALSE);
+	}
+
+	return ret;
+}
+
+/**
+ * Receives all remaining rows of a query at once.
+ * This is used if the connection cannot be detached because too many iterators are open,
+ * the connection is returned immediately at the cost of keeping all rows in memory.
+ *
+ * \private
+ *
+ * \param helper The iterator helper, its connection must have requested the next rows.
+ * \param error  A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_iterator_helper_drain(JDBIteratorHelper* helper, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t rows;
+	guint32 count = 0;
+	gboolean ret = TRUE;
+
+	bson_init(&rows);
 
-		if (G_UNLIKELY(!j_bson_iter_init(&helper->iter, &helper->bson, error)))
+	while (ret)
+	{
+		if (j_db_iterator_helper_bson_valid(&helper->bson))
 		{
-			goto _error;
+			bson_iter_t iter;
+
+			if (!j_bson_iter_init(&iter, &helper->bson, error))
+			{
+				ret = FALSE;
+				break;
+			}
+
+			while (bson_iter_next(&iter))
+			{
+				gchar buf[16];
+				gchar const* key;
+
+				bson_uint32_to_string(count, &key, buf, sizeof(buf));
+				bson_append_iter(&rows, key, -1, &iter);
+				count++;
+			}
+
+			j_bson_destroy(&helper->bson);
+			memset(&helper->bson, 0, sizeof(bson_t));
 		}
 
-		helper->initialized = TRUE;
-	}
+		if (helper->connection == NULL)
+		{
+			break;
+		}
 
-	if (G_UNLIKELY(!j_bson_iter_next(&helper->iter, &has_next, error)))
-	{
-		goto _error;
+		ret = j_db_iterator_helper_receive(helper, TRUE, error);
 	}
 
-	if (G_UNLIKELY(!has_next))
+	if (ret)
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-		goto _error;
+		bson_copy_to(&rows, &helper->bson);
 	}
-
-	if (G_UNLIKELY(!j_bson_iter_copy_document(&helper->iter, &j_db_iterator->bson, error)))
+	else if (helper->connection != NULL)
 	{
-		goto _error;
+		// The reply to the pending request would be received by the connection's next user
+		j_db_iterator_helper_release(helper, TRUE);
 	}
 
-	return TRUE;
-
-_error:
-	j_bson_destroy(&helper->bson);
-
-error2:
-	g_free(helper);
+	bson_destroy(&rows);
 
-	return FALSE;
+	return ret;
 }
 
-bson_t*
-j_db_selector_get_bson(JDBSelector* selector)
+static gboolean
+j_db_query_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+	g_autoptr(JListIterator) iter = NULL;
+
+	if (j_db_get_backend() != NULL)
+	{
+		ret = j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_QUERY);
+
+		iter = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(iter))
+		{
+			JBackendOperation* data = j_list_iterator_get(iter);
+			JDBIterator* j_db_iterator = data->unref_values[2];
+
+			// Local backends return all rows at once
+			j_db_iterator_helper_more(j_db_iterator->iterator);
+		}
+
+		return ret;
+	}
+
+	iter = j_list_iterator_new(operations);
+
+	// Queries are sent separately to allow the server to stream their rows
+	while (j_list_iterator_next(iter))
+	{
+		JBackendOperation* data = j_list_iterator_get(iter);
+		JDBIterator* j_db_iterator = data->unref_values[2];
+		JDBIteratorHelper* helper = j_db_iterator->iterator;
+		g_autoptr(JMessage) message = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		GSocketConnection* db_connection;
+		guint32 index;
+
+		index = j_db_internal_get_server_index(data->in_param[0].ptr);
+
+		message = j_message_new(J_MESSAGE_DB_QUERY, 0);
+		ret = j_backend_operation_to_message(message, data->in_param, data->in_param_count) && ret;
+
+		db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, index);
+		j_message_send(message, db_connection);
+		reply = j_message_new_reply(message);
+		j_message_receive(reply, db_connection);
+
+		ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
+
+		if (j_db_iterator_helper_more(helper))
+		{
+			// The connection is kept until all rows have been received or the iterator is closed
+			helper->detached = j_connection_pool_detach(J_BACKEND_TYPE_DB, index);
+			helper->connection = db_connection;
+			helper->index = index;
+			j_db_iterator_helper_request(helper);
+
+			if (!helper->detached)
+			{
+				ret = j_db_iterator_helper_drain(helper, data->out_param[2].ptr) && ret;
+			}
+		}
+		else
+		{
+			j_connection_pool_push(J_BACKEND_TYPE_DB, index, db_connection);
+		}
+	}
+
+	return ret;
+}
+
+gboolean
+j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper;
+	JOperation* op;
+	JBackendOperation* data;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
+	helper->initialized = FALSE;
+	helper->connection = NULL;
+	helper->index = 0;
+	helper->detached = FALSE;
+	helper->request = NULL;
+	memset(&helper->bson, 0, sizeof(bson_t));
+	memset(&helper->cursor, 0, sizeof(bson_t));
+	j_db_iterator->iterator = helper;
+
+	data = g_slice_new(JBackendOperation);
+	memcpy(data, &j_backend_operation_db_query, sizeof(JBackendOperation));
+	data->in_param[0].ptr_const = j_db_schema->namespace;
+	data->in_param[1].ptr_const = j_db_schema->name;
+	data->in_param[2].ptr_const = j_db_selector_get_query_bson(j_db_selector);
+	data->out_param[0].ptr_const = &helper->bson;
+	data->out_param[1].ptr_const = &helper->cursor;
+	data->out_param[2].ptr_const = error;
+
+	data->unref_func_count = 3;
+	data->unref_funcs[0] = (GDestroyNotify)j_db_schema_unref;
+	data->unref_funcs[1] = (GDestroyNotify)j_db_selector_unref;
+	data->unref_funcs[2] = (GDestroyNotify)j_db_iterator_unref;
+	data->unref_values[0] = j_db_schema_ref(j_db_schema);
+	data->unref_values[1] = j_db_selector_ref(j_db_selector);
+	data->unref_values[2] = j_db_iterator_ref(j_db_iterator);
+
+	op = j_operation_new();
+	op->key = j_db_schema->namespace;
+	op->data = data;
+	op->exec_func = j_db_query_exec;
+	op->free_func = j_backend_db_func_free;
+
+	j_batch_add(batch, op);
+
+	return TRUE;
+}
+
+gboolean
+j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	gboolean has_next = FALSE;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(helper == NULL))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+		goto _error;
+	}
+
+	while (!has_next)
+	{
+		if (!helper->initialized)
+		{
+			if (G_UNLIKELY(!j_db_iterator_helper_bson_valid(&helper->bson)))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_init(&helper->iter, &helper->bson, error)))
+			{
+				goto _error;
+			}
+
+			helper->initialized = TRUE;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_next(&helper->iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			if (helper->connection == NULL)
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+				goto _error;
+			}
+
+			j_bson_destroy(&helper->bson);
+			memset(&helper->bson, 0, sizeof(bson_t));
+
+			if (G_UNLIKELY(!j_db_iterator_helper_receive(helper, TRUE, error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_copy_document(&helper->iter, &j_db_iterator->bson, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	j_db_internal_iterator_close(j_db_iterator);
+
+	return FALSE;
+}
+
+void
+j_db_internal_iterator_close(JDBIterator* j_db_iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	if (helper == NULL)
+	{
+		return;
+	}
+
+	if (helper->connection != NULL)
+	{
+		if (j_db_iterator_helper_bson_valid(&helper->bson))
+		{
+			j_bson_destroy(&helper->bson);
+			memset(&helper->bson, 0, sizeof(bson_t));
+		}
+
+		// Wait for the prefetched rows, they also tell whether the server's cursor is still open
+		j_db_iterator_helper_receive(helper, FALSE, NULL);
+
+		if (helper->connection != NULL)
+		{
+			g_autoptr(JMessage) message = NULL;
+
+			message = j_message_new(J_MESSAGE_DB_QUERY_CLOSE, 0);
+			j_message_send(message, helper->connection);
+
+			j_db_iterator_helper_release(helper, FALSE);
+		}
+	}
+
+	if (j_db_iterator_helper_bson_valid(&helper->bson))
+	{
+		j_bson_destroy(&helper->bson);
+	}
+
+	g_free(helper);
+	j_db_iterator->iterator = NULL;
+}
+
+bson_t*
+j_db_selector_get_bson(JDBSelector* selector)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -519,3 +1084,328 @@ j_db_selector_get_bson(JDBSelector* selector)
 
 	return NULL;
 }
+
+/**
+ * Appends a document containing the given strings to bson.
+ *
+ * \private
+ **/
+static gboolean
+j_db_selector_append_names(bson_t* bson, gchar const* key, gchar** names)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t bson_child;
+	JDBTypeValue val;
+	char buf[20];
+
+	if (!j_bson_append_document_begin(bson, key, &bson_child, NULL))
+	{
+		return FALSE;
+	}
+
+	for (guint i = 0; names[i] != NULL; i++)
+	{
+		snprintf(buf, sizeof(buf), "%d", i);
+		val.val_string = names[i];
+
+		if (!j_bson_append_value(&bson_child, buf, J_DB_TYPE_STRING, &val, NULL))
+		{
+			return FALSE;
+		}
+	}
+
+	return j_bson_append_document_end(bson, &bson_child, NULL);
+}
+
+/**
+ * Appends the selector's aggregates to bson.
+ * Each aggregate is a document containing the function, the field's name and type as well as the result's type.
+ *
+ * \private
+ **/
+static gboolean
+j_db_selector_append_aggregates(bson_t* bson, GArray* aggregates)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t bson_child;
+	JDBTypeValue val;
+	char buf[20];
+
+	if (!j_bson_append_document_begin(bson, "_aggregate", &bson_child, NULL))
+	{
+		return FALSE;
+	}
+
+	for (guint i = 0; i < aggregates->len; i++)
+	{
+		JDBSelectorAggregate* aggregate = &g_array_index(aggregates, JDBSelectorAggregate, i);
+		bson_t bson_aggregate;
+
+		snprintf(buf, sizeof(buf), "%d", i);
+
+		if (!j_bson_append_document_begin(&bson_child, buf, &bson_aggregate, NULL))
+		{
+			return FALSE;
+		}
+
+		val.val_uint32 = aggregate->function;
+
+		if (!j_bson_append_value(&bson_aggregate, "_function", J_DB_TYPE_UINT32, &val, NULL))
+		{
+			return FALSE;
+		}
+
+		if (aggregate->name != NULL)
+		{
+			val.val_string = aggregate->name;
+
+			if (!j_bson_append_value(&bson_aggregate, "_name", J_DB_TYPE_STRING, &val, NULL))
+			{
+				return FALSE;
+			}
+
+			val.val_uint32 = aggregate->type;
+
+			if (!j_bson_append_value(&bson_aggregate, "_type", J_DB_TYPE_UINT32, &val, NULL))
+			{
+				return FALSE;
+			}
+		}
+
+		val.val_uint32 = aggregate->result_type;
+
+		if (!j_bson_append_value(&bson_aggregate, "_result_type", J_DB_TYPE_UINT32, &val, NULL))
+		{
+			return FALSE;
+		}
+
+		if (!j_bson_append_document_end(&bson_child, &bson_aggregate, NULL))
+		{
+			return FALSE;
+		}
+	}
+
+	return j_bson_append_document_end(bson, &bson_child, NULL);
+}
+
+/**
+ * Appends the selector's sort keys to bson.
+ * Each sort key is a document containing the field's name and the order.
+ *
+ * \private
+ **/
+static gboolean
+j_db_selector_append_order(bson_t* bson, GArray* order)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t bson_child;
+	JDBTypeValue val;
+	char buf[20];
+
+	if (!j_bson_append_document_begin(bson, "_order", &bson_child, NULL))
+	{
+		return FALSE;
+	}
+
+	for (guint i = 0; i < order->len; i++)
+	{
+		JDBSelectorSort* sort = &g_array_index(order, JDBSelectorSort, i);
+		bson_t bson_sort;
+
+		snprintf(buf, sizeof(buf), "%d", i);
+
+		if (!j_bson_append_document_begin(&bson_child, buf, &bson_sort, NULL))
+		{
+			return FALSE;
+		}
+
+		val.val_string = sort->name;
+
+		if (!j_bson_append_value(&bson_sort, "_name", J_DB_TYPE_STRING, &val, NULL))
+		{
+			return FALSE;
+		}
+
+		val.val_uint32 = sort->order;
+
+		if (!j_bson_append_value(&bson_sort, "_order", J_DB_TYPE_UINT32, &val, NULL))
+		{
+			return FALSE;
+		}
+
+		if (!j_bson_append_document_end(&bson_child, &bson_sort, NULL))
+		{
+			return FALSE;
+		}
+	}
+
+	return j_bson_append_document_end(bson, &bson_child, NULL);
+}
+
+/**
+ * Appends the selector's limit and offset to bson, they are omitted if they are 0.
+ *
+ * \private
+ **/
+static gboolean
+j_db_selector_append_limit(bson_t* bson, guint64 limit, guint64 offset)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBTypeValue val;
+
+	if (limit > 0)
+	{
+		val.val_uint64 = limit;
+
+		if (!j_bson_append_value(bson, "_limit", J_DB_TYPE_UINT64, &val, NULL))
+		{
+			return FALSE;
+		}
+	}
+
+	if (offset > 0)
+	{
+		val.val_uint64 = offset;
+
+		if (!j_bson_append_value(bson, "_offset", J_DB_TYPE_UINT64, &val, NULL))
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Appends the selector's joins to bson.
+ * Each join is a document containing the joined fields, the joined schema's name as well as the joined selector's conditions and fields.
+ *
+ * \private
+ **/
+static gboolean
+j_db_selector_append_joins(bson_t* bson, GArray* joins)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t bson_child;
+	JDBTypeValue val;
+	char buf[20];
+
+	if (!j_bson_append_document_begin(bson, "_join", &bson_child, NULL))
+	{
+		return FALSE;
+	}
+
+	for (guint i = 0; i < joins->len; i++)
+	{
+		JDBSelectorJoin* join = &g_array_index(joins, JDBSelectorJoin, i);
+		bson_t bson_join;
+
+		snprintf(buf, sizeof(buf), "%d", i);
+
+		if (!j_bson_append_document_begin(&bson_child, buf, &bson_join, NULL))
+		{
+			return FALSE;
+		}
+
+		val.val_string = join->schema->name;
+
+		if (!j_bson_append_value(&bson_join, "_schema", J_DB_TYPE_STRING, &val, NULL))
+		{
+			return FALSE;
+		}
+
+		val.val_string = join->name;
+
+		if (!j_bson_append_value(&bson_join, "_name", J_DB_TYPE_STRING, &val, NULL))
+		{
+			return FALSE;
+		}
+
+		val.val_string = join->join_name;
+
+		if (!j_bson_append_value(&bson_join, "_join_name", J_DB_TYPE_STRING, &val, NULL))
+		{
+			return FALSE;
+		}
+
+		if (join->selector != NULL && !j_bson_append_document(&bson_join, "_selector", join->selector, NULL))
+		{
+			return FALSE;
+		}
+
+		if (join->fields != NULL && !j_db_selector_append_names(&bson_join, "_fields", join->fields))
+		{
+			return FALSE;
+		}
+
+		if (!j_bson_append_document_end(&bson_child, &bson_join, NULL))
+		{
+			return FALSE;
+		}
+	}
+
+	return j_bson_append_document_end(bson, &bson_child, NULL);
+}
+
+bson_t*
+j_db_selector_get_query_bson(JDBSelector* selector)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (selector == NULL || (selector->fields == NULL && selector->aggregates == NULL && selector->order == NULL && selector->limit == 0 && selector->offset == 0 && selector->joins == NULL))
+	{
+		return j_db_selector_get_bson(selector);
+	}
+
+	if (!selector->bson_query_valid)
+	{
+		bson_copy_to(&selector->bson, &selector->bson_query);
+
+		// Query options use reserved keys starting with an underscore
+		if (selector->aggregates != NULL)
+		{
+			if (!j_db_selector_append_aggregates(&selector->bson_query, selector->aggregates))
+			{
+				goto _error;
+			}
+
+			if (selector->group_by != NULL && !j_db_selector_append_names(&selector->bson_query, "_group_by", selector->group_by))
+			{
+				goto _error;
+			}
+		}
+		else if (selector->fields != NULL && !j_db_selector_append_names(&selector->bson_query, "_fields", selector->fields))
+		{
+			goto _error;
+		}
+
+		if (selector->order != NULL && !j_db_selector_append_order(&selector->bson_query, selector->order))
+		{
+			goto _error;
+		}
+
+		if (!j_db_selector_append_limit(&selector->bson_query, selector->limit, selector->offset))
+		{
+			goto _error;
+		}
+
+		if (selector->joins != NULL && !j_db_selector_append_joins(&selector->bson_query, selector->joins))
+		{
+			goto _error;
+		}
+
+		selector->bson_query_valid = TRUE;
+	}
+
+	return &selector->bson_query;
+
+_error:
+	bson_destroy(&selector->bson_query);
+
+	return NULL;
+}
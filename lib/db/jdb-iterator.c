@@ -88,16 +88,82 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	return iterator;
 
 _error:
-	if (ret2)
+	j_db_internal_iterator_close(iterator);
+	j_db_iterator_unref(iterator);
+
+	return NULL;
+}
+
+JDBIterator*
+j_db_iterator_new_aggregate(JDBSchema* schema, JDBSelector* selector, JDBAggregate const* aggregates, guint aggregates_count, gchar const** group_by, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBSelector) aggregate_selector = NULL;
+
+	g_return_val_if_fail(schema != NULL, NULL);
+	g_return_val_if_fail((selector == NULL) || (selector->schema == schema), NULL);
+	g_return_val_if_fail(error == NULL || *error == NULL, NULL);
+
+	if (G_UNLIKELY(selector != NULL && selector->joins != NULL))
 	{
-		while (j_db_internal_iterate(iterator, NULL))
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "joins can not be aggregated");
+		goto _error;
+	}
+
+	// The aggregates are stored in a private selector to leave the caller's selector untouched
+	if (G_UNLIKELY(!(aggregate_selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, error))))
+	{
+		goto _error;
+	}
+
+	if (selector != NULL && selector->bson_count > 0)
+	{
+		if (G_UNLIKELY(!j_db_selector_add_selector(aggregate_selector, selector, error)))
 		{
-			/*do nothing*/
+			goto _error;
 		}
 	}
 
-	j_db_iterator_unref(iterator);
+	if (G_UNLIKELY(!j_db_selector_set_aggregates(aggregate_selector, aggregates, aggregates_count, group_by, error)))
+	{
+		goto _error;
+	}
 
+	// Sorting and paging apply to the groups
+	if (selector != NULL && selector->order != NULL)
+	{
+		for (guint i = 0; i < selector->order->len; i++)
+		{
+			JDBSelectorSort* sort = &g_array_index(selector->order, JDBSelectorSort, i);
+			gboolean grouped = FALSE;
+
+			for (guint j = 0; group_by != NULL && group_by[j] != NULL; j++)
+			{
+				grouped = grouped || (g_strcmp0(group_by[j], sort->name) == 0);
+			}
+
+			if (G_UNLIKELY(!grouped))
+			{
+				g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "only grouped fields can be sorted");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_db_selector_add_order(aggregate_selector, sort->name, sort->order, error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	if (selector != NULL && G_UNLIKELY(!j_db_selector_set_limit(aggregate_selector, selector->limit, selector->offset, error)))
+	{
+		goto _error;
+	}
+
+	return j_db_iterator_new(schema, aggregate_selector, error);
+
+_error:
 	return NULL;
 }
 
@@ -122,9 +188,10 @@ j_db_iterator_unref(JDBIterator* iterator)
 
 	if (g_atomic_int_dec_and_test(&iterator->ref_count))
 	{
-		while (iterator->valid)
+		// Closing the iterator releases the server's cursor without fetching the remaining rows
+		if (iterator->valid)
 		{
-			j_db_iterator_next(iterator, NULL);
+			j_db_internal_iterator_close(iterator);
 		}
 
 		j_db_schema_unref(iterator->schema);
@@ -173,43 +240,35 @@ _error:
 	return FALSE;
 }
 
-gboolean
-j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error)
+/**
+ * Copies a value from the current entry of the iterator.
+ *
+ * \private
+ **/
+static gboolean
+j_db_iterator_get_value(JDBIterator* iterator, gchar const* key, JDBType type, gpointer* value, guint64* length, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JDBTypeValue val;
 	bson_iter_t iter;
 
-	g_return_val_if_fail(iterator != NULL, FALSE);
-	g_return_val_if_fail(iterator->bson_valid, FALSE);
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(type != NULL, FALSE);
-	g_return_val_if_fail(value != NULL, FALSE);
-	g_return_val_if_fail(length != NULL, FALSE);
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
-
-	if (G_UNLIKELY(!j_db_schema_get_field(iterator->schema, name, type, error)))
-	{
-		goto _error;
-	}
-
 	if (G_UNLIKELY(!j_bson_iter_init(&iter, &iterator->bson, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_find(&iter, name, error)))
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, key, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_value(&iter, *type, &val, error)))
+	if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &val, error)))
 	{
 		goto _error;
 	}
 
-	switch (*type)
+	switch (type)
 	{
 		case J_DB_TYPE_SINT32:
 			*value = g_new(gint32, 1);
@@ -268,3 +327,67 @@ j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type,
 _error:
 	return FALSE;
 }
+
+gboolean
+j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(iterator->bson_valid, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (iterator->selector != NULL && iterator->selector->joins != NULL && strchr(name, '.') != NULL)
+	{
+		if (G_UNLIKELY(!j_db_selector_get_join_field(iterator->selector, name, type, error)))
+		{
+			goto _error;
+		}
+	}
+	else if (G_UNLIKELY(!j_db_schema_get_field(iterator->schema, name, type, error)))
+	{
+		goto _error;
+	}
+
+	return j_db_iterator_get_value(iterator, name, *type, value, length, error);
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_iterator_get_aggregate(JDBIterator* iterator, guint index, JDBType* type, gpointer* value, guint64* length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorAggregate* aggregate;
+	char key[32];
+
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(iterator->bson_valid, FALSE);
+	g_return_val_if_fail(iterator->selector != NULL, FALSE);
+	g_return_val_if_fail(iterator->selector->aggregates != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(index >= iterator->selector->aggregates->len))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+		goto _error;
+	}
+
+	aggregate = &g_array_index(iterator->selector->aggregates, JDBSelectorAggregate, index);
+	*type = aggregate->result_type;
+	snprintf(key, sizeof(key), "_aggregate_%u", index);
+
+	return j_db_iterator_get_value(iterator, key, *type, value, length, error);
+
+_error:
+	return FALSE;
+}
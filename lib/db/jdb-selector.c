@@ -33,6 +33,96 @@
 #include <julea-db.h>
 #include "../../backend/db/jbson.c"
 
+/**
+ * Frees the combined query document, it has to be rebuilt after the selector has been modified.
+ **/
+static void
+j_db_selector_invalidate_query(JDBSelector* selector)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (selector->bson_query_valid)
+	{
+		bson_destroy(&selector->bson_query);
+		selector->bson_query_valid = FALSE;
+	}
+}
+
+static void
+j_db_selector_aggregate_clear(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorAggregate* aggregate = data;
+
+	g_free(aggregate->name);
+}
+
+static void
+j_db_selector_sort_clear(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorSort* sort = data;
+
+	g_free(sort->name);
+}
+
+static void
+j_db_selector_join_clear(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorJoin* join = data;
+
+	g_free(join->name);
+	g_free(join->join_name);
+	j_db_schema_unref(join->schema);
+	g_strfreev(join->fields);
+
+	if (join->selector != NULL)
+	{
+		bson_destroy(join->selector);
+	}
+}
+
+/**
+ * Returns the type of a field that can be joined on.
+ * Entries can always be joined on their ID, IDs are compared as unsigned integers.
+ **/
+static gboolean
+j_db_selector_get_join_type(JDBSchema* schema, gchar const* name, JDBType* type, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (g_strcmp0(name, "_id") == 0)
+	{
+		*type = J_DB_TYPE_UINT32;
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!j_db_schema_get_field(schema, name, type, error)))
+	{
+		goto _error;
+	}
+
+	if (*type == J_DB_TYPE_ID)
+	{
+		*type = J_DB_TYPE_UINT32;
+	}
+
+	if (G_UNLIKELY(*type == J_DB_TYPE_BLOB))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "blobs can not be joined");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 JDBSelector*
 j_db_selector_new(JDBSchema* schema, JDBSelectorMode mode, GError** error)
 {
@@ -47,6 +137,14 @@ j_db_selector_new(JDBSchema* schema, JDBSelectorMode mode, GError** error)
 	selector->ref_count = 1;
 	selector->mode = mode;
 	selector->bson_count = 0;
+	selector->fields = NULL;
+	selector->aggregates = NULL;
+	selector->group_by = NULL;
+	selector->order = NULL;
+	selector->limit = 0;
+	selector->offset = 0;
+	selector->joins = NULL;
+	selector->bson_query_valid = FALSE;
 	bson_init(&selector->bson);
 	selector->schema = j_db_schema_ref(schema);
 
@@ -92,6 +190,25 @@ j_db_selector_unref(JDBSelector* selector)
 	{
 		j_db_schema_unref(selector->schema);
 		bson_destroy(&selector->bson);
+		j_db_selector_invalidate_query(selector);
+		g_strfreev(selector->fields);
+		g_strfreev(selector->group_by);
+
+		if (selector->aggregates)
+		{
+			g_array_unref(selector->aggregates);
+		}
+
+		if (selector->order)
+		{
+			g_array_unref(selector->order);
+		}
+
+		if (selector->joins)
+		{
+			g_array_unref(selector->joins);
+		}
+
 		g_free(selector);
 	}
 }
@@ -184,6 +301,7 @@ j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSelectorOpe
 	}
 
 	selector->bson_count++;
+	j_db_selector_invalidate_query(selector);
 
 	return TRUE;
 
@@ -210,6 +328,13 @@ j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GEr
 		goto _error;
 	}
 
+	// Only the conditions are nested, joins would be lost
+	if (G_UNLIKELY(sub_selector->joins != NULL))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "joins can not be nested");
+		goto _error;
+	}
+
 	if (G_UNLIKELY(selector->bson_count + sub_selector->bson_count > 500))
 	{
 		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "selector too complex");
@@ -224,6 +349,367 @@ j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GEr
 	}
 
 	selector->bson_count += sub_selector->bson_count;
+	j_db_selector_invalidate_query(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_set_fields(JDBSelector* selector, gchar const** names, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType type;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (names != NULL)
+	{
+		if (G_UNLIKELY(names[0] == NULL))
+		{
+			g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_EMPTY, "fields must not be empty");
+			goto _error;
+		}
+
+		for (guint i = 0; names[i] != NULL; i++)
+		{
+			if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, names[i], &type, error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	g_strfreev(selector->fields);
+	selector->fields = g_strdupv((gchar**)names);
+	j_db_selector_invalidate_query(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_add_order(JDBSelector* selector, gchar const* name, JDBSelectorOrder order, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorSort sort;
+	JDBType type;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(order != J_DB_SELECTOR_ORDER_ASCENDING && order != J_DB_SELECTOR_ORDER_DESCENDING))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_OPERATOR_INVALID, "order invalid");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, name, &type, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(type == J_DB_TYPE_BLOB))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "blobs can not be compared");
+		goto _error;
+	}
+
+	if (selector->order == NULL)
+	{
+		selector->order = g_array_new(FALSE, FALSE, sizeof(JDBSelectorSort));
+		g_array_set_clear_func(selector->order, j_db_selector_sort_clear);
+	}
+
+	sort.name = g_strdup(name);
+	sort.order = order;
+	g_array_append_val(selector->order, sort);
+	j_db_selector_invalidate_query(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_set_limit(JDBSelector* selector, guint64 limit, guint64 offset, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	// Backends store limits as signed 64-bit integers
+	if (G_UNLIKELY(limit > G_MAXINT64 || offset > G_MAXINT64))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_OPERATOR_INVALID, "limit invalid");
+		goto _error;
+	}
+
+	selector->limit = limit;
+	selector->offset = offset;
+	j_db_selector_invalidate_query(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_add_join(JDBSelector* selector, gchar const* name, JDBSelector* sub_selector, gchar const* join_name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorJoin join;
+	JDBType type;
+	JDBType join_type;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(sub_selector != NULL, FALSE);
+	g_return_val_if_fail(join_name != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(selector->aggregates != NULL))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "joins can not be aggregated");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(sub_selector->joins != NULL || sub_selector->aggregates != NULL || sub_selector->order != NULL || sub_selector->limit > 0 || sub_selector->offset > 0))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "joins can not be nested");
+		goto _error;
+	}
+
+	// Joined fields are named after their schema, which therefore has to be unique within the query
+	if (G_UNLIKELY(g_strcmp0(sub_selector->schema->name, selector->schema->name) == 0))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_MUST_NOT_EQUAL, "joined schema must not equal the selector's schema");
+		goto _error;
+	}
+
+	for (guint i = 0; selector->joins != NULL && i < selector->joins->len; i++)
+	{
+		if (G_UNLIKELY(g_strcmp0(g_array_index(selector->joins, JDBSelectorJoin, i).schema->name, sub_selector->schema->name) == 0))
+		{
+			g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_MUST_NOT_EQUAL, "schema already joined");
+			goto _error;
+		}
+	}
+
+	// Joins are evaluated by the server storing both schemas, which is only guaranteed for schemas of the same namespace
+	if (G_UNLIKELY(g_strcmp0(sub_selector->schema->namespace, selector->schema->namespace) != 0))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SCHEMA_SERVER, "joined schemas must be stored in the same namespace");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_selector_get_join_type(selector->schema, name, &type, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_selector_get_join_type(sub_selector->schema, join_name, &join_type, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(type != join_type))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "joined fields must have the same type");
+		goto _error;
+	}
+
+	if (selector->joins == NULL)
+	{
+		selector->joins = g_array_new(FALSE, FALSE, sizeof(JDBSelectorJoin));
+		g_array_set_clear_func(selector->joins, j_db_selector_join_clear);
+	}
+
+	// Like sub-selectors, the joined selector is copied and can be modified afterwards
+	join.name = g_strdup(name);
+	join.join_name = g_strdup(join_name);
+	join.schema = j_db_schema_ref(sub_selector->schema);
+	join.selector = (sub_selector->bson_count > 0) ? bson_copy(&sub_selector->bson) : NULL;
+	join.fields = g_strdupv(sub_selector->fields);
+	g_array_append_val(selector->joins, join);
+	j_db_selector_invalidate_query(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_get_join_field(JDBSelector* selector, gchar const* name, JDBType* type, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* field;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	// Joined fields are named schema.field
+	if (selector->joins == NULL || (field = strchr(name, '.')) == NULL)
+	{
+		goto _not_found;
+	}
+
+	for (guint i = 0; i < selector->joins->len; i++)
+	{
+		JDBSelectorJoin* join = &g_array_index(selector->joins, JDBSelectorJoin, i);
+		gsize length = strlen(join->schema->name);
+
+		if ((gsize)(field - name) != length || strncmp(name, join->schema->name, length) != 0)
+		{
+			continue;
+		}
+
+		if (g_strcmp0(field + 1, "_id") == 0)
+		{
+			*type = J_DB_TYPE_UINT32;
+			return TRUE;
+		}
+
+		return j_db_schema_get_field(join->schema, field + 1, type, error);
+	}
+
+_not_found:
+	g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+	return FALSE;
+}
+
+gboolean
+j_db_selector_set_aggregates(JDBSelector* selector, JDBAggregate const* aggregates, guint aggregates_count, gchar const** group_by, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType type;
+	g_autoptr(GArray) array = NULL;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(aggregates != NULL || aggregates_count == 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(aggregates_count == 0 && (group_by == NULL || group_by[0] == NULL)))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_EMPTY, "aggregates must not be empty");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(selector->joins != NULL))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "joins can not be aggregated");
+		goto _error;
+	}
+
+	array = g_array_sized_new(FALSE, FALSE, sizeof(JDBSelectorAggregate), aggregates_count);
+	g_array_set_clear_func(array, j_db_selector_aggregate_clear);
+
+	for (guint i = 0; i < aggregates_count; i++)
+	{
+		JDBSelectorAggregate aggregate;
+
+		aggregate.function = aggregates[i].function;
+		aggregate.name = NULL;
+		aggregate.type = J_DB_TYPE_ID;
+
+		if (aggregates[i].name != NULL)
+		{
+			if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, aggregates[i].name, &aggregate.type, error)))
+			{
+				goto _error;
+			}
+		}
+		else if (G_UNLIKELY(aggregate.function != J_DB_AGGREGATE_COUNT))
+		{
+			g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		switch (aggregate.function)
+		{
+			case J_DB_AGGREGATE_COUNT:
+				aggregate.result_type = J_DB_TYPE_UINT64;
+				break;
+			case J_DB_AGGREGATE_MIN:
+			case J_DB_AGGREGATE_MAX:
+				if (G_UNLIKELY(aggregate.type == J_DB_TYPE_BLOB))
+				{
+					g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "blobs can not be compared");
+					goto _error;
+				}
+
+				aggregate.result_type = aggregate.type;
+				break;
+			case J_DB_AGGREGATE_SUM:
+				switch (aggregate.type)
+				{
+					case J_DB_TYPE_SINT32:
+					case J_DB_TYPE_SINT64:
+						aggregate.result_type = J_DB_TYPE_SINT64;
+						break;
+					case J_DB_TYPE_UINT32:
+					case J_DB_TYPE_UINT64:
+						aggregate.result_type = J_DB_TYPE_UINT64;
+						break;
+					case J_DB_TYPE_FLOAT32:
+					case J_DB_TYPE_FLOAT64:
+						aggregate.result_type = J_DB_TYPE_FLOAT64;
+						break;
+					case J_DB_TYPE_STRING:
+					case J_DB_TYPE_BLOB:
+					case J_DB_TYPE_ID:
+					default:
+						g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "only numeric fields can be summed");
+						goto _error;
+				}
+				break;
+			default:
+				g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_OPERATOR_INVALID, "aggregate function invalid");
+				goto _error;
+		}
+
+		aggregate.name = g_strdup(aggregates[i].name);
+		g_array_append_val(array, aggregate);
+	}
+
+	if (group_by != NULL)
+	{
+		for (guint i = 0; group_by[i] != NULL; i++)
+		{
+			if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, group_by[i], &type, error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	if (selector->aggregates)
+	{
+		g_array_unref(selector->aggregates);
+	}
+
+	g_strfreev(selector->group_by);
+
+	selector->aggregates = g_steal_pointer(&array);
+	selector->group_by = g_strdupv((gchar**)group_by);
+	j_db_selector_invalidate_query(selector);
 
 	return TRUE;
 
@@ -214,7 +214,7 @@ H5VL_julea_db_attr_truncate_file(void* obj)
 		j_goto_error();
 	}
 
-	if (!j_db_entry_delete(entry, selector, batch, &error))
+	if (!j_db_entry_delete(entry, selector, NULL, batch, &error))
 	{
 		j_goto_error();
 	}
@@ -299,12 +299,12 @@ H5VL_julea_db_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const
 		j_goto_error();
 	}
 
-	if (!(object->attr.datatype = H5VL_julea_db_datatype_encode(&type_id)))
+	if (!(object->attr.datatype = H5VL_julea_db_datatype_encode(file, &type_id)))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->attr.space = H5VL_julea_db_space_encode(&space_id)))
+	if (!(object->attr.space = H5VL_julea_db_space_encode(file, &space_id)))
 	{
 		j_goto_error();
 	}
@@ -371,7 +371,6 @@ H5VL_julea_db_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 	g_autoptr(GError) error = NULL;
 	g_autoptr(JBatch) batch = NULL;
 	g_autoptr(JDBIterator) iterator = NULL;
-	g_autoptr(JDBSelector) selector = NULL;
 	g_autofree void* space_id_buf = NULL;
 	g_autofree void* datatype_id_buf = NULL;
 	JHDF5Object_t* object = NULL;
@@ -431,27 +430,7 @@ H5VL_julea_db_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		j_goto_error();
 	}
 
-	if (!H5VL_julea_db_link_get_helper(parent, object, name))
-	{
-		j_goto_error();
-	}
-
-	if (!(selector = j_db_selector_new(julea_db_schema_attr, J_DB_SELECTOR_MODE_AND, &error)))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
-	{
-		j_goto_error();
-	}
-
-	if (!(iterator = j_db_iterator_new(julea_db_schema_attr, selector, &error)))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_iterator_next(iterator, &error))
+	if (!(iterator = H5VL_julea_db_link_get_iterator(parent, object, name, julea_db_schema_attr)))
 	{
 		j_goto_error();
 	}
@@ -461,7 +440,7 @@ H5VL_julea_db_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		j_goto_error();
 	}
 
-	if (!(object->attr.space = H5VL_julea_db_space_decode(space_id_buf, space_id_buf_len)))
+	if (!(object->attr.space = H5VL_julea_db_space_decode(file, space_id_buf, space_id_buf_len)))
 	{
 		j_goto_error();
 	}
@@ -471,7 +450,7 @@ H5VL_julea_db_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		j_goto_error();
 	}
 
-	if (!(object->attr.datatype = H5VL_julea_db_datatype_decode(datatype_id_buf, datatype_id_buf_len)))
+	if (!(object->attr.datatype = H5VL_julea_db_datatype_decode(file, datatype_id_buf, datatype_id_buf_len)))
 	{
 		j_goto_error();
 	}
@@ -607,7 +586,7 @@ H5VL_julea_db_attr_write(void* obj, hid_t mem_type_id, const void* buf, hid_t dx
 		j_goto_error();
 	}
 
-	if (!j_db_entry_update(entry, selector, batch, &error))
+	if (!j_db_entry_update(entry, selector, NULL, batch, &error))
 	{
 		j_goto_error();
 	}
@@ -638,10 +617,11 @@ H5VL_julea_db_attr_get(void* obj, H5VL_attr_get_t get_type, hid_t dxpl_id, void*
 	switch (get_type)
 	{
 		case H5VL_ATTR_GET_SPACE:
-			*(va_arg(arguments, hid_t*)) = object->attr.space->space.hdf5_id;
+			// The caller owns the returned ID, spaces and datatypes can be shared by multiple objects
+			*(va_arg(arguments, hid_t*)) = H5Scopy(object->attr.space->space.hdf5_id);
 			break;
 		case H5VL_ATTR_GET_TYPE:
-			*(va_arg(arguments, hid_t*)) = object->attr.datatype->datatype.hdf5_id;
+			*(va_arg(arguments, hid_t*)) = H5Tcopy(object->attr.datatype->datatype.hdf5_id);
 			break;
 		case H5VL_ATTR_GET_ACPL:
 		case H5VL_ATTR_GET_INFO:
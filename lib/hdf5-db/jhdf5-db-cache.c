@@ -0,0 +1,202 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Per-file cache for metadata that is looked up repeatedly.
+ * Links map a parent and a name to the child's ID.
+ * Datatypes and spaces are cached as decoded objects and can be found by ID and by their encoded representation.
+ * The cache only sees modifications made through the same file and is dropped when the file is closed.
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+#include <H5PLextern.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <hdf5/jhdf5.h>
+
+#include <julea.h>
+#include <julea-db.h>
+#include <julea-object.h>
+
+#include "jhdf5-db.h"
+
+static void
+H5VL_julea_db_cache_init(JHDF5Object_t* file)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(file->type == J_HDF5_OBJECT_TYPE_FILE);
+
+	file->file.links = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_bytes_unref);
+	file->file.objects = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)H5VL_julea_db_object_unref);
+}
+
+static gchar*
+H5VL_julea_db_cache_link_key(JHDF5Object_t* parent, const char* name)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree char* parent_id = NULL;
+
+	parent_id = H5VL_julea_db_buf_to_hex("", parent->backend_id, parent->backend_id_len);
+
+	return g_strdup_printf("%d:%s:%s", parent->type, parent_id, name);
+}
+
+static gchar*
+H5VL_julea_db_cache_object_key(JHDF5ObjectType type, gboolean encoded, const void* buf, guint64 buf_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* prefix = NULL;
+
+	prefix = g_strdup_printf("%d:%s:", type, (encoded) ? "data" : "id");
+
+	return H5VL_julea_db_buf_to_hex(prefix, buf, buf_len);
+}
+
+/**
+ * Looks up a link.
+ *
+ * \param file         The file.
+ * \param parent       The link's parent.
+ * \param name         The link's name.
+ * \param child_id     Returns a copy of the child's ID.
+ * \param child_id_len Returns the length of the child's ID.
+ *
+ * \return TRUE if the link is cached, FALSE otherwise.
+ **/
+static gboolean
+H5VL_julea_db_cache_link_lookup(JHDF5Object_t* file, JHDF5Object_t* parent, const char* name, void** child_id, guint64* child_id_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+	GBytes* bytes;
+	gconstpointer data;
+	gsize size;
+
+	key = H5VL_julea_db_cache_link_key(parent, name);
+
+	if ((bytes = g_hash_table_lookup(file->file.links, key)) == NULL)
+	{
+		return FALSE;
+	}
+
+	data = g_bytes_get_data(bytes, &size);
+
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	*child_id = g_memdup2(data, size);
+#else
+	*child_id = g_memdup(data, size);
+#endif
+	*child_id_len = size;
+
+	return TRUE;
+}
+
+static void
+H5VL_julea_db_cache_link_insert(JHDF5Object_t* file, JHDF5Object_t* parent, const char* name, const void* child_id, guint64 child_id_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_hash_table_replace(file->file.links, H5VL_julea_db_cache_link_key(parent, name), g_bytes_new(child_id, child_id_len));
+}
+
+/**
+ * Removes all links of a file, for example, after they have been deleted.
+ **/
+static void
+H5VL_julea_db_cache_link_remove_all(JHDF5Object_t* file)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_hash_table_remove_all(file->file.links);
+}
+
+/**
+ * Looks up a datatype or space.
+ *
+ * \param file    The file.
+ * \param type    J_HDF5_OBJECT_TYPE_DATATYPE or J_HDF5_OBJECT_TYPE_SPACE.
+ * \param encoded Whether buf contains the object's encoded representation or its ID.
+ * \param buf     A buffer.
+ * \param buf_len The buffer's length.
+ *
+ * \return A new reference to the cached object, NULL if it is not cached.
+ **/
+static JHDF5Object_t*
+H5VL_julea_db_cache_object_lookup(JHDF5Object_t* file, JHDF5ObjectType type, gboolean encoded, const void* buf, guint64 buf_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree gchar* key = NULL;
+	JHDF5Object_t* object;
+
+	g_return_val_if_fail(type == J_HDF5_OBJECT_TYPE_DATATYPE || type == J_HDF5_OBJECT_TYPE_SPACE, NULL);
+
+	key = H5VL_julea_db_cache_object_key(type, encoded, buf, buf_len);
+
+	if ((object = g_hash_table_lookup(file->file.objects, key)) == NULL)
+	{
+		return NULL;
+	}
+
+	return H5VL_julea_db_object_ref(object);
+}
+
+/**
+ * Inserts a datatype or space that has an ID, it can then be looked up by ID and by its encoded representation.
+ **/
+static void
+H5VL_julea_db_cache_object_insert(JHDF5Object_t* file, JHDF5Object_t* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	const void* data;
+	guint64 data_size;
+
+	g_return_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATATYPE || object->type == J_HDF5_OBJECT_TYPE_SPACE);
+	g_return_if_fail(object->backend_id != NULL);
+
+	if (object->type == J_HDF5_OBJECT_TYPE_DATATYPE)
+	{
+		data = object->datatype.data;
+		data_size = object->datatype.data_size;
+	}
+	else
+	{
+		data = object->space.data;
+		data_size = object->space.data_size;
+	}
+
+	g_hash_table_replace(file->file.objects, H5VL_julea_db_cache_object_key(object->type, FALSE, object->backend_id, object->backend_id_len), H5VL_julea_db_object_ref(object));
+	g_hash_table_replace(file->file.objects, H5VL_julea_db_cache_object_key(object->type, TRUE, data, data_size), H5VL_julea_db_object_ref(object));
+}
@@ -0,0 +1,397 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Compression of dataset chunks.
+ * Chunks are compressed as a whole before they are written to the dataset's object and decompressed after they have been read.
+ * Compressed chunks are stored at the same position as uncompressed ones, only their size differs.
+ * Chunks that do not become smaller are stored uncompressed, which can be detected by their size.
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+#include <H5PLextern.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifdef HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <hdf5/jhdf5.h>
+
+#include <julea.h>
+#include <julea-db.h>
+#include <julea-object.h>
+
+#include "jhdf5-db.h"
+
+/**
+ * A chunk to be compressed or decompressed.
+ **/
+struct JHDF5CompressionTask
+{
+	const void* in;
+	gsize in_size;
+	void* out;
+	/**
+	 * The size of out, which is set to the compressed size after compression.
+	 **/
+	gsize out_size;
+	gboolean ret;
+};
+
+typedef struct JHDF5CompressionTask JHDF5CompressionTask;
+
+/**
+ * Sets a dataset's compression according to the filters in its creation property list.
+ * Optional filters that are not supported are ignored, mandatory ones cause an error.
+ **/
+static gboolean
+H5VL_julea_db_compression_set(JHDF5Object_t* object, hid_t dcpl_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint nfilters;
+
+	object->dataset.codec = J_HDF5_CODEC_NONE;
+	object->dataset.codec_level = 0;
+	object->dataset.shuffle = FALSE;
+
+	if (dcpl_id == H5P_DEFAULT)
+	{
+		return TRUE;
+	}
+
+	if ((nfilters = H5Pget_nfilters(dcpl_id)) < 0)
+	{
+		j_goto_error();
+	}
+
+	for (gint i = 0; i < nfilters; i++)
+	{
+		H5Z_filter_t filter;
+		guint flags;
+		guint cd_values[8];
+		gsize cd_nelmts = G_N_ELEMENTS(cd_values);
+
+		if ((filter = H5Pget_filter2(dcpl_id, i, &flags, &cd_nelmts, cd_values, 0, NULL, NULL)) < 0)
+		{
+			j_goto_error();
+		}
+
+		switch (filter)
+		{
+			case H5Z_FILTER_SHUFFLE:
+				object->dataset.shuffle = TRUE;
+				break;
+#ifdef HAVE_LZ4
+			case J_HDF5_FILTER_LZ4:
+				object->dataset.codec = J_HDF5_CODEC_LZ4;
+				break;
+#endif
+#ifdef HAVE_ZSTD
+			case J_HDF5_FILTER_ZSTD:
+				object->dataset.codec = J_HDF5_CODEC_ZSTD;
+				// The first value is the compression level, which might be negative
+				object->dataset.codec_level = (cd_nelmts > 0) ? (gint)cd_values[0] : 0;
+				break;
+#endif
+			default:
+				if (!(flags & H5Z_FLAG_OPTIONAL))
+				{
+					g_warning("%s filter %d is not supported", G_STRLOC, filter);
+					j_goto_error();
+				}
+
+				break;
+		}
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+H5VL_julea_db_compression_enabled(JHDF5Object_t* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return object->dataset.codec != J_HDF5_CODEC_NONE;
+}
+
+/**
+ * Returns the size of a buffer that is large enough for compressing size bytes.
+ **/
+static gsize
+H5VL_julea_db_compression_bound(JHDF5Object_t* object, gsize size)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize bound = size;
+
+	switch (object->dataset.codec)
+	{
+		case J_HDF5_CODEC_LZ4:
+#ifdef HAVE_LZ4
+			if (size <= LZ4_MAX_INPUT_SIZE)
+			{
+				bound = LZ4_compressBound(size);
+			}
+#endif
+			break;
+		case J_HDF5_CODEC_ZSTD:
+#ifdef HAVE_ZSTD
+			bound = ZSTD_compressBound(size);
+#endif
+			break;
+		case J_HDF5_CODEC_NONE:
+		default:
+			break;
+	}
+
+	// Chunks that cannot be compressed are stored as they are
+	return MAX(bound, size);
+}
+
+/**
+ * Groups the bytes of elements by their significance, which usually makes numeric data more compressible.
+ **/
+static void
+H5VL_julea_db_compression_shuffle(const guchar* in, guchar* out, gsize size, gsize element_size, gboolean reverse)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize count = size / element_size;
+
+	for (gsize b = 0; b < element_size; b++)
+	{
+		for (gsize i = 0; i < count; i++)
+		{
+			if (!reverse)
+			{
+				out[b * count + i] = in[i * element_size + b];
+			}
+			else
+			{
+				out[i * element_size + b] = in[b * count + i];
+			}
+		}
+	}
+
+	// Trailing bytes that do not form a whole element are not shuffled
+	memcpy(out + count * element_size, in + count * element_size, size - count * element_size);
+}
+
+static gboolean
+H5VL_julea_db_compression_compress(JHDF5Object_t* object, JHDF5CompressionTask* task)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guchar* shuffled = NULL;
+	gsize element_size = object->dataset.datatype->datatype.type_total_size;
+	const void* in = task->in;
+	gsize size = 0;
+
+	if (object->dataset.shuffle && element_size > 1)
+	{
+		shuffled = g_malloc(task->in_size);
+		H5VL_julea_db_compression_shuffle(task->in, shuffled, task->in_size, element_size, FALSE);
+		in = shuffled;
+	}
+
+	switch (object->dataset.codec)
+	{
+		case J_HDF5_CODEC_LZ4:
+#ifdef HAVE_LZ4
+			if (task->in_size <= LZ4_MAX_INPUT_SIZE)
+			{
+				size = LZ4_compress_default(in, task->out, task->in_size, MIN(task->out_size, (gsize)G_MAXINT));
+			}
+#endif
+			break;
+		case J_HDF5_CODEC_ZSTD:
+#ifdef HAVE_ZSTD
+			size = ZSTD_compress(task->out, task->out_size, in, task->in_size, object->dataset.codec_level);
+
+			if (ZSTD_isError(size))
+			{
+				size = 0;
+			}
+#endif
+			break;
+		case J_HDF5_CODEC_NONE:
+		default:
+			break;
+	}
+
+	if (size == 0 || size >= task->in_size)
+	{
+		memcpy(task->out, task->in, task->in_size);
+		size = task->in_size;
+	}
+
+	task->out_size = size;
+
+	return TRUE;
+}
+
+static gboolean
+H5VL_julea_db_compression_decompress(JHDF5Object_t* object, JHDF5CompressionTask* task)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree guchar* shuffled = NULL;
+	gsize element_size = object->dataset.datatype->datatype.type_total_size;
+	void* out = task->out;
+	gsize size = 0;
+
+	// Chunks that could not be compressed have been stored as they are
+	if (task->in_size == task->out_size)
+	{
+		memcpy(task->out, task->in, task->in_size);
+
+		return TRUE;
+	}
+
+	if (object->dataset.shuffle && element_size > 1)
+	{
+		shuffled = g_malloc(task->out_size);
+		out = shuffled;
+	}
+
+	switch (object->dataset.codec)
+	{
+		case J_HDF5_CODEC_LZ4:
+#ifdef HAVE_LZ4
+		{
+			gint ret;
+
+			ret = LZ4_decompress_safe(task->in, out, task->in_size, task->out_size);
+			size = (ret > 0) ? (gsize)ret : 0;
+		}
+#endif
+		break;
+		case J_HDF5_CODEC_ZSTD:
+#ifdef HAVE_ZSTD
+			size = ZSTD_decompress(out, task->out_size, task->in, task->in_size);
+
+			if (ZSTD_isError(size))
+			{
+				size = 0;
+			}
+#endif
+			break;
+		case J_HDF5_CODEC_NONE:
+		default:
+			break;
+	}
+
+	if (size != task->out_size)
+	{
+		return FALSE;
+	}
+
+	if (shuffled != NULL)
+	{
+		H5VL_julea_db_compression_shuffle(shuffled, task->out, task->out_size, element_size, TRUE);
+	}
+
+	return TRUE;
+}
+
+static void
+H5VL_julea_db_compression_compress_func(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5CompressionTask* task = data;
+
+	task->ret = H5VL_julea_db_compression_compress(user_data, task);
+}
+
+static void
+H5VL_julea_db_compression_decompress_func(gpointer data, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5CompressionTask* task = data;
+
+	task->ret = H5VL_julea_db_compression_decompress(user_data, task);
+}
+
+/**
+ * Compresses or decompresses chunks, using one thread per processor.
+ *
+ * \param object   A dataset.
+ * \param tasks    An array of JHDF5CompressionTask.
+ * \param compress Whether to compress or decompress.
+ *
+ * \return TRUE if all tasks succeeded, FALSE otherwise.
+ **/
+static gboolean
+H5VL_julea_db_compression_run(JHDF5Object_t* object, GArray* tasks, gboolean compress)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GFunc func = (compress) ? H5VL_julea_db_compression_compress_func : H5VL_julea_db_compression_decompress_func;
+	gboolean ret = TRUE;
+
+	if (tasks->len == 1)
+	{
+		func(&g_array_index(tasks, JHDF5CompressionTask, 0), object);
+	}
+	else if (tasks->len > 1)
+	{
+		GThreadPool* pool;
+
+		// Shared pools reuse their threads, so creating one per operation is cheap
+		pool = g_thread_pool_new(func, object, MIN(tasks->len, g_get_num_processors()), FALSE, NULL);
+
+		for (guint i = 0; i < tasks->len; i++)
+		{
+			g_thread_pool_push(pool, &g_array_index(tasks, JHDF5CompressionTask, i), NULL);
+		}
+
+		// Waits for all tasks to finish
+		g_thread_pool_free(pool, FALSE, TRUE);
+	}
+
+	for (guint i = 0; i < tasks->len; i++)
+	{
+		ret = ret && g_array_index(tasks, JHDF5CompressionTask, i).ret;
+	}
+
+	return ret;
+}
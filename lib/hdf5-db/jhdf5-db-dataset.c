@@ -27,6 +27,7 @@
 #include <hdf5.h>
 #include <H5PLextern.h>
 
+#include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -42,7 +43,14 @@
 
 #include "jhdf5-db.h"
 
+// Maximum size of the buffer used for converting data before writing it
+#define J_HDF5_CONVERT_SIZE (4 * 1024 * 1024)
+
 static JDBSchema* julea_db_schema_dataset = NULL;
+static JDBSchema* julea_db_schema_chunk = NULL;
+
+// Whether the dataset schema stores the chunk layout and compression, schemas created by older versions do not
+static gboolean julea_db_dataset_layout = FALSE;
 
 static herr_t
 H5VL_julea_db_dataset_term(void)
@@ -55,9 +63,171 @@ H5VL_julea_db_dataset_term(void)
 		julea_db_schema_dataset = NULL;
 	}
 
+	if (julea_db_schema_chunk != NULL)
+	{
+		j_db_schema_unref(julea_db_schema_chunk);
+		julea_db_schema_chunk = NULL;
+	}
+
 	return 0;
 }
 
+/**
+ * Gets or creates the schema of the chunk index.
+ * Every chunk that contains data has an entry holding its statistics.
+ **/
+static gboolean
+H5VL_julea_db_dataset_init_chunk(JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+
+	if (!(julea_db_schema_chunk = j_db_schema_new(JULEA_HDF5_DB_NAMESPACE, "chunk", NULL)))
+	{
+		j_goto_error();
+	}
+
+	if (!(j_db_schema_get(julea_db_schema_chunk, batch, &error) && j_batch_execute(batch)))
+	{
+		if (error == NULL || error->code != J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND)
+		{
+			g_assert_not_reached();
+			j_goto_error();
+		}
+
+		g_error_free(error);
+		error = NULL;
+
+		j_db_schema_unref(julea_db_schema_chunk);
+
+		if (!(julea_db_schema_chunk = j_db_schema_new(JULEA_HDF5_DB_NAMESPACE, "chunk", NULL)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "file", J_DB_TYPE_ID, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "dataset", J_DB_TYPE_ID, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "index", J_DB_TYPE_UINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "min_value_f", J_DB_TYPE_FLOAT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "max_value_f", J_DB_TYPE_FLOAT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "min_value_i", J_DB_TYPE_SINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "max_value_i", J_DB_TYPE_SINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_add_field(julea_db_schema_chunk, "size", J_DB_TYPE_UINT64, &error))
+		{
+			j_goto_error();
+		}
+
+		{
+			const gchar* index_file[] = {
+				"file",
+				NULL,
+			};
+			const gchar* index_dataset[] = {
+				"dataset",
+				"index",
+				NULL,
+			};
+
+			if (!j_db_schema_add_index(julea_db_schema_chunk, index_file, &error))
+			{
+				j_goto_error();
+			}
+
+			if (!j_db_schema_add_index(julea_db_schema_chunk, index_dataset, &error))
+			{
+				j_goto_error();
+			}
+		}
+
+		if (!j_db_schema_create(julea_db_schema_chunk, batch, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+
+		j_db_schema_unref(julea_db_schema_chunk);
+
+		if (!(julea_db_schema_chunk = j_db_schema_new(JULEA_HDF5_DB_NAMESPACE, "chunk", NULL)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_schema_get(julea_db_schema_chunk, batch, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+	}
+
+	return TRUE;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+
+	return FALSE;
+}
+
+/**
+ * Checks whether the dataset schema contains the fields describing the chunk layout and compression.
+ * The schema cannot be changed after it has been created, so existing schemas may lack these fields.
+ **/
+static gboolean
+H5VL_julea_db_dataset_schema_has_layout(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	const gchar* fields[] = { "chunk_dims", "codec", "codec_level", "shuffle", NULL };
+
+	for (guint i = 0; fields[i] != NULL; i++)
+	{
+		JDBType type;
+
+		if (!j_db_schema_get_field(julea_db_schema_dataset, fields[i], &type, NULL))
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 static herr_t
 H5VL_julea_db_dataset_init(hid_t vipl_id)
 {
@@ -132,6 +302,26 @@ H5VL_julea_db_dataset_init(hid_t vipl_id)
 					j_goto_error();
 				}
 
+				if (!j_db_schema_add_field(julea_db_schema_dataset, "chunk_dims", J_DB_TYPE_BLOB, &error))
+				{
+					j_goto_error();
+				}
+
+				if (!j_db_schema_add_field(julea_db_schema_dataset, "codec", J_DB_TYPE_UINT32, &error))
+				{
+					j_goto_error();
+				}
+
+				if (!j_db_schema_add_field(julea_db_schema_dataset, "codec_level", J_DB_TYPE_SINT32, &error))
+				{
+					j_goto_error();
+				}
+
+				if (!j_db_schema_add_field(julea_db_schema_dataset, "shuffle", J_DB_TYPE_UINT32, &error))
+				{
+					j_goto_error();
+				}
+
 				{
 					const gchar* index[] = {
 						"file",
@@ -187,6 +377,17 @@ H5VL_julea_db_dataset_init(hid_t vipl_id)
 		}
 	}
 
+	// Datasets stored using an older schema are contiguous and uncompressed
+	if (!(julea_db_dataset_layout = H5VL_julea_db_dataset_schema_has_layout()))
+	{
+		g_warning("%s dataset schema lacks chunk layout fields, chunked and compressed datasets are not supported until the schema is reset", G_STRLOC);
+	}
+
+	if (!H5VL_julea_db_dataset_init_chunk(batch))
+	{
+		j_goto_error();
+	}
+
 	return 0;
 
 _error:
@@ -229,7 +430,7 @@ H5VL_julea_db_dataset_truncate_file(void* obj)
 		j_goto_error();
 	}
 
-	if (!j_db_entry_delete(entry, selector, batch, &error))
+	if (!j_db_entry_delete(entry, selector, NULL, batch, &error))
 	{
 		j_goto_error();
 	}
@@ -242,190 +443,487 @@ H5VL_julea_db_dataset_truncate_file(void* obj)
 		}
 	}
 
-	return 0;
-
-_error:
-	H5VL_julea_db_error_handler(error);
-
-	return 1;
-}
-
-static void*
-H5VL_julea_db_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t lcpl_id, hid_t type_id, hid_t space_id, hid_t dcpl_id, hid_t dapl_id, hid_t dxpl_id, void** req)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	g_autoptr(GError) error = NULL;
-	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(JDBEntry) entry = NULL;
-	g_autofree char* hex_buf = NULL;
-	JHDF5Object_t* object = NULL;
-	JHDF5Object_t* parent = obj;
-	JHDF5Object_t* file;
-
-	(void)loc_params;
-	(void)lcpl_id;
-	(void)dcpl_id;
-	(void)dapl_id;
-	(void)dxpl_id;
-	(void)req;
-
-	g_return_val_if_fail(name != NULL, NULL);
-	g_return_val_if_fail(parent != NULL, NULL);
-
-	switch (parent->type)
-	{
-		case J_HDF5_OBJECT_TYPE_FILE:
-			file = parent;
-			break;
-		case J_HDF5_OBJECT_TYPE_DATASET:
-			file = parent->dataset.file;
-			break;
-		case J_HDF5_OBJECT_TYPE_ATTR:
-			file = parent->attr.file;
-			break;
-		case J_HDF5_OBJECT_TYPE_GROUP:
-			file = parent->group.file;
-			break;
-		case J_HDF5_OBJECT_TYPE_DATATYPE:
-		case J_HDF5_OBJECT_TYPE_SPACE:
-		case _J_HDF5_OBJECT_TYPE_COUNT:
-		default:
-			g_assert_not_reached();
-			j_goto_error();
-	}
+	g_clear_error(&error);
+	j_db_selector_unref(selector);
+	j_db_entry_unref(entry);
 
-	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	if (!(selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!(object = H5VL_julea_db_object_new(J_HDF5_OBJECT_TYPE_DATASET)))
+	if (!j_db_selector_add_field(selector, "file", J_DB_SELECTOR_OPERATOR_EQ, file->backend_id, file->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.min_value_i = 0;
-	object->dataset.statistics.max_value_i = 0;
-	object->dataset.statistics.min_value_f = 0;
-	object->dataset.statistics.max_value_f = 0;
-
-	if (!(object->dataset.name = g_strdup(name)))
+	if (!(entry = j_db_entry_new(julea_db_schema_chunk, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->dataset.file = H5VL_julea_db_object_ref(file)))
+	if (!j_db_entry_delete(entry, selector, NULL, batch, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->dataset.datatype = H5VL_julea_db_datatype_encode(&type_id)))
+	if (!j_batch_execute(batch))
 	{
-		j_goto_error();
+		if (!error || error->code != J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+		{
+			j_goto_error();
+		}
 	}
 
-	if (!(object->dataset.space = H5VL_julea_db_space_encode(&space_id)))
-	{
-		j_goto_error();
-	}
+	return 0;
 
-	if (!(entry = j_db_entry_new(julea_db_schema_dataset, &error)))
-	{
-		j_goto_error();
-	}
+_error:
+	H5VL_julea_db_error_handler(error);
 
-	if (!j_db_entry_set_field(entry, "file", file->backend_id, file->backend_id_len, &error))
-	{
-		j_goto_error();
-	}
+	return 1;
+}
 
-	if (!j_db_entry_set_field(entry, "datatype", object->dataset.datatype->backend_id, object->dataset.datatype->backend_id_len, &error))
-	{
-		j_goto_error();
-	}
+/**
+ * Sets up the chunk layout of a dataset and the distribution of its object.
+ *
+ * Chunks are linearized in row-major order and every chunk occupies chunk_elements elements of the object, edge chunks are padded.
+ * Datasets that are not chunked consist of a single chunk covering the whole dataspace, that is, they are stored contiguously.
+ *
+ * \param chunk_dims  The chunk dimensions, NULL if the dataset is not chunked.
+ * \param chunk_ndims The number of chunk dimensions.
+ **/
+static gboolean
+H5VL_julea_db_dataset_layout_init(JHDF5Object_t* object, const hsize_t* chunk_dims, guint chunk_ndims)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (!j_db_entry_set_field(entry, "space", object->dataset.space->backend_id, object->dataset.space->backend_id_len, &error))
+	hid_t space_id = object->dataset.space->space.hdf5_id;
+	gint ndims;
+	guint i;
+
+	if ((ndims = H5Sget_simple_extent_ndims(space_id)) < 0)
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_entry_insert(entry, batch, &error))
+	// Scalar dataspaces are treated like one-dimensional dataspaces with a single element
+	object->dataset.ndims = MAX(ndims, 1);
+	object->dataset.dims = g_new(hsize_t, object->dataset.ndims);
+	object->dataset.chunk_dims = g_new(hsize_t, object->dataset.ndims);
+	object->dataset.dims[0] = 1;
+
+	if (H5Sget_simple_extent_dims(space_id, object->dataset.dims, NULL) < 0)
 	{
 		j_goto_error();
 	}
 
-	if (!j_batch_execute(batch))
+	if (chunk_ndims != object->dataset.ndims)
 	{
-		j_goto_error();
+		chunk_dims = NULL;
 	}
 
-	if (!j_db_entry_get_id(entry, &object->backend_id, &object->backend_id_len, &error))
+	object->dataset.chunked = FALSE;
+	object->dataset.chunk_elements = 1;
+
+	for (i = 0; i < object->dataset.ndims; i++)
 	{
-		j_goto_error();
+		object->dataset.chunk_dims[i] = (chunk_dims != NULL && chunk_dims[i] > 0) ? chunk_dims[i] : object->dataset.dims[i];
+		object->dataset.chunk_elements *= object->dataset.chunk_dims[i];
+
+		if (object->dataset.chunk_dims[i] != object->dataset.dims[i])
+		{
+			object->dataset.chunked = TRUE;
+		}
 	}
 
+	object->dataset.chunks = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, g_free);
+	object->dataset.batches = g_ptr_array_new_with_free_func((GDestroyNotify)j_batch_unref);
+	object->dataset.statistics_func = H5VL_julea_db_statistics_get_func(object->dataset.datatype->datatype.hdf5_id);
+	object->dataset.statistics_dirty = FALSE;
+
 	if (!(object->dataset.distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN)))
 	{
 		j_goto_error();
 	}
 
-	if (!(hex_buf = H5VL_julea_db_buf_to_hex("dataset", object->backend_id, object->backend_id_len)))
-	{
-		j_goto_error();
-	}
+	// The start index is random by default, which would make the data unreachable after reopening the dataset
+	j_distribution_set(object->dataset.distribution, "start-index", 0);
 
-	if (!(object->dataset.object = j_distributed_object_new(JULEA_HDF5_DB_NAMESPACE, hex_buf, object->dataset.distribution)))
+	if (object->dataset.chunked)
 	{
-		j_goto_error();
+		guint64 chunk_size;
+		guint64 stripe_size;
+
+		chunk_size = object->dataset.chunk_elements * object->dataset.datatype->datatype.type_total_size;
+		stripe_size = j_configuration_get_stripe_size(j_configuration());
+
+		// Stripes consist of whole chunks, so that every chunk is accessed using a single server
+		j_distribution_set_block_size(object->dataset.distribution, MAX(stripe_size / chunk_size, 1) * chunk_size);
 	}
 
-	j_distributed_object_create(object->dataset.object, batch);
+	return TRUE;
 
-	{
-		if (!j_batch_execute(batch))
-		{
+_error:
+	return FALSE;
+}
+
+/**
+ * Maps elements of the dataspace to their position in the dataset's object.
+ *
+ * \param element The row-major index of the first element.
+ * \param count   The number of consecutive elements.
+ * \param stored  Returns the position of the first element in the object.
+ * \param chunk   Returns the index of the chunk containing the first element.
+ *
+ * \return The number of elements that are also stored consecutively, at most count.
+ **/
+static guint64
+H5VL_julea_db_dataset_chunk_map(JHDF5Object_t* object, guint64 element, guint64 count, guint64* stored, guint64* chunk)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	hsize_t coordinates[H5S_MAX_RANK];
+	const hsize_t* dims = object->dataset.dims;
+	const hsize_t* chunk_dims = object->dataset.chunk_dims;
+	guint64 offset = 0;
+	guint64 last;
+	guint i;
+
+	if (!object->dataset.chunked)
+	{
+		*stored = element;
+		*chunk = 0;
+
+		return count;
+	}
+
+	for (i = object->dataset.ndims; i > 0; i--)
+	{
+		coordinates[i - 1] = element % dims[i - 1];
+		element /= dims[i - 1];
+	}
+
+	*chunk = 0;
+
+	for (i = 0; i < object->dataset.ndims; i++)
+	{
+		*chunk = *chunk * ((dims[i] + chunk_dims[i] - 1) / chunk_dims[i]) + coordinates[i] / chunk_dims[i];
+		offset = offset * chunk_dims[i] + coordinates[i] % chunk_dims[i];
+	}
+
+	*stored = *chunk * object->dataset.chunk_elements + offset;
+
+	// Elements are consecutive up to the end of the chunk's row or the dataspace's row, whichever comes first
+	last = object->dataset.ndims - 1;
+	count = MIN(count, chunk_dims[last] - coordinates[last] % chunk_dims[last]);
+	count = MIN(count, dims[last] - coordinates[last]);
+
+	return count;
+}
+
+/**
+ * Returns the number of elements of a chunk that are part of the dataspace, that is, without padding.
+ **/
+static guint64
+H5VL_julea_db_dataset_chunk_elements(JHDF5Object_t* object, guint64 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 elements = 1;
+	guint i;
+
+	for (i = object->dataset.ndims; i > 0; i--)
+	{
+		hsize_t dim = object->dataset.dims[i - 1];
+		hsize_t chunk_dim = object->dataset.chunk_dims[i - 1];
+		hsize_t chunks_per_dim = (dim + chunk_dim - 1) / chunk_dim;
+		hsize_t start = (index % chunks_per_dim) * chunk_dim;
+
+		elements *= MIN(chunk_dim, dim - start);
+		index /= chunks_per_dim;
+	}
+
+	return elements;
+}
+
+static void
+merge_statistics(JHDF5Statistics_t* statistics, JHDF5Statistics_t const* other)
+{
+	statistics->min_value_i = MIN(statistics->min_value_i, other->min_value_i);
+	statistics->max_value_i = MAX(statistics->max_value_i, other->max_value_i);
+	statistics->min_value_f = MIN(statistics->min_value_f, other->min_value_f);
+	statistics->max_value_f = MAX(statistics->max_value_f, other->max_value_f);
+}
+
+static JHDF5Chunk_t*
+H5VL_julea_db_dataset_chunk_get(JHDF5Object_t* object, guint64 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Chunk_t* chunk;
+
+	if ((chunk = g_hash_table_lookup(object->dataset.chunks, &index)) == NULL)
+	{
+		// Chunks are zero-filled, so zero is part of their range until they are written completely
+		chunk = g_new0(JHDF5Chunk_t, 1);
+		chunk->index = index;
+		chunk->stored = FALSE;
+		chunk->dirty = FALSE;
+
+		g_hash_table_insert(object->dataset.chunks, &(chunk->index), chunk);
+	}
+
+	return chunk;
+}
+
+static JDBEntry*
+H5VL_julea_db_dataset_chunk_entry(JHDF5Object_t* object, JHDF5Chunk_t* chunk, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBEntry) entry = NULL;
+	JHDF5Object_t* file = object->dataset.file;
+
+	if (!(entry = j_db_entry_new(julea_db_schema_chunk, error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "file", file->backend_id, file->backend_id_len, error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "dataset", object->backend_id, object->backend_id_len, error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "index", &chunk->index, sizeof(chunk->index), error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "min_value_i", &chunk->statistics.min_value_i, sizeof(chunk->statistics.min_value_i), error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "max_value_i", &chunk->statistics.max_value_i, sizeof(chunk->statistics.max_value_i), error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "min_value_f", &chunk->statistics.min_value_f, sizeof(chunk->statistics.min_value_f), error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "max_value_f", &chunk->statistics.max_value_f, sizeof(chunk->statistics.max_value_f), error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_set_field(entry, "size", &chunk->size, sizeof(chunk->size), error))
+	{
+		j_goto_error();
+	}
+
+	return g_steal_pointer(&entry);
+
+_error:
+	return NULL;
+}
+
+/**
+ * Updates the index entry of a chunk that has already been stored.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunk_update(JHDF5Object_t* object, JHDF5Chunk_t* chunk, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JDBEntry) entry = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+
+	if (!(selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "dataset", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "index", J_DB_SELECTOR_OPERATOR_EQ, &chunk->index, sizeof(chunk->index), error))
+	{
+		j_goto_error();
+	}
+
+	if (!(entry = H5VL_julea_db_dataset_chunk_entry(object, chunk, error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_update(entry, selector, NULL, batch, error))
+	{
+		j_goto_error();
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Loads the chunk index of a dataset.
+ *
+ * Chunks that are already part of the index are kept, because they might have been modified since they were stored.
+ *
+ * \param indexes The indexes of the chunks to load, NULL to load all chunks.
+ **/
+static gboolean
+H5VL_julea_db_dataset_chunk_load(JHDF5Object_t* object, GArray* indexes)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+
+	if (!(selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_selector_add_field(selector, "dataset", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	{
+		j_goto_error();
+	}
+
+	if (indexes != NULL && indexes->len > 0)
+	{
+		guint64 first = G_MAXUINT64;
+		guint64 last = 0;
+
+		// Selecting the range of indexes keeps the selector small, chunks outside of indexes are valid index entries as well
+		for (guint i = 0; i < indexes->len; i++)
+		{
+			first = MIN(first, g_array_index(indexes, guint64, i));
+			last = MAX(last, g_array_index(indexes, guint64, i));
+		}
+
+		if (!j_db_selector_add_field(selector, "index", J_DB_SELECTOR_OPERATOR_GE, &first, sizeof(first), &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_selector_add_field(selector, "index", J_DB_SELECTOR_OPERATOR_LE, &last, sizeof(last), &error))
+		{
 			j_goto_error();
 		}
 	}
 
-	if (!H5VL_julea_db_link_create_helper(parent, object, name))
+	if (!(iterator = j_db_iterator_new(julea_db_schema_chunk, selector, &error)))
 	{
 		j_goto_error();
 	}
 
-	return object;
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		JHDF5Chunk_t* chunk;
+		JDBType type;
+		guint64 len;
+		guint64* index;
+		guint64* size;
+		gint64* value_i;
+		gdouble* value_f;
+
+		if (!j_db_iterator_get_field(iterator, "index", &type, (gpointer*)&index, &len, &error))
+		{
+			j_goto_error();
+		}
+
+		if (g_hash_table_contains(object->dataset.chunks, index))
+		{
+			g_free(index);
+			continue;
+		}
+
+		chunk = H5VL_julea_db_dataset_chunk_get(object, *index);
+		chunk->stored = TRUE;
+		g_free(index);
+
+		if (!j_db_iterator_get_field(iterator, "min_value_i", &type, (gpointer*)&value_i, &len, &error))
+		{
+			j_goto_error();
+		}
+
+		chunk->statistics.min_value_i = *value_i;
+		g_free(value_i);
+
+		if (!j_db_iterator_get_field(iterator, "max_value_i", &type, (gpointer*)&value_i, &len, &error))
+		{
+			j_goto_error();
+		}
+
+		chunk->statistics.max_value_i = *value_i;
+		g_free(value_i);
+
+		if (!j_db_iterator_get_field(iterator, "min_value_f", &type, (gpointer*)&value_f, &len, &error))
+		{
+			j_goto_error();
+		}
+
+		chunk->statistics.min_value_f = *value_f;
+		g_free(value_f);
+
+		if (!j_db_iterator_get_field(iterator, "max_value_f", &type, (gpointer*)&value_f, &len, &error))
+		{
+			j_goto_error();
+		}
+
+		chunk->statistics.max_value_f = *value_f;
+		g_free(value_f);
+
+		if (!j_db_iterator_get_field(iterator, "size", &type, (gpointer*)&size, &len, &error))
+		{
+			j_goto_error();
+		}
+
+		chunk->size = *size;
+		g_free(size);
+	}
+
+	return TRUE;
 
 _error:
 	H5VL_julea_db_error_handler(error);
-	H5VL_julea_db_object_unref(object);
 
-	return NULL;
+	return FALSE;
 }
 
 static void*
-H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t dapl_id, hid_t dxpl_id, void** req)
+H5VL_julea_db_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t lcpl_id, hid_t type_id, hid_t space_id, hid_t dcpl_id, hid_t dapl_id, hid_t dxpl_id, void** req)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(GError) error = NULL;
 	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(JDBIterator) iterator = NULL;
-	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBEntry) entry = NULL;
 	g_autofree char* hex_buf = NULL;
-	g_autofree void* space_id_buf = NULL;
-	g_autofree void* datatype_id_buf = NULL;
 	JHDF5Object_t* object = NULL;
 	JHDF5Object_t* parent = obj;
 	JHDF5Object_t* file;
-	JDBType type;
-	guint64 len;
-	guint64 space_id_buf_len;
-	guint64 datatype_id_buf_len;
-	guint64* tmp_ptr_i;
-	gdouble* tmp_ptr_f;
+	hsize_t chunk_dims[H5S_MAX_RANK];
+	gint chunk_ndims = 0;
+	guint32 codec;
+	guint32 shuffle;
 
 	(void)loc_params;
+	(void)lcpl_id;
 	(void)dapl_id;
 	(void)dxpl_id;
 	(void)req;
@@ -465,6 +963,11 @@ H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const
 		j_goto_error();
 	}
 
+	object->dataset.statistics.min_value_i = 0;
+	object->dataset.statistics.max_value_i = 0;
+	object->dataset.statistics.min_value_f = 0;
+	object->dataset.statistics.max_value_f = 0;
+
 	if (!(object->dataset.name = g_strdup(name)))
 	{
 		j_goto_error();
@@ -475,86 +978,103 @@ H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const
 		j_goto_error();
 	}
 
-	if (!H5VL_julea_db_link_get_helper(parent, object, name))
+	if (!(object->dataset.datatype = H5VL_julea_db_datatype_encode(file, &type_id)))
 	{
 		j_goto_error();
 	}
 
-	if (!(selector = j_db_selector_new(julea_db_schema_dataset, J_DB_SELECTOR_MODE_AND, &error)))
+	if (!(object->dataset.space = H5VL_julea_db_space_encode(file, &space_id)))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
+	if (dcpl_id != H5P_DEFAULT && H5Pget_layout(dcpl_id) == H5D_CHUNKED)
 	{
-		j_goto_error();
+		if ((chunk_ndims = H5Pget_chunk(dcpl_id, H5S_MAX_RANK, chunk_dims)) < 0)
+		{
+			j_goto_error();
+		}
 	}
 
-	if (!(iterator = j_db_iterator_new(julea_db_schema_dataset, selector, &error)))
+	if (!H5VL_julea_db_dataset_layout_init(object, (chunk_ndims > 0) ? chunk_dims : NULL, chunk_ndims))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_next(iterator, &error))
+	if (!H5VL_julea_db_compression_set(object, dcpl_id))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "min_value_i", &type, (gpointer*)&tmp_ptr_i, &len, &error))
+	// Like HDF5, filters are only supported for chunked datasets
+	if (H5VL_julea_db_compression_enabled(object) && chunk_ndims == 0)
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.min_value_i = *tmp_ptr_i;
-	g_free(tmp_ptr_i);
-
-	if (!j_db_iterator_get_field(iterator, "max_value_i", &type, (gpointer*)&tmp_ptr_i, &len, &error))
+	if (!julea_db_dataset_layout && (object->dataset.chunked || H5VL_julea_db_compression_enabled(object)))
 	{
+		g_warning("%s chunked and compressed datasets require a dataset schema containing the chunk layout", G_STRLOC);
 		j_goto_error();
 	}
 
-	object->dataset.statistics.max_value_i = *tmp_ptr_i;
-	g_free(tmp_ptr_i);
+	codec = object->dataset.codec;
+	shuffle = object->dataset.shuffle;
 
-	if (!j_db_iterator_get_field(iterator, "min_value_f", &type, (gpointer*)&tmp_ptr_f, &len, &error))
+	if (!(entry = j_db_entry_new(julea_db_schema_dataset, &error)))
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.min_value_f = *tmp_ptr_f;
-	g_free(tmp_ptr_f);
-
-	if (!j_db_iterator_get_field(iterator, "max_value_f", &type, (gpointer*)&tmp_ptr_f, &len, &error))
+	if (!j_db_entry_set_field(entry, "file", file->backend_id, file->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	object->dataset.statistics.max_value_f = *tmp_ptr_f;
-	g_free(tmp_ptr_f);
-
-	if (!j_db_iterator_get_field(iterator, "space", &type, &space_id_buf, &space_id_buf_len, &error))
+	if (!j_db_entry_set_field(entry, "datatype", object->dataset.datatype->backend_id, object->dataset.datatype->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(object->dataset.space = H5VL_julea_db_space_decode(space_id_buf, space_id_buf_len)))
+	if (!j_db_entry_set_field(entry, "space", object->dataset.space->backend_id, object->dataset.space->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!j_db_iterator_get_field(iterator, "datatype", &type, &datatype_id_buf, &datatype_id_buf_len, &error))
+	if (julea_db_dataset_layout)
 	{
-		j_goto_error();
-	}
+		if (!j_db_entry_set_field(entry, "chunk_dims", object->dataset.chunk_dims, object->dataset.ndims * sizeof(hsize_t), &error))
+		{
+			j_goto_error();
+		}
 
-	if (!(object->dataset.datatype = H5VL_julea_db_datatype_decode(datatype_id_buf, datatype_id_buf_len)))
-	{
-		j_goto_error();
-	}
+		if (!j_db_entry_set_field(entry, "codec", &codec, sizeof(codec), &error))
+		{
+			j_goto_error();
+		}
 
-	g_assert(!j_db_iterator_next(iterator, NULL));
+		if (!j_db_entry_set_field(entry, "codec_level", &object->dataset.codec_level, sizeof(object->dataset.codec_level), &error))
+		{
+			j_goto_error();
+		}
 
-	if (!(object->dataset.distribution = j_distribution_new(J_DISTRIBUTION_ROUND_ROBIN)))
+		if (!j_db_entry_set_field(entry, "shuffle", &shuffle, sizeof(shuffle), &error))
+		{
+			j_goto_error();
+		}
+	}
+
+	if (!j_db_entry_insert(entry, batch, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!j_batch_execute(batch))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_entry_get_id(entry, &object->backend_id, &object->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
@@ -569,6 +1089,20 @@ H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const
 		j_goto_error();
 	}
 
+	j_distributed_object_create(object->dataset.object, batch);
+
+	{
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+	}
+
+	if (!H5VL_julea_db_link_create_helper(parent, object, name))
+	{
+		j_goto_error();
+	}
+
 	return object;
 
 _error:
@@ -578,591 +1112,2150 @@ _error:
 	return NULL;
 }
 
-struct JHDF5IndexRange
+static void*
+H5VL_julea_db_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t dapl_id, hid_t dxpl_id, void** req)
 {
-	guint64 start;
-	guint64 stop;
-};
+	J_TRACE_FUNCTION(NULL);
 
-typedef struct JHDF5IndexRange JHDF5IndexRange;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autofree char* hex_buf = NULL;
+	g_autofree void* space_id_buf = NULL;
+	g_autofree void* datatype_id_buf = NULL;
+	g_autofree hsize_t* chunk_dims = NULL;
+	JHDF5Object_t* object = NULL;
+	JHDF5Object_t* parent = obj;
+	JHDF5Object_t* file;
+	JDBType type;
+	guint64 len;
+	guint64 space_id_buf_len;
+	guint64 datatype_id_buf_len;
+	guint64 chunk_dims_len;
+	guint64* tmp_ptr_i;
+	gdouble* tmp_ptr_f;
+	guint32* tmp_ptr_u32;
+	gint32* tmp_ptr_s32;
 
-static GArray*
-H5VL_julea_db_space_hdf5_to_range(hid_t mem_space_id, hid_t stored_space_id)
-{
-	J_TRACE_FUNCTION(NULL);
+	(void)loc_params;
+	(void)dapl_id;
+	(void)dxpl_id;
+	(void)req;
 
-	g_autofree hsize_t* stored_dims = NULL;
-	JHDF5IndexRange range;
-	JHDF5IndexRange range_tmp;
-	GArray* range_arr = NULL;
-	gboolean range_valid = FALSE;
-	gint stored_ndims;
-	guint i;
-	H5S_sel_type sel_type;
-	stored_ndims = H5Sget_simple_extent_ndims(stored_space_id);
-	stored_dims = g_new(hsize_t, stored_ndims);
-	H5Sget_simple_extent_dims(stored_space_id, stored_dims, NULL);
-	range_arr = g_array_new(FALSE, FALSE, sizeof(JHDF5IndexRange));
-	// FIXME G_DEBUG_HERE();
+	g_return_val_if_fail(name != NULL, NULL);
+	g_return_val_if_fail(parent != NULL, NULL);
 
-	if (mem_space_id == H5S_ALL)
+	switch (parent->type)
 	{
-		sel_type = H5S_SEL_ALL;
+		case J_HDF5_OBJECT_TYPE_FILE:
+			file = parent;
+			break;
+		case J_HDF5_OBJECT_TYPE_DATASET:
+			file = parent->dataset.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_ATTR:
+			file = parent->attr.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_GROUP:
+			file = parent->group.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_DATATYPE:
+		case J_HDF5_OBJECT_TYPE_SPACE:
+		case _J_HDF5_OBJECT_TYPE_COUNT:
+		default:
+			g_assert_not_reached();
+			j_goto_error();
 	}
-	else
+
+	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
 	{
-		sel_type = H5Sget_select_type(mem_space_id);
+		j_goto_error();
 	}
 
-	switch (sel_type)
+	if (!(object = H5VL_julea_db_object_new(J_HDF5_OBJECT_TYPE_DATASET)))
 	{
-		case H5S_SEL_POINTS:
-		{
-			hssize_t npoints = 0;
-			hssize_t point_current = 0;
-			hssize_t point_current_index = 0;
-			g_autofree hsize_t* point_current_arr = NULL;
-			guint skipsize;
+		j_goto_error();
+	}
 
-			point_current_arr = g_new(hsize_t, stored_ndims);
+	if (!(object->dataset.name = g_strdup(name)))
+	{
+		j_goto_error();
+	}
 
-			if ((npoints = H5Sget_select_elem_npoints(mem_space_id)) <= 0)
-			{
-				j_goto_error();
-			}
+	if (!(object->dataset.file = H5VL_julea_db_object_ref(file)))
+	{
+		j_goto_error();
+	}
 
-		_start:
-			while (point_current_index < npoints)
-			{
-				if (H5Sget_select_elem_pointlist(mem_space_id, point_current_index, 1, point_current_arr) < 0)
-				{
-					j_goto_error();
-				}
+	if (!(iterator = H5VL_julea_db_link_get_iterator(parent, object, name, julea_db_schema_dataset)))
+	{
+		j_goto_error();
+	}
 
-				point_current = point_current_arr[stored_ndims - 1];
-				skipsize = stored_dims[stored_ndims - 1];
+	if (!j_db_iterator_get_field(iterator, "min_value_i", &type, (gpointer*)&tmp_ptr_i, &len, &error))
+	{
+		j_goto_error();
+	}
 
-				for (i = 2; i <= (guint)stored_ndims; i++)
-				{
-					point_current += point_current_arr[stored_ndims - i] * skipsize;
-					skipsize *= stored_dims[stored_ndims - i];
-				}
+	object->dataset.statistics.min_value_i = *tmp_ptr_i;
+	g_free(tmp_ptr_i);
 
-				if (range_valid)
-				{
-					if ((guint64)point_current == range.stop + 1)
-					{
-						range.stop++;
-					}
-					else
-					{
-						g_array_append_val(range_arr, range);
-						range.start = point_current;
-						range.stop = point_current;
-					}
-				}
-				else
-				{
-					range.start = point_current;
-					range.stop = point_current;
-					range_valid = TRUE;
+	if (!j_db_iterator_get_field(iterator, "max_value_i", &type, (gpointer*)&tmp_ptr_i, &len, &error))
+	{
+		j_goto_error();
+	}
 
-					goto _start;
-				}
+	object->dataset.statistics.max_value_i = *tmp_ptr_i;
+	g_free(tmp_ptr_i);
 
-				point_current_index++;
-			}
+	if (!j_db_iterator_get_field(iterator, "min_value_f", &type, (gpointer*)&tmp_ptr_f, &len, &error))
+	{
+		j_goto_error();
+	}
 
-			if (range_valid)
-			{
-				g_array_append_val(range_arr, range);
-			}
-		}
-		break;
-		case H5S_SEL_HYPERSLABS:
-		{
-			g_autofree hsize_t* hyperspab_counters = NULL;
-			g_autofree hsize_t* hyperspab_coordinates = NULL;
-			g_autofree hsize_t* hyperspab_skip_size = NULL;
-			hssize_t hyperslab_count;
-			hssize_t hyperslab_index;
-			gint current_counter;
-			gboolean found;
-			gboolean first;
+	object->dataset.statistics.min_value_f = *tmp_ptr_f;
+	g_free(tmp_ptr_f);
 
-			if ((hyperslab_count = H5Sget_select_hyper_nblocks(mem_space_id)) < 0)
-			{
-				j_goto_error();
-			}
+	if (!j_db_iterator_get_field(iterator, "max_value_f", &type, (gpointer*)&tmp_ptr_f, &len, &error))
+	{
+		j_goto_error();
+	}
 
-			hyperspab_coordinates = g_new(hsize_t, stored_ndims * 2);
-			hyperspab_counters = g_new(hsize_t, stored_ndims);
-			hyperspab_skip_size = g_new(hsize_t, stored_ndims);
-			hyperspab_skip_size[stored_ndims - 1] = 1;
+	object->dataset.statistics.max_value_f = *tmp_ptr_f;
+	g_free(tmp_ptr_f);
 
-			for (i = stored_ndims - 1; i > 0; i--)
-			{
-				hyperspab_skip_size[i - 1] = hyperspab_skip_size[i] * stored_dims[i];
-			}
+	if (!j_db_iterator_get_field(iterator, "space", &type, &space_id_buf, &space_id_buf_len, &error))
+	{
+		j_goto_error();
+	}
 
-			//iterate over all hyperslabs
-			for (hyperslab_index = 0; hyperslab_index < hyperslab_count; hyperslab_index++)
-			{
-				if (H5Sget_select_hyper_blocklist(mem_space_id, hyperslab_index, 1, hyperspab_coordinates) < 0)
-				{
-					j_goto_error();
-				}
+	if (!(object->dataset.space = H5VL_julea_db_space_decode(file, space_id_buf, space_id_buf_len)))
+	{
+		j_goto_error();
+	}
 
-				for (i = 0; i < (guint)stored_ndims; i++)
-				{
-					hyperspab_counters[i] = hyperspab_coordinates[i];
-				}
+	if (!j_db_iterator_get_field(iterator, "datatype", &type, &datatype_id_buf, &datatype_id_buf_len, &error))
+	{
+		j_goto_error();
+	}
 
-				current_counter = stored_ndims - 1;
-				first = TRUE;
-				//within a hyperslab - iterate over the dimensions
+	if (!(object->dataset.datatype = H5VL_julea_db_datatype_decode(file, datatype_id_buf, datatype_id_buf_len)))
+	{
+		j_goto_error();
+	}
 
-				do
-				{
-					//update current counter
-					found = FALSE;
+	object->dataset.codec = J_HDF5_CODEC_NONE;
+	object->dataset.codec_level = 0;
+	object->dataset.shuffle = FALSE;
+	chunk_dims_len = 0;
 
-					while (current_counter >= 0)
-					{
-						if ((hyperspab_counters[current_counter] < hyperspab_coordinates[stored_ndims + current_counter]) || first)
-						{
-							found = TRUE;
-							first = FALSE;
+	if (julea_db_dataset_layout)
+	{
+		if (!j_db_iterator_get_field(iterator, "chunk_dims", &type, (gpointer*)&chunk_dims, &chunk_dims_len, &error))
+		{
+			j_goto_error();
+		}
 
-							break;
-						}
+		if (!j_db_iterator_get_field(iterator, "codec", &type, (gpointer*)&tmp_ptr_u32, &len, &error))
+		{
+			j_goto_error();
+		}
 
-						for (i = 0; i < (guint)stored_ndims; i++)
-						{
-							//reset counters
-							hyperspab_counters[current_counter] = hyperspab_coordinates[i];
-						}
+		object->dataset.codec = *tmp_ptr_u32;
+		g_free(tmp_ptr_u32);
 
-						current_counter--;
-					}
+		if (!j_db_iterator_get_field(iterator, "codec_level", &type, (gpointer*)&tmp_ptr_s32, &len, &error))
+		{
+			j_goto_error();
+		}
 
-					if (!found)
-					{
-						break;
-					}
+		object->dataset.codec_level = *tmp_ptr_s32;
+		g_free(tmp_ptr_s32);
 
-					//calculate output range
-					range_tmp.start = 0;
+		if (!j_db_iterator_get_field(iterator, "shuffle", &type, (gpointer*)&tmp_ptr_u32, &len, &error))
+		{
+			j_goto_error();
+		}
 
-					for (i = 0; i < (guint)stored_ndims; i++)
-					{
-						range_tmp.start += hyperspab_counters[i] * hyperspab_skip_size[i];
-					}
+		object->dataset.shuffle = *tmp_ptr_u32;
+		g_free(tmp_ptr_u32);
+	}
 
-					range_tmp.stop = range_tmp.start + hyperspab_coordinates[stored_ndims * 2 - 1] - hyperspab_coordinates[stored_ndims - 1];
+	g_assert(!j_db_iterator_next(iterator, NULL));
 
-					if (!range_valid)
-					{
-						range.start = range_tmp.start;
-						range.stop = range_tmp.stop;
-						range_valid = TRUE;
-					}
-					else
-					{
-						if (range.stop + 1 == range_tmp.start)
-						{ //merge consecutive ranges
-							range.stop = range_tmp.stop;
-						}
-						else
-						{ //append range if the next has a gap
-							g_array_append_val(range_arr, range);
-							range.start = range_tmp.start;
-							range.stop = range_tmp.stop;
-						}
-					}
+	if (!H5VL_julea_db_dataset_layout_init(object, chunk_dims, chunk_dims_len / sizeof(hsize_t)))
+	{
+		j_goto_error();
+	}
 
-					hyperspab_counters[current_counter]++;
-				} while (1);
-			}
+	if (!H5VL_julea_db_dataset_chunk_load(object, NULL))
+	{
+		j_goto_error();
+	}
 
-			if (range_valid)
-			{
-				g_array_append_val(range_arr, range);
-			}
-		}
-		break;
-		case H5S_SEL_ALL:
-		{
-			range.start = 0;
-			range.stop = 1;
+	// Datasets written before the chunk index existed consist of a single contiguous chunk without an index entry
+	if (!julea_db_dataset_layout && g_hash_table_size(object->dataset.chunks) == 0)
+	{
+		JHDF5Chunk_t* chunk;
 
-			for (i = 0; i < (guint)stored_ndims; i++)
-			{
-				range.stop *= stored_dims[i];
-			}
+		chunk = H5VL_julea_db_dataset_chunk_get(object, 0);
+		merge_statistics(&chunk->statistics, &object->dataset.statistics);
+	}
 
-			g_array_append_val(range_arr, range);
-		}
-		break;
-		case H5S_SEL_N:
-		case H5S_SEL_ERROR:
-		case H5S_SEL_NONE:
-		default:
-			g_critical("%s NOT implemented !!", G_STRLOC);
-			g_assert_not_reached();
+	if (!(hex_buf = H5VL_julea_db_buf_to_hex("dataset", object->backend_id, object->backend_id_len)))
+	{
+		j_goto_error();
 	}
 
-	//TODO for speedup: sort the array of ranges and merge if possible
-	return range_arr;
+	if (!(object->dataset.object = j_distributed_object_new(JULEA_HDF5_DB_NAMESPACE, hex_buf, object->dataset.distribution)))
+	{
+		j_goto_error();
+	}
+
+	return object;
+
+_error:
+	H5VL_julea_db_error_handler(error);
+	H5VL_julea_db_object_unref(object);
+
+	return NULL;
+}
+
+/*
+ * A range of selected elements, given as row-major indexes into the dataspace.
+ * It consists of count blocks of block elements each, consecutive blocks start stride elements apart.
+ * Contiguous ranges have a count of 1.
+ */
+struct JHDF5IndexRange
+{
+	guint64 start;
+	guint64 stride;
+	guint64 count;
+	guint64 block;
+};
+
+typedef struct JHDF5IndexRange JHDF5IndexRange;
+
+/**
+ * Returns the index of the element at the given position within the range.
+ *
+ * \return The number of elements that follow consecutively, including the returned one.
+ **/
+static guint64
+H5VL_julea_db_space_range_get(JHDF5IndexRange const* range, guint64 position, guint64* index)
+{
+	*index = range->start + (position / range->block) * range->stride + position % range->block;
+
+	return range->block - position % range->block;
+}
+
+static void
+H5VL_julea_db_space_range_append(GArray* range_arr, guint64 start, guint64 stride, guint64 count, guint64 block)
+{
+	JHDF5IndexRange range;
+
+	// Normalize blocks without gaps to contiguous ranges
+	if (count > 1 && stride == block)
+	{
+		block *= count;
+		count = 1;
+	}
+
+	if (count == 1)
+	{
+		stride = block;
+	}
+
+	if (range_arr->len > 0)
+	{
+		JHDF5IndexRange* last = &g_array_index(range_arr, JHDF5IndexRange, range_arr->len - 1);
+
+		if (last->count == 1 && count == 1 && last->start + last->block == start)
+		{
+			last->block += block;
+			last->stride = last->block;
+
+			return;
+		}
+		else if (last->block == block && (count == 1 || last->stride == stride) && last->start + last->count * last->stride == start)
+		{
+			last->count += count;
+
+			return;
+		}
+		else if (last->count == 1 && count == 1 && last->block == block && last->start + last->block < start)
+		{
+			// Two blocks of equal size form a strided range that subsequent blocks can extend
+			last->stride = start - last->start;
+			last->count = 2;
+
+			return;
+		}
+	}
+
+	range.start = start;
+	range.stride = stride;
+	range.count = count;
+	range.block = block;
+
+	g_array_append_val(range_arr, range);
+}
+
+static gint
+H5VL_julea_db_space_range_compare(gconstpointer a, gconstpointer b)
+{
+	JHDF5IndexRange const* range_a = a;
+	JHDF5IndexRange const* range_b = b;
+
+	if (range_a->start < range_b->start)
+	{
+		return -1;
+	}
+	else if (range_a->start > range_b->start)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Converts a hyperslab to ranges in row-major order.
+ *
+ * Fully selected inner dimensions are folded into the blocks of the innermost partially selected dimension.
+ * If strided is TRUE and this dimension is selected contiguously, the next outer dimension is expressed as a stride instead.
+ * A hyperslab of rows with a fixed column range therefore becomes a single range.
+ **/
+static void
+H5VL_julea_db_space_hyperslab_to_range(GArray* range_arr, guint ndims, const hsize_t* skip, const hsize_t* dims, const hsize_t* start, const hsize_t* stride, const hsize_t* count, const hsize_t* block, gboolean strided)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	hsize_t positions[H5S_MAX_RANK];
+	guint64 range_stride;
+	guint64 range_count;
+	guint64 range_block;
+	guint64 range_start;
+	guint outer;
+	guint k;
+	guint i;
+
+	for (i = 0; i < ndims; i++)
+	{
+		if (count[i] == 0 || block[i] == 0)
+		{
+			return;
+		}
+	}
+
+	if (ndims == 0)
+	{
+		H5VL_julea_db_space_range_append(range_arr, 0, 1, 1, 1);
+
+		return;
+	}
+
+	k = ndims - 1;
+
+	while (k > 0 && start[k] == 0 && (count[k] == 1 || stride[k] == block[k]) && count[k] * block[k] == dims[k])
+	{
+		k--;
+	}
+
+	range_start = start[k] * skip[k];
+
+	if (count[k] == 1 || stride[k] == block[k])
+	{
+		range_stride = count[k] * block[k] * skip[k];
+		range_count = 1;
+		range_block = range_stride;
+	}
+	else
+	{
+		range_stride = stride[k] * skip[k];
+		range_count = count[k];
+		range_block = block[k] * skip[k];
+	}
+
+	outer = k;
+
+	if (strided && range_count == 1 && k > 0)
+	{
+		outer = k - 1;
+	}
+
+	for (i = 0; i < outer; i++)
+	{
+		positions[i] = 0;
+	}
+
+	do
+	{
+		guint64 base = 0;
+
+		for (i = 0; i < outer; i++)
+		{
+			base += (start[i] + (positions[i] / block[i]) * stride[i] + positions[i] % block[i]) * skip[i];
+		}
+
+		if (outer == k)
+		{
+			H5VL_julea_db_space_range_append(range_arr, base + range_start, range_stride, range_count, range_block);
+		}
+		else
+		{
+			// Every block of consecutive rows of the outer dimension becomes one strided range
+			for (i = 0; i < count[outer]; i++)
+			{
+				guint64 row = start[outer] + i * stride[outer];
+
+				H5VL_julea_db_space_range_append(range_arr, base + row * skip[outer] + range_start, skip[outer], block[outer], range_block);
+			}
+		}
+
+		for (i = outer; i > 0; i--)
+		{
+			if (++positions[i - 1] < count[i - 1] * block[i - 1])
+			{
+				break;
+			}
+
+			positions[i - 1] = 0;
+		}
+	} while (i > 0);
+}
+
+/**
+ * Converts a selection to ranges of row-major element indexes.
+ *
+ * The ranges are in the order HDF5 iterates over the selection: row-major for hyperslabs and in the order of definition for points.
+ *
+ * \param space_id        The selection, H5S_ALL to select the whole extent.
+ * \param extent_space_id The dataspace providing the extent.
+ **/
+static GArray*
+H5VL_julea_db_space_hdf5_to_range(hid_t space_id, hid_t extent_space_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	hsize_t dims[H5S_MAX_RANK];
+	hsize_t skip[H5S_MAX_RANK];
+	GArray* range_arr = NULL;
+	gint ndims;
+	guint i;
+	H5S_sel_type sel_type;
+
+	range_arr = g_array_new(FALSE, FALSE, sizeof(JHDF5IndexRange));
+
+	if ((ndims = H5Sget_simple_extent_ndims(extent_space_id)) < 0)
+	{
+		j_goto_error();
+	}
+
+	if (H5Sget_simple_extent_dims(extent_space_id, dims, NULL) < 0)
+	{
+		j_goto_error();
+	}
+
+	if (ndims > 0)
+	{
+		skip[ndims - 1] = 1;
+
+		for (i = ndims - 1; i > 0; i--)
+		{
+			skip[i - 1] = skip[i] * dims[i];
+		}
+	}
+
+	if (space_id == H5S_ALL)
+	{
+		sel_type = H5S_SEL_ALL;
+	}
+	else
+	{
+		sel_type = H5Sget_select_type(space_id);
+	}
+
+	switch (sel_type)
+	{
+		case H5S_SEL_POINTS:
+		{
+			g_autofree hsize_t* points = NULL;
+			hssize_t npoints;
+
+			if ((npoints = H5Sget_select_elem_npoints(space_id)) < 0)
+			{
+				j_goto_error();
+			}
+
+			points = g_new(hsize_t, MAX(npoints * ndims, 1));
+
+			if (npoints > 0 && H5Sget_select_elem_pointlist(space_id, 0, npoints, points) < 0)
+			{
+				j_goto_error();
+			}
+
+			// Points must not be reordered, consecutive points are merged by the append
+			for (hssize_t point = 0; point < npoints; point++)
+			{
+				guint64 index = 0;
+
+				for (i = 0; i < (guint)ndims; i++)
+				{
+					index += points[point * ndims + i] * skip[i];
+				}
+
+				H5VL_julea_db_space_range_append(range_arr, index, 1, 1, 1);
+			}
+		}
+		break;
+		case H5S_SEL_HYPERSLABS:
+		{
+			if (H5Sis_regular_hyperslab(space_id) > 0)
+			{
+				hsize_t start[H5S_MAX_RANK];
+				hsize_t stride[H5S_MAX_RANK];
+				hsize_t count[H5S_MAX_RANK];
+				hsize_t block[H5S_MAX_RANK];
+
+				if (H5Sget_regular_hyperslab(space_id, start, stride, count, block) < 0)
+				{
+					j_goto_error();
+				}
+
+				H5VL_julea_db_space_hyperslab_to_range(range_arr, ndims, skip, dims, start, stride, count, block, TRUE);
+			}
+			else
+			{
+				g_autofree hsize_t* blocks = NULL;
+				g_autoptr(GArray) unsorted_arr = NULL;
+				hsize_t ones[H5S_MAX_RANK];
+				hsize_t block[H5S_MAX_RANK];
+				hssize_t nblocks;
+
+				if ((nblocks = H5Sget_select_hyper_nblocks(space_id)) < 0)
+				{
+					j_goto_error();
+				}
+
+				blocks = g_new(hsize_t, MAX(nblocks * ndims * 2, 1));
+
+				if (nblocks > 0 && H5Sget_select_hyper_blocklist(space_id, 0, nblocks, blocks) < 0)
+				{
+					j_goto_error();
+				}
+
+				for (i = 0; i < (guint)ndims; i++)
+				{
+					ones[i] = 1;
+				}
+
+				unsorted_arr = g_array_new(FALSE, FALSE, sizeof(JHDF5IndexRange));
+
+				// Blocks may interleave, so only contiguous ranges are generated and sorted afterwards
+				for (hssize_t b = 0; b < nblocks; b++)
+				{
+					const hsize_t* corner_start = blocks + b * ndims * 2;
+					const hsize_t* corner_end = corner_start + ndims;
+
+					for (i = 0; i < (guint)ndims; i++)
+					{
+						block[i] = corner_end[i] - corner_start[i] + 1;
+					}
+
+					H5VL_julea_db_space_hyperslab_to_range(unsorted_arr, ndims, skip, dims, corner_start, ones, ones, block, FALSE);
+				}
+
+				g_array_sort(unsorted_arr, H5VL_julea_db_space_range_compare);
+
+				for (i = 0; i < unsorted_arr->len; i++)
+				{
+					JHDF5IndexRange const* range = &g_array_index(unsorted_arr, JHDF5IndexRange, i);
+
+					H5VL_julea_db_space_range_append(range_arr, range->start, range->stride, range->count, range->block);
+				}
+			}
+		}
+		break;
+		case H5S_SEL_ALL:
+		{
+			hssize_t npoints;
+
+			if ((npoints = H5Sget_simple_extent_npoints(extent_space_id)) < 0)
+			{
+				j_goto_error();
+			}
+
+			if (npoints > 0)
+			{
+				H5VL_julea_db_space_range_append(range_arr, 0, npoints, 1, npoints);
+			}
+		}
+		break;
+		case H5S_SEL_NONE:
+			break;
+		case H5S_SEL_N:
+		case H5S_SEL_ERROR:
+		default:
+			g_critical("%s NOT implemented !!", G_STRLOC);
+			g_assert_not_reached();
+	}
+
+	return range_arr;
+
+_error:
+	g_array_free(range_arr, TRUE);
+
+	return NULL;
+}
+
+/**
+ * Statistics of the data written to a chunk by a single write.
+ **/
+struct JHDF5ChunkWrite
+{
+	JHDF5Chunk_t* chunk;
+	guint64 count;
+	JHDF5Statistics_t statistics;
+	// Whether the chunk contained data before this write
+	gboolean stored;
+	// The chunk's uncompressed data, only used for compressed datasets
+	void* data;
+};
+
+typedef struct JHDF5ChunkWrite JHDF5ChunkWrite;
+
+static void
+H5VL_julea_db_dataset_chunk_write_free(gpointer data)
+{
+	JHDF5ChunkWrite* chunk_write = data;
+
+	g_free(chunk_write->data);
+	g_free(chunk_write);
+}
+
+/**
+ * Returns the statistics of the data written to a chunk by the current write.
+ * Chunks that are written for the first time are added to new_chunks.
+ **/
+static JHDF5ChunkWrite*
+H5VL_julea_db_dataset_chunk_write_get(JHDF5Object_t* object, GHashTable* chunk_writes, GPtrArray* new_chunks, guint64 index)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5ChunkWrite* chunk_write;
+	JHDF5Chunk_t* chunk;
+
+	if ((chunk_write = g_hash_table_lookup(chunk_writes, &index)) != NULL)
+	{
+		return chunk_write;
+	}
+
+	chunk = H5VL_julea_db_dataset_chunk_get(object, index);
+
+	chunk_write = g_new(JHDF5ChunkWrite, 1);
+	chunk_write->chunk = chunk;
+	chunk_write->count = 0;
+	chunk_write->statistics.min_value_i = G_MAXINT64;
+	chunk_write->statistics.max_value_i = G_MININT64;
+	chunk_write->statistics.min_value_f = INFINITY;
+	chunk_write->statistics.max_value_f = -INFINITY;
+	chunk_write->stored = chunk->stored;
+	chunk_write->data = NULL;
+
+	if (!chunk->stored)
+	{
+		// New chunks are added to the index at the end of this write
+		chunk->stored = TRUE;
+		g_ptr_array_add(new_chunks, chunk);
+	}
+	else
+	{
+		chunk->dirty = TRUE;
+	}
+
+	g_hash_table_insert(chunk_writes, &(chunk->index), chunk_write);
+
+	return chunk_write;
+}
+
+/**
+ * Updates the statistics of the chunks and the dataset with those of the current write.
+ **/
+static void
+H5VL_julea_db_dataset_chunk_writes_apply(JHDF5Object_t* object, GHashTable* chunk_writes)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GHashTableIter iter;
+	JHDF5ChunkWrite* chunk_write;
+
+	g_hash_table_iter_init(&iter, chunk_writes);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&chunk_write))
+	{
+		JHDF5Chunk_t* chunk = chunk_write->chunk;
+
+		// Chunks that have been overwritten completely lose their previous values, including the initial zeros
+		if (chunk_write->count >= H5VL_julea_db_dataset_chunk_elements(object, chunk->index))
+		{
+			// Only one kind of statistics is computed, the other one still has its initial values
+			if (chunk_write->statistics.min_value_i <= chunk_write->statistics.max_value_i)
+			{
+				chunk->statistics.min_value_i = chunk_write->statistics.min_value_i;
+				chunk->statistics.max_value_i = chunk_write->statistics.max_value_i;
+			}
+
+			if (chunk_write->statistics.min_value_f <= chunk_write->statistics.max_value_f)
+			{
+				chunk->statistics.min_value_f = chunk_write->statistics.min_value_f;
+				chunk->statistics.max_value_f = chunk_write->statistics.max_value_f;
+			}
+		}
+		else
+		{
+			merge_statistics(&chunk->statistics, &chunk_write->statistics);
+		}
+
+		merge_statistics(&object->dataset.statistics, &chunk->statistics);
+		object->dataset.statistics_dirty = TRUE;
+	}
+}
+
+struct JHDF5ChunkSegment
+{
+	// Positions in elements
+	guint64 mem;
+	guint64 stored;
+	guint64 count;
+	guint64 chunk;
+};
+
+typedef struct JHDF5ChunkSegment JHDF5ChunkSegment;
+
+/**
+ * Pairs the selected memory and file ranges and splits them into segments that are stored consecutively within a single chunk.
+ * Adjacent segments are merged.
+ **/
+static GArray*
+H5VL_julea_db_dataset_ranges_to_segments(JHDF5Object_t* object, GArray* mem_space_arr, GArray* file_space_arr)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GArray* segments;
+	guint mem_space_idx = 0;
+	guint file_space_idx = 0;
+	guint64 mem_space_pos = 0;
+	guint64 file_space_pos = 0;
+
+	segments = g_array_new(FALSE, FALSE, sizeof(JHDF5ChunkSegment));
+
+	while (mem_space_idx < mem_space_arr->len && file_space_idx < file_space_arr->len)
+	{
+		JHDF5IndexRange const* mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, mem_space_idx);
+		JHDF5IndexRange const* file_space_range = &g_array_index(file_space_arr, JHDF5IndexRange, file_space_idx);
+		guint64 mem;
+		guint64 file;
+		guint64 count;
+
+		count = H5VL_julea_db_space_range_get(mem_space_range, mem_space_pos, &mem);
+		count = MIN(count, H5VL_julea_db_space_range_get(file_space_range, file_space_pos, &file));
+
+		while (count > 0)
+		{
+			JHDF5ChunkSegment segment;
+			JHDF5ChunkSegment* last = NULL;
+
+			segment.mem = mem;
+			segment.count = H5VL_julea_db_dataset_chunk_map(object, file, count, &segment.stored, &segment.chunk);
+
+			if (segments->len > 0)
+			{
+				last = &g_array_index(segments, JHDF5ChunkSegment, segments->len - 1);
+			}
+
+			if (last != NULL && last->chunk == segment.chunk && last->mem + last->count == segment.mem && last->stored + last->count == segment.stored)
+			{
+				last->count += segment.count;
+			}
+			else
+			{
+				g_array_append_val(segments, segment);
+			}
+
+			mem += segment.count;
+			file += segment.count;
+			count -= segment.count;
+			mem_space_pos += segment.count;
+			file_space_pos += segment.count;
+		}
+
+		if (mem_space_pos == mem_space_range->count * mem_space_range->block)
+		{
+			mem_space_idx++;
+			mem_space_pos = 0;
+		}
+
+		if (file_space_pos == file_space_range->count * file_space_range->block)
+		{
+			file_space_idx++;
+			file_space_pos = 0;
+		}
+	}
+
+	return segments;
+}
+
+/**
+ * Writes to a compressed dataset, whose chunks can only be written as a whole.
+ * Chunks that are only written partially are read and decompressed first.
+ *
+ * \param buffers Returns the compressed chunks, which have to stay valid until the batch has been executed.
+ **/
+static gboolean
+H5VL_julea_db_dataset_write_compressed(JHDF5Object_t* object, hid_t mem_type_id, const void* buf, gsize mem_data_size, gboolean convert, GArray* segments, GHashTable* chunk_writes, GPtrArray* new_chunks, GPtrArray* buffers, guint64* bytes_written, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) chunk_list = NULL;
+	g_autoptr(GPtrArray) compressed = NULL;
+	g_autoptr(GArray) tasks = NULL;
+	guint64 bytes_read = 0;
+	gsize data_size;
+	gsize chunk_size;
+	hid_t stored_type_id;
+	guint i;
+
+	data_size = object->dataset.datatype->datatype.type_total_size;
+	chunk_size = object->dataset.chunk_elements * data_size;
+	stored_type_id = object->dataset.datatype->datatype.hdf5_id;
+
+	chunk_list = g_ptr_array_new();
+	compressed = g_ptr_array_new_with_free_func(g_free);
+	tasks = g_array_new(FALSE, FALSE, sizeof(JHDF5CompressionTask));
+
+	for (i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JHDF5ChunkWrite* chunk_write;
+
+		chunk_write = H5VL_julea_db_dataset_chunk_write_get(object, chunk_writes, new_chunks, segment->chunk);
+		chunk_write->count += segment->count;
+
+		if (chunk_write->data == NULL)
+		{
+			// Chunks that have not been stored yet only contain the fill value
+			chunk_write->data = g_malloc0(chunk_size);
+			g_ptr_array_add(chunk_list, chunk_write);
+		}
+	}
+
+	// Pending asynchronous writes might still modify the chunks that are read below
+	for (i = 0; i < object->dataset.batches->len; i++)
+	{
+		j_batch_wait(g_ptr_array_index(object->dataset.batches, i));
+	}
+
+	for (i = 0; i < chunk_list->len; i++)
+	{
+		JHDF5ChunkWrite* chunk_write = g_ptr_array_index(chunk_list, i);
+		JHDF5Chunk_t* chunk = chunk_write->chunk;
+		JHDF5CompressionTask task;
+		void* in;
+
+		// Chunks that are overwritten completely do not have to be read
+		if (!chunk_write->stored || chunk_write->count >= H5VL_julea_db_dataset_chunk_elements(object, chunk->index))
+		{
+			continue;
+		}
+
+		task.in_size = (chunk->size > 0) ? chunk->size : chunk_size;
+		task.out = chunk_write->data;
+		task.out_size = chunk_size;
+		task.ret = FALSE;
+
+		in = g_malloc(task.in_size);
+		task.in = in;
+
+		g_ptr_array_add(compressed, in);
+		g_array_append_val(tasks, task);
+
+		j_distributed_object_read(object->dataset.object, in, task.in_size, chunk->index * chunk_size, &bytes_read, batch);
+	}
+
+	if (tasks->len > 0)
+	{
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+
+		if (!H5VL_julea_db_compression_run(object, tasks, FALSE))
+		{
+			j_goto_error();
+		}
+	}
+
+	for (i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JHDF5ChunkWrite* chunk_write;
+		const char* segment_buf = ((const char*)buf) + segment->mem * mem_data_size;
+		char* chunk_buf;
+
+		chunk_write = g_hash_table_lookup(chunk_writes, &segment->chunk);
+		chunk_buf = ((char*)chunk_write->data) + (segment->stored - segment->chunk * object->dataset.chunk_elements) * data_size;
+
+		if (convert)
+		{
+			g_autofree char* converted_buf = NULL;
+
+			// Conversion happens in place, the buffer has to hold both representations
+			converted_buf = g_malloc(MAX(mem_data_size, data_size) * segment->count);
+			memcpy(converted_buf, segment_buf, mem_data_size * segment->count);
+
+			if (H5Tconvert(mem_type_id, stored_type_id, segment->count, converted_buf, NULL, H5P_DEFAULT) < 0)
+			{
+				j_goto_error();
+			}
+
+			memcpy(chunk_buf, converted_buf, data_size * segment->count);
+		}
+		else
+		{
+			memcpy(chunk_buf, segment_buf, data_size * segment->count);
+		}
+
+		if (object->dataset.statistics_func != NULL)
+		{
+			object->dataset.statistics_func(&chunk_write->statistics, chunk_buf, segment->count);
+		}
+	}
+
+	g_array_set_size(tasks, 0);
+
+	for (i = 0; i < chunk_list->len; i++)
+	{
+		JHDF5ChunkWrite* chunk_write = g_ptr_array_index(chunk_list, i);
+		JHDF5CompressionTask task;
+
+		task.in = chunk_write->data;
+		task.in_size = chunk_size;
+		task.out_size = H5VL_julea_db_compression_bound(object, chunk_size);
+		task.out = g_malloc(task.out_size);
+		task.ret = FALSE;
+
+		g_ptr_array_add(buffers, task.out);
+		g_array_append_val(tasks, task);
+	}
+
+	if (!H5VL_julea_db_compression_run(object, tasks, TRUE))
+	{
+		j_goto_error();
+	}
+
+	for (i = 0; i < chunk_list->len; i++)
+	{
+		JHDF5ChunkWrite* chunk_write = g_ptr_array_index(chunk_list, i);
+		JHDF5CompressionTask const* task = &g_array_index(tasks, JHDF5CompressionTask, i);
+
+		// Compressed chunks still start at the same position, the rest of their space stays unused
+		chunk_write->chunk->size = task->out_size;
+		j_distributed_object_write(object->dataset.object, task->out, task->out_size, chunk_write->chunk->index * chunk_size, bytes_written, batch);
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Reads from a compressed dataset, every chunk is read and decompressed once.
+ **/
+static gboolean
+H5VL_julea_db_dataset_read_compressed(JHDF5Object_t* object, GArray* segments, void* buf, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) buffers = NULL;
+	g_autoptr(GArray) tasks = NULL;
+	g_autoptr(GHashTable) chunk_tasks = NULL;
+	guint64 bytes_read = 0;
+	gsize data_size;
+	gsize chunk_size;
+	guint i;
+
+	data_size = object->dataset.datatype->datatype.type_total_size;
+	chunk_size = object->dataset.chunk_elements * data_size;
+
+	buffers = g_ptr_array_new_with_free_func(g_free);
+	tasks = g_array_new(FALSE, FALSE, sizeof(JHDF5CompressionTask));
+	// Chunk index to position in tasks, offset by one
+	chunk_tasks = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+	for (i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JHDF5Chunk_t* chunk;
+		JHDF5CompressionTask task;
+		void* in;
+
+		if ((chunk = g_hash_table_lookup(object->dataset.chunks, &segment->chunk)) == NULL || g_hash_table_contains(chunk_tasks, &chunk->index))
+		{
+			continue;
+		}
+
+		task.in_size = (chunk->size > 0) ? chunk->size : chunk_size;
+		task.out = g_malloc(chunk_size);
+		task.out_size = chunk_size;
+		task.ret = FALSE;
+
+		in = g_malloc(task.in_size);
+		task.in = in;
+
+		g_ptr_array_add(buffers, in);
+		g_ptr_array_add(buffers, task.out);
+		g_array_append_val(tasks, task);
+		g_hash_table_insert(chunk_tasks, &chunk->index, GUINT_TO_POINTER(tasks->len));
+
+		j_distributed_object_read(object->dataset.object, in, task.in_size, chunk->index * chunk_size, &bytes_read, batch);
+	}
+
+	if (tasks->len > 0)
+	{
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+
+		if (!H5VL_julea_db_compression_run(object, tasks, FALSE))
+		{
+			j_goto_error();
+		}
+	}
+
+	for (i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		char* segment_buf = ((char*)buf) + segment->mem * data_size;
+		guint task_index;
+
+		// Chunks that have never been written only contain the fill value
+		if ((task_index = GPOINTER_TO_UINT(g_hash_table_lookup(chunk_tasks, &segment->chunk))) == 0)
+		{
+			memset(segment_buf, 0, data_size * segment->count);
+			continue;
+		}
+
+		memcpy(segment_buf, ((char*)g_array_index(tasks, JHDF5CompressionTask, task_index - 1).out) + (segment->stored - segment->chunk * object->dataset.chunk_elements) * data_size, data_size * segment->count);
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static herr_t
+H5VL_julea_db_dataset_write(void* obj, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id, hid_t xfer_plist_id, const void* buf, void** req)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GError) error = NULL;
+	g_autofree void* local_buf_org = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GArray) mem_space_arr = NULL;
+	g_autoptr(GArray) file_space_arr = NULL;
+	g_autoptr(GArray) segments = NULL;
+	g_autoptr(GPtrArray) new_chunks = NULL;
+	g_autoptr(GHashTable) chunk_writes = NULL;
+	g_autoptr(GPtrArray) buffers = NULL;
+	guint64 bytes_written_sync = 0;
+	guint64* bytes_written = NULL;
+	gsize data_size;
+	gsize mem_data_size;
+	gsize local_data_size = 0;
+	gsize local_buf_offset = 0;
+	gsize local_buf_count = 0;
+	htri_t convert;
+	gboolean compressed;
+	JHDF5Object_t* object = obj;
+	hid_t mem_extent_id;
+	hid_t stored_type_id;
+	guint i;
+
+	(void)xfer_plist_id;
+
+	g_return_val_if_fail(buf != NULL, 1);
+	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
+
+	data_size = object->dataset.datatype->datatype.type_total_size;
+	stored_type_id = object->dataset.datatype->datatype.hdf5_id;
+	compressed = H5VL_julea_db_compression_enabled(object);
+
+	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	{
+		j_goto_error();
+	}
+
+	// Without a memory dataspace, the memory buffer has the shape of the dataset
+	mem_extent_id = (mem_space_id == H5S_ALL) ? object->dataset.space->space.hdf5_id : mem_space_id;
+
+	if (!(mem_space_arr = H5VL_julea_db_space_hdf5_to_range(mem_space_id, mem_extent_id)))
+	{
+		j_goto_error();
+	}
+
+	if (!(file_space_arr = H5VL_julea_db_space_hdf5_to_range(file_space_id, object->dataset.space->space.hdf5_id)))
+	{
+		j_goto_error();
+	}
+
+	// Data that does not have to be converted is written directly from the application's buffer
+	if ((convert = H5VL_julea_db_datatype_is_compatible(mem_type_id, stored_type_id)) < 0)
+	{
+		j_goto_error();
+	}
+
+	convert = !convert;
+	mem_data_size = (convert) ? H5Tget_size(mem_type_id) : data_size;
+
+	// Asynchronous operations return before the batch has been executed, the number of bytes is owned by the request
+	bytes_written = (req != NULL) ? g_new0(guint64, 1) : &bytes_written_sync;
+
+	segments = H5VL_julea_db_dataset_ranges_to_segments(object, mem_space_arr, file_space_arr);
+	new_chunks = g_ptr_array_new();
+	chunk_writes = g_hash_table_new_full(g_int64_hash, g_int64_equal, NULL, H5VL_julea_db_dataset_chunk_write_free);
+	buffers = g_ptr_array_new_with_free_func(g_free);
+
+	if (compressed)
+	{
+		// Compressed chunks are written as a whole, the segments are copied into them instead of being written individually
+		if (!H5VL_julea_db_dataset_write_compressed(object, mem_type_id, buf, mem_data_size, convert, segments, chunk_writes, new_chunks, buffers, bytes_written, batch))
+		{
+			j_goto_error();
+		}
+	}
+	else if (convert)
+	{
+		gsize count = 0;
+
+		// Only the selected elements are converted, the buffer has to hold both representations because conversion happens in place
+		for (i = 0; i < segments->len; i++)
+		{
+			count += g_array_index(segments, JHDF5ChunkSegment, i).count;
+		}
+
+		// The buffer's size is bounded, large selections are converted and written in multiple rounds
+		local_data_size = MAX(mem_data_size, data_size);
+		local_buf_count = MIN(count, MAX(J_HDF5_CONVERT_SIZE / local_data_size, 1));
+		local_buf_org = g_malloc(local_data_size * local_buf_count);
+	}
+
+	// Segments are independent of each other, the object client sends the operations to the chunks' servers in parallel
+	for (i = 0; i < segments->len && !compressed; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		JHDF5ChunkWrite* chunk_write;
+		guint64 done = 0;
+
+		chunk_write = H5VL_julea_db_dataset_chunk_write_get(object, chunk_writes, new_chunks, segment->chunk);
+		chunk_write->count += segment->count;
+
+		// Segments are written in one piece unless they do not fit into the rest of the conversion buffer
+		while (done < segment->count)
+		{
+			const char* segment_buf = ((const char*)buf) + (segment->mem + done) * mem_data_size;
+			guint64 count = segment->count - done;
+
+			if (convert)
+			{
+				// Conversion and statistics are done piece by piece while the data is still in the cache
+				char* converted_buf;
+
+				if (local_buf_offset == local_buf_count)
+				{
+					// The converted data has to be written before the buffer can be reused
+					if (!j_batch_execute(batch))
+					{
+						j_goto_error();
+					}
+
+					local_buf_offset = 0;
+				}
+
+				count = MIN(count, local_buf_count - local_buf_offset);
+				converted_buf = ((char*)local_buf_org) + local_buf_offset * local_data_size;
+
+				memcpy(converted_buf, segment_buf, mem_data_size * count);
+
+				if (H5Tconvert(mem_type_id, stored_type_id, count, converted_buf, NULL, H5P_DEFAULT) < 0)
+				{
+					j_goto_error();
+				}
+
+				segment_buf = converted_buf;
+				local_buf_offset += count;
+			}
+
+			if (object->dataset.statistics_func != NULL)
+			{
+				object->dataset.statistics_func(&chunk_write->statistics, segment_buf, count);
+			}
+
+			j_distributed_object_write(object->dataset.object, segment_buf, data_size * count, (segment->stored + done) * data_size, bytes_written, batch);
+			done += count;
+		}
+	}
+
+	H5VL_julea_db_dataset_chunk_writes_apply(object, chunk_writes);
+
+	for (i = 0; i < new_chunks->len; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+
+		if (!(entry = H5VL_julea_db_dataset_chunk_entry(object, g_ptr_array_index(new_chunks, i), &error)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_entry_insert(entry, batch, &error))
+		{
+			j_goto_error();
+		}
+	}
+
+	if (compressed)
+	{
+		GHashTableIter iter;
+		JHDF5ChunkWrite* chunk_write;
+
+		// The size of rewritten chunks changes with their data, other processes could not decompress them if the entry was updated later
+		g_hash_table_iter_init(&iter, chunk_writes);
+
+		while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&chunk_write))
+		{
+			if (chunk_write->stored && !H5VL_julea_db_dataset_chunk_update(object, chunk_write->chunk, batch, &error))
+			{
+				j_goto_error();
+			}
+		}
+	}
+
+	if (req != NULL)
+	{
+		g_ptr_array_add(buffers, bytes_written);
+
+		// The converted and compressed buffers have to stay valid until the batch has been executed
+		if (local_buf_org != NULL)
+		{
+			g_ptr_array_add(buffers, g_steal_pointer(&local_buf_org));
+		}
+
+		if (segments->len > 0)
+		{
+			*req = j_hdf5_request_new(batch, g_steal_pointer(&buffers), (GDestroyNotify)g_ptr_array_unref, object->dataset.batches);
+		}
+	}
+	else if (segments->len > 0)
+	{
+		GHashTableIter iter;
+		JHDF5ChunkWrite* chunk_write;
+
+		if (!j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+
+		// The entries of rewritten compressed chunks are up to date, asynchronous writes keep them dirty until close
+		g_hash_table_iter_init(&iter, chunk_writes);
+
+		while (compressed && g_hash_table_iter_next(&iter, NULL, (gpointer*)&chunk_write))
+		{
+			chunk_write->chunk->dirty = FALSE;
+		}
+	}
+
+	return 0;
+
+_error:
+	if (bytes_written != &bytes_written_sync)
+	{
+		g_free(bytes_written);
+	}
+
+	H5VL_julea_db_error_handler(error);
+
+	return 1;
+}
+
+/**
+ * Reads segments into a buffer, chunks that have never been written are filled with the fill value.
+ *
+ * \param pending Returns whether reads have been added to the batch, which has to be executed afterwards.
+ **/
+static gboolean
+H5VL_julea_db_dataset_read_segments(JHDF5Object_t* object, GArray* segments, void* buf, gboolean compressed, guint64* bytes_read, JBatch* batch, gboolean* pending)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gsize data_size;
+	guint i;
+
+	data_size = object->dataset.datatype->datatype.type_total_size;
+	*pending = FALSE;
+
+	// Compressed chunks are read and decompressed right away
+	if (compressed)
+	{
+		return H5VL_julea_db_dataset_read_compressed(object, segments, buf, batch);
+	}
+
+	for (i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		char* segment_buf = ((char*)buf) + segment->mem * data_size;
+
+		// Chunks that have never been written only contain the fill value, there is no need to read them
+		if (!g_hash_table_contains(object->dataset.chunks, &segment->chunk))
+		{
+			memset(segment_buf, 0, data_size * segment->count);
+			continue;
+		}
+
+		j_distributed_object_read(object->dataset.object, segment_buf, data_size * segment->count, segment->stored * data_size, bytes_read, batch);
+		*pending = TRUE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Reads a piece of a selection into the conversion buffer, converts it and copies the converted elements to their positions in the memory buffer.
+ *
+ * \param read_segments   The piece's segments, positioned consecutively within local_buf.
+ * \param target_segments The same segments, positioned within buf.
+ **/
+static gboolean
+H5VL_julea_db_dataset_read_converted(JHDF5Object_t* object, hid_t mem_type_id, gsize mem_data_size, GArray* read_segments, GArray* target_segments, void* local_buf, void* buf, gboolean compressed, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint64 bytes_read = 0;
+	guint64 count = 0;
+	gboolean pending;
+	guint i;
+
+	if (!H5VL_julea_db_dataset_read_segments(object, read_segments, local_buf, compressed, &bytes_read, batch, &pending))
+	{
+		j_goto_error();
+	}
+
+	if (pending && !j_batch_execute(batch))
+	{
+		j_goto_error();
+	}
+
+	for (i = 0; i < read_segments->len; i++)
+	{
+		count += g_array_index(read_segments, JHDF5ChunkSegment, i).count;
+	}
+
+	if (H5Tconvert(object->dataset.datatype->datatype.hdf5_id, mem_type_id, count, local_buf, NULL, H5P_DEFAULT) < 0)
+	{
+		j_goto_error();
+	}
+
+	count = 0;
+
+	for (i = 0; i < target_segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(target_segments, JHDF5ChunkSegment, i);
+
+		memcpy(((char*)buf) + segment->mem * mem_data_size, ((char*)local_buf) + count * mem_data_size, mem_data_size * segment->count);
+		count += segment->count;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static herr_t
+H5VL_julea_db_dataset_read(void* obj, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id, hid_t xfer_plist_id, void* buf, void** req)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autofree void* local_buf_org = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(GArray) mem_space_arr = NULL;
+	g_autoptr(GArray) file_space_arr = NULL;
+	g_autoptr(GArray) segments = NULL;
+	g_autoptr(GArray) read_segments = NULL;
+	g_autoptr(GArray) target_segments = NULL;
+	g_autoptr(GArray) unknown_chunks = NULL;
+	guint64 bytes_read_sync = 0;
+	guint64* bytes_read = NULL;
+	gsize data_size;
+	gsize mem_data_size;
+	gsize local_data_size;
+	gsize local_buf_offset = 0;
+	gsize local_buf_count;
+	guint64 count = 0;
+	JHDF5Object_t* object = obj;
+	hid_t stored_type_id;
+	hid_t mem_extent_id;
+	gboolean pending = FALSE;
+	htri_t convert;
+	gboolean compressed;
+	guint i;
+
+	(void)xfer_plist_id;
+
+	g_return_val_if_fail(buf != NULL, 1);
+	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
+
+	data_size = object->dataset.datatype->datatype.type_total_size;
+	stored_type_id = object->dataset.datatype->datatype.hdf5_id;
+	compressed = H5VL_julea_db_compression_enabled(object);
+
+	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	{
+		j_goto_error();
+	}
+
+	// Without a memory dataspace, the memory buffer has the shape of the dataset
+	mem_extent_id = (mem_space_id == H5S_ALL) ? object->dataset.space->space.hdf5_id : mem_space_id;
+
+	if (!(mem_space_arr = H5VL_julea_db_space_hdf5_to_range(mem_space_id, mem_extent_id)))
+	{
+		j_goto_error();
+	}
+
+	if (!(file_space_arr = H5VL_julea_db_space_hdf5_to_range(file_space_id, object->dataset.space->space.hdf5_id)))
+	{
+		j_goto_error();
+	}
+
+	// Data that does not have to be converted is read directly into the application's buffer
+	if ((convert = H5VL_julea_db_datatype_is_compatible(mem_type_id, stored_type_id)) < 0)
+	{
+		j_goto_error();
+	}
+
+	convert = !convert;
+	mem_data_size = (convert) ? H5Tget_size(mem_type_id) : data_size;
+
+	// Data that has to be converted after reading it is read synchronously
+	if (convert)
+	{
+		req = NULL;
+	}
+
+	// Compressed data has to be decompressed after reading it
+	if (compressed)
+	{
+		req = NULL;
+	}
+
+	bytes_read = (req != NULL) ? g_new0(guint64, 1) : &bytes_read_sync;
+
+	segments = H5VL_julea_db_dataset_ranges_to_segments(object, mem_space_arr, file_space_arr);
+
+	// Chunks might have been written by other processes since the dataset was opened, so they are looked up before assuming that they only contain the fill value
+	unknown_chunks = g_array_new(FALSE, FALSE, sizeof(guint64));
+
+	for (i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+
+		if (!g_hash_table_contains(object->dataset.chunks, &segment->chunk))
+		{
+			g_array_append_val(unknown_chunks, segment->chunk);
+		}
+	}
+
+	if (unknown_chunks->len > 0 && !H5VL_julea_db_dataset_chunk_load(object, unknown_chunks))
+	{
+		j_goto_error();
+	}
+
+	if (!convert)
+	{
+		if (!H5VL_julea_db_dataset_read_segments(object, segments, buf, compressed, bytes_read, batch, &pending))
+		{
+			j_goto_error();
+		}
+
+		if (req != NULL)
+		{
+			if (pending)
+			{
+				// The number of bytes is owned by the request
+				*req = j_hdf5_request_new(batch, bytes_read, g_free, object->dataset.batches);
+			}
+			else
+			{
+				g_free(bytes_read);
+			}
+
+			return 0;
+		}
+
+		if (pending && !j_batch_execute(batch))
+		{
+			j_goto_error();
+		}
+
+		return 0;
+	}
+
+	for (i = 0; i < segments->len; i++)
+	{
+		count += g_array_index(segments, JHDF5ChunkSegment, i).count;
+	}
+
+	// Only the selected elements are read into a compact buffer, which has to hold both representations because conversion happens in place
+	// The buffer's size is bounded, large selections are read and converted in multiple rounds
+	local_data_size = MAX(mem_data_size, data_size);
+	local_buf_count = MIN(count, MAX(J_HDF5_CONVERT_SIZE / local_data_size, 1));
+	local_buf_org = g_malloc(local_data_size * local_buf_count);
+
+	read_segments = g_array_new(FALSE, FALSE, sizeof(JHDF5ChunkSegment));
+	target_segments = g_array_new(FALSE, FALSE, sizeof(JHDF5ChunkSegment));
+
+	for (i = 0; i < segments->len; i++)
+	{
+		JHDF5ChunkSegment const* segment = &g_array_index(segments, JHDF5ChunkSegment, i);
+		guint64 done = 0;
+
+		// Segments are split if they do not fit into the rest of the conversion buffer
+		while (done < segment->count)
+		{
+			JHDF5ChunkSegment piece;
+
+			piece.mem = local_buf_offset;
+			piece.stored = segment->stored + done;
+			piece.count = MIN(segment->count - done, local_buf_count - local_buf_offset);
+			piece.chunk = segment->chunk;
+
+			g_array_append_val(read_segments, piece);
+
+			piece.mem = segment->mem + done;
+
+			g_array_append_val(target_segments, piece);
+
+			local_buf_offset += piece.count;
+			done += piece.count;
+
+			// Compressed chunks that are split across pieces are read and decompressed once per piece
+			if (local_buf_offset == local_buf_count || (i == segments->len - 1 && done == segment->count))
+			{
+				if (!H5VL_julea_db_dataset_read_converted(object, mem_type_id, mem_data_size, read_segments, target_segments, local_buf_org, buf, compressed, batch))
+				{
+					j_goto_error();
+				}
+
+				g_array_set_size(read_segments, 0);
+				g_array_set_size(target_segments, 0);
+				local_buf_offset = 0;
+			}
+		}
+	}
+
+	return 0;
+
+_error:
+	if (bytes_read != NULL && bytes_read != &bytes_read_sync)
+	{
+		g_free(bytes_read);
+	}
+
+	return 1;
+}
+
+/**
+ * Returns the number of bytes stored for a dataset's chunks.
+ * Only chunks that are part of the handle's chunk index are taken into account.
+ **/
+static hsize_t
+H5VL_julea_db_dataset_storage_size(JHDF5Object_t* object)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GHashTableIter iter;
+	JHDF5Chunk_t* chunk;
+	hsize_t size = 0;
+
+	g_hash_table_iter_init(&iter, object->dataset.chunks);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&chunk))
+	{
+		if (!chunk->stored)
+		{
+			continue;
+		}
+
+		// Uncompressed chunks do not record their size
+		if (chunk->size > 0)
+		{
+			size += chunk->size;
+		}
+		else
+		{
+			size += H5VL_julea_db_dataset_chunk_elements(object, chunk->index) * object->dataset.datatype->datatype.type_total_size;
+		}
+	}
+
+	return size;
+}
+
+static herr_t
+H5VL_julea_db_dataset_get(void* obj, H5VL_dataset_get_t get_type, hid_t dxpl_id, void** req, va_list arguments)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Object_t* object = obj;
+
+	(void)dxpl_id;
+	(void)req;
+
+	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
+
+	switch (get_type)
+	{
+		case H5VL_DATASET_GET_SPACE:
+			// The caller owns the returned ID, spaces and datatypes can be shared by multiple objects
+			*(va_arg(arguments, hid_t*)) = H5Scopy(object->dataset.space->space.hdf5_id);
+			break;
+		case H5VL_DATASET_GET_TYPE:
+			*(va_arg(arguments, hid_t*)) = H5Tcopy(object->dataset.datatype->datatype.hdf5_id);
+			break;
+		case H5VL_DATASET_GET_STORAGE_SIZE:
+			*(va_arg(arguments, hsize_t*)) = H5VL_julea_db_dataset_storage_size(object);
+			break;
+		case H5VL_DATASET_GET_DAPL:
+		case H5VL_DATASET_GET_DCPL:
+		case H5VL_DATASET_GET_SPACE_STATUS:
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+static herr_t
+H5VL_julea_db_dataset_specific(void* obj, H5VL_dataset_specific_t specific_type, hid_t dxpl_id, void** req, va_list arguments)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Object_t* object = obj;
+
+	(void)specific_type;
+	(void)dxpl_id;
+	(void)req;
+	(void)arguments;
+
+	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
+
+	g_critical("%s NOT implemented !!", G_STRLOC);
+	g_assert_not_reached();
+}
+
+/**
+ * Stores the statistics of a dataset and those of its chunks that changed since they were stored.
+ *
+ * Pending asynchronous writes are waited for first, because they might still insert chunk entries.
+ **/
+static gboolean
+H5VL_julea_db_dataset_statistics_store(JHDF5Object_t* object, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JDBEntry) entry = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	GHashTableIter iter;
+	JHDF5Chunk_t* chunk;
+
+	for (guint i = 0; i < object->dataset.batches->len; i++)
+	{
+		j_batch_wait(g_ptr_array_index(object->dataset.batches, i));
+	}
+
+	g_ptr_array_set_size(object->dataset.batches, 0);
+
+	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	{
+		j_goto_error();
+	}
+
+	// Other processes might have stored newer statistics, which must not be overwritten with unchanged ones
+	if (object->dataset.statistics_dirty)
+	{
+		if (!(selector = j_db_selector_new(julea_db_schema_dataset, J_DB_SELECTOR_MODE_AND, error)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, error))
+		{
+			j_goto_error();
+		}
+
+		if (!(entry = j_db_entry_new(julea_db_schema_dataset, error)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_entry_set_field(entry, "min_value_i", &object->dataset.statistics.min_value_i, sizeof(object->dataset.statistics.min_value_i), error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_entry_set_field(entry, "max_value_i", &object->dataset.statistics.max_value_i, sizeof(object->dataset.statistics.max_value_i), error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_entry_set_field(entry, "min_value_f", &object->dataset.statistics.min_value_f, sizeof(object->dataset.statistics.min_value_f), error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_entry_set_field(entry, "max_value_f", &object->dataset.statistics.max_value_f, sizeof(object->dataset.statistics.max_value_f), error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_entry_update(entry, selector, NULL, batch, error))
+		{
+			j_goto_error();
+		}
+	}
+
+	g_hash_table_iter_init(&iter, object->dataset.chunks);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&chunk))
+	{
+		if (chunk->dirty && !H5VL_julea_db_dataset_chunk_update(object, chunk, batch, error))
+		{
+			j_goto_error();
+		}
+	}
+
+	if (!j_batch_execute(batch))
+	{
+		j_goto_error();
+	}
+
+	// Chunks stay dirty if storing their statistics failed
+	g_hash_table_iter_init(&iter, object->dataset.chunks);
+
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer*)&chunk))
+	{
+		chunk->dirty = FALSE;
+	}
+
+	object->dataset.statistics_dirty = FALSE;
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+H5VL_julea_db_dataset_query_match(JHDF5Statistics_t const* statistics, gboolean is_float, JHDF5QueryOperator op, gdouble value)
+{
+	gdouble min = (is_float) ? statistics->min_value_f : (gdouble)statistics->min_value_i;
+	gdouble max = (is_float) ? statistics->max_value_f : (gdouble)statistics->max_value_i;
+
+	switch (op)
+	{
+		case J_HDF5_QUERY_OPERATOR_LT:
+			return (min < value);
+		case J_HDF5_QUERY_OPERATOR_LE:
+			return (min <= value);
+		case J_HDF5_QUERY_OPERATOR_GT:
+			return (max > value);
+		case J_HDF5_QUERY_OPERATOR_GE:
+			return (max >= value);
+		case J_HDF5_QUERY_OPERATOR_EQ:
+			return (min <= value && value <= max);
+		default:
+			g_assert_not_reached();
+	}
+
+	return TRUE;
+}
+
+/**
+ * Converts a query value to the integer bound that is equivalent for integer statistics.
+ *
+ * \param round_up Whether to round up instead of down.
+ **/
+static gint64
+H5VL_julea_db_dataset_query_bound(gdouble value, gboolean round_up)
+{
+	value = (round_up) ? ceil(value) : floor(value);
+
+	// Clamping only makes the selection larger, it never loses matching chunks
+	if (value >= (gdouble)G_MAXINT64)
+	{
+		return G_MAXINT64;
+	}
+	else if (value <= (gdouble)G_MININT64)
+	{
+		return G_MININT64;
+	}
+
+	return (gint64)value;
+}
+
+/**
+ * Adds a condition on the minimum or maximum value of a dataset or chunk to a selector.
+ **/
+static gboolean
+H5VL_julea_db_dataset_query_add_field(JDBSelector* selector, gboolean is_float, gboolean max, JDBSelectorOperator operator_, gdouble value, gboolean round_up, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gint64 value_i;
+
+	if (is_float)
+	{
+		return j_db_selector_add_field(selector, (max) ? "max_value_f" : "min_value_f", operator_, &value, sizeof(value), error);
+	}
 
-_error:
-	g_array_free(range_arr, TRUE);
+	value_i = H5VL_julea_db_dataset_query_bound(value, round_up);
 
-	return NULL;
+	return j_db_selector_add_field(selector, (max) ? "max_value_i" : "min_value_i", operator_, &value_i, sizeof(value_i), error);
 }
 
-#define calculate_statistics_helper(_buf, _target_extension) \
-	do \
-	{ \
-		for (i = 0; i < n; i++) \
-		{ \
-			if (_buf < object->dataset.statistics.min_value##_target_extension) \
-				object->dataset.statistics.min_value##_target_extension = _buf; \
-			if (_buf > object->dataset.statistics.max_value##_target_extension) \
-				object->dataset.statistics.max_value##_target_extension = _buf; \
-		} \
-	} while (0)
-
-static void
-calculate_statistics(JHDF5Object_t* object, const void* buf, gsize bytes, hid_t memory_type)
+/**
+ * Adds the conditions for statistics that may contain values matching a predicate to a selector.
+ * The dataset and chunk schemas use the same fields for their statistics.
+ *
+ * \param negate Whether to add the conditions for statistics that cannot contain matching values instead.
+ **/
+static gboolean
+H5VL_julea_db_dataset_query_add_fields(JDBSelector* selector, JDBSchema* schema, gboolean is_float, JHDF5QueryOperator op, gdouble value, gboolean negate, GError** error)
 {
-	guint i;
-	guint n;
-	guint element_size = H5Tget_size(memory_type);
-	n = bytes / element_size;
+	J_TRACE_FUNCTION(NULL);
 
-	if (H5Tget_class(memory_type) == H5T_FLOAT)
-	{
-		if (element_size == 4)
-		{
-			calculate_statistics_helper(((gdouble)((const gfloat*)buf)[i]), _f);
-		}
-		else if (element_size == 8)
-		{
-			calculate_statistics_helper(((const gdouble*)buf)[i], _f);
-		}
-	}
-	else if (H5Tget_class(memory_type) == H5T_INTEGER)
-	{
-		if (H5Tget_sign(memory_type) == H5T_SGN_NONE)
-		{
-			if (element_size == 1)
-			{
-				calculate_statistics_helper(((gint8)((const guint8*)buf)[i]), _i);
-			}
-			else if (element_size == 2)
-			{
-				calculate_statistics_helper(((gint16)((const guint16*)buf)[i]), _i);
-			}
-			else if (element_size == 4)
-			{
-				calculate_statistics_helper(((gint32)((const guint32*)buf)[i]), _i);
-			}
-			else if (element_size == 8)
-			{
-				calculate_statistics_helper(((gint64)((const guint64*)buf)[i]), _i);
-			}
-		}
-		else
-		{
-			if (element_size == 1)
-			{
-				calculate_statistics_helper(((const gint8*)buf)[i], _i);
-			}
-			else if (element_size == 2)
+	g_autoptr(JDBSelector) sub_selector = NULL;
+
+	// Integer statistics are compared with the closest integers that do not change the result
+	switch (op)
+	{
+		case J_HDF5_QUERY_OPERATOR_LT:
+			return H5VL_julea_db_dataset_query_add_field(selector, is_float, FALSE, (negate) ? J_DB_SELECTOR_OPERATOR_GE : J_DB_SELECTOR_OPERATOR_LT, value, TRUE, error);
+		case J_HDF5_QUERY_OPERATOR_LE:
+			return H5VL_julea_db_dataset_query_add_field(selector, is_float, FALSE, (negate) ? J_DB_SELECTOR_OPERATOR_GT : J_DB_SELECTOR_OPERATOR_LE, value, FALSE, error);
+		case J_HDF5_QUERY_OPERATOR_GT:
+			return H5VL_julea_db_dataset_query_add_field(selector, is_float, TRUE, (negate) ? J_DB_SELECTOR_OPERATOR_LE : J_DB_SELECTOR_OPERATOR_GT, value, FALSE, error);
+		case J_HDF5_QUERY_OPERATOR_GE:
+			return H5VL_julea_db_dataset_query_add_field(selector, is_float, TRUE, (negate) ? J_DB_SELECTOR_OPERATOR_LT : J_DB_SELECTOR_OPERATOR_GE, value, TRUE, error);
+		case J_HDF5_QUERY_OPERATOR_EQ:
+			if (!negate)
 			{
-				calculate_statistics_helper(((const gint16*)buf)[i], _i);
+				return H5VL_julea_db_dataset_query_add_field(selector, is_float, FALSE, J_DB_SELECTOR_OPERATOR_LE, value, FALSE, error)
+				       && H5VL_julea_db_dataset_query_add_field(selector, is_float, TRUE, J_DB_SELECTOR_OPERATOR_GE, value, TRUE, error);
 			}
-			else if (element_size == 4)
-			{
-				calculate_statistics_helper(((const gint32*)buf)[i], _i);
-			}
-			else if (element_size == 8)
+
+			// The minimum is greater or the maximum is smaller than the value
+			if (!(sub_selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_OR, error)))
 			{
-				calculate_statistics_helper(((const gint64*)buf)[i], _i);
+				return FALSE;
 			}
-		}
+
+			return H5VL_julea_db_dataset_query_add_field(sub_selector, is_float, FALSE, J_DB_SELECTOR_OPERATOR_GT, value, FALSE, error)
+			       && H5VL_julea_db_dataset_query_add_field(sub_selector, is_float, TRUE, J_DB_SELECTOR_OPERATOR_LT, value, TRUE, error)
+			       && j_db_selector_add_selector(selector, sub_selector, error);
+		default:
+			g_assert_not_reached();
 	}
+
+	return FALSE;
 }
 
-static herr_t
-H5VL_julea_db_dataset_write(void* obj, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id, hid_t xfer_plist_id, const void* buf, void** req)
+/**
+ * Returns the stored indexes of a dataset's chunks whose statistics may or cannot contain values matching a predicate, in ascending order.
+ *
+ * \param negate Whether to return the chunks that cannot contain matching values instead.
+ **/
+static GArray*
+H5VL_julea_db_dataset_query_chunks(JHDF5Object_t* object, gboolean is_float, JHDF5QueryOperator op, gdouble value, gboolean negate, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_autofree void* local_buf_org = NULL;
-	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(GArray) mem_space_arr = NULL;
-	g_autoptr(GArray) file_space_arr = NULL;
-	const void* local_buf;
-	guint64 bytes_written;
-	gsize data_size;
-	gsize data_count;
-	JHDF5Object_t* object = obj;
-	guint mem_space_idx;
-	guint file_space_idx;
-	JHDF5IndexRange* mem_space_range = NULL;
-	JHDF5IndexRange* file_space_range = NULL;
-	guint64 current_count1;
-	guint64 current_count2;
-	guint i;
-
-	(void)xfer_plist_id;
-	(void)req;
-
-	g_return_val_if_fail(buf != NULL, 1);
-	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
-
-	data_size = object->dataset.datatype->datatype.type_total_size;
+	g_autoptr(GArray) indexes = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	gchar const* fields[] = { "index", NULL };
 
-	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	if (!(selector = j_db_selector_new(julea_db_schema_chunk, J_DB_SELECTOR_MODE_AND, error)))
 	{
 		j_goto_error();
 	}
 
-	if (!(mem_space_arr = H5VL_julea_db_space_hdf5_to_range(mem_space_id, object->dataset.space->space.hdf5_id)))
+	if (!j_db_selector_add_field(selector, "dataset", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, error))
 	{
 		j_goto_error();
 	}
 
-	if (!(file_space_arr = H5VL_julea_db_space_hdf5_to_range(file_space_id, object->dataset.space->space.hdf5_id)))
+	if (!H5VL_julea_db_dataset_query_add_fields(selector, julea_db_schema_chunk, is_float, op, value, negate, error))
 	{
 		j_goto_error();
 	}
 
-	data_count = 0;
-
-	for (i = 0; i < mem_space_arr->len; i++)
+	if (!j_db_selector_set_fields(selector, fields, error))
 	{
-		mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, i);
-		data_count += mem_space_range->stop - mem_space_range->start;
+		j_goto_error();
 	}
 
-	local_buf_org = g_new(char, data_size* data_count);
-
-	local_buf = H5VL_julea_db_datatype_convert_type(mem_type_id, object->dataset.datatype->datatype.hdf5_id, buf, local_buf_org, data_count);
-	mem_space_idx = 0;
-	file_space_idx = 0;
-
-	while ((mem_space_idx < mem_space_arr->len) && (file_space_idx < file_space_arr->len))
+	// Adding the chunks in row-major order allows HDF5 to append to its selection
+	if (!j_db_selector_add_order(selector, "index", J_DB_SELECTOR_ORDER_ASCENDING, error))
 	{
-		if (mem_space_range == NULL)
-		{
-			mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, mem_space_idx++);
-		}
+		j_goto_error();
+	}
 
-		if (file_space_range == NULL)
-		{
-			file_space_range = &g_array_index(file_space_arr, JHDF5IndexRange, file_space_idx++);
-		}
+	if (!(iterator = j_db_iterator_new(julea_db_schema_chunk, selector, error)))
+	{
+		j_goto_error();
+	}
 
-		current_count1 = mem_space_range->stop - mem_space_range->start;
-		current_count2 = file_space_range->stop - file_space_range->start;
-		current_count1 = current_count1 < current_count2 ? current_count1 : current_count2;
-		calculate_statistics(object, ((const char*)local_buf) + mem_space_range->start * data_size, data_size * current_count1, mem_type_id);
-		j_distributed_object_write(object->dataset.object, ((const char*)local_buf) + mem_space_range->start * data_size, data_size * current_count1, file_space_range->start * data_size, &bytes_written, batch);
+	indexes = g_array_new(FALSE, FALSE, sizeof(guint64));
 
-		if (mem_space_range->start + current_count1 == mem_space_range->stop)
-		{
-			mem_space_range = NULL;
-		}
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		JDBType type;
+		guint64 len;
+		guint64* index;
 
-		if (file_space_range->start + current_count1 == file_space_range->stop)
+		if (!j_db_iterator_get_field(iterator, "index", &type, (gpointer*)&index, &len, error))
 		{
-			file_space_range = NULL;
+			j_goto_error();
 		}
-	}
 
-	if (!j_batch_execute(batch))
-	{
-		j_goto_error();
+		g_array_append_val(indexes, *index);
+		g_free(index);
 	}
 
-	return 0;
+	return g_steal_pointer(&indexes);
 
 _error:
-	return 1;
+	return NULL;
 }
 
-static herr_t
-H5VL_julea_db_dataset_read(void* obj, hid_t mem_type_id, hid_t mem_space_id, hid_t file_space_id, hid_t xfer_plist_id, void* buf, void** req)
+/**
+ * Selects the chunks of a dataset that may contain values matching a predicate.
+ *
+ * The statistics are answered by the database, so that chunks written by other processes are taken into account.
+ * The dataset's statistics are checked first, so that datasets without matching values are skipped without looking at their chunks.
+ *
+ * \return A copy of the dataset's dataspace with the candidate chunks selected.
+ **/
+static hid_t
+H5VL_julea_db_dataset_query(JHDF5Object_t* object, JHDF5QueryOperator op, gdouble value)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	g_autofree void* local_buf_org = NULL;
-	g_autoptr(JBatch) batch = NULL;
-	g_autoptr(GArray) mem_space_arr = NULL;
-	g_autoptr(GArray) file_space_arr = NULL;
-	const void* local_buf;
-	guint64 bytes_read;
-	gsize data_size;
-	gsize data_count;
-	JHDF5Object_t* object = obj;
-	guint mem_space_idx;
-	guint file_space_idx;
-	JHDF5IndexRange* mem_space_range = NULL;
-	JHDF5IndexRange* file_space_range = NULL;
-	guint64 current_count1;
-	guint64 current_count2;
+	g_autoptr(GError) error = NULL;
+	g_autoptr(GArray) candidates = NULL;
+	g_autoptr(GArray) excluded = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	JHDF5Statistics_t const zero = { 0, 0.0, 0, 0.0 };
+	hsize_t chunks_per_dim[H5S_MAX_RANK];
+	hsize_t start[H5S_MAX_RANK];
+	hsize_t count[H5S_MAX_RANK];
+	hsize_t block[H5S_MAX_RANK];
+	hid_t space_id = H5I_INVALID_HID;
+	guint64 chunks;
+	gboolean is_float;
 	guint i;
 
-	(void)xfer_plist_id;
-	(void)req;
+	if ((space_id = H5Scopy(object->dataset.space->space.hdf5_id)) < 0)
+	{
+		j_goto_error();
+	}
 
-	g_return_val_if_fail(buf != NULL, 1);
-	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
+	// Without statistics, every element is a candidate
+	if (object->dataset.statistics_func == NULL)
+	{
+		H5Sselect_all(space_id);
 
-	data_size = object->dataset.datatype->datatype.type_total_size;
+		return space_id;
+	}
 
-	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
+	// No value matches NaN
+	if (isnan(value))
+	{
+		H5Sselect_none(space_id);
+
+		return space_id;
+	}
+
+	// Statistics of local writes are stored first, so that the database also knows about them
+	if (!H5VL_julea_db_dataset_statistics_store(object, &error))
+	{
+		j_goto_error();
+	}
+
+	is_float = (H5Tget_class(object->dataset.datatype->datatype.hdf5_id) == H5T_FLOAT);
+
+	if (!(selector = j_db_selector_new(julea_db_schema_dataset, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
 	}
 
-	if (!(mem_space_arr = H5VL_julea_db_space_hdf5_to_range(mem_space_id, object->dataset.space->space.hdf5_id)))
+	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
 	{
 		j_goto_error();
 	}
 
-	if (!(file_space_arr = H5VL_julea_db_space_hdf5_to_range(file_space_id, object->dataset.space->space.hdf5_id)))
+	if (!H5VL_julea_db_dataset_query_add_fields(selector, julea_db_schema_dataset, is_float, op, value, FALSE, &error))
+	{
+		j_goto_error();
+	}
+
+	if (!(iterator = j_db_iterator_new(julea_db_schema_dataset, selector, &error)))
 	{
 		j_goto_error();
 	}
 
-	data_count = 0;
+	if (!j_db_iterator_next(iterator, NULL))
+	{
+		H5Sselect_none(space_id);
+
+		return space_id;
+	}
 
-	for (i = 0; i < mem_space_arr->len; i++)
+	if (H5Sget_simple_extent_ndims(space_id) == 0)
 	{
-		mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, i);
-		data_count += mem_space_range->stop - mem_space_range->start;
+		H5Sselect_all(space_id);
+
+		return space_id;
 	}
 
-	local_buf_org = g_new(char, data_size* data_count);
+	chunks = 1;
 
-	mem_space_idx = 0;
-	file_space_idx = 0;
+	for (i = 0; i < object->dataset.ndims; i++)
+	{
+		chunks_per_dim[i] = (object->dataset.dims[i] + object->dataset.chunk_dims[i] - 1) / object->dataset.chunk_dims[i];
+		chunks *= chunks_per_dim[i];
+		count[i] = 1;
+	}
 
-	while ((mem_space_idx < mem_space_arr->len) && (file_space_idx < file_space_arr->len))
+	if (H5VL_julea_db_dataset_query_match(&zero, is_float, op, value))
 	{
-		if (mem_space_range == NULL)
-		{
-			mem_space_range = &g_array_index(mem_space_arr, JHDF5IndexRange, mem_space_idx++);
-		}
+		guint j = 0;
 
-		if (file_space_range == NULL)
+		// Chunks that have never been written only contain zeros, so only the stored chunks without matching values are excluded
+		if (!(excluded = H5VL_julea_db_dataset_query_chunks(object, is_float, op, value, TRUE, &error)))
 		{
-			file_space_range = &g_array_index(file_space_arr, JHDF5IndexRange, file_space_idx++);
+			j_goto_error();
 		}
 
-		current_count1 = mem_space_range->stop - mem_space_range->start;
-		current_count2 = file_space_range->stop - file_space_range->start;
-		current_count1 = current_count1 < current_count2 ? current_count1 : current_count2;
-		j_distributed_object_read(object->dataset.object, ((char*)buf) + mem_space_range->start * data_size, data_size * current_count1, file_space_range->start * data_size, &bytes_read, batch);
+		candidates = g_array_new(FALSE, FALSE, sizeof(guint64));
 
-		if (mem_space_range->start + current_count1 == mem_space_range->stop)
+		for (guint64 index = 0; index < chunks; index++)
 		{
-			mem_space_range = NULL;
-		}
+			if (j < excluded->len && g_array_index(excluded, guint64, j) == index)
+			{
+				j++;
+				continue;
+			}
 
-		if (file_space_range->start + current_count1 == file_space_range->stop)
-		{
-			file_space_range = NULL;
+			g_array_append_val(candidates, index);
 		}
 	}
-
-	if (!j_batch_execute(batch))
+	else if (!(candidates = H5VL_julea_db_dataset_query_chunks(object, is_float, op, value, FALSE, &error)))
 	{
 		j_goto_error();
 	}
 
-	local_buf = H5VL_julea_db_datatype_convert_type(mem_type_id, object->dataset.datatype->datatype.hdf5_id, buf, local_buf_org, data_count);
-
-	if (local_buf != buf)
+	if (candidates->len == chunks)
 	{
-		memcpy(buf, local_buf, data_size * data_count);
+		H5Sselect_all(space_id);
+
+		return space_id;
 	}
 
-	return 0;
+	H5Sselect_none(space_id);
 
-_error:
-	return 1;
-}
+	for (i = 0; i < candidates->len; i++)
+	{
+		guint64 index = g_array_index(candidates, guint64, i);
 
-static herr_t
-H5VL_julea_db_dataset_get(void* obj, H5VL_dataset_get_t get_type, hid_t dxpl_id, void** req, va_list arguments)
-{
-	J_TRACE_FUNCTION(NULL);
+		for (guint j = object->dataset.ndims; j > 0; j--)
+		{
+			start[j - 1] = (index % chunks_per_dim[j - 1]) * object->dataset.chunk_dims[j - 1];
+			block[j - 1] = MIN(object->dataset.chunk_dims[j - 1], object->dataset.dims[j - 1] - start[j - 1]);
+			index /= chunks_per_dim[j - 1];
+		}
 
-	JHDF5Object_t* object = obj;
+		if (H5Sselect_hyperslab(space_id, H5S_SELECT_OR, start, NULL, count, block) < 0)
+		{
+			j_goto_error();
+		}
+	}
 
-	(void)dxpl_id;
-	(void)req;
+	return space_id;
 
-	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
+_error:
+	H5VL_julea_db_error_handler(error);
 
-	switch (get_type)
+	if (space_id >= 0)
 	{
-		case H5VL_DATASET_GET_SPACE:
-			*(va_arg(arguments, hid_t*)) = object->dataset.space->space.hdf5_id;
-			break;
-		case H5VL_DATASET_GET_TYPE:
-			*(va_arg(arguments, hid_t*)) = object->dataset.datatype->datatype.hdf5_id;
-			break;
-		case H5VL_DATASET_GET_DAPL:
-		case H5VL_DATASET_GET_DCPL:
-		case H5VL_DATASET_GET_SPACE_STATUS:
-		case H5VL_DATASET_GET_STORAGE_SIZE:
-		default:
-			g_assert_not_reached();
+		H5Sclose(space_id);
 	}
 
-	return 0;
+	return H5I_INVALID_HID;
 }
 
 static herr_t
-H5VL_julea_db_dataset_specific(void* obj, H5VL_dataset_specific_t specific_type, hid_t dxpl_id, void** req, va_list arguments)
+H5VL_julea_db_dataset_optional(void* obj, H5VL_dataset_optional_t opt_type, hid_t dxpl_id, void** req, va_list arguments)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JHDF5Object_t* object = obj;
 
-	(void)specific_type;
 	(void)dxpl_id;
 	(void)req;
-	(void)arguments;
 
 	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
 
-	g_critical("%s NOT implemented !!", G_STRLOC);
-	g_assert_not_reached();
-}
-
-static herr_t
-H5VL_julea_db_dataset_optional(void* obj, H5VL_dataset_optional_t opt_type, hid_t dxpl_id, void** req, va_list arguments)
-{
-	J_TRACE_FUNCTION(NULL);
+	// The query operation's value is registered at runtime and cannot be used as a case label
+	if (opt_type == j_hdf5_dataset_query_operation())
+	{
+		JHDF5QueryOperator op;
+		gdouble value;
+		hid_t* selection;
 
-	JHDF5Object_t* object = obj;
+		op = va_arg(arguments, gint);
+		value = va_arg(arguments, gdouble);
+		selection = va_arg(arguments, hid_t*);
 
-	(void)opt_type;
-	(void)dxpl_id;
-	(void)req;
-	(void)arguments;
+		if ((*selection = H5VL_julea_db_dataset_query(object, op, value)) < 0)
+		{
+			j_goto_error();
+		}
+	}
+	else
+	{
+		g_critical("%s NOT implemented !!", G_STRLOC);
+		g_assert_not_reached();
+	}
 
-	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
+	return 0;
 
-	g_critical("%s NOT implemented !!", G_STRLOC);
-	g_assert_not_reached();
+_error:
+	return 1;
 }
 
 static herr_t
@@ -1171,62 +3264,14 @@ H5VL_julea_db_dataset_close(void* obj, hid_t dxpl_id, void** req)
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(GError) error = NULL;
-	g_autoptr(JBatch) batch = NULL;
 	JHDF5Object_t* object = obj;
-	g_autoptr(JDBEntry) entry = NULL;
-	g_autoptr(JDBSelector) selector = NULL;
 
 	(void)dxpl_id;
 	(void)req;
 
 	g_return_val_if_fail(object->type == J_HDF5_OBJECT_TYPE_DATASET, 1);
 
-	if (!(batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT)))
-	{
-		j_goto_error();
-	}
-
-	if (!(selector = j_db_selector_new(julea_db_schema_dataset, J_DB_SELECTOR_MODE_AND, &error)))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, object->backend_id, object->backend_id_len, &error))
-	{
-		j_goto_error();
-	}
-
-	if (!(entry = j_db_entry_new(julea_db_schema_dataset, &error)))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_set_field(entry, "min_value_i", &object->dataset.statistics.min_value_i, sizeof(object->dataset.statistics.min_value_i), &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_set_field(entry, "max_value_i", &object->dataset.statistics.max_value_i, sizeof(object->dataset.statistics.max_value_i), &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_set_field(entry, "min_value_f", &object->dataset.statistics.min_value_f, sizeof(object->dataset.statistics.min_value_f), &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_set_field(entry, "max_value_f", &object->dataset.statistics.max_value_f, sizeof(object->dataset.statistics.max_value_f), &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_db_entry_update(entry, selector, batch, &error))
-	{
-		j_goto_error();
-	}
-
-	if (!j_batch_execute(batch))
+	if (!H5VL_julea_db_dataset_statistics_store(object, &error))
 	{
 		j_goto_error();
 	}
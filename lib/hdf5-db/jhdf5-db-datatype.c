@@ -44,25 +44,52 @@
 
 static JDBSchema* julea_db_schema_datatype_header = NULL;
 
-static const void*
-H5VL_julea_db_datatype_convert_type_change(hid_t type_id_from, hid_t type_id_to, const char* from_buf, char* target_buf, guint count)
+/**
+ * Checks whether data of one datatype can be used as data of another datatype without conversion.
+ * This is the case for equal datatypes as well as for numeric datatypes with the same memory layout.
+ *
+ * \return TRUE if no conversion is necessary, FALSE if it is and a negative value on error.
+ **/
+static htri_t
+H5VL_julea_db_datatype_is_compatible(hid_t type_id_from, hid_t type_id_to)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	(void)from_buf;
-	(void)count;
+	htri_t equal;
+	H5T_class_t clazz;
+	size_t fields_from[5];
+	size_t fields_to[5];
 
-	g_assert(H5Tget_class(type_id_from) == H5Tget_class(type_id_to));
-	g_assert(H5Tget_size(type_id_from) == H5Tget_size(type_id_to));
+	if ((equal = H5Tequal(type_id_from, type_id_to)) != 0)
+	{
+		return equal;
+	}
+
+	clazz = H5Tget_class(type_id_from);
 
-	// FIXME doesn't do anything?
+	if (clazz != H5Tget_class(type_id_to)
+	    || H5Tget_size(type_id_from) != H5Tget_size(type_id_to)
+	    || H5Tget_order(type_id_from) != H5Tget_order(type_id_to)
+	    || H5Tget_precision(type_id_from) != H5Tget_precision(type_id_to)
+	    || H5Tget_offset(type_id_from) != H5Tget_offset(type_id_to))
+	{
+		return FALSE;
+	}
 
-	switch (H5Tget_class(type_id_from))
+	switch (clazz)
 	{
-		case H5T_FLOAT: // no conversion
-			break;
-		case H5T_INTEGER: // no conversion
-			break;
+		case H5T_INTEGER:
+			return H5Tget_sign(type_id_from) == H5Tget_sign(type_id_to);
+		case H5T_FLOAT:
+			if (H5Tget_fields(type_id_from, &fields_from[0], &fields_from[1], &fields_from[2], &fields_from[3], &fields_from[4]) < 0
+			    || H5Tget_fields(type_id_to, &fields_to[0], &fields_to[1], &fields_to[2], &fields_to[3], &fields_to[4]) < 0)
+			{
+				return -1;
+			}
+
+			return memcmp(fields_from, fields_to, sizeof(fields_from)) == 0
+			       && H5Tget_ebias(type_id_from) == H5Tget_ebias(type_id_to)
+			       && H5Tget_norm(type_id_from) == H5Tget_norm(type_id_to);
 		case H5T_STRING:
 		case H5T_BITFIELD:
 		case H5T_OPAQUE:
@@ -75,24 +102,8 @@ H5VL_julea_db_datatype_convert_type_change(hid_t type_id_from, hid_t type_id_to,
 		case H5T_TIME:
 		case H5T_NCLASSES:
 		default:
-			g_critical("%s NOT implemented !!", G_STRLOC);
-			g_assert_not_reached();
+			return FALSE;
 	}
-
-	return target_buf;
-}
-
-static const void*
-H5VL_julea_db_datatype_convert_type(hid_t type_id_from, hid_t type_id_to, const char* from_buf, char* tmp_buf, guint count)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	if (H5Tequal(type_id_from, type_id_to))
-	{
-		return from_buf;
-	}
-
-	return H5VL_julea_db_datatype_convert_type_change(type_id_from, type_id_to, from_buf, tmp_buf, count);
 }
 
 static herr_t
@@ -241,7 +252,7 @@ _error:
 }
 
 static JHDF5Object_t*
-H5VL_julea_db_datatype_decode(void* backend_id, guint64 backend_id_len)
+H5VL_julea_db_datatype_decode(JHDF5Object_t* file, void* backend_id, guint64 backend_id_len)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -253,6 +264,13 @@ H5VL_julea_db_datatype_decode(void* backend_id, guint64 backend_id_len)
 	JDBType type;
 	guint64 length;
 
+	g_return_val_if_fail(file != NULL, NULL);
+
+	if ((object = H5VL_julea_db_cache_object_lookup(file, J_HDF5_OBJECT_TYPE_DATATYPE, FALSE, backend_id, backend_id_len)) != NULL)
+	{
+		return object;
+	}
+
 	if (!(object = H5VL_julea_db_object_new(J_HDF5_OBJECT_TYPE_DATATYPE)))
 	{
 		j_goto_error();
@@ -303,6 +321,8 @@ H5VL_julea_db_datatype_decode(void* backend_id, guint64 backend_id_len)
 		j_goto_error();
 	}
 
+	H5VL_julea_db_cache_object_insert(file, object);
+
 	return object;
 
 _error:
@@ -313,7 +333,7 @@ _error:
 }
 
 static JHDF5Object_t*
-H5VL_julea_db_datatype_encode(hid_t* type_id)
+H5VL_julea_db_datatype_encode(JHDF5Object_t* file, hid_t* type_id)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -323,11 +343,13 @@ H5VL_julea_db_datatype_encode(hid_t* type_id)
 	g_autoptr(JDBIterator) iterator = NULL;
 	g_autoptr(JDBSelector) selector = NULL;
 	JHDF5Object_t* object = NULL;
+	JHDF5Object_t* cached;
 	JDBType type;
 	size_t size;
 	guint i;
 	H5T_class_t clazz;
 
+	g_return_val_if_fail(file != NULL, NULL);
 	g_return_val_if_fail(type_id != NULL, NULL);
 	g_return_val_if_fail(*type_id != -1, NULL);
 
@@ -351,7 +373,17 @@ H5VL_julea_db_datatype_encode(hid_t* type_id)
 	}
 
 	H5Tencode(*type_id, object->datatype.data, &size);
-	object->datatype.hdf5_id = *type_id;
+	object->datatype.data_size = size;
+
+	if ((cached = H5VL_julea_db_cache_object_lookup(file, J_HDF5_OBJECT_TYPE_DATATYPE, TRUE, object->datatype.data, size)) != NULL)
+	{
+		H5VL_julea_db_object_unref(object);
+
+		return cached;
+	}
+
+	// The caller might close its type while the object is still in use
+	object->datatype.hdf5_id = H5Tcopy(*type_id);
 
 	//check if this datatype exists
 	if (!(selector = j_db_selector_new(julea_db_schema_datatype_header, J_DB_SELECTOR_MODE_AND, &error)))
@@ -499,6 +531,8 @@ H5VL_julea_db_datatype_encode(hid_t* type_id)
 	}
 
 _done:
+	H5VL_julea_db_cache_object_insert(file, object);
+
 	return object;
 
 _error:
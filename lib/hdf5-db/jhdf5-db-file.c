@@ -185,6 +185,8 @@ H5VL_julea_db_file_create(const char* name, unsigned flags, hid_t fcpl_id, hid_t
 		j_goto_error();
 	}
 
+	H5VL_julea_db_cache_init(object);
+
 	if (!(selector = j_db_selector_new(julea_db_schema_file, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
@@ -223,6 +225,8 @@ H5VL_julea_db_file_create(const char* name, unsigned flags, hid_t fcpl_id, hid_t
 			j_goto_error();
 		}
 
+		H5VL_julea_db_cache_init(object);
+
 		if (!(entry = j_db_entry_new(julea_db_schema_file, &error)))
 		{
 			j_goto_error();
@@ -324,6 +328,8 @@ H5VL_julea_db_file_open(const char* name, unsigned flags, hid_t fapl_id, hid_t d
 		j_goto_error();
 	}
 
+	H5VL_julea_db_cache_init(object);
+
 	if (!(selector = j_db_selector_new(julea_db_schema_file, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
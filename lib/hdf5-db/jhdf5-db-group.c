@@ -199,7 +199,7 @@ H5VL_julea_db_group_truncate_file(void* obj)
 		j_goto_error();
 	}
 
-	if (!j_db_entry_delete(entry, selector, batch, &error))
+	if (!j_db_entry_delete(entry, selector, NULL, batch, &error))
 	{
 		j_goto_error();
 	}
@@ -238,7 +238,7 @@ H5VL_julea_db_link_truncate_file(void* obj)
 		j_goto_error();
 	}
 
-	if (!j_db_entry_delete(entry, selector, batch, &error))
+	if (!j_db_entry_delete(entry, selector, NULL, batch, &error))
 	{
 		j_goto_error();
 	}
@@ -251,6 +251,8 @@ H5VL_julea_db_link_truncate_file(void* obj)
 		}
 	}
 
+	H5VL_julea_db_cache_link_remove_all(file);
+
 	return 0;
 
 _error:
@@ -316,6 +318,11 @@ H5VL_julea_db_link_get_helper(JHDF5Object_t* parent, JHDF5Object_t* child, const
 			j_goto_error();
 	}
 
+	if (H5VL_julea_db_cache_link_lookup(file, parent, name, &child->backend_id, &child->backend_id_len))
+	{
+		return TRUE;
+	}
+
 	if (!(selector = j_db_selector_new(julea_db_schema_link, J_DB_SELECTOR_MODE_AND, &error)))
 	{
 		j_goto_error();
@@ -355,6 +362,8 @@ H5VL_julea_db_link_get_helper(JHDF5Object_t* parent, JHDF5Object_t* child, const
 	//TODO g_assert (iteartor->'child_type' == child->type)
 	g_assert(!j_db_iterator_next(iterator, NULL));
 
+	H5VL_julea_db_cache_link_insert(file, parent, name, child->backend_id, child->backend_id_len);
+
 	return TRUE;
 
 _error:
@@ -363,6 +372,130 @@ _error:
 	return FALSE;
 }
 
+/**
+ * Looks up the child linked to parent by name and returns an iterator positioned at the child's entry in schema.
+ * The link and the child's entry are retrieved using a single query joining both schemas.
+ * Sets the child's backend ID.
+ **/
+static JDBIterator*
+H5VL_julea_db_link_get_iterator(JHDF5Object_t* parent, JHDF5Object_t* child, const char* name, JDBSchema* schema)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gchar const* link_fields[] = { "child", NULL };
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBSelector) link_selector = NULL;
+	JHDF5Object_t* file;
+	JDBType type;
+	gboolean cached;
+
+	g_return_val_if_fail(name != NULL, NULL);
+	g_return_val_if_fail(parent != NULL, NULL);
+	g_return_val_if_fail(child != NULL, NULL);
+	g_return_val_if_fail(schema != NULL, NULL);
+
+	switch (parent->type)
+	{
+		case J_HDF5_OBJECT_TYPE_FILE:
+			file = parent;
+			break;
+		case J_HDF5_OBJECT_TYPE_DATASET:
+			file = parent->dataset.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_ATTR:
+			file = parent->attr.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_GROUP:
+			file = parent->group.file;
+			break;
+		case J_HDF5_OBJECT_TYPE_DATATYPE:
+		case J_HDF5_OBJECT_TYPE_SPACE:
+		case _J_HDF5_OBJECT_TYPE_COUNT:
+		default:
+			g_assert_not_reached();
+			j_goto_error();
+	}
+
+	if (!(selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error)))
+	{
+		j_goto_error();
+	}
+
+	cached = H5VL_julea_db_cache_link_lookup(file, parent, name, &child->backend_id, &child->backend_id_len);
+
+	if (cached)
+	{
+		if (!j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, child->backend_id, child->backend_id_len, &error))
+		{
+			j_goto_error();
+		}
+	}
+	else
+	{
+		if (!(link_selector = j_db_selector_new(julea_db_schema_link, J_DB_SELECTOR_MODE_AND, &error)))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_selector_add_field(link_selector, "parent", J_DB_SELECTOR_OPERATOR_EQ, parent->backend_id, parent->backend_id_len, &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_selector_add_field(link_selector, "parent_type", J_DB_SELECTOR_OPERATOR_EQ, &parent->type, sizeof(parent->type), &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_selector_add_field(link_selector, "name", J_DB_SELECTOR_OPERATOR_EQ, name, strlen(name), &error))
+		{
+			j_goto_error();
+		}
+
+		if (!j_db_selector_set_fields(link_selector, link_fields, &error))
+		{
+			j_goto_error();
+		}
+
+		// All HDF5 schemas share a namespace and are therefore stored on the same server
+		if (!j_db_selector_add_join(selector, "_id", link_selector, "child", &error))
+		{
+			j_goto_error();
+		}
+	}
+
+	if (!(iterator = j_db_iterator_new(schema, selector, &error)))
+	{
+		j_goto_error();
+	}
+
+	if (!j_db_iterator_next(iterator, &error))
+	{
+		//name must exist for parent before
+		j_goto_error();
+	}
+
+	if (!cached)
+	{
+		if (!j_db_iterator_get_field(iterator, "link.child", &type, &child->backend_id, &child->backend_id_len, &error))
+		{
+			j_goto_error();
+		}
+
+		H5VL_julea_db_cache_link_insert(file, parent, name, child->backend_id, child->backend_id_len);
+	}
+
+	return g_steal_pointer(&iterator);
+
+_error:
+	H5VL_julea_db_error_handler(error);
+
+	return NULL;
+}
+
 static gboolean
 H5VL_julea_db_link_create_helper(JHDF5Object_t* parent, JHDF5Object_t* child, const char* name)
 {
@@ -502,6 +635,8 @@ H5VL_julea_db_link_create_helper(JHDF5Object_t* parent, JHDF5Object_t* child, co
 		j_goto_error();
 	}
 
+	H5VL_julea_db_cache_link_insert(file, parent, name, child->backend_id, child->backend_id_len);
+
 	return TRUE;
 
 _error:
@@ -120,6 +120,17 @@ H5VL_julea_db_object_unref(JHDF5Object_t* object)
 		{
 			case J_HDF5_OBJECT_TYPE_FILE:
 				g_free(object->file.name);
+
+				if (object->file.links)
+				{
+					g_hash_table_unref(object->file.links);
+				}
+
+				if (object->file.objects)
+				{
+					g_hash_table_unref(object->file.objects);
+				}
+
 				break;
 			case J_HDF5_OBJECT_TYPE_DATASET:
 				H5VL_julea_db_object_unref(object->dataset.file);
@@ -138,6 +149,19 @@ H5VL_julea_db_object_unref(JHDF5Object_t* object)
 					j_distributed_object_unref(object->dataset.object);
 				}
 
+				if (object->dataset.chunks)
+				{
+					g_hash_table_unref(object->dataset.chunks);
+				}
+
+				if (object->dataset.batches)
+				{
+					g_ptr_array_unref(object->dataset.batches);
+				}
+
+				g_free(object->dataset.dims);
+				g_free(object->dataset.chunk_dims);
+
 				break;
 			case J_HDF5_OBJECT_TYPE_ATTR:
 				H5VL_julea_db_object_unref(object->attr.file);
@@ -153,9 +177,21 @@ H5VL_julea_db_object_unref(JHDF5Object_t* object)
 				break;
 			case J_HDF5_OBJECT_TYPE_DATATYPE:
 				g_free(object->datatype.data);
+
+				if (object->datatype.hdf5_id > 0)
+				{
+					H5Tclose(object->datatype.hdf5_id);
+				}
+
 				break;
 			case J_HDF5_OBJECT_TYPE_SPACE:
 				g_free(object->space.data);
+
+				if (object->space.hdf5_id > 0)
+				{
+					H5Sclose(object->space.hdf5_id);
+				}
+
 				break;
 			case _J_HDF5_OBJECT_TYPE_COUNT:
 			default:
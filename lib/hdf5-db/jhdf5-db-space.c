@@ -214,7 +214,7 @@ _error:
 }
 
 static JHDF5Object_t*
-H5VL_julea_db_space_decode(void* backend_id, guint64 backend_id_len)
+H5VL_julea_db_space_decode(JHDF5Object_t* file, void* backend_id, guint64 backend_id_len)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -226,6 +226,13 @@ H5VL_julea_db_space_decode(void* backend_id, guint64 backend_id_len)
 	JDBType type;
 	guint64 length;
 
+	g_return_val_if_fail(file != NULL, NULL);
+
+	if ((object = H5VL_julea_db_cache_object_lookup(file, J_HDF5_OBJECT_TYPE_SPACE, FALSE, backend_id, backend_id_len)) != NULL)
+	{
+		return object;
+	}
+
 	if (!(object = H5VL_julea_db_object_new(J_HDF5_OBJECT_TYPE_SPACE)))
 	{
 		j_goto_error();
@@ -272,6 +279,8 @@ H5VL_julea_db_space_decode(void* backend_id, guint64 backend_id_len)
 	object->space.dim_total_count = *tmp_uint32;
 	object->space.hdf5_id = H5Sdecode(object->space.data);
 
+	H5VL_julea_db_cache_object_insert(file, object);
+
 	return object;
 
 _error:
@@ -282,7 +291,7 @@ _error:
 }
 
 static JHDF5Object_t*
-H5VL_julea_db_space_encode(hid_t* type_id)
+H5VL_julea_db_space_encode(JHDF5Object_t* file, hid_t* type_id)
 {
 	J_TRACE_FUNCTION(NULL);
 
@@ -295,11 +304,13 @@ H5VL_julea_db_space_encode(hid_t* type_id)
 	gint stored_ndims;
 	guint element_count;
 	JHDF5Object_t* object = NULL;
+	JHDF5Object_t* cached;
 	JDBType type;
 	size_t size;
 	guint i;
 	guint j;
 
+	g_return_val_if_fail(file != NULL, NULL);
 	g_return_val_if_fail(type_id != NULL, NULL);
 	g_return_val_if_fail(*type_id != -1, NULL);
 
@@ -348,7 +359,17 @@ H5VL_julea_db_space_encode(hid_t* type_id)
 		H5Sencode(*type_id, object->space.data, &size);
 	}
 
-	object->space.hdf5_id = *type_id;
+	object->space.data_size = size;
+
+	if ((cached = H5VL_julea_db_cache_object_lookup(file, J_HDF5_OBJECT_TYPE_SPACE, TRUE, object->space.data, size)) != NULL)
+	{
+		H5VL_julea_db_object_unref(object);
+
+		return cached;
+	}
+
+	// The caller might close its space while the object is still in use
+	object->space.hdf5_id = H5Scopy(*type_id);
 	object->space.dim_total_count = element_count;
 
 	//check if this space exists
@@ -456,6 +477,8 @@ H5VL_julea_db_space_encode(hid_t* type_id)
 	}
 
 _done:
+	H5VL_julea_db_cache_object_insert(file, object);
+
 	return object;
 
 _error:
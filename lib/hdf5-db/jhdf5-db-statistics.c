@@ -0,0 +1,276 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Min/max statistics kernels for the supported dataset types.
+ *
+ * Every kernel folds a buffer of elements into existing statistics, integers are accumulated in the _i fields and floating point numbers in the _f fields.
+ * NaNs are ignored.
+ * The kernel is chosen once per dataset using the stored datatype and the CPU's features.
+ * The JULEA_HDF5_STATISTICS environment variable limits the kernels to scalar or sse4.1 ones, for example, to compare them.
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+
+#include <math.h>
+
+#include <julea.h>
+#include <julea-object.h>
+
+#include "jhdf5-db.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define J_HDF5_STATISTICS_X86
+#include <immintrin.h>
+#endif
+
+// Comparisons are written so that NaNs never replace the current value
+#define J_HDF5_STATISTICS_MERGE(_value, _min, _max) \
+	do \
+	{ \
+		_min = ((_value) < (_min)) ? (_value) : (_min); \
+		_max = ((_value) > (_max)) ? (_value) : (_max); \
+	} while (0)
+
+#define J_HDF5_STATISTICS_SCALAR(_name, _type, _target, _ext) \
+	static void \
+	H5VL_julea_db_statistics_##_name##_scalar(JHDF5Statistics_t* statistics, const void* buf, guint64 count) \
+	{ \
+		const _type* data = buf; \
+		_target min = statistics->min_value##_ext; \
+		_target max = statistics->max_value##_ext; \
+		guint64 i; \
+\
+		for (i = 0; i < count; i++) \
+		{ \
+			_target value = (_target)data[i]; \
+\
+			J_HDF5_STATISTICS_MERGE(value, min, max); \
+		} \
+\
+		statistics->min_value##_ext = min; \
+		statistics->max_value##_ext = max; \
+	}
+
+J_HDF5_STATISTICS_SCALAR(i8, gint8, gint64, _i)
+J_HDF5_STATISTICS_SCALAR(u8, guint8, gint64, _i)
+J_HDF5_STATISTICS_SCALAR(i16, gint16, gint64, _i)
+J_HDF5_STATISTICS_SCALAR(u16, guint16, gint64, _i)
+J_HDF5_STATISTICS_SCALAR(i32, gint32, gint64, _i)
+J_HDF5_STATISTICS_SCALAR(u32, guint32, gint64, _i)
+J_HDF5_STATISTICS_SCALAR(i64, gint64, gint64, _i)
+J_HDF5_STATISTICS_SCALAR(f32, gfloat, gdouble, _f)
+J_HDF5_STATISTICS_SCALAR(f64, gdouble, gdouble, _f)
+
+#ifdef J_HDF5_STATISTICS_X86
+
+/*
+ * The vector kernels keep one minimum and maximum per lane and reduce the lanes at the end.
+ * The accumulators start at the type's extremes, which also keeps NaNs out of them because the new value is passed as the first operand.
+ */
+#define J_HDF5_STATISTICS_VECTOR(_name, _isa, _target_isa, _type, _target, _ext, _vec, _lanes, _set1, _load, _store, _min, _max, _type_min, _type_max) \
+	static __attribute__((target(_target_isa))) void \
+	H5VL_julea_db_statistics_##_name##_##_isa(JHDF5Statistics_t* statistics, const void* buf, guint64 count) \
+	{ \
+		const _type* data = buf; \
+		_type lanes_min[_lanes]; \
+		_type lanes_max[_lanes]; \
+		_target min = statistics->min_value##_ext; \
+		_target max = statistics->max_value##_ext; \
+		_vec vector_min = _set1(_type_max); \
+		_vec vector_max = _set1(_type_min); \
+		guint64 i; \
+\
+		for (i = 0; i + (_lanes) <= count; i += (_lanes)) \
+		{ \
+			_vec value = _load(data + i); \
+\
+			vector_min = _min(value, vector_min); \
+			vector_max = _max(value, vector_max); \
+		} \
+\
+		_store(lanes_min, vector_min); \
+		_store(lanes_max, vector_max); \
+\
+		for (guint j = 0; j < (_lanes); j++) \
+		{ \
+			_target value_min = (_target)lanes_min[j]; \
+			_target value_max = (_target)lanes_max[j]; \
+\
+			min = (value_min < min) ? value_min : min; \
+			max = (value_max > max) ? value_max : max; \
+		} \
+\
+		for (; i < count; i++) \
+		{ \
+			_target value = (_target)data[i]; \
+\
+			J_HDF5_STATISTICS_MERGE(value, min, max); \
+		} \
+\
+		statistics->min_value##_ext = min; \
+		statistics->max_value##_ext = max; \
+	}
+
+#define j_sse_loadu_si(p) _mm_loadu_si128((const __m128i*)(const void*)(p))
+#define j_sse_storeu_si(p, v) _mm_storeu_si128((__m128i*)(void*)(p), (v))
+#define j_avx_loadu_si(p) _mm256_loadu_si256((const __m256i*)(const void*)(p))
+#define j_avx_storeu_si(p, v) _mm256_storeu_si256((__m256i*)(void*)(p), (v))
+
+// The set1 intrinsics take signed arguments, the unsigned extremes are reinterpreted accordingly
+J_HDF5_STATISTICS_VECTOR(i8, sse41, "sse4.1", gint8, gint64, _i, __m128i, 16, _mm_set1_epi8, j_sse_loadu_si, j_sse_storeu_si, _mm_min_epi8, _mm_max_epi8, G_MININT8, G_MAXINT8)
+J_HDF5_STATISTICS_VECTOR(u8, sse41, "sse4.1", guint8, gint64, _i, __m128i, 16, _mm_set1_epi8, j_sse_loadu_si, j_sse_storeu_si, _mm_min_epu8, _mm_max_epu8, 0, -1)
+J_HDF5_STATISTICS_VECTOR(i16, sse41, "sse4.1", gint16, gint64, _i, __m128i, 8, _mm_set1_epi16, j_sse_loadu_si, j_sse_storeu_si, _mm_min_epi16, _mm_max_epi16, G_MININT16, G_MAXINT16)
+J_HDF5_STATISTICS_VECTOR(u16, sse41, "sse4.1", guint16, gint64, _i, __m128i, 8, _mm_set1_epi16, j_sse_loadu_si, j_sse_storeu_si, _mm_min_epu16, _mm_max_epu16, 0, -1)
+J_HDF5_STATISTICS_VECTOR(i32, sse41, "sse4.1", gint32, gint64, _i, __m128i, 4, _mm_set1_epi32, j_sse_loadu_si, j_sse_storeu_si, _mm_min_epi32, _mm_max_epi32, G_MININT32, G_MAXINT32)
+J_HDF5_STATISTICS_VECTOR(u32, sse41, "sse4.1", guint32, gint64, _i, __m128i, 4, _mm_set1_epi32, j_sse_loadu_si, j_sse_storeu_si, _mm_min_epu32, _mm_max_epu32, 0, -1)
+J_HDF5_STATISTICS_VECTOR(f32, sse41, "sse4.1", gfloat, gdouble, _f, __m128, 4, _mm_set1_ps, _mm_loadu_ps, _mm_storeu_ps, _mm_min_ps, _mm_max_ps, -INFINITY, INFINITY)
+J_HDF5_STATISTICS_VECTOR(f64, sse41, "sse4.1", gdouble, gdouble, _f, __m128d, 2, _mm_set1_pd, _mm_loadu_pd, _mm_storeu_pd, _mm_min_pd, _mm_max_pd, -INFINITY, INFINITY)
+
+// AVX2 has no 64-bit integer min/max, it is built from a comparison and a blend
+static inline __attribute__((target("avx2"))) __m256i
+j_avx_min_epi64(__m256i a, __m256i b)
+{
+	return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+static inline __attribute__((target("avx2"))) __m256i
+j_avx_max_epi64(__m256i a, __m256i b)
+{
+	return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+
+J_HDF5_STATISTICS_VECTOR(i8, avx2, "avx2", gint8, gint64, _i, __m256i, 32, _mm256_set1_epi8, j_avx_loadu_si, j_avx_storeu_si, _mm256_min_epi8, _mm256_max_epi8, G_MININT8, G_MAXINT8)
+J_HDF5_STATISTICS_VECTOR(u8, avx2, "avx2", guint8, gint64, _i, __m256i, 32, _mm256_set1_epi8, j_avx_loadu_si, j_avx_storeu_si, _mm256_min_epu8, _mm256_max_epu8, 0, -1)
+J_HDF5_STATISTICS_VECTOR(i16, avx2, "avx2", gint16, gint64, _i, __m256i, 16, _mm256_set1_epi16, j_avx_loadu_si, j_avx_storeu_si, _mm256_min_epi16, _mm256_max_epi16, G_MININT16, G_MAXINT16)
+J_HDF5_STATISTICS_VECTOR(u16, avx2, "avx2", guint16, gint64, _i, __m256i, 16, _mm256_set1_epi16, j_avx_loadu_si, j_avx_storeu_si, _mm256_min_epu16, _mm256_max_epu16, 0, -1)
+J_HDF5_STATISTICS_VECTOR(i32, avx2, "avx2", gint32, gint64, _i, __m256i, 8, _mm256_set1_epi32, j_avx_loadu_si, j_avx_storeu_si, _mm256_min_epi32, _mm256_max_epi32, G_MININT32, G_MAXINT32)
+J_HDF5_STATISTICS_VECTOR(u32, avx2, "avx2", guint32, gint64, _i, __m256i, 8, _mm256_set1_epi32, j_avx_loadu_si, j_avx_storeu_si, _mm256_min_epu32, _mm256_max_epu32, 0, -1)
+J_HDF5_STATISTICS_VECTOR(i64, avx2, "avx2", gint64, gint64, _i, __m256i, 4, _mm256_set1_epi64x, j_avx_loadu_si, j_avx_storeu_si, j_avx_min_epi64, j_avx_max_epi64, G_MININT64, G_MAXINT64)
+J_HDF5_STATISTICS_VECTOR(f32, avx2, "avx2", gfloat, gdouble, _f, __m256, 8, _mm256_set1_ps, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_min_ps, _mm256_max_ps, -INFINITY, INFINITY)
+J_HDF5_STATISTICS_VECTOR(f64, avx2, "avx2", gdouble, gdouble, _f, __m256d, 4, _mm256_set1_pd, _mm256_loadu_pd, _mm256_storeu_pd, _mm256_min_pd, _mm256_max_pd, -INFINITY, INFINITY)
+
+#endif
+
+/**
+ * Returns the statistics kernel for a datatype.
+ *
+ * \param type_id The stored datatype.
+ *
+ * \return The kernel, NULL if no statistics are kept for the datatype, for example, because its byte order is not the CPU's.
+ **/
+static JHDF5StatisticsFunc
+H5VL_julea_db_statistics_get_func(hid_t type_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// Indexed by the element size's logarithm, unsigned 64-bit integers are reinterpreted as signed ones like before
+	static const JHDF5StatisticsFunc scalar_signed[] = { H5VL_julea_db_statistics_i8_scalar, H5VL_julea_db_statistics_i16_scalar, H5VL_julea_db_statistics_i32_scalar, H5VL_julea_db_statistics_i64_scalar };
+	static const JHDF5StatisticsFunc scalar_unsigned[] = { H5VL_julea_db_statistics_u8_scalar, H5VL_julea_db_statistics_u16_scalar, H5VL_julea_db_statistics_u32_scalar, H5VL_julea_db_statistics_i64_scalar };
+	static const JHDF5StatisticsFunc scalar_float[] = { NULL, NULL, H5VL_julea_db_statistics_f32_scalar, H5VL_julea_db_statistics_f64_scalar };
+
+#ifdef J_HDF5_STATISTICS_X86
+	gchar const* kernels;
+
+	static const JHDF5StatisticsFunc sse41_signed[] = { H5VL_julea_db_statistics_i8_sse41, H5VL_julea_db_statistics_i16_sse41, H5VL_julea_db_statistics_i32_sse41, H5VL_julea_db_statistics_i64_scalar };
+	static const JHDF5StatisticsFunc sse41_unsigned[] = { H5VL_julea_db_statistics_u8_sse41, H5VL_julea_db_statistics_u16_sse41, H5VL_julea_db_statistics_u32_sse41, H5VL_julea_db_statistics_i64_scalar };
+	static const JHDF5StatisticsFunc sse41_float[] = { NULL, NULL, H5VL_julea_db_statistics_f32_sse41, H5VL_julea_db_statistics_f64_sse41 };
+	static const JHDF5StatisticsFunc avx2_signed[] = { H5VL_julea_db_statistics_i8_avx2, H5VL_julea_db_statistics_i16_avx2, H5VL_julea_db_statistics_i32_avx2, H5VL_julea_db_statistics_i64_avx2 };
+	static const JHDF5StatisticsFunc avx2_unsigned[] = { H5VL_julea_db_statistics_u8_avx2, H5VL_julea_db_statistics_u16_avx2, H5VL_julea_db_statistics_u32_avx2, H5VL_julea_db_statistics_i64_avx2 };
+	static const JHDF5StatisticsFunc avx2_float[] = { NULL, NULL, H5VL_julea_db_statistics_f32_avx2, H5VL_julea_db_statistics_f64_avx2 };
+#endif
+
+	const JHDF5StatisticsFunc* signed_funcs = scalar_signed;
+	const JHDF5StatisticsFunc* unsigned_funcs = scalar_unsigned;
+	const JHDF5StatisticsFunc* float_funcs = scalar_float;
+	H5T_order_t native_order = (G_BYTE_ORDER == G_LITTLE_ENDIAN) ? H5T_ORDER_LE : H5T_ORDER_BE;
+	guint size_log;
+
+	switch (H5Tget_size(type_id))
+	{
+		case 1:
+			size_log = 0;
+			break;
+		case 2:
+			size_log = 1;
+			break;
+		case 4:
+			size_log = 2;
+			break;
+		case 8:
+			size_log = 3;
+			break;
+		default:
+			return NULL;
+	}
+
+	// The kernels interpret the elements using the CPU's byte order, which does not matter for single bytes
+	if (size_log > 0 && H5Tget_order(type_id) != native_order)
+	{
+		return NULL;
+	}
+
+#ifdef J_HDF5_STATISTICS_X86
+	kernels = g_getenv("JULEA_HDF5_STATISTICS");
+	__builtin_cpu_init();
+
+	if (g_strcmp0(kernels, "scalar") != 0)
+	{
+		if (__builtin_cpu_supports("avx2") && g_strcmp0(kernels, "sse4.1") != 0)
+		{
+			signed_funcs = avx2_signed;
+			unsigned_funcs = avx2_unsigned;
+			float_funcs = avx2_float;
+		}
+		else if (__builtin_cpu_supports("sse4.1"))
+		{
+			signed_funcs = sse41_signed;
+			unsigned_funcs = sse41_unsigned;
+			float_funcs = sse41_float;
+		}
+	}
+#endif
+
+	switch (H5Tget_class(type_id))
+	{
+		case H5T_INTEGER:
+			return (H5Tget_sign(type_id) == H5T_SGN_NONE) ? unsigned_funcs[size_log] : signed_funcs[size_log];
+		case H5T_FLOAT:
+			// Only IEEE single and double precision are supported
+			return float_funcs[size_log];
+		case H5T_STRING:
+		case H5T_BITFIELD:
+		case H5T_OPAQUE:
+		case H5T_COMPOUND:
+		case H5T_REFERENCE:
+		case H5T_ENUM:
+		case H5T_VLEN:
+		case H5T_ARRAY:
+		case H5T_NO_CLASS:
+		case H5T_TIME:
+		case H5T_NCLASSES:
+		default:
+			return NULL;
+	}
+}
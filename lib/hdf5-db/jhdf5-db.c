@@ -64,11 +64,16 @@ static herr_t H5VL_julea_db_link_term(void);
 
 // FIXME order is important
 #include "jhdf5-db-shared.c"
+#include "jhdf5-db-cache.c"
 #include "jhdf5-db-link.c"
 #include "jhdf5-db-group.c"
 #include "jhdf5-db-datatype.c"
 #include "jhdf5-db-space.c"
 #include "jhdf5-db-attr.c"
+#include "jhdf5-db-statistics.c"
+#include "jhdf5-db-compression.c"
+#include "../hdf5/jhdf5-request.c"
+#include "../hdf5/jhdf5-query.c"
 #include "jhdf5-db-dataset.c"
 #include "jhdf5-db-file.c"
 
@@ -309,12 +314,12 @@ static const H5VL_class_t H5VL_julea_db_g = {
 		.opt_query = H5VL_julea_db_introspect_opt_query,
 	},
 	.request_cls = {
-		.wait = NULL,
-		.notify = NULL,
-		.cancel = NULL,
+		.wait = j_hdf5_request_wait,
+		.notify = j_hdf5_request_notify,
+		.cancel = j_hdf5_request_cancel,
 		.specific = NULL,
 		.optional = NULL,
-		.free = NULL,
+		.free = j_hdf5_request_free,
 	},
 	.blob_cls = {
 		.put = NULL,
@@ -43,6 +43,45 @@ enum JHDF5ObjectType
 
 typedef enum JHDF5ObjectType JHDF5ObjectType;
 
+// Filter IDs registered with The HDF Group, used to request compression via H5Pset_filter
+#define J_HDF5_FILTER_LZ4 32004
+#define J_HDF5_FILTER_ZSTD 32015
+
+enum JHDF5Codec
+{
+	J_HDF5_CODEC_NONE = 0,
+	J_HDF5_CODEC_LZ4,
+	J_HDF5_CODEC_ZSTD
+};
+
+typedef enum JHDF5Codec JHDF5Codec;
+
+typedef struct JHDF5Statistics_t JHDF5Statistics_t;
+struct JHDF5Statistics_t
+{
+	gint64 min_value_i;
+	gdouble min_value_f;
+	gint64 max_value_i;
+	gdouble max_value_f;
+};
+
+/**
+ * Folds count elements of buf into the statistics.
+ **/
+typedef void (*JHDF5StatisticsFunc)(JHDF5Statistics_t* statistics, const void* buf, guint64 count);
+
+typedef struct JHDF5Chunk_t JHDF5Chunk_t;
+struct JHDF5Chunk_t
+{
+	guint64 index;
+	JHDF5Statistics_t statistics;
+	// Number of bytes stored for compressed chunks, 0 otherwise
+	guint64 size;
+	// Whether the chunk has an entry in the chunk schema and whether its statistics changed since it was stored
+	gboolean stored;
+	gboolean dirty;
+};
+
 typedef struct JHDF5Object_t JHDF5Object_t;
 struct JHDF5Object_t
 {
@@ -55,6 +94,9 @@ struct JHDF5Object_t
 		struct
 		{
 			char* name;
+			// Metadata cache, see jhdf5-db-cache.c
+			GHashTable* links;
+			GHashTable* objects;
 		} file;
 		struct
 		{
@@ -64,13 +106,26 @@ struct JHDF5Object_t
 			JHDF5Object_t* space;
 			JDistribution* distribution;
 			JDistributedObject* object;
-			struct
-			{
-				gint64 min_value_i;
-				gdouble min_value_f;
-				gint64 max_value_i;
-				gdouble max_value_f;
-			} statistics;
+			JHDF5Statistics_t statistics;
+			// Whether the statistics changed since they were stored
+			gboolean statistics_dirty;
+			// Statistics kernel for the stored datatype, NULL if no statistics are kept
+			JHDF5StatisticsFunc statistics_func;
+			// Chunk layout, datasets that are not chunked are stored as a single chunk
+			gboolean chunked;
+			guint ndims;
+			hsize_t* dims;
+			hsize_t* chunk_dims;
+			guint64 chunk_elements;
+			// Chunk index to JHDF5Chunk_t for all chunks that contain data
+			GHashTable* chunks;
+			// Compression of whole chunks, shuffling is only done in combination with a codec
+			JHDF5Codec codec;
+			gint codec_level;
+			gboolean shuffle;
+			// Batches of pending asynchronous reads and writes, they have to complete before the dataset is closed
+			// Requests remove their batch when they are freed
+			GPtrArray* batches;
 		} dataset;
 		struct
 		{
@@ -0,0 +1,126 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Dataset queries via an optional VOL operation.
+ * This file is shared by the julea and julea-db VOL plugins.
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+
+#include <hdf5/jhdf5.h>
+
+#include <julea.h>
+
+/**
+ * Returns the value of the dataset operation for j_hdf5_dataset_query().
+ *
+ * The operation is registered by name, so that its value does not collide with the operations of other VOL connectors.
+ * Both plugins look up the same name and therefore agree on the value if they are loaded at the same time.
+ *
+ * \return The operation's value, -1 if it could not be registered.
+ **/
+static gint
+j_hdf5_dataset_query_operation(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// The value is offset by two, because g_once_init_enter needs a non-zero value and registering might fail
+	static gsize operation = 0;
+
+	if (g_once_init_enter(&operation))
+	{
+		gint op_val = -1;
+
+#if H5_VERSION_GE(1, 12, 1)
+		herr_t ret;
+
+		// The lookup fails if the operation has not been registered yet, which is not an error
+		H5E_BEGIN_TRY
+		{
+			ret = H5VLfind_opt_operation(H5VL_SUBCLS_DATASET, J_HDF5_DATASET_OPTIONAL_QUERY, &op_val);
+		}
+		H5E_END_TRY;
+
+		if (ret < 0 && H5VLregister_opt_operation(H5VL_SUBCLS_DATASET, J_HDF5_DATASET_OPTIONAL_QUERY, &op_val) < 0)
+		{
+			op_val = -1;
+		}
+#else
+		// Older versions of HDF5 do not support registering operations, the value is chosen after the native ones
+		op_val = H5VL_RESERVED_NATIVE_OPTIONAL;
+#endif
+
+		g_once_init_leave(&operation, (gsize)(op_val + 2));
+	}
+
+	return (gint)(operation - 2);
+}
+
+static herr_t
+j_hdf5_dataset_optional(hid_t dataset, H5VL_dataset_optional_t opt_type, ...)
+{
+	va_list arguments;
+	void* object;
+	hid_t connector_id;
+	herr_t ret;
+
+	if ((object = H5VLobject(dataset)) == NULL)
+	{
+		return -1;
+	}
+
+	if ((connector_id = H5VLget_connector_id(dataset)) < 0)
+	{
+		return -1;
+	}
+
+	va_start(arguments, opt_type);
+	ret = H5VLdataset_optional(object, connector_id, opt_type, H5P_DATASET_XFER_DEFAULT, NULL, arguments);
+	va_end(arguments);
+
+	H5VLclose(connector_id);
+
+	return ret;
+}
+
+hid_t
+j_hdf5_dataset_query(hid_t dataset, JHDF5QueryOperator op, gdouble value)
+{
+	hid_t selection = H5I_INVALID_HID;
+	gint operation;
+
+	if ((operation = j_hdf5_dataset_query_operation()) < 0)
+	{
+		return H5I_INVALID_HID;
+	}
+
+	// The dataset might belong to a different VOL plugin, which does not know about queries
+	if (j_hdf5_dataset_optional(dataset, operation, (gint)op, value, &selection) < 0)
+	{
+		return H5I_INVALID_HID;
+	}
+
+	return selection;
+}
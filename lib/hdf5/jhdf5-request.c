@@ -0,0 +1,264 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ *
+ * Asynchronous VOL requests backed by asynchronous batches.
+ * This file is shared by the julea and julea-db VOL plugins.
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <hdf5.h>
+
+#include <julea.h>
+
+/**
+ * A request returned to HDF5 for an operation that is executed in the background.
+ **/
+struct JHDF5Request
+{
+	/**
+	 * The batch executing the operation.
+	 **/
+	JBatch* batch;
+
+	/**
+	 * Data that has to be kept alive until the batch has been executed, for example, buffers.
+	 **/
+	gpointer data;
+	GDestroyNotify data_free;
+
+	/**
+	 * The list of pending batches the batch has been added to, or NULL.
+	 * The batch is removed from it when the request is freed.
+	 **/
+	GPtrArray* batches;
+
+	/**
+	 * The mutex and condition protecting status and the notify callback.
+	 **/
+	GMutex mutex;
+	GCond cond;
+
+	H5ES_status_t status;
+
+	/**
+	 * The callback to notify once the request has completed, it is called on the application's thread and reset afterwards.
+	 **/
+	H5VL_request_notify_t notify;
+	void* notify_ctx;
+};
+
+typedef struct JHDF5Request JHDF5Request;
+
+/**
+ * Records the batch's result.
+ *
+ * This is called on one of JULEA's background threads, which must not call into HDF5.
+ * The notify callback is therefore called by j_hdf5_request_wait() or j_hdf5_request_notify() instead.
+ **/
+static void
+j_hdf5_request_complete(JBatch* batch, gboolean ret, gpointer user_data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request* request = user_data;
+
+	(void)batch;
+
+	g_mutex_lock(&request->mutex);
+
+	request->status = (ret) ? H5ES_STATUS_SUCCEED : H5ES_STATUS_FAIL;
+
+	g_cond_broadcast(&request->cond);
+	g_mutex_unlock(&request->mutex);
+}
+
+/**
+ * Executes a batch asynchronously and returns a request for it.
+ *
+ * \param batch     A batch.
+ * \param data      Data to free after the batch has been executed, or NULL.
+ * \param data_free A function to free data.
+ * \param batches   A list of pending batches to add the batch to until the request is freed, or NULL.
+ *
+ * \return A request.
+ **/
+static JHDF5Request*
+j_hdf5_request_new(JBatch* batch, gpointer data, GDestroyNotify data_free, GPtrArray* batches)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request* request;
+
+	request = g_new(JHDF5Request, 1);
+	request->batch = j_batch_ref(batch);
+	request->data = data;
+	request->data_free = data_free;
+	request->batches = NULL;
+	request->status = H5ES_STATUS_IN_PROGRESS;
+	request->notify = NULL;
+	request->notify_ctx = NULL;
+
+	g_mutex_init(&request->mutex);
+	g_cond_init(&request->cond);
+
+	if (batches != NULL)
+	{
+		request->batches = g_ptr_array_ref(batches);
+		g_ptr_array_add(batches, j_batch_ref(batch));
+	}
+
+	j_batch_execute_async(batch, j_hdf5_request_complete, request);
+
+	return request;
+}
+
+/**
+ * Waits for a request.
+ *
+ * \param timeout The timeout in nanoseconds, G_MAXUINT64 to wait until the request has completed.
+ **/
+static herr_t
+j_hdf5_request_wait(void* req, uint64_t timeout, H5ES_status_t* status)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request* request = req;
+	H5VL_request_notify_t notify = NULL;
+	void* notify_ctx = NULL;
+	gint64 end_time;
+
+	g_mutex_lock(&request->mutex);
+
+	if (timeout == G_MAXUINT64)
+	{
+		while (request->status == H5ES_STATUS_IN_PROGRESS)
+		{
+			g_cond_wait(&request->cond, &request->mutex);
+		}
+	}
+	else
+	{
+		end_time = g_get_monotonic_time() + timeout / 1000;
+
+		while (request->status == H5ES_STATUS_IN_PROGRESS)
+		{
+			if (!g_cond_wait_until(&request->cond, &request->mutex, end_time))
+			{
+				break;
+			}
+		}
+	}
+
+	*status = request->status;
+
+	// The callback is called only once
+	if (*status != H5ES_STATUS_IN_PROGRESS)
+	{
+		notify = request->notify;
+		notify_ctx = request->notify_ctx;
+		request->notify = NULL;
+		request->notify_ctx = NULL;
+	}
+
+	g_mutex_unlock(&request->mutex);
+
+	if (notify != NULL)
+	{
+		notify(notify_ctx, *status);
+	}
+
+	return 0;
+}
+
+static herr_t
+j_hdf5_request_notify(void* req, H5VL_request_notify_t cb, void* ctx)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request* request = req;
+	H5ES_status_t status;
+
+	g_mutex_lock(&request->mutex);
+
+	status = request->status;
+
+	if (status == H5ES_STATUS_IN_PROGRESS)
+	{
+		request->notify = cb;
+		request->notify_ctx = ctx;
+	}
+
+	g_mutex_unlock(&request->mutex);
+
+	// The request has already completed, the callback is called immediately, otherwise it is called when waiting for the request
+	if (status != H5ES_STATUS_IN_PROGRESS)
+	{
+		cb(ctx, status);
+	}
+
+	return 0;
+}
+
+static herr_t
+j_hdf5_request_cancel(void* req)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)req;
+
+	// Batches cannot be cancelled once they have been sent to the servers
+	return -1;
+}
+
+static herr_t
+j_hdf5_request_free(void* req)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHDF5Request* request = req;
+
+	// Joins the background operation, the batch might still be running if the request has not been waited for
+	j_batch_wait(request->batch);
+
+	if (request->batches != NULL)
+	{
+		// The list might have been cleared in the meantime, for example, by closing the dataset
+		g_ptr_array_remove_fast(request->batches, request->batch);
+		g_ptr_array_unref(request->batches);
+	}
+
+	j_batch_unref(request->batch);
+
+	if (request->data_free != NULL)
+	{
+		request->data_free(request->data);
+	}
+
+	g_cond_clear(&request->cond);
+	g_mutex_clear(&request->mutex);
+
+	g_free(request);
+
+	return 0;
+}
@@ -47,10 +47,16 @@
 #include <julea-kv.h>
 #include <julea-object.h>
 
+#include "jhdf5-request.c"
+#include "jhdf5-query.c"
+
 #define _GNU_SOURCE
 
 #define JULEA 520
 
+// Number of bytes of deferred metadata after which a file's batch is flushed
+#define J_HDF5_DEFERRED_SIZE (4 * 1024 * 1024)
+
 enum JHDF5Type
 {
 	J_HDF5_TYPE_FILE,
@@ -64,13 +70,40 @@ struct JHF_t
 {
 	char* name;
 	JKV* kv;
+
+	/*
+	 * Metadata puts are deferred until the file is flushed or closed.
+	 * Their values are kept in pending (key to JHFPending) to allow reading them back before that.
+	 * If flushing fails, everything stays pending and is retried by the next flush.
+	 */
+	JBatch* batch;
+	GHashTable* pending;
+	// Objects created in the batch (JDistributedObject)
+	GPtrArray* pending_objects;
+	guint pending_operations;
+	gsize pending_size;
+	// Number of times the batch has been flushed
+	guint64 flushes;
+
+	// Open groups, datasets and attributes reference their file
+	gint ref_count;
 };
 
 typedef struct JHF_t JHF_t;
 
+/* deferred metadata put */
+struct JHFPending
+{
+	JKV* kv;
+	GBytes* value;
+};
+
+typedef struct JHFPending JHFPending;
+
 /* structure for group */
 struct JHG_t
 {
+	JHF_t* file;
 	char* location;
 	char* name;
 	JKV* kv;
@@ -81,12 +114,16 @@ typedef struct JHG_t JHG_t;
 /* structure for dataset */
 struct JHD_t
 {
+	JHF_t* file;
 	char* location;
 	char* name;
 	size_t data_size;
 	JDistribution* distribution;
 	JDistributedObject* object;
 	JKV* kv;
+	char* kv_key;
+	// Value of the file's flushes when the object was created, G_MAXUINT64 if it already existed
+	guint64 created;
 };
 
 typedef struct JHD_t JHD_t;
@@ -94,11 +131,13 @@ typedef struct JHD_t JHD_t;
 /* structure for attribute */
 struct JHA_t
 {
+	JHF_t* file;
 	char* location;
 	char* name;
 	size_t data_size;
 	JKV* kv;
 	JKV* ts;
+	char* ts_key;
 };
 
 typedef struct JHA_t JHA_t;
@@ -481,6 +520,228 @@ j_hdf5_deserialize_dataset(const bson_t* b, JHD_t* d, size_t* data_size)
 	}
 }
 
+static void
+j_hdf5_pending_free(JHFPending* pending)
+{
+	j_kv_unref(pending->kv);
+	g_bytes_unref(pending->value);
+	g_free(pending);
+}
+
+/**
+ * Creates the structure for a file
+ *
+ * \return file The file
+ **/
+static JHF_t*
+j_hdf5_file_new(const char* fname)
+{
+	JHF_t* file;
+
+	file = g_new(JHF_t, 1);
+	file->name = g_strdup(fname);
+	file->kv = j_kv_new("hdf5", fname);
+	file->batch = j_batch_new(j_hdf5_semantics);
+	file->pending = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)j_hdf5_pending_free);
+	file->pending_objects = g_ptr_array_new_with_free_func((GDestroyNotify)j_distributed_object_unref);
+	file->pending_operations = 0;
+	file->pending_size = 0;
+	file->flushes = 0;
+	file->ref_count = 1;
+
+	return file;
+}
+
+static JHF_t*
+j_hdf5_file_ref(JHF_t* file)
+{
+	file->ref_count++;
+
+	return file;
+}
+
+/**
+ * Executes the deferred metadata operations of a file
+ *
+ * \return TRUE on success, FALSE if an error occurred
+ **/
+static gboolean
+j_hdf5_file_flush(JHF_t* file)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	if (file->pending_operations == 0)
+	{
+		return TRUE;
+	}
+
+	ret = j_batch_execute(file->batch);
+
+	if (!ret)
+	{
+		GHashTableIter iter;
+		gpointer value;
+
+		// Executing the batch consumes its operations, add them again so that the next flush retries them
+		// Puts and creates that have already succeeded are simply repeated
+		g_hash_table_iter_init(&iter, file->pending);
+
+		while (g_hash_table_iter_next(&iter, NULL, &value))
+		{
+			JHFPending* pending = value;
+			gconstpointer data;
+			gpointer copy;
+			gsize size;
+
+			data = g_bytes_get_data(pending->value, &size);
+#if GLIB_CHECK_VERSION(2, 68, 0)
+			copy = g_memdup2(data, size);
+#else
+			copy = g_memdup(data, size);
+#endif
+			j_kv_put(pending->kv, copy, size, g_free, file->batch);
+		}
+
+		for (guint i = 0; i < file->pending_objects->len; i++)
+		{
+			j_distributed_object_create(g_ptr_array_index(file->pending_objects, i), file->batch);
+		}
+
+		return FALSE;
+	}
+
+	// The values are stored now, reads have to go to the servers again
+	g_hash_table_remove_all(file->pending);
+	g_ptr_array_set_size(file->pending_objects, 0);
+	file->pending_operations = 0;
+	file->pending_size = 0;
+	file->flushes++;
+
+	return TRUE;
+}
+
+static gboolean
+j_hdf5_file_unref(JHF_t* file)
+{
+	gboolean ret = TRUE;
+
+	file->ref_count--;
+
+	if (file->ref_count == 0)
+	{
+		ret = j_hdf5_file_flush(file);
+
+		j_batch_unref(file->batch);
+		g_hash_table_unref(file->pending);
+		g_ptr_array_unref(file->pending_objects);
+		j_kv_unref(file->kv);
+		g_free(file->name);
+		g_free(file);
+	}
+
+	return ret;
+}
+
+/**
+ * Defers putting a metadata value, taking ownership of it
+ * Once enough values are pending, they are flushed.
+ * If this fails, they stay pending and the error is reported by the next explicit flush, by closing the file or by dataset I/O.
+ **/
+static void
+j_hdf5_file_put(JHF_t* file, JKV* kv, const char* key, gpointer value, guint32 len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JHFPending* pending;
+
+	pending = g_new(JHFPending, 1);
+	pending->kv = j_kv_ref(kv);
+	pending->value = g_bytes_new(value, len);
+
+	g_hash_table_insert(file->pending, g_strdup(key), pending);
+	j_kv_put(kv, value, len, bson_free, file->batch);
+
+	file->pending_operations++;
+	file->pending_size += len;
+
+	if (file->pending_size >= J_HDF5_DEFERRED_SIZE)
+	{
+		j_hdf5_file_flush(file);
+	}
+}
+
+/**
+ * Gets a metadata value, taking deferred puts into account
+ *
+ * \return TRUE on success, FALSE if an error occurred
+ **/
+static gboolean
+j_hdf5_file_get(JHF_t* file, JKV* kv, const char* key, gpointer* value, guint32* len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JBatch) batch = NULL;
+	JHFPending* pending;
+
+	if ((pending = g_hash_table_lookup(file->pending, key)) != NULL)
+	{
+		gconstpointer data;
+		gsize size;
+
+		data = g_bytes_get_data(pending->value, &size);
+		*value = g_malloc(size);
+		*len = size;
+		memcpy(*value, data, size);
+
+		return TRUE;
+	}
+
+	batch = j_batch_new(j_hdf5_semantics);
+	j_kv_get(kv, value, len, batch);
+
+	return j_batch_execute(batch);
+}
+
+/**
+ * Returns the file an object belongs to
+ *
+ * \return file The file
+ **/
+static JHF_t*
+j_hdf5_get_file(void* obj, H5I_type_t obj_type)
+{
+	switch (obj_type)
+	{
+		case H5I_FILE:
+			return obj;
+		case H5I_GROUP:
+			return ((JHG_t*)obj)->file;
+		case H5I_DATASET:
+			return ((JHD_t*)obj)->file;
+		case H5I_ATTR:
+			return ((JHA_t*)obj)->file;
+		case H5I_BADID:
+		case H5I_DATASPACE:
+		case H5I_DATATYPE:
+		case H5I_ERROR_CLASS:
+		case H5I_ERROR_MSG:
+		case H5I_ERROR_STACK:
+		case H5I_GENPROP_CLS:
+		case H5I_GENPROP_LST:
+		case H5I_MAP:
+		case H5I_NTYPES:
+		case H5I_SPACE_SEL_ITER:
+		case H5I_UNINIT:
+		case H5I_VFL:
+		case H5I_VOL:
+		default:
+			g_assert_not_reached();
+			exit(1);
+	}
+}
+
 /**
  * Creates a new attribute
  *
@@ -504,8 +765,6 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 	gsize data_size;
 
 	bson_t* tmp;
-	g_autoptr(JBatch) batch = NULL;
-	gchar* tsloc;
 
 	gpointer value;
 	guint32 len;
@@ -540,6 +799,7 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 		{
 			JHD_t* o = obj;
 
+			attribute->file = j_hdf5_file_ref(o->file);
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
 			attribute->kv = j_kv_new("hdf5", attribute->location);
 		}
@@ -548,6 +808,7 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 		{
 			JHG_t* o = obj;
 
+			attribute->file = j_hdf5_file_ref(o->file);
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
 			attribute->kv = j_kv_new("hdf5", attribute->location);
 		}
@@ -573,19 +834,13 @@ H5VL_julea_attr_create(void* obj, const H5VL_loc_params_t* loc_params, const cha
 			exit(1);
 	}
 
-	tsloc = g_strdup_printf("%s_ts", attribute->location);
-	attribute->ts = j_kv_new("hdf5", tsloc);
-	g_free(tsloc);
+	attribute->ts_key = g_strdup_printf("%s_ts", attribute->location);
+	attribute->ts = j_kv_new("hdf5", attribute->ts_key);
 
-	batch = j_batch_new(j_hdf5_semantics);
 	tmp = j_hdf5_serialize_attribute(type_buf, type_size, space_buf, space_size);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
-	j_kv_put(attribute->ts, value, len, bson_free, batch);
 
-	if (!j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_hdf5_file_put(attribute->file, attribute->ts, attribute->ts_key, value, len);
 
 	g_free(type_buf);
 	g_free(space_buf);
@@ -605,9 +860,6 @@ H5VL_julea_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const char*
 
 	JHA_t* attribute;
 
-	g_autoptr(JBatch) batch = NULL;
-	gchar* tsloc;
-
 	gpointer value;
 	guint32 len;
 
@@ -623,12 +875,14 @@ H5VL_julea_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const char*
 		case H5I_DATASET:
 		{
 			JHD_t* o = obj;
+			attribute->file = j_hdf5_file_ref(o->file);
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
 		}
 		break;
 		case H5I_GROUP:
 		{
 			JHG_t* o = obj;
+			attribute->file = j_hdf5_file_ref(o->file);
 			attribute->location = g_build_path("/", o->location, attr_name, NULL);
 		}
 		break;
@@ -653,15 +907,12 @@ H5VL_julea_attr_open(void* obj, const H5VL_loc_params_t* loc_params, const char*
 			exit(1);
 	}
 
-	tsloc = g_strdup_printf("%s_ts", attribute->location);
-	attribute->ts = j_kv_new("hdf5", tsloc);
-	g_free(tsloc);
+	attribute->ts_key = g_strdup_printf("%s_ts", attribute->location);
+	attribute->ts = j_kv_new("hdf5", attribute->ts_key);
 
-	batch = j_batch_new(j_hdf5_semantics);
 	attribute->kv = j_kv_new("hdf5", attribute->location);
-	j_kv_get(attribute->kv, &value, &len, batch);
 
-	if (j_batch_execute(batch))
+	if (j_hdf5_file_get(attribute->file, attribute->kv, attribute->location, &value, &len))
 	{
 		bson_t data[1];
 
@@ -683,8 +934,6 @@ H5VL_julea_attr_read(void* attr, hid_t dtype_id, void* buf, hid_t dxpl_id, void*
 
 	JHA_t* attribute = attr;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	gpointer value;
 	guint32 len;
 
@@ -692,10 +941,7 @@ H5VL_julea_attr_read(void* attr, hid_t dtype_id, void* buf, hid_t dxpl_id, void*
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-	j_kv_get(attribute->kv, &value, &len, batch);
-
-	if (j_batch_execute(batch))
+	if (j_hdf5_file_get(attribute->file, attribute->kv, attribute->location, &value, &len))
 	{
 		bson_t b[1];
 
@@ -717,8 +963,6 @@ H5VL_julea_attr_write(void* attr, hid_t dtype_id, const void* buf, hid_t dxpl_id
 
 	JHA_t* attribute = attr;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	bson_t* tmp;
 
 	gpointer value;
@@ -728,15 +972,10 @@ H5VL_julea_attr_write(void* attr, hid_t dtype_id, const void* buf, hid_t dxpl_id
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
 	tmp = j_hdf5_serialize_attribute_data(buf, attribute->data_size);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
-	j_kv_put(attribute->kv, value, len, bson_free, batch);
 
-	if (!j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_hdf5_file_put(attribute->file, attribute->kv, attribute->location, value, len);
 
 	return 1;
 }
@@ -753,8 +992,6 @@ H5VL_julea_attr_get(void* attr, H5VL_attr_get_t get_type, hid_t dxpl_id, void**
 
 	JHA_t* attribute = attr;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	herr_t ret_value = 0;
 
 	gpointer value;
@@ -770,10 +1007,7 @@ H5VL_julea_attr_get(void* attr, H5VL_attr_get_t get_type, hid_t dxpl_id, void**
 			hid_t* ret_id = va_arg(arguments, hid_t*);
 			void* space;
 
-			batch = j_batch_new(j_hdf5_semantics);
-			j_kv_get(attribute->ts, &value, &len, batch);
-
-			if (j_batch_execute(batch))
+			if (j_hdf5_file_get(attribute->file, attribute->ts, attribute->ts_key, &value, &len))
 			{
 				bson_t b[1];
 
@@ -790,10 +1024,7 @@ H5VL_julea_attr_get(void* attr, H5VL_attr_get_t get_type, hid_t dxpl_id, void**
 			hid_t* ret_id = va_arg(arguments, hid_t*);
 			void* type;
 
-			batch = j_batch_new(j_hdf5_semantics);
-			j_kv_get(attribute->ts, &value, &len, batch);
-
-			if (j_batch_execute(batch))
+			if (j_hdf5_file_get(attribute->file, attribute->ts, attribute->ts_key, &value, &len))
 			{
 				bson_t b[1];
 
@@ -838,8 +1069,11 @@ H5VL_julea_attr_close(void* attr, hid_t dxpl_id, void** req)
 		j_kv_unref(attribute->ts);
 	}
 
+	j_hdf5_file_unref(attribute->file);
+
 	g_free(attribute->name);
 	g_free(attribute->location);
+	g_free(attribute->ts_key);
 	g_free(attribute);
 
 	return 1;
@@ -855,8 +1089,6 @@ H5VL_julea_file_create(const char* fname, unsigned flags, hid_t fcpl_id, hid_t f
 {
 	JHF_t* file;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	bson_t tmp[1];
 
 	gpointer value;
@@ -868,23 +1100,14 @@ H5VL_julea_file_create(const char* fname, unsigned flags, hid_t fcpl_id, hid_t f
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
-	file = g_new(JHF_t, 1);
-	file->name = g_strdup(fname);
-	file->kv = j_kv_new("hdf5", fname);
+	file = j_hdf5_file_new(fname);
 
 	bson_init(tmp);
 	bson_append_int32(tmp, "type", -1, J_HDF5_TYPE_FILE);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
 	bson_destroy(tmp);
 
-	j_kv_put(file->kv, value, len, bson_free, batch);
-
-	if (j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_hdf5_file_put(file, file->kv, file->name, value, len);
 
 	return file;
 }
@@ -899,8 +1122,6 @@ H5VL_julea_file_open(const char* fname, unsigned flags, hid_t fapl_id, hid_t dxp
 {
 	JHF_t* file;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	gpointer value;
 	guint32 len;
 
@@ -909,15 +1130,9 @@ H5VL_julea_file_open(const char* fname, unsigned flags, hid_t fapl_id, hid_t dxp
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
-	file = g_new(JHF_t, 1);
-	file->name = g_strdup(fname);
-	file->kv = j_kv_new("hdf5", fname);
-
-	j_kv_get(file->kv, &value, &len, batch);
+	file = j_hdf5_file_new(fname);
 
-	if (j_batch_execute(batch))
+	if (j_hdf5_file_get(file, file->kv, file->name, &value, &len))
 	{
 		// FIXME check return value properly
 		g_free(value);
@@ -931,14 +1146,19 @@ H5VL_julea_file_specific(void* obj, H5VL_file_specific_t specific_type, hid_t dx
 {
 	gint ret = -1;
 
-	(void)obj;
 	(void)dxpl_id;
 	(void)req;
-	(void)arguments;
 
 	switch (specific_type)
 	{
 		case H5VL_FILE_FLUSH:
+		{
+			H5I_type_t obj_type = (H5I_type_t)va_arg(arguments, int);
+
+			// The scope does not matter since there are no mounted files
+			ret = j_hdf5_file_flush(j_hdf5_get_file(obj, obj_type)) ? 0 : -1;
+		}
+		break;
 		case H5VL_FILE_REOPEN:
 		case H5VL_FILE_MOUNT:
 		case H5VL_FILE_UNMOUNT:
@@ -959,15 +1179,16 @@ static herr_t
 H5VL_julea_file_close(void* file, hid_t dxpl_id, void** req)
 {
 	JHF_t* f = file;
+	gboolean ret;
 
 	(void)dxpl_id;
 	(void)req;
 
-	j_kv_unref(f->kv);
-	g_free(f->name);
-	g_free(f);
+	// Objects that are still open keep the file alive, make sure everything written so far is stored
+	ret = j_hdf5_file_flush(f);
+	ret = j_hdf5_file_unref(f) && ret;
 
-	return 1;
+	return (ret) ? 1 : -1;
 }
 
 /**
@@ -980,8 +1201,6 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 {
 	JHG_t* group;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	bson_t tmp[1];
 
 	gpointer value;
@@ -993,8 +1212,6 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
 	group = g_new(JHG_t, 1);
 
 	switch (loc_params->obj_type)
@@ -1002,6 +1219,7 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		case H5I_FILE:
 		{
 			JHF_t* o = obj;
+			group->file = j_hdf5_file_ref(o);
 			group->location = g_build_path("/", o->name, name, NULL);
 			group->name = g_strdup(name);
 		}
@@ -1009,6 +1227,7 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		case H5I_GROUP:
 		{
 			JHG_t* o = obj;
+			group->file = j_hdf5_file_ref(o->file);
 			group->location = g_build_path("/", o->location, name, NULL);
 			group->name = g_strdup(name);
 		}
@@ -1034,19 +1253,15 @@ H5VL_julea_group_create(void* obj, const H5VL_loc_params_t* loc_params, const ch
 			exit(1);
 	}
 
-	group->kv = j_kv_new("hdf5", group->name);
+	// Use the same key as H5VL_julea_group_open
+	group->kv = j_kv_new("hdf5", group->location);
 
 	bson_init(tmp);
 	bson_append_int32(tmp, "type", -1, J_HDF5_TYPE_GROUP);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
 	bson_destroy(tmp);
 
-	j_kv_put(group->kv, value, len, bson_free, batch);
-
-	if (j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_hdf5_file_put(group->file, group->kv, group->location, value, len);
 
 	return group;
 }
@@ -1061,8 +1276,6 @@ H5VL_julea_group_open(void* obj, const H5VL_loc_params_t* loc_params, const char
 {
 	JHG_t* group;
 
-	g_autoptr(JBatch) batch = NULL;
-
 	gpointer value;
 	guint32 len;
 
@@ -1070,8 +1283,6 @@ H5VL_julea_group_open(void* obj, const H5VL_loc_params_t* loc_params, const char
 	(void)dxpl_id;
 	(void)req;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
 	group = g_new(JHG_t, 1);
 	group->name = g_strdup(name);
 
@@ -1080,12 +1291,14 @@ H5VL_julea_group_open(void* obj, const H5VL_loc_params_t* loc_params, const char
 		case H5I_FILE:
 		{
 			JHF_t* o = obj;
+			group->file = j_hdf5_file_ref(o);
 			group->location = g_build_path("/", o->name, name, NULL);
 		}
 		break;
 		case H5I_GROUP:
 		{
 			JHG_t* o = obj;
+			group->file = j_hdf5_file_ref(o->file);
 			group->location = g_build_path("/", o->location, name, NULL);
 		}
 		break;
@@ -1112,9 +1325,7 @@ H5VL_julea_group_open(void* obj, const H5VL_loc_params_t* loc_params, const char
 
 	group->kv = j_kv_new("hdf5", group->location);
 
-	j_kv_get(group->kv, &value, &len, batch);
-
-	if (j_batch_execute(batch))
+	if (j_hdf5_file_get(group->file, group->kv, group->location, &value, &len))
 	{
 		// FIXME check return value properly
 		g_free(value);
@@ -1135,6 +1346,7 @@ H5VL_julea_group_close(void* grp, hid_t dxpl_id, void** req)
 	(void)req;
 
 	j_kv_unref(g->kv);
+	j_hdf5_file_unref(g->file);
 	g_free(g->name);
 	g_free(g->location);
 	g_free(g);
@@ -1165,8 +1377,6 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 	gsize data_size;
 
 	bson_t* tmp;
-	g_autoptr(JBatch) batch = NULL;
-	gchar* tsloc;
 
 	gpointer value;
 	guint32 len;
@@ -1197,17 +1407,14 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 
 	dset->data_size = data_size;
 
-	batch = j_batch_new(j_hdf5_semantics);
-
 	switch (loc_params->obj_type)
 	{
 		case H5I_FILE:
 		{
 			JHF_t* o = obj;
 
+			dset->file = j_hdf5_file_ref(o);
 			dset->location = g_build_path("/", o->name, name, NULL);
-			dset->object = j_distributed_object_new("hdf5", dset->location, dset->distribution);
-			j_distributed_object_create(dset->object, batch);
 		}
 
 		break;
@@ -1215,9 +1422,8 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 		{
 			JHG_t* o = obj;
 
+			dset->file = j_hdf5_file_ref(o->file);
 			dset->location = g_build_path("/", o->location, name, NULL);
-			dset->object = j_distributed_object_new("hdf5", dset->location, dset->distribution);
-			j_distributed_object_create(dset->object, batch);
 		}
 		break;
 		case H5I_ATTR:
@@ -1241,18 +1447,20 @@ H5VL_julea_dataset_create(void* obj, const H5VL_loc_params_t* loc_params, const
 			exit(1);
 	}
 
-	tsloc = g_strdup_printf("%s_data", dset->location);
-	dset->kv = j_kv_new("hdf5", tsloc);
-	g_free(tsloc);
+	// The object is created together with the metadata, reading or writing the dataset flushes both
+	dset->object = j_distributed_object_new("hdf5", dset->location, dset->distribution);
+	j_distributed_object_create(dset->object, dset->file->batch);
+	g_ptr_array_add(dset->file->pending_objects, j_distributed_object_ref(dset->object));
+	dset->file->pending_operations++;
+	dset->created = dset->file->flushes;
+
+	dset->kv_key = g_strdup_printf("%s_data", dset->location);
+	dset->kv = j_kv_new("hdf5", dset->kv_key);
 
 	tmp = j_hdf5_serialize_dataset(type_buf, type_size, space_buf, space_size, data_size, dset->distribution);
 	value = bson_destroy_with_steal(tmp, TRUE, &len);
-	j_kv_put(dset->kv, value, len, bson_free, batch);
 
-	if (!j_batch_execute(batch))
-	{
-		// FIXME check return value properly
-	}
+	j_hdf5_file_put(dset->file, dset->kv, dset->kv_key, value, len);
 
 	g_free(type_buf);
 	g_free(space_buf);
@@ -1269,8 +1477,6 @@ static void*
 H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const char* name, hid_t dapl_id, hid_t dxpl_id, void** req)
 {
 	JHD_t* dset;
-	g_autoptr(JBatch) batch = NULL;
-	char* tsloc;
 
 	gpointer value;
 	guint32 len;
@@ -1281,12 +1487,14 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 
 	dset = g_new(JHD_t, 1);
 	dset->name = g_strdup(name);
+	dset->created = G_MAXUINT64;
 
 	switch (loc_params->obj_type)
 	{
 		case H5I_FILE:
 		{
 			JHF_t* o = obj;
+			dset->file = j_hdf5_file_ref(o);
 			dset->location = g_build_path("/", o->name, name, NULL);
 		}
 
@@ -1294,6 +1502,7 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 		case H5I_GROUP:
 		{
 			JHG_t* o = obj;
+			dset->file = j_hdf5_file_ref(o->file);
 			dset->location = g_build_path("/", o->location, name, NULL);
 		}
 		break;
@@ -1318,14 +1527,10 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
 			exit(1);
 	}
 
-	tsloc = g_strdup_printf("%s_data", dset->location);
-	dset->kv = j_kv_new("hdf5", tsloc);
-	g_free(tsloc);
+	dset->kv_key = g_strdup_printf("%s_data", dset->location);
+	dset->kv = j_kv_new("hdf5", dset->kv_key);
 
-	batch = j_batch_new(j_hdf5_semantics);
-	j_kv_get(dset->kv, &value, &len, batch);
-
-	if (j_batch_execute(batch))
+	if (j_hdf5_file_get(dset->file, dset->kv, dset->kv_key, &value, &len))
 	{
 		bson_t kvdata[1];
 
@@ -1343,29 +1548,41 @@ H5VL_julea_dataset_open(void* obj, const H5VL_loc_params_t* loc_params, const ch
  * Reads the data from the dataset
  **/
 static herr_t
-H5VL_julea_dataset_read(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id __attribute__((unused)), hid_t file_space_id __attribute__((unused)), hid_t plist_id __attribute__((unused)), void* buf, void** req __attribute__((unused)))
+H5VL_julea_dataset_read(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id __attribute__((unused)), hid_t file_space_id __attribute__((unused)), hid_t plist_id __attribute__((unused)), void* buf, void** req)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JBatch) batch = NULL;
 	JHD_t* d;
-	guint64 bytes_read;
+	guint64 bytes_read_sync = 0;
+	guint64* bytes_read;
 
 	d = (JHD_t*)dset;
 
+	if (d->created == d->file->flushes && !j_hdf5_file_flush(d->file))
+	{
+		// The object has not been created
+		return -1;
+	}
+
 	batch = j_batch_new(j_hdf5_semantics);
 
-	bytes_read = 0;
+	bytes_read = (req != NULL) ? g_new0(guint64, 1) : &bytes_read_sync;
 
 	g_assert(buf != NULL);
 
 	g_assert(d->object != NULL);
 
-	j_distributed_object_read(d->object, buf, d->data_size, 0, &bytes_read, batch);
+	j_distributed_object_read(d->object, buf, d->data_size, 0, bytes_read, batch);
 
-	if (!j_batch_execute(batch))
+	if (req != NULL)
 	{
-		// FIXME check return value properly
+		// The buffer has to stay valid until the request has completed, the number of bytes is owned by the request
+		*req = j_hdf5_request_new(batch, bytes_read, g_free, NULL);
+	}
+	else if (!j_batch_execute(batch))
+	{
+		return -1;
 	}
 
 	return 1;
@@ -1383,7 +1600,6 @@ H5VL_julea_dataset_get(void* dset, H5VL_dataset_get_t get_type, hid_t dxpl_id __
 
 	herr_t ret_value = 0;
 	JHD_t* d;
-	g_autoptr(JBatch) batch = NULL;
 
 	gpointer value;
 	guint32 len;
@@ -1401,9 +1617,7 @@ H5VL_julea_dataset_get(void* dset, H5VL_dataset_get_t get_type, hid_t dxpl_id __
 			hid_t* ret_id = va_arg(arguments, hid_t*);
 			void* space;
 
-			batch = j_batch_new(j_hdf5_semantics);
-			j_kv_get(d->kv, &value, &len, batch);
-			if (j_batch_execute(batch))
+			if (j_hdf5_file_get(d->file, d->kv, d->kv_key, &value, &len))
 			{
 				bson_t b[1];
 
@@ -1424,9 +1638,7 @@ H5VL_julea_dataset_get(void* dset, H5VL_dataset_get_t get_type, hid_t dxpl_id __
 			hid_t* ret_id = va_arg(arguments, hid_t*);
 			void* type;
 
-			batch = j_batch_new(j_hdf5_semantics);
-			j_kv_get(d->kv, &value, &len, batch);
-			if (j_batch_execute(batch))
+			if (j_hdf5_file_get(d->file, d->kv, d->kv_key, &value, &len))
 			{
 				bson_t b[1];
 
@@ -1450,25 +1662,37 @@ H5VL_julea_dataset_get(void* dset, H5VL_dataset_get_t get_type, hid_t dxpl_id __
  * Writes the data to the dataset
  **/
 static herr_t
-H5VL_julea_dataset_write(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id __attribute__((unused)), hid_t file_space_id __attribute__((unused)), hid_t plist_id __attribute__((unused)), const void* buf, void** req __attribute__((unused)))
+H5VL_julea_dataset_write(void* dset, hid_t mem_type_id __attribute__((unused)), hid_t mem_space_id __attribute__((unused)), hid_t file_space_id __attribute__((unused)), hid_t plist_id __attribute__((unused)), const void* buf, void** req)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	g_autoptr(JBatch) batch = NULL;
 	JHD_t* d;
-	guint64 bytes_written;
+	guint64 bytes_written_sync = 0;
+	guint64* bytes_written;
 
 	d = (JHD_t*)dset;
 
+	if (d->created == d->file->flushes && !j_hdf5_file_flush(d->file))
+	{
+		// The object has not been created
+		return -1;
+	}
+
 	batch = j_batch_new(j_hdf5_semantics);
 
-	bytes_written = 0;
+	bytes_written = (req != NULL) ? g_new0(guint64, 1) : &bytes_written_sync;
 
-	j_distributed_object_write(d->object, buf, d->data_size, 0, &bytes_written, batch);
+	j_distributed_object_write(d->object, buf, d->data_size, 0, bytes_written, batch);
 
-	if (!j_batch_execute(batch))
+	if (req != NULL)
 	{
-		// FIXME check return value properly
+		// The buffer has to stay valid until the request has completed, the number of bytes is owned by the request
+		*req = j_hdf5_request_new(batch, bytes_written, g_free, NULL);
+	}
+	else if (!j_batch_execute(batch))
+	{
+		return -1;
 	}
 
 	return 1;
@@ -1496,6 +1720,9 @@ H5VL_julea_dataset_close(void* dset, hid_t dxpl_id __attribute__((unused)), void
 		j_distributed_object_unref(d->object);
 	}
 
+	j_hdf5_file_unref(d->file);
+
+	g_free(d->kv_key);
 	g_free(d->name);
 	free(d->location);
 	free(d);
@@ -1616,12 +1843,12 @@ static const H5VL_class_t H5VL_julea_g = {
 		.opt_query = H5VL_julea_introspect_opt_query,
 	},
 	.request_cls = {
-		.wait = NULL,
-		.notify = NULL,
-		.cancel = NULL,
+		.wait = j_hdf5_request_wait,
+		.notify = j_hdf5_request_notify,
+		.cancel = j_hdf5_request_cancel,
 		.specific = NULL,
 		.optional = NULL,
-		.free = NULL,
+		.free = j_hdf5_request_free,
 	},
 	.blob_cls = {
 		.put = NULL,
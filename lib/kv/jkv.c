@@ -59,6 +59,30 @@ struct JKVOperation
 			guint32 value_len;
 			GDestroyNotify value_destroy;
 		} put;
+
+		struct
+		{
+			JKV* kv;
+			gpointer old_value;
+			guint32 old_value_len;
+			gpointer new_value;
+			guint32 new_value_len;
+			gboolean* swapped;
+		} compare_and_swap;
+
+		struct
+		{
+			JKV* kv;
+			gint64 delta;
+			gint64* old_value;
+		} fetch_add;
+
+		struct
+		{
+			JKV* kv;
+			gpointer value;
+			guint32 value_len;
+		} append;
 	};
 };
 
@@ -188,6 +212,47 @@ j_kv_get_free(gpointer data)
 	g_slice_free(JKVOperation, operation);
 }
 
+static void
+j_kv_compare_and_swap_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	j_kv_unref(operation->compare_and_swap.kv);
+
+	g_free(operation->compare_and_swap.old_value);
+	g_free(operation->compare_and_swap.new_value);
+
+	g_slice_free(JKVOperation, operation);
+}
+
+static void
+j_kv_fetch_add_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	j_kv_unref(operation->fetch_add.kv);
+
+	g_slice_free(JKVOperation, operation);
+}
+
+static void
+j_kv_append_free(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* operation = data;
+
+	j_kv_unref(operation->append.kv);
+
+	g_free(operation->append.value);
+
+	g_slice_free(JKVOperation, operation);
+}
+
 static gboolean
 j_kv_put_exec(JList* operations, JSemantics* semantics)
 {
@@ -528,6 +593,305 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 	return ret;
 }
 
+static gboolean
+j_kv_compare_and_swap_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->compare_and_swap.kv->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = kop->compare_and_swap.kv->index;
+	}
+
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend();
+
+	if (kv_backend == NULL)
+	{
+		message = j_message_new(J_MESSAGE_KV_COMPARE_AND_SWAP, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+			gchar has_old;
+
+			key_len = strlen(kop->compare_and_swap.kv->key) + 1;
+			has_old = (kop->compare_and_swap.old_value != NULL) ? 1 : 0;
+
+			j_message_add_operation(message, key_len + 1 + 4 + kop->compare_and_swap.old_value_len + 4 + kop->compare_and_swap.new_value_len);
+			j_message_append_n(message, kop->compare_and_swap.kv->key, key_len);
+			j_message_append_1(message, &has_old);
+			j_message_append_4(message, &(kop->compare_and_swap.old_value_len));
+
+			if (has_old)
+			{
+				j_message_append_n(message, kop->compare_and_swap.old_value, kop->compare_and_swap.old_value_len);
+			}
+
+			j_message_append_4(message, &(kop->compare_and_swap.new_value_len));
+			j_message_append_n(message, kop->compare_and_swap.new_value, kop->compare_and_swap.new_value_len);
+		}
+		else
+		{
+			gboolean swapped;
+
+			swapped = j_backend_kv_compare_and_swap(kv_backend, namespace, semantics, kop->compare_and_swap.kv->key, kop->compare_and_swap.old_value, kop->compare_and_swap.old_value_len, kop->compare_and_swap.new_value, kop->compare_and_swap.new_value_len);
+
+			if (kop->compare_and_swap.swapped != NULL)
+			{
+				*(kop->compare_and_swap.swapped) = swapped;
+			}
+		}
+	}
+
+	if (kv_backend == NULL)
+	{
+		g_autoptr(JListIterator) iter = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		gpointer kv_connection;
+
+		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
+		j_message_send(message, kv_connection);
+
+		reply = j_message_new_reply(message);
+		j_message_receive(reply, kv_connection);
+
+		iter = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(iter))
+		{
+			JKVOperation* kop = j_list_iterator_get(iter);
+			guint32 status;
+
+			status = j_message_get_4(reply);
+
+			if (kop->compare_and_swap.swapped != NULL)
+			{
+				*(kop->compare_and_swap.swapped) = (status != 0);
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	}
+
+	// A failed comparison is a valid result and does not make the batch fail
+	return ret;
+}
+
+static gboolean
+j_kv_fetch_add_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->fetch_add.kv->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = kop->fetch_add.kv->index;
+	}
+
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend();
+
+	if (kv_backend == NULL)
+	{
+		message = j_message_new(J_MESSAGE_KV_FETCH_ADD, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+
+			key_len = strlen(kop->fetch_add.kv->key) + 1;
+
+			j_message_add_operation(message, key_len + 8);
+			j_message_append_n(message, kop->fetch_add.kv->key, key_len);
+			j_message_append_8(message, &(kop->fetch_add.delta));
+		}
+		else
+		{
+			gint64 old_value = 0;
+
+			ret = j_backend_kv_fetch_add(kv_backend, namespace, semantics, kop->fetch_add.kv->key, kop->fetch_add.delta, &old_value) && ret;
+
+			if (kop->fetch_add.old_value != NULL)
+			{
+				*(kop->fetch_add.old_value) = old_value;
+			}
+		}
+	}
+
+	if (kv_backend == NULL)
+	{
+		g_autoptr(JListIterator) iter = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		gpointer kv_connection;
+
+		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
+		j_message_send(message, kv_connection);
+
+		reply = j_message_new_reply(message);
+		j_message_receive(reply, kv_connection);
+
+		iter = j_list_iterator_new(operations);
+
+		while (j_list_iterator_next(iter))
+		{
+			JKVOperation* kop = j_list_iterator_get(iter);
+			guint32 status;
+			gint64 old_value;
+
+			status = j_message_get_4(reply);
+			old_value = j_message_get_8(reply);
+
+			ret = (status != 0) && ret;
+
+			if (kop->fetch_add.old_value != NULL)
+			{
+				*(kop->fetch_add.old_value) = old_value;
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_kv_append_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	JSemanticsSafety safety;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JKVOperation* kop;
+
+		kop = j_list_get_first(operations);
+		g_assert(kop != NULL);
+
+		namespace = kop->append.kv->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = kop->append.kv->index;
+	}
+
+	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+	it = j_list_iterator_new(operations);
+	kv_backend = j_kv_get_backend();
+
+	if (kv_backend == NULL)
+	{
+		message = j_message_new(J_MESSAGE_KV_APPEND, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+
+	while (j_list_iterator_next(it))
+	{
+		JKVOperation* kop = j_list_iterator_get(it);
+
+		if (kv_backend == NULL)
+		{
+			gsize key_len;
+
+			key_len = strlen(kop->append.kv->key) + 1;
+
+			j_message_add_operation(message, key_len + 4 + kop->append.value_len);
+			j_message_append_n(message, kop->append.kv->key, key_len);
+			j_message_append_4(message, &(kop->append.value_len));
+			j_message_append_n(message, kop->append.value, kop->append.value_len);
+		}
+		else
+		{
+			ret = j_backend_kv_append(kv_backend, namespace, semantics, kop->append.kv->key, kop->append.value, kop->append.value_len) && ret;
+		}
+	}
+
+	if (kv_backend == NULL)
+	{
+		gpointer kv_connection;
+
+		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
+		j_message_send(message, kv_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, kv_connection);
+
+			for (guint i = 0; i < j_message_get_count(reply); i++)
+			{
+				ret = (j_message_get_4(reply) != 0) && ret;
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	}
+
+	return ret;
+}
+
 /**
  * Creates a new key-value pair.
  *
@@ -781,6 +1145,150 @@ j_kv_get_callback(JKV* kv, JKVGetFunc func, gpointer data, JBatch* batch)
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Atomically replaces a key-value pair's value if it matches an expected value.
+ *
+ * The comparison and replacement are executed on the server, avoiding a separate j_kv_get().
+ * A failed comparison does not make the batch fail, use \p swapped to check the result.
+ *
+ * \code
+ * \endcode
+ *
+ * \param kv            A key-value pair.
+ * \param old_value     The expected value, or NULL if the key-value pair must not exist.
+ * \param old_value_len The expected value's length.
+ * \param new_value     The new value.
+ * \param new_value_len The new value's length.
+ * \param swapped       Returns whether the value has been replaced (may be NULL).
+ * \param batch         A batch.
+ **/
+void
+j_kv_compare_and_swap(JKV* kv, gconstpointer old_value, guint32 old_value_len, gconstpointer new_value, guint32 new_value_len, gboolean* swapped, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* kop;
+	JOperation* operation;
+
+	g_return_if_fail(kv != NULL);
+	g_return_if_fail(new_value != NULL);
+
+	kop = g_slice_new(JKVOperation);
+	kop->compare_and_swap.kv = j_kv_ref(kv);
+	kop->compare_and_swap.old_value = NULL;
+	kop->compare_and_swap.old_value_len = 0;
+	kop->compare_and_swap.new_value_len = new_value_len;
+	kop->compare_and_swap.swapped = swapped;
+
+	if (old_value != NULL)
+	{
+#if GLIB_CHECK_VERSION(2, 68, 0)
+		kop->compare_and_swap.old_value = g_memdup2(old_value, old_value_len);
+#else
+		kop->compare_and_swap.old_value = g_memdup(old_value, old_value_len);
+#endif
+		kop->compare_and_swap.old_value_len = old_value_len;
+	}
+
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	kop->compare_and_swap.new_value = g_memdup2(new_value, new_value_len);
+#else
+	kop->compare_and_swap.new_value = g_memdup(new_value, new_value_len);
+#endif
+
+	if (swapped != NULL)
+	{
+		*swapped = FALSE;
+	}
+
+	operation = j_operation_new();
+	operation->key = kv;
+	operation->data = kop;
+	operation->exec_func = j_kv_compare_and_swap_exec;
+	operation->free_func = j_kv_compare_and_swap_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Atomically adds to a key-value pair's 64-bit integer value.
+ *
+ * Values are stored as 8 bytes in little endian byte order.
+ * Key-value pairs that do not exist are treated as having a value of 0.
+ *
+ * \code
+ * \endcode
+ *
+ * \param kv        A key-value pair.
+ * \param delta     The value to add.
+ * \param old_value Returns the value before the addition (may be NULL).
+ * \param batch     A batch.
+ **/
+void
+j_kv_fetch_add(JKV* kv, gint64 delta, gint64* old_value, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* kop;
+	JOperation* operation;
+
+	g_return_if_fail(kv != NULL);
+
+	kop = g_slice_new(JKVOperation);
+	kop->fetch_add.kv = j_kv_ref(kv);
+	kop->fetch_add.delta = delta;
+	kop->fetch_add.old_value = old_value;
+
+	operation = j_operation_new();
+	operation->key = kv;
+	operation->data = kop;
+	operation->exec_func = j_kv_fetch_add_exec;
+	operation->free_func = j_kv_fetch_add_free;
+
+	j_batch_add(batch, operation);
+}
+
+/**
+ * Atomically appends data to a key-value pair's value.
+ * Key-value pairs that do not exist are created.
+ *
+ * \code
+ * \endcode
+ *
+ * \param kv        A key-value pair.
+ * \param value     The data to append.
+ * \param value_len The data's length.
+ * \param batch     A batch.
+ **/
+void
+j_kv_append(JKV* kv, gconstpointer value, guint32 value_len, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* kop;
+	JOperation* operation;
+
+	g_return_if_fail(kv != NULL);
+	g_return_if_fail(value != NULL);
+
+	kop = g_slice_new(JKVOperation);
+	kop->append.kv = j_kv_ref(kv);
+#if GLIB_CHECK_VERSION(2, 68, 0)
+	kop->append.value = g_memdup2(value, value_len);
+#else
+	kop->append.value = g_memdup(value, value_len);
+#endif
+	kop->append.value_len = value_len;
+
+	operation = j_operation_new();
+	operation->key = kv;
+	operation->data = kop;
+	operation->exec_func = j_kv_append_exec;
+	operation->free_func = j_kv_append_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * Returns the kv backend.
  *
@@ -28,6 +28,309 @@
 
 static guint jd_thread_num = 0;
 
+/**
+ * Maximum number of rows sent per reply when streaming query results.
+ **/
+static guint const jd_db_query_batch_size = 1000;
+
+/**
+ * Number of seconds after which idle cursors are closed.
+ * An open cursor occupies a thread and keeps the query's batch open, which might hold locks in the backend.
+ **/
+static guint const jd_db_query_cursor_timeout = 60;
+
+/**
+ * Executes a DB batch.
+ * A failure is reported via error unless an error has already been set, otherwise it is logged.
+ *
+ * \param batch The batch.
+ * \param error A GError, may be NULL.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_db_batch_execute(gpointer batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError* execute_error = NULL;
+
+	if (batch == NULL)
+	{
+		return FALSE;
+	}
+
+	if (j_backend_db_batch_execute(jd_db_backend, batch, &execute_error))
+	{
+		return TRUE;
+	}
+
+	if (execute_error == NULL)
+	{
+		execute_error = g_error_new_literal(J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "batch execution failed");
+	}
+
+	if (error != NULL && *error == NULL)
+	{
+		g_propagate_error(error, execute_error);
+	}
+	else
+	{
+		g_warning("%s %s", G_STRLOC, execute_error->message);
+		g_error_free(execute_error);
+	}
+
+	return FALSE;
+}
+
+/**
+ * Streams the remaining rows of a query.
+ * The client keeps the connection until it has fetched all rows or closes the cursor,
+ * so no other messages are received in between.
+ * The query's batch is kept open while streaming and executed once the cursor has been closed.
+ * If the client does not request more rows within jd_db_query_cursor_timeout seconds, the cursor and the connection are closed.
+ *
+ * \param connection       The connection.
+ * \param backend_operation The query operation with an open backend iterator.
+ * \param batch            The query's batch.
+ **/
+static void
+jd_handle_db_query_cursor(GSocketConnection* connection, JBackendOperation* backend_operation, gpointer batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) message = NULL;
+	GSocket* socket;
+	gboolean lost = FALSE;
+
+	message = j_message_new(J_MESSAGE_NONE, 0);
+	socket = g_socket_connection_get_socket(connection);
+
+	g_socket_set_timeout(socket, jd_db_query_cursor_timeout);
+
+	while (backend_operation->backend_iterator != NULL)
+	{
+		g_autoptr(JMessage) reply = NULL;
+
+		if (!j_message_receive(message, connection))
+		{
+			lost = TRUE;
+			break;
+		}
+
+		if (j_message_get_type(message) != J_MESSAGE_DB_QUERY_NEXT)
+		{
+			break;
+		}
+
+		reply = j_message_new_reply(message);
+
+		backend_operation->out_param[0].ptr = &(backend_operation->out_param[0].bson);
+		backend_operation->out_param[1].ptr = &(backend_operation->out_param[1].bson);
+		backend_operation->out_param[2].ptr = &(backend_operation->out_param[2].error_ptr);
+		backend_operation->out_param[2].error_ptr = NULL;
+
+		j_backend_operation_db_query_next(jd_db_backend, backend_operation);
+
+		backend_operation->out_param[0].bson_initialized = TRUE;
+		backend_operation->out_param[1].bson_initialized = TRUE;
+
+		j_backend_operation_to_message(reply, backend_operation->out_param, backend_operation->out_param_count);
+
+		bson_destroy(&(backend_operation->out_param[0].bson));
+		bson_destroy(&(backend_operation->out_param[1].bson));
+
+		j_message_send(reply, connection);
+	}
+
+	g_socket_set_timeout(socket, 0);
+
+	// The client has closed the cursor, the cursor has timed out or the connection has been lost
+	j_backend_operation_db_query_close(jd_db_backend, backend_operation);
+
+	jd_db_batch_execute(batch, NULL);
+
+	if (lost)
+	{
+		// The client might still send requests for the closed cursor, closing the connection tells it that the cursor is gone
+		g_io_stream_close(G_IO_STREAM(connection), NULL, NULL);
+	}
+}
+
+/**
+ * Handles a batch of inserts.
+ * Consecutive inserts into the same schema are passed to the backend at once,
+ * allowing it to insert multiple rows per statement.
+ * Unless the whole batch is atomic, inserts are retried one by one if a group fails,
+ * so that errors are reported for the offending inserts only.
+ *
+ * \param message         The message containing the inserts.
+ * \param connection      The connection.
+ * \param semantics       The semantics of the batch.
+ * \param operation_count The number of inserts.
+ **/
+static void
+jd_handle_db_insert(JMessage* message, GSocketConnection* connection, JSemantics* semantics, guint32 operation_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(JMessage) reply = NULL;
+	g_autofree JBackendOperation* operations = NULL;
+	g_autofree bson_t const** metadata = NULL;
+	g_autofree bson_t* ids = NULL;
+	g_autofree gboolean* ids_valid = NULL;
+	g_autofree GError** errors = NULL;
+	JSemanticsAtomicity atomicity;
+	GError* error = NULL;
+	gpointer batch = NULL;
+	gboolean ret = TRUE;
+	guint32 i;
+	guint32 j;
+
+	reply = j_message_new_reply(message);
+	operations = g_new(JBackendOperation, operation_count);
+	metadata = g_new(bson_t const*, operation_count);
+	ids = g_new(bson_t, operation_count);
+	ids_valid = g_new0(gboolean, operation_count);
+	errors = g_new0(GError*, operation_count);
+	atomicity = j_semantics_get(semantics, J_SEMANTICS_ATOMICITY);
+
+	// All inserts are read first, their parameters point into the message
+	for (i = 0; i < operation_count; i++)
+	{
+		memcpy(&operations[i], &j_backend_operation_db_insert, sizeof(JBackendOperation));
+		j_backend_operation_from_message_static(message, operations[i].in_param, operations[i].in_param_count);
+		metadata[i] = operations[i].in_param[2].ptr;
+	}
+
+	if (atomicity == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		j_backend_db_batch_start(jd_db_backend, operations[0].in_param[0].ptr, semantics, &batch, &error);
+	}
+
+	for (i = 0; i < operation_count; i = j)
+	{
+		gchar const* name = operations[i].in_param[1].ptr;
+		guint32 k;
+
+		for (j = i + 1; j < operation_count && g_strcmp0(operations[j].in_param[1].ptr, name) == 0; j++)
+		{
+		}
+
+		if (atomicity == J_SEMANTICS_ATOMICITY_BATCH)
+		{
+			// There should be no more executions in a failed batch
+			if (!ret || error != NULL)
+			{
+				continue;
+			}
+
+			for (k = i; k < j; k++)
+			{
+				bson_init(&ids[k]);
+			}
+
+			ret = j_backend_db_insert_many(jd_db_backend, batch, name, metadata + i, ids + i, j - i, &error);
+		}
+		else
+		{
+			GError* run_error = NULL;
+			gpointer run_batch = NULL;
+
+			for (k = i; k < j; k++)
+			{
+				bson_init(&ids[k]);
+			}
+
+			ret = j_backend_db_batch_start(jd_db_backend, operations[i].in_param[0].ptr, semantics, &run_batch, &run_error);
+			ret = ret && j_backend_db_insert_many(jd_db_backend, run_batch, name, metadata + i, ids + i, j - i, &run_error);
+
+			if (run_batch != NULL)
+			{
+				j_backend_db_batch_execute(jd_db_backend, run_batch, NULL);
+			}
+
+			g_clear_error(&run_error);
+
+			if (!ret)
+			{
+				// Each insert is its own transaction, so find out which ones fail
+				for (k = i; k < j; k++)
+				{
+					gpointer operation_batch = NULL;
+
+					bson_destroy(&ids[k]);
+					bson_init(&ids[k]);
+
+					if (j_backend_db_batch_start(jd_db_backend, operations[k].in_param[0].ptr, semantics, &operation_batch, &errors[k]))
+					{
+						ids_valid[k] = j_backend_db_insert(jd_db_backend, operation_batch, name, metadata[k], &ids[k], &errors[k]);
+					}
+
+					if (operation_batch != NULL)
+					{
+						j_backend_db_batch_execute(jd_db_backend, operation_batch, NULL);
+					}
+
+					if (!ids_valid[k])
+					{
+						bson_destroy(&ids[k]);
+					}
+				}
+
+				continue;
+			}
+		}
+
+		for (k = i; k < j; k++)
+		{
+			if (ret)
+			{
+				ids_valid[k] = TRUE;
+			}
+			else
+			{
+				bson_destroy(&ids[k]);
+			}
+		}
+	}
+
+	if (atomicity == J_SEMANTICS_ATOMICITY_BATCH)
+	{
+		j_backend_db_batch_execute(jd_db_backend, batch, NULL);
+	}
+
+	for (i = 0; i < operation_count; i++)
+	{
+		JBackendOperation* operation = &operations[i];
+
+		if (errors[i] == NULL && !ids_valid[i] && error != NULL)
+		{
+			errors[i] = g_error_copy(error);
+		}
+
+		operation->out_param[0].ptr = &ids[i];
+		operation->out_param[0].bson_initialized = ids_valid[i];
+		operation->out_param[1].ptr = &operation->out_param[1].error_ptr;
+		operation->out_param[1].error_ptr = errors[i];
+
+		// Frees the error
+		j_backend_operation_to_message(reply, operation->out_param, operation->out_param_count);
+
+		if (ids_valid[i])
+		{
+			bson_destroy(&ids[i]);
+		}
+	}
+
+	if (error)
+	{
+		g_error_free(error);
+	}
+
+	j_message_send(reply, connection);
+}
+
 gboolean
 jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk* memory_chunk, guint64 memory_chunk_size, JStatistics* statistics)
 {
@@ -399,6 +702,8 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		{
 			g_autoptr(JMessage) reply = NULL;
 			JStatistics* r_statistics;
+			g_autofree gchar* backend_statistics = NULL;
+			g_autofree gchar* db_backend_statistics = NULL;
 			gchar get_all;
 			guint64 value;
 
@@ -411,8 +716,22 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				/* FIXME add statistics of all threads */
 			}
 
+			if (jd_kv_backend == NULL || !j_backend_kv_statistics(jd_kv_backend, &backend_statistics))
+			{
+				g_free(backend_statistics);
+				backend_statistics = g_strdup("");
+			}
+
+			if (jd_db_backend != NULL && j_backend_db_statistics(jd_db_backend, &db_backend_statistics))
+			{
+				gchar* tmp = backend_statistics;
+
+				backend_statistics = g_strconcat(tmp, db_backend_statistics, NULL);
+				g_free(tmp);
+			}
+
 			reply = j_message_new_reply(message);
-			j_message_add_operation(reply, 8 * sizeof(guint64));
+			j_message_add_operation(reply, 8 * sizeof(guint64) + strlen(backend_statistics) + 1);
 
 			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_CREATED);
 			j_message_append_8(reply, &value);
@@ -430,6 +749,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			j_message_append_8(reply, &value);
 			value = j_statistics_get(r_statistics, J_STATISTICS_BYTES_SENT);
 			j_message_append_8(reply, &value);
+			j_message_append_string(reply, backend_statistics);
 
 			if (get_all != 0)
 			{
@@ -592,6 +912,108 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			j_message_send(reply, connection);
 		}
 		break;
+		case J_MESSAGE_KV_COMPARE_AND_SWAP:
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				gconstpointer old_data = NULL;
+				gconstpointer new_data;
+				guint32 old_len;
+				guint32 new_len;
+				guint32 status;
+				gchar has_old;
+
+				key = j_message_get_string(message);
+				has_old = j_message_get_1(message);
+				old_len = j_message_get_4(message);
+
+				if (has_old)
+				{
+					old_data = j_message_get_n(message, old_len);
+				}
+
+				new_len = j_message_get_4(message);
+				new_data = j_message_get_n(message, new_len);
+
+				status = (j_backend_kv_compare_and_swap(jd_kv_backend, namespace, semantics, key, old_data, old_len, new_data, new_len)) ? 1 : 0;
+
+				j_message_add_operation(reply, 4);
+				j_message_append_4(reply, &status);
+			}
+
+			j_message_send(reply, connection);
+		}
+		break;
+		case J_MESSAGE_KV_FETCH_ADD:
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				gint64 delta;
+				gint64 old_value = 0;
+				guint32 status;
+
+				key = j_message_get_string(message);
+				delta = j_message_get_8(message);
+
+				status = (j_backend_kv_fetch_add(jd_kv_backend, namespace, semantics, key, delta, &old_value)) ? 1 : 0;
+
+				j_message_add_operation(reply, 4 + 8);
+				j_message_append_4(reply, &status);
+				j_message_append_8(reply, &old_value);
+			}
+
+			j_message_send(reply, connection);
+		}
+		break;
+		case J_MESSAGE_KV_APPEND:
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			namespace = j_message_get_string(message);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				gconstpointer data;
+				guint32 len;
+				gboolean ret;
+
+				key = j_message_get_string(message);
+				len = j_message_get_4(message);
+				data = j_message_get_n(message, len);
+
+				ret = j_backend_kv_append(jd_kv_backend, namespace, semantics, key, data, len);
+
+				if (reply != NULL)
+				{
+					guint32 dummy;
+
+					dummy = (ret) ? 1 : 0;
+					j_message_add_operation(reply, 4);
+					j_message_append_4(reply, &dummy);
+				}
+			}
+
+			if (reply != NULL)
+			{
+				j_message_send(reply, connection);
+			}
+		}
+		break;
 		case J_MESSAGE_KV_GET_ALL:
 		{
 			g_autoptr(JMessage) reply = NULL;
@@ -678,6 +1100,12 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 			// fallthrough
 		case J_MESSAGE_DB_INSERT:
+			if (!message_matched && operation_count > 1)
+			{
+				jd_handle_db_insert(message, connection, semantics, operation_count);
+				break;
+			}
+
 			if (!message_matched)
 			{
 				memcpy(&backend_operation, &j_backend_operation_db_insert, sizeof(JBackendOperation));
@@ -703,6 +1131,12 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			{
 				memcpy(&backend_operation, &j_backend_operation_db_query, sizeof(JBackendOperation));
 				message_matched = TRUE;
+
+				// Results of single queries are streamed in batches
+				if (operation_count == 1)
+				{
+					backend_operation.batch_size = jd_db_query_batch_size;
+				}
 			}
 			{
 				g_autoptr(JMessage) reply = NULL;
@@ -789,7 +1223,11 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 							break;
 						case J_SEMANTICS_ATOMICITY_OPERATION:
 						case J_SEMANTICS_ATOMICITY_NONE:
-							j_backend_db_batch_execute(jd_db_backend, batch, NULL);
+							// Streamed queries keep their batch open until the cursor has been closed
+							if (backend_operation.backend_iterator == NULL)
+							{
+								jd_db_batch_execute(batch, backend_operation.out_param[backend_operation.out_param_count - 1].ptr);
+							}
 
 							if (error)
 							{
@@ -824,7 +1262,10 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				switch (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY))
 				{
 					case J_SEMANTICS_ATOMICITY_BATCH:
-						j_backend_db_batch_execute(jd_db_backend, batch, NULL);
+						if (backend_operation.backend_iterator == NULL)
+						{
+							jd_db_batch_execute(batch, NULL);
+						}
 
 						if (error)
 						{
@@ -841,8 +1282,18 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				}
 
 				j_message_send(reply, connection);
+
+				if (backend_operation.backend_iterator != NULL)
+				{
+					jd_handle_db_query_cursor(connection, &backend_operation, batch);
+				}
 			}
 			break;
+		case J_MESSAGE_DB_QUERY_NEXT:
+		case J_MESSAGE_DB_QUERY_CLOSE:
+			// Only valid while a cursor is open, see jd_handle_db_query_cursor
+			g_warn_if_reached();
+			break;
 		default:
 			g_warn_if_reached();
 			break;
@@ -74,6 +74,7 @@ test_configuration_get(void)
 	gchar const* object_servers[] = { "localhost", "local.host", NULL };
 	gchar const* kv_servers[] = { "localhost", NULL };
 	gchar const* db_servers[] = { "localhost", "host.local", NULL };
+	g_autofree gchar* option = NULL;
 
 	key_file = g_key_file_new();
 	g_key_file_set_string_list(key_file, "servers", "object", object_servers, 2);
@@ -85,6 +86,8 @@ test_configuration_get(void)
 	g_key_file_set_string(key_file, "kv", "backend", "null2");
 	g_key_file_set_string(key_file, "kv", "component", "client");
 	g_key_file_set_string(key_file, "kv", "path", "NULL2");
+	g_key_file_set_string(key_file, "kv", "option", "value");
+	g_key_file_set_uint64(key_file, "kv", "size", 42);
 	g_key_file_set_string(key_file, "db", "backend", "null3");
 	g_key_file_set_string(key_file, "db", "component", "client");
 	g_key_file_set_string(key_file, "db", "path", "NULL3");
@@ -111,6 +114,12 @@ test_configuration_get(void)
 	g_assert_cmpstr(j_configuration_get_backend_component(configuration, J_BACKEND_TYPE_KV), ==, "client");
 	g_assert_cmpstr(j_configuration_get_backend_path(configuration, J_BACKEND_TYPE_KV), ==, "NULL2");
 
+	option = j_configuration_get_backend_option(configuration, J_BACKEND_TYPE_KV, "option");
+	g_assert_cmpstr(option, ==, "value");
+	g_assert_null(j_configuration_get_backend_option(configuration, J_BACKEND_TYPE_DB, "option"));
+	g_assert_cmpuint(j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_KV, "size", 0), ==, 42);
+	g_assert_cmpuint(j_configuration_get_backend_option_uint64(configuration, J_BACKEND_TYPE_KV, "missing", 23), ==, 23);
+
 	g_assert_cmpstr(j_configuration_get_backend(configuration, J_BACKEND_TYPE_DB), ==, "null3");
 	g_assert_cmpstr(j_configuration_get_backend_component(configuration, J_BACKEND_TYPE_DB), ==, "client");
 	g_assert_cmpstr(j_configuration_get_backend_path(configuration, J_BACKEND_TYPE_DB), ==, "NULL3");
@@ -165,6 +165,25 @@ test_message_write_read(void)
 	g_assert_cmpstr(dummy_str, ==, "42");
 }
 
+static void
+test_message_written(void)
+{
+	g_autoptr(GOutputStream) output = NULL;
+	g_autoptr(JMessage) message = NULL;
+	guint32 written;
+	gboolean ret;
+
+	output = g_memory_output_stream_new(NULL, 0, g_realloc, g_free);
+	message = j_message_new(J_MESSAGE_NONE, 0);
+
+	written = j_message_get_written();
+
+	ret = j_message_write(message, output);
+	g_assert_true(ret);
+
+	g_assert_cmpuint(j_message_get_written() - written, >=, 1);
+}
+
 static void
 test_message_semantics(void)
 {
@@ -198,5 +217,6 @@ test_core_message(void)
 	g_test_add_func("/core/message/header", test_message_header);
 	g_test_add_func("/core/message/append", test_message_append);
 	g_test_add_func("/core/message/write_read", test_message_write_read);
+	g_test_add_func("/core/message/written", test_message_written);
 	g_test_add_func("/core/message/semantics", test_message_semantics);
 }
@@ -205,7 +205,7 @@ test_db_entry_insert_update_delete(void)
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
-	ret = j_db_entry_update(update_entry, selector, batch, &error);
+	ret = j_db_entry_update(update_entry, selector, NULL, batch, &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
@@ -217,7 +217,7 @@ test_db_entry_insert_update_delete(void)
 	g_assert_nonnull(delete_entry);
 	g_assert_no_error(error);
 
-	ret = j_db_entry_delete(delete_entry, selector, batch, &error);
+	ret = j_db_entry_delete(delete_entry, selector, NULL, batch, &error);
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
@@ -233,6 +233,1807 @@ test_db_entry_insert_update_delete(void)
 	g_assert_true(ret);
 }
 
+static guint
+db_count_entries(JDBSchema* schema, gchar const* name, guint64 value)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	guint count = 0;
+	gboolean ret;
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector, name, J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		count++;
+	}
+
+	return count;
+}
+
+static void
+test_db_entry_update_delete_many(void)
+{
+	guint const n = 20;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBEntry) update_entry = NULL;
+	g_autoptr(JDBEntry) delete_entry = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	guint64 value;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-update-delete-many", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-1", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Entries are split into two groups by uint-0
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		guint64 group = i % 2;
+		guint64 other = 0;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &group, sizeof(group), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-1", &other, sizeof(other), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	update_entry = j_db_entry_new(schema, &error);
+	g_assert_nonnull(update_entry);
+	g_assert_no_error(error);
+
+	value = 42;
+	ret = j_db_entry_set_field(update_entry, "uint-1", &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	delete_entry = j_db_entry_new(schema, &error);
+	g_assert_nonnull(delete_entry);
+	g_assert_no_error(error);
+
+	// An update without conditions is rejected instead of modifying all entries
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_update(update_entry, selector, NULL, batch, &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_EMPTY);
+		g_clear_error(&error);
+	}
+
+	// Query options cannot be honoured by updates and deletes
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		value = 0;
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_set_limit(selector, 1, 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_update(update_entry, selector, NULL, batch, &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX);
+		g_clear_error(&error);
+
+		ret = j_db_entry_delete(delete_entry, selector, NULL, batch, &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX);
+		g_clear_error(&error);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		value = 1;
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_order(selector, "uint-0", J_DB_SELECTOR_ORDER_ASCENDING, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_delete(delete_entry, selector, NULL, batch, &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX);
+		g_clear_error(&error);
+	}
+
+	// Nothing has been modified so far
+	g_assert_cmpuint(db_count_entries(schema, "uint-1", 42), ==, 0);
+	g_assert_cmpuint(db_count_entries(schema, "uint-0", 0), ==, n / 2);
+	g_assert_cmpuint(db_count_entries(schema, "uint-0", 1), ==, n / 2);
+
+	// An update modifies all matching entries
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		guint64 count = 0;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		value = 0;
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_update(update_entry, selector, &count, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(count, ==, n / 2);
+	}
+
+	g_assert_cmpuint(db_count_entries(schema, "uint-1", 42), ==, n / 2);
+	g_assert_cmpuint(db_count_entries(schema, "uint-1", 0), ==, n / 2);
+
+	// A delete removes all matching entries
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		guint64 count = 0;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		value = 42;
+		ret = j_db_selector_add_field(selector, "uint-1", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_delete(delete_entry, selector, &count, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_cmpuint(count, ==, n / 2);
+	}
+
+	g_assert_cmpuint(db_count_entries(schema, "uint-0", 0), ==, 0);
+	g_assert_cmpuint(db_count_entries(schema, "uint-0", 1), ==, n / 2);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_entry_batch_rollback(void)
+{
+	guint const n = 4;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBEntry) entry = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	guint64 value;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-batch-rollback", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-1", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	{
+		g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+		ret = j_db_schema_create(schema, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		for (guint i = 0; i < n; i++)
+		{
+			g_autoptr(JDBEntry) insert_entry = NULL;
+
+			insert_entry = j_db_entry_new(schema, &error);
+			g_assert_nonnull(insert_entry);
+			g_assert_no_error(error);
+
+			value = i;
+			ret = j_db_entry_set_field(insert_entry, "uint-0", &value, sizeof(value), &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_entry_insert(insert_entry, batch, NULL);
+			g_assert_true(ret);
+		}
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	entry = j_db_entry_new(schema, &error);
+	g_assert_nonnull(entry);
+	g_assert_no_error(error);
+
+	value = 42;
+	ret = j_db_entry_set_field(entry, "uint-1", &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_ATOMICITY, J_SEMANTICS_ATOMICITY_BATCH);
+
+	// The second operation of each batch does not match any entry and makes the batch fail
+	// Updates are tested in the first iteration, deletes in the second
+	for (guint mode = 0; mode < 2; mode++)
+	{
+		g_autoptr(JBatch) batch = j_batch_new(semantics);
+
+		for (guint i = 0; i < 2; i++)
+		{
+			g_autoptr(JDBSelector) selector = NULL;
+
+			selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+			g_assert_nonnull(selector);
+			g_assert_no_error(error);
+
+			value = (i == 0) ? 1 : n;
+			ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			if (mode == 1)
+			{
+				ret = j_db_entry_delete(entry, selector, NULL, batch, NULL);
+			}
+			else
+			{
+				ret = j_db_entry_update(entry, selector, NULL, batch, NULL);
+			}
+
+			g_assert_true(ret);
+		}
+
+		ret = j_batch_execute(batch);
+		g_assert_false(ret);
+
+		// The first operation has been rolled back
+		g_assert_cmpuint(db_count_entries(schema, "uint-1", 42), ==, 0);
+		g_assert_cmpuint(db_count_entries(schema, "uint-0", 1), ==, 1);
+	}
+
+	{
+		g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+		ret = j_db_schema_delete(schema, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+}
+
+static void
+test_db_entry_insert_many(void)
+{
+	// Enough entries for several multi-row inserts
+	guint const n = 300;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-insert-many", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	{
+		g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+		ret = j_db_schema_create(schema, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	for (guint atomicity = 0; atomicity < 2; atomicity++)
+	{
+		g_autoptr(JSemantics) semantics = NULL;
+		g_autoptr(JBatch) batch = NULL;
+		g_autoptr(GPtrArray) entries = NULL;
+		guint32 previous_id = 0;
+
+		semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+		j_semantics_set(semantics, J_SEMANTICS_ATOMICITY, (atomicity == 0) ? J_SEMANTICS_ATOMICITY_OPERATION : J_SEMANTICS_ATOMICITY_BATCH);
+		batch = j_batch_new(semantics);
+		entries = g_ptr_array_new_with_free_func((GDestroyNotify)j_db_entry_unref);
+
+		for (guint i = 0; i < n; i++)
+		{
+			JDBEntry* entry;
+			guint64 value = i;
+
+			entry = j_db_entry_new(schema, &error);
+			g_assert_nonnull(entry);
+			g_assert_no_error(error);
+
+			ret = j_db_entry_set_field(entry, "uint-0", &value, sizeof(value), &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			// FIXME Do not pass error, will not exist anymore when batch is executed
+			ret = j_db_entry_insert(entry, batch, NULL);
+			g_assert_true(ret);
+
+			g_ptr_array_add(entries, entry);
+		}
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+
+		// Every entry gets its own id in insertion order
+		for (guint i = 0; i < n; i++)
+		{
+			g_autofree guint32* id = NULL;
+			guint64 len;
+
+			ret = j_db_entry_get_id(g_ptr_array_index(entries, i), (gpointer*)&id, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			if (i > 0)
+			{
+				g_assert_cmpuint(*id, ==, previous_id + 1);
+			}
+
+			previous_id = *id;
+		}
+	}
+
+	{
+		g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+		ret = j_db_schema_delete(schema, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+}
+
+static void
+test_db_iterator_stream(void)
+{
+	// More rows than fit into a single reply
+	guint const n = 2500;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	gboolean ret;
+	guint count;
+
+	schema = j_db_schema_new("test-ns", "test-schema-stream", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		guint64 value = i;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Fetch all rows
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+
+		iterator = j_db_iterator_new(schema, NULL, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		count = 0;
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, n);
+	}
+
+	// Close iterators before all rows have been fetched
+	for (guint i = 0; i < 3; i++)
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+
+		iterator = j_db_iterator_new(schema, NULL, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		for (guint j = 0; j < 10; j++)
+		{
+			ret = j_db_iterator_next(iterator, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+		}
+	}
+
+	// Keep more streaming iterators open than there are pooled connections
+	{
+		g_autoptr(GPtrArray) iterators = NULL;
+		guint iterators_count;
+
+		iterators = g_ptr_array_new_with_free_func((GDestroyNotify)j_db_iterator_unref);
+		iterators_count = 2 * j_configuration_get_max_connections(j_configuration()) + 1;
+
+		for (guint i = 0; i < iterators_count; i++)
+		{
+			JDBIterator* iterator;
+
+			iterator = j_db_iterator_new(schema, NULL, &error);
+			g_assert_nonnull(iterator);
+			g_assert_no_error(error);
+
+			ret = j_db_iterator_next(iterator, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			g_ptr_array_add(iterators, iterator);
+		}
+
+		for (guint i = 0; i < iterators->len; i++)
+		{
+			count = 1;
+
+			while (j_db_iterator_next(g_ptr_array_index(iterators, i), NULL))
+			{
+				count++;
+			}
+
+			g_assert_cmpuint(count, ==, n);
+		}
+	}
+
+	// Interleave more streaming iterators than connections can be detached, all of them have to return every row
+	{
+		g_autoptr(GPtrArray) iterators = NULL;
+		g_autofree guint* counts = NULL;
+		g_autofree guint64* sums = NULL;
+		guint iterators_count;
+		guint active;
+
+		iterators = g_ptr_array_new_with_free_func((GDestroyNotify)j_db_iterator_unref);
+		iterators_count = 2 * j_configuration_get_max_connections(j_configuration()) + 1;
+		counts = g_new0(guint, iterators_count);
+		sums = g_new0(guint64, iterators_count);
+
+		for (guint i = 0; i < iterators_count; i++)
+		{
+			JDBIterator* iterator;
+
+			iterator = j_db_iterator_new(schema, NULL, &error);
+			g_assert_nonnull(iterator);
+			g_assert_no_error(error);
+
+			g_ptr_array_add(iterators, iterator);
+		}
+
+		do
+		{
+			active = 0;
+
+			for (guint i = 0; i < iterators->len; i++)
+			{
+				JDBIterator* iterator = g_ptr_array_index(iterators, i);
+
+				// Fetch a few rows from every iterator in turn, so that all of them have to keep their cursors open
+				for (guint j = 0; j < 100 && counts[i] < n; j++)
+				{
+					g_autofree guint64* value = NULL;
+					JDBType type;
+					guint64 len;
+
+					ret = j_db_iterator_next(iterator, &error);
+					g_assert_true(ret);
+					g_assert_no_error(error);
+
+					ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&value, &len, &error);
+					g_assert_true(ret);
+					g_assert_no_error(error);
+
+					sums[i] += *value;
+					counts[i]++;
+				}
+
+				if (counts[i] < n)
+				{
+					active++;
+				}
+			}
+		} while (active > 0);
+
+		for (guint i = 0; i < iterators->len; i++)
+		{
+			ret = j_db_iterator_next(g_ptr_array_index(iterators, i), NULL);
+			g_assert_false(ret);
+
+			g_assert_cmpuint(sums[i], ==, (guint64)n * (n - 1) / 2);
+		}
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_iterator_fields(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	gboolean ret;
+	guint count;
+	guint64 limit = 5;
+
+	gchar const* fields[] = { "uint-1", NULL };
+	gchar const* fields_invalid[] = { "uint-2", NULL };
+
+	schema = j_db_schema_new("test-ns", "test-schema-fields", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-1", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		guint64 value0 = i;
+		guint64 value1 = 2 * i;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &value0, sizeof(value0), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-1", &value1, sizeof(value1), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	// Conditions may refer to fields that are not returned
+	ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_LT, &limit, sizeof(limit), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_set_fields(selector, fields_invalid, &error);
+	g_assert_false(ret);
+	g_assert_nonnull(error);
+	g_clear_error(&error);
+
+	ret = j_db_selector_set_fields(selector, fields, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	count = 0;
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		g_autofree guint64* value_missing = NULL;
+		JDBType type;
+		guint64 len;
+
+		ret = j_db_iterator_get_field(iterator, "uint-1", &type, (gpointer*)&value, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(type, ==, J_DB_TYPE_UINT64);
+		g_assert_cmpuint(*value % 2, ==, 0);
+		g_assert_cmpuint(*value, <, 2 * limit);
+
+		ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&value_missing, &len, &error);
+		g_assert_false(ret);
+		g_assert_nonnull(error);
+		g_clear_error(&error);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, limit);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_iterator_aggregate(void)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	gboolean ret;
+	guint count;
+	guint64 limit = 5;
+
+	JDBAggregate aggregates[] = {
+		{ J_DB_AGGREGATE_COUNT, NULL },
+		{ J_DB_AGGREGATE_SUM, "value" },
+		{ J_DB_AGGREGATE_MIN, "value" },
+		{ J_DB_AGGREGATE_MAX, "value" }
+	};
+	JDBAggregate aggregate_invalid = { J_DB_AGGREGATE_SUM, "name" };
+	gchar const* group_by[] = { "bucket", NULL };
+
+	schema = j_db_schema_new("test-ns", "test-schema-aggregate", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "bucket", J_DB_TYPE_UINT32, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = g_strdup_printf("name-%u", i);
+		guint32 bucket = i % 2;
+		guint64 value = i;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "bucket", &bucket, sizeof(bucket), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "name", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Only numeric fields can be summed
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+
+		iterator = j_db_iterator_new_aggregate(schema, NULL, &aggregate_invalid, 1, NULL, &error);
+		g_assert_null(iterator);
+		g_assert_nonnull(error);
+		g_clear_error(&error);
+	}
+
+	// Aggregate all entries
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+		g_autofree guint64* value = NULL;
+		JDBType type;
+		guint64 len;
+
+		iterator = j_db_iterator_new_aggregate(schema, NULL, aggregates, G_N_ELEMENTS(aggregates), NULL, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		ret = j_db_iterator_next(iterator, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_iterator_get_aggregate(iterator, 0, &type, (gpointer*)&value, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(type, ==, J_DB_TYPE_UINT64);
+		g_assert_cmpuint(*value, ==, 10);
+
+		ret = j_db_iterator_next(iterator, NULL);
+		g_assert_false(ret);
+	}
+
+	// Aggregate the selected entries per bucket
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field(selector, "value", J_DB_SELECTOR_OPERATOR_LT, &limit, sizeof(limit), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new_aggregate(schema, selector, aggregates, G_N_ELEMENTS(aggregates), group_by, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		count = 0;
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree guint32* bucket = NULL;
+			g_autofree guint64* number = NULL;
+			g_autofree guint64* sum = NULL;
+			g_autofree guint64* min = NULL;
+			g_autofree guint64* max = NULL;
+			JDBType type;
+			guint64 len;
+
+			ret = j_db_iterator_get_field(iterator, "bucket", &type, (gpointer*)&bucket, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_iterator_get_aggregate(iterator, 0, &type, (gpointer*)&number, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_iterator_get_aggregate(iterator, 1, &type, (gpointer*)&sum, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_iterator_get_aggregate(iterator, 2, &type, (gpointer*)&min, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_iterator_get_aggregate(iterator, 3, &type, (gpointer*)&max, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			// Bucket 0 contains 0, 2 and 4, bucket 1 contains 1 and 3
+			g_assert_cmpuint(*number, ==, (*bucket == 0) ? 3 : 2);
+			g_assert_cmpuint(*sum, ==, (*bucket == 0) ? 6 : 4);
+			g_assert_cmpuint(*min, ==, *bucket);
+			g_assert_cmpuint(*max, ==, (*bucket == 0) ? 4 : 3);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, 2);
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_iterator_shapes(void)
+{
+	// More selector shapes than prepared statements are cached by default
+	guint const shapes = 160;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-shapes", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < 10; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		guint64 value = i;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Selectors of the same shape share a statement but must use their own values
+	for (guint64 value = 0; value < 10; value++)
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+		guint count = 0;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree guint64* result = NULL;
+			JDBType type;
+			guint64 len;
+
+			ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&result, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpuint(*result, ==, value);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, 1);
+	}
+
+	// Every selector has a different number of conditions, evicting older statements
+	for (guint i = 1; i <= shapes; i++)
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+		guint count = 0;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_OR, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		for (guint64 value = 0; value < i; value++)
+		{
+			ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+		}
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, MIN(i, 10));
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static guint
+db_count(JDBSchema* schema, JDBSelector* selector)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	guint count = 0;
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		count++;
+	}
+
+	return count;
+}
+
+static JDBSelector*
+db_selector_new(JDBSchema* schema, JDBSelectorMode mode, gchar const* name, JDBSelectorOperator operator_, gconstpointer value, guint64 length)
+{
+	g_autoptr(GError) error = NULL;
+	JDBSelector* selector;
+	gboolean ret;
+
+	selector = j_db_selector_new(schema, mode, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector, name, operator_, value, length, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	return selector;
+}
+
+static void
+test_db_iterator_index(void)
+{
+	guint const n = 100;
+
+	gchar const* idx_uint[] = { "uint-0", NULL };
+	gchar const* idx_string[] = { "string-0", NULL };
+	gchar const* name_0 = "name-0";
+	gchar const* name_3 = "name-3";
+	gchar const* name_7 = "name-7";
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBEntry) update_entry = NULL;
+	g_autoptr(JDBEntry) delete_entry = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	gboolean ret;
+	guint64 value;
+	gint32 other;
+
+	schema = j_db_schema_new("test-ns", "test-schema-index", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "sint-0", J_DB_TYPE_SINT32, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_index(schema, idx_uint, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_index(schema, idx_string, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = g_strdup_printf("name-%u", i % 10);
+
+		value = i;
+		other = i % 3;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "string-0", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "sint-0", &other, sizeof(other), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Range and equality conditions on indexed fields
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = 10;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "uint-0", J_DB_SELECTOR_OPERATOR_LT, &value, sizeof(value));
+		g_assert_cmpuint(db_count(schema, selector), ==, 10);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = 90;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "uint-0", J_DB_SELECTOR_OPERATOR_GE, &value, sizeof(value));
+		g_assert_cmpuint(db_count(schema, selector), ==, 10);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "string-0", J_DB_SELECTOR_OPERATOR_EQ, name_3, strlen(name_3));
+		g_assert_cmpuint(db_count(schema, selector), ==, 10);
+
+		value = 50;
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_LT, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(db_count(schema, selector), ==, 5);
+	}
+
+	// Disjunctions of indexed conditions must not return entries twice
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = 7;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_OR, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value));
+
+		ret = j_db_selector_add_field(selector, "string-0", J_DB_SELECTOR_OPERATOR_EQ, name_7, strlen(name_7), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(db_count(schema, selector), ==, 10);
+	}
+
+	// Mixing indexed and non-indexed conditions
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBSelector) sub_selector = NULL;
+
+		other = 0;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "sint-0", J_DB_SELECTOR_OPERATOR_EQ, &other, sizeof(other));
+
+		value = 9;
+		sub_selector = db_selector_new(schema, J_DB_SELECTOR_MODE_OR, "uint-0", J_DB_SELECTOR_OPERATOR_LE, &value, sizeof(value));
+
+		ret = j_db_selector_add_selector(selector, sub_selector, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(db_count(schema, selector), ==, 4);
+	}
+
+	// Updating indexed fields has to move entries within the index
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "string-0", J_DB_SELECTOR_OPERATOR_EQ, name_0, strlen(name_0));
+
+		update_entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(update_entry);
+		g_assert_no_error(error);
+
+		value = 1000;
+		ret = j_db_entry_set_field(update_entry, "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_update(update_entry, selector, NULL, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = 1000;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "uint-0", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value));
+		g_assert_cmpuint(db_count(schema, selector), ==, 10);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = 10;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "uint-0", J_DB_SELECTOR_OPERATOR_LT, &value, sizeof(value));
+		g_assert_cmpuint(db_count(schema, selector), ==, 9);
+	}
+
+	// Deleted entries have to disappear from all indexes
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = 50;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "uint-0", J_DB_SELECTOR_OPERATOR_GE, &value, sizeof(value));
+
+		delete_entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(delete_entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_delete(delete_entry, selector, NULL, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+
+		g_assert_cmpuint(db_count(schema, selector), ==, 0);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "string-0", J_DB_SELECTOR_OPERATOR_EQ, name_0, strlen(name_0));
+		g_assert_cmpuint(db_count(schema, selector), ==, 0);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = 0;
+		selector = db_selector_new(schema, J_DB_SELECTOR_MODE_AND, "uint-0", J_DB_SELECTOR_OPERATOR_GE, &value, sizeof(value));
+		g_assert_cmpuint(db_count(schema, selector), ==, 45);
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+db_assert_order(JDBSchema* schema, JDBSelector* selector, guint64 const* expected, guint expected_count)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	guint count = 0;
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		JDBType type;
+		guint64 len;
+		gboolean ret;
+
+		ret = j_db_iterator_get_field(iterator, "uint-0", &type, (gpointer*)&value, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(count, <, expected_count);
+		g_assert_cmpuint(*value, ==, expected[count]);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, expected_count);
+}
+
+static void
+test_db_iterator_order(void)
+{
+	guint const n = 20;
+
+	gchar const* group_by[] = { "string-0", NULL };
+	JDBAggregate aggregate = { J_DB_AGGREGATE_COUNT, NULL };
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-order", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "uint-0", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "string-0", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Insert the values out of order
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = NULL;
+		guint64 value = (i * 7) % n;
+
+		name = g_strdup_printf("name-%" G_GUINT64_FORMAT, value % 4);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "uint-0", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "string-0", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Top-N
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		guint64 const expected[] = { 19, 18, 17, 16, 15 };
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_order(selector, "uint-0", J_DB_SELECTOR_ORDER_DESCENDING, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_set_limit(selector, 5, 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		db_assert_order(schema, selector, expected, G_N_ELEMENTS(expected));
+	}
+
+	// Pages of the same selector share a statement but must use their own limits
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		guint64 const expected[] = { 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19 };
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_order(selector, "uint-0", J_DB_SELECTOR_ORDER_ASCENDING, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_set_limit(selector, 5, 5, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		db_assert_order(schema, selector, expected, 5);
+
+		ret = j_db_selector_set_limit(selector, 3, 10, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		db_assert_order(schema, selector, expected + 5, 3);
+
+		// An offset without a limit returns all remaining entries
+		ret = j_db_selector_set_limit(selector, 0, 18, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		db_assert_order(schema, selector, expected + 13, 2);
+	}
+
+	// Keyset pagination continues after the last value of the previous page
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		guint64 const expected[] = { 15, 16, 17 };
+		guint64 last = 14;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field(selector, "uint-0", J_DB_SELECTOR_OPERATOR_GT, &last, sizeof(last), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_order(selector, "uint-0", J_DB_SELECTOR_ORDER_ASCENDING, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_set_limit(selector, 3, 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		db_assert_order(schema, selector, expected, G_N_ELEMENTS(expected));
+	}
+
+	// Groups are sorted and limited
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+		gchar const* expected[] = { "name-3", "name-2" };
+		guint count = 0;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_order(selector, "string-0", J_DB_SELECTOR_ORDER_DESCENDING, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_set_limit(selector, 2, 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new_aggregate(schema, selector, &aggregate, 1, group_by, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree gchar* name = NULL;
+			g_autofree guint64* number = NULL;
+			JDBType type;
+			guint64 len;
+
+			g_assert_cmpuint(count, <, G_N_ELEMENTS(expected));
+
+			ret = j_db_iterator_get_field(iterator, "string-0", &type, (gpointer*)&name, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpstr(name, ==, expected[count]);
+
+			ret = j_db_iterator_get_aggregate(iterator, 0, &type, (gpointer*)&number, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpuint(*number, ==, 5);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, G_N_ELEMENTS(expected));
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_iterator_join(void)
+{
+	guint const n = 4;
+
+	gchar const* attr_fields[] = { "key", NULL };
+	gchar const* name_3 = "file-3";
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) file_schema = NULL;
+	g_autoptr(JDBSchema) attr_schema = NULL;
+	gboolean ret;
+
+	file_schema = j_db_schema_new("test-ns", "test-schema-join-file", &error);
+	g_assert_nonnull(file_schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(file_schema, "file-id", J_DB_TYPE_UINT32, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(file_schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(file_schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	attr_schema = j_db_schema_new("test-ns", "test-schema-join-attr", &error);
+	g_assert_nonnull(attr_schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(attr_schema, "file-id", J_DB_TYPE_UINT32, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(attr_schema, "key", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(attr_schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(attr_schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// File i has i attributes
+	for (guint32 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = g_strdup_printf("file-%u", i);
+
+		entry = j_db_entry_new(file_schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "file-id", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "name", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+
+		for (guint64 j = 0; j < i; j++)
+		{
+			g_autoptr(JDBEntry) attr = NULL;
+			g_autofree gchar* key = g_strdup_printf("key-%" G_GUINT64_FORMAT, j);
+
+			attr = j_db_entry_new(attr_schema, &error);
+			g_assert_nonnull(attr);
+			g_assert_no_error(error);
+
+			ret = j_db_entry_set_field(attr, "file-id", &i, sizeof(i), &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_entry_set_field(attr, "key", key, strlen(key), &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_entry_set_field(attr, "value", &j, sizeof(j), &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			// FIXME Do not pass error, will not exist anymore when batch is executed
+			ret = j_db_entry_insert(attr, batch, NULL);
+			g_assert_true(ret);
+		}
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Files without attributes are not returned
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBSelector) attr_selector = NULL;
+
+		selector = j_db_selector_new(file_schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		attr_selector = j_db_selector_new(attr_schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(attr_selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_join(selector, "file-id", attr_selector, "file-id", &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(db_count(file_schema, selector), ==, 6);
+	}
+
+	// Conditions apply to both schemas, joined fields are named after their schema
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBSelector) attr_selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+		guint64 value = 1;
+		guint count = 0;
+
+		selector = db_selector_new(file_schema, J_DB_SELECTOR_MODE_AND, "name", J_DB_SELECTOR_OPERATOR_EQ, name_3, strlen(name_3));
+		attr_selector = db_selector_new(attr_schema, J_DB_SELECTOR_MODE_AND, "value", J_DB_SELECTOR_OPERATOR_GE, &value, sizeof(value));
+
+		ret = j_db_selector_set_fields(attr_selector, attr_fields, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_join(selector, "file-id", attr_selector, "file-id", &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new(file_schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree gchar* name = NULL;
+			g_autofree gchar* key = NULL;
+			g_autofree guint32* id = NULL;
+			g_autofree guint64* attr_value = NULL;
+			JDBType type;
+			guint64 len;
+
+			ret = j_db_iterator_get_field(iterator, "name", &type, (gpointer*)&name, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpstr(name, ==, name_3);
+
+			ret = j_db_iterator_get_field(iterator, "test-schema-join-attr.key", &type, (gpointer*)&key, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_true(g_str_equal(key, "key-1") || g_str_equal(key, "key-2"));
+
+			ret = j_db_iterator_get_field(iterator, "test-schema-join-attr._id", &type, (gpointer*)&id, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			// Only the selected fields of the joined schema are returned
+			ret = j_db_iterator_get_field(iterator, "test-schema-join-attr.value", &type, (gpointer*)&attr_value, &len, &error);
+			g_assert_false(ret);
+			g_assert_nonnull(error);
+			g_clear_error(&error);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, 2);
+	}
+
+	// Sort keys and limits apply to the joined results
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBSelector) attr_selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+		guint count = 0;
+
+		selector = j_db_selector_new(file_schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		attr_selector = j_db_selector_new(attr_schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(attr_selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_join(selector, "file-id", attr_selector, "file-id", &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_order(selector, "file-id", J_DB_SELECTOR_ORDER_DESCENDING, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_set_limit(selector, 3, 1, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new(file_schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree guint32* file_id = NULL;
+			JDBType type;
+			guint64 len;
+
+			ret = j_db_iterator_get_field(iterator, "test-schema-join-attr.file-id", &type, (gpointer*)&file_id, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			// File 3 has three attributes, the first one is skipped
+			g_assert_cmpuint(*file_id, ==, (count < 2) ? 3 : 2);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, 3);
+	}
+
+	// Schemas can not be joined to themselves and joins can not be aggregated
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBSelector) other_selector = NULL;
+		g_autoptr(JDBSelector) attr_selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+		JDBAggregate aggregate = { J_DB_AGGREGATE_COUNT, NULL };
+
+		selector = j_db_selector_new(file_schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		other_selector = j_db_selector_new(file_schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(other_selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_join(selector, "file-id", other_selector, "file-id", &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_MUST_NOT_EQUAL);
+		g_clear_error(&error);
+
+		attr_selector = j_db_selector_new(attr_schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(attr_selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_join(selector, "name", attr_selector, "file-id", &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID);
+		g_clear_error(&error);
+
+		ret = j_db_selector_add_join(selector, "file-id", attr_selector, "file-id", &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new_aggregate(file_schema, selector, &aggregate, 1, NULL, &error);
+		g_assert_null(iterator);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX);
+		g_clear_error(&error);
+	}
+
+	ret = j_db_schema_delete(attr_schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_delete(file_schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 schema_create(void)
 {
@@ -450,7 +2251,7 @@ entry_update(void)
 	success = j_db_entry_set_field(entry, "max", &max, sizeof(max), &error);
 	g_assert_true(success);
 	g_assert_no_error(error);
-	success = j_db_entry_update(entry, selector, batch, &error);
+	success = j_db_entry_update(entry, selector, NULL, batch, &error);
 	g_assert_true(success);
 	g_assert_no_error(error);
 	success = j_batch_execute(batch);
@@ -493,7 +2294,7 @@ entry_delete(void)
 	entry = j_db_entry_new(schema, &error);
 	g_assert_nonnull(entry);
 	g_assert_no_error(error);
-	success = j_db_entry_delete(entry, selector, batch, &error);
+	success = j_db_entry_delete(entry, selector, NULL, batch, &error);
 	g_assert_true(success);
 	g_assert_no_error(error);
 	success = j_batch_execute(batch);
@@ -540,5 +2341,15 @@ test_db_db(void)
 	g_test_add_func("/db/schema/create_delete", test_db_schema_create_delete);
 	g_test_add_func("/db/entry/new_free", test_db_entry_new_free);
 	g_test_add_func("/db/entry/insert_update_delete", test_db_entry_insert_update_delete);
+	g_test_add_func("/db/entry/insert_many", test_db_entry_insert_many);
+	g_test_add_func("/db/entry/update_delete_many", test_db_entry_update_delete_many);
+	g_test_add_func("/db/entry/batch_rollback", test_db_entry_batch_rollback);
+	g_test_add_func("/db/iterator/stream", test_db_iterator_stream);
+	g_test_add_func("/db/iterator/fields", test_db_iterator_fields);
+	g_test_add_func("/db/iterator/aggregate", test_db_iterator_aggregate);
+	g_test_add_func("/db/iterator/shapes", test_db_iterator_shapes);
+	g_test_add_func("/db/iterator/index", test_db_iterator_index);
+	g_test_add_func("/db/iterator/order", test_db_iterator_order);
+	g_test_add_func("/db/iterator/join", test_db_iterator_join);
 	g_test_add_func("/db/all", test_db_all);
 }
@@ -25,6 +25,9 @@
 
 #include <glib.h>
 
+#include <math.h>
+#include <string.h>
+
 #include <julea.h>
 
 #include "test.h"
@@ -132,6 +135,38 @@ read_dataset(hid_t file)
 	H5Dclose(dataset);
 }
 
+// Chunks do not divide the dimensions evenly to test edge chunks
+static hid_t
+write_chunked_dataset(hid_t file, const char* name, int data[6][7])
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t dcpl;
+
+	hsize_t dims[2] = { 6, 7 };
+	hsize_t chunk_dims[2] = { 4, 3 };
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			data[i][j] = i * 7 + j;
+		}
+	}
+
+	dataspace = H5Screate_simple(2, dims, NULL);
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 2, chunk_dims);
+
+	dataset = H5Dcreate2(file, name, H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+	g_assert_cmpint(H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data), >=, 0);
+
+	H5Pclose(dcpl);
+	H5Sclose(dataspace);
+
+	return dataset;
+}
+
 static void
 test_hdf_read_write(void)
 {
@@ -145,6 +180,997 @@ test_hdf_read_write(void)
 	H5Fclose(file);
 }
 
+static void
+test_hdf_chunked(void)
+{
+	hid_t dataset;
+	hid_t file;
+
+	int data[6][7];
+	int data_read[6][7];
+
+	file = H5Fcreate("JULEA-chunked.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataset = write_chunked_dataset(file, "ChunkedDataset", data);
+	H5Dclose(dataset);
+
+	dataset = H5Dopen2(file, "ChunkedDataset", H5P_DEFAULT);
+	H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read);
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			g_assert_cmpint(data_read[i][j], ==, data[i][j]);
+		}
+	}
+
+	H5Dclose(dataset);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_chunked_shared(void)
+{
+	hid_t dataset;
+	hid_t dataset_reader;
+	hid_t dataspace;
+	hid_t dcpl;
+	hid_t file;
+	hid_t file_reader;
+
+	hsize_t dims[1] = { 16 };
+	hsize_t chunk_dims[1] = { 4 };
+
+	int data[16];
+	int data_read[16];
+
+	for (guint i = 0; i < 16; i++)
+	{
+		data[i] = i + 1;
+	}
+
+	file = H5Fcreate("JULEA-chunked-shared.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 1, chunk_dims);
+
+	dataset = H5Dcreate2(file, "ChunkedSharedDataset", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+	// The reader opens the dataset before any chunk has been written
+	file_reader = H5Fopen("JULEA-chunked-shared.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+	dataset_reader = H5Dopen2(file_reader, "ChunkedSharedDataset", H5P_DEFAULT);
+
+	g_assert_cmpint(H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data), >=, 0);
+
+	// Chunks written by others must not be mistaken for chunks that only contain the fill value
+	g_assert_cmpint(H5Dread(dataset_reader, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read), >=, 0);
+
+	for (guint i = 0; i < 16; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, data[i]);
+	}
+
+	H5Dclose(dataset_reader);
+	H5Fclose(file_reader);
+
+	H5Dclose(dataset);
+	H5Pclose(dcpl);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_hyperslab(void)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t file;
+	hid_t memspace;
+
+	hsize_t mem_dims[2] = { 4, 2 };
+	hsize_t start[2] = { 1, 2 };
+	hsize_t stride[2] = { 2, 2 };
+	hsize_t count[2] = { 2, 2 };
+	hsize_t block[2] = { 2, 1 };
+
+	int data[6][7];
+	int data_read[4][2];
+
+	file = H5Fcreate("JULEA-hyperslab.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	dataset = write_chunked_dataset(file, "HyperslabDataset", data);
+
+	// Rows 1 to 4, columns 2 and 4
+	dataspace = H5Dget_space(dataset);
+	memspace = H5Screate_simple(2, mem_dims, NULL);
+	H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, start, stride, count, block);
+	H5Dread(dataset, H5T_NATIVE_INT, memspace, dataspace, H5P_DEFAULT, data_read);
+
+	for (guint i = 0; i < 4; i++)
+	{
+		for (guint j = 0; j < 2; j++)
+		{
+			g_assert_cmpint(data_read[i][j], ==, data[i + 1][2 + 2 * j]);
+		}
+	}
+
+	H5Dclose(dataset);
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_hyperslab_irregular(void)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t file;
+	hid_t memspace;
+
+	hsize_t start[2][2] = { { 0, 1 }, { 1, 4 } };
+	hsize_t count[2][2] = { { 2, 2 }, { 4, 3 } };
+	hsize_t mem_dims[1];
+	hssize_t npoints;
+
+	gboolean selected[6][7];
+	int data[6][7];
+	int data_read[6][7];
+	int values[42];
+	guint n;
+
+	file = H5Fcreate("JULEA-hyperslab-irregular.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	dataset = write_chunked_dataset(file, "HyperslabIrregularDataset", data);
+
+	// Rows 0 and 1 of columns 1 and 2 as well as rows 1 to 4 of columns 4 to 6, both blocks share row 1
+	dataspace = H5Dget_space(dataset);
+	H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, start[0], NULL, count[0], NULL);
+	H5Sselect_hyperslab(dataspace, H5S_SELECT_OR, start[1], NULL, count[1], NULL);
+	g_assert_cmpint(H5Sis_regular_hyperslab(dataspace), <=, 0);
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			selected[i][j] = (i < 2 && j >= 1 && j < 3) || (i >= 1 && i < 5 && j >= 4);
+		}
+	}
+
+	npoints = H5Sget_select_npoints(dataspace);
+	g_assert_cmpint(npoints, ==, 16);
+
+	mem_dims[0] = npoints;
+	memspace = H5Screate_simple(1, mem_dims, NULL);
+
+	// The selected elements are returned in row-major order
+	g_assert_cmpint(H5Dread(dataset, H5T_NATIVE_INT, memspace, dataspace, H5P_DEFAULT, values), >=, 0);
+
+	n = 0;
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			if (selected[i][j])
+			{
+				g_assert_cmpint(values[n], ==, data[i][j]);
+				n++;
+			}
+		}
+	}
+
+	for (guint i = 0; i < (guint)npoints; i++)
+	{
+		values[i] = -1 - (int)i;
+	}
+
+	g_assert_cmpint(H5Dwrite(dataset, H5T_NATIVE_INT, memspace, dataspace, H5P_DEFAULT, values), >=, 0);
+	g_assert_cmpint(H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read), >=, 0);
+
+	n = 0;
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			if (selected[i][j])
+			{
+				g_assert_cmpint(data_read[i][j], ==, -1 - (int)n);
+				n++;
+			}
+			else
+			{
+				g_assert_cmpint(data_read[i][j], ==, data[i][j]);
+			}
+		}
+	}
+
+	H5Dclose(dataset);
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_points(void)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t file;
+	hid_t memspace;
+
+	// Points are not sorted, the third and fourth point are consecutive
+	hsize_t points[5][2] = { { 5, 6 }, { 0, 0 }, { 2, 3 }, { 2, 4 }, { 1, 1 } };
+	hsize_t mem_dims[1] = { 5 };
+
+	int data[6][7];
+	int data_read[6][7];
+	int values[5];
+
+	file = H5Fcreate("JULEA-points.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	dataset = write_chunked_dataset(file, "PointsDataset", data);
+
+	dataspace = H5Dget_space(dataset);
+	H5Sselect_elements(dataspace, H5S_SELECT_SET, 5, (const hsize_t*)points);
+	memspace = H5Screate_simple(1, mem_dims, NULL);
+
+	// The selected elements are returned in the order of the points
+	g_assert_cmpint(H5Dread(dataset, H5T_NATIVE_INT, memspace, dataspace, H5P_DEFAULT, values), >=, 0);
+
+	for (guint i = 0; i < 5; i++)
+	{
+		g_assert_cmpint(values[i], ==, data[points[i][0]][points[i][1]]);
+	}
+
+	for (guint i = 0; i < 5; i++)
+	{
+		values[i] = 100 + i;
+	}
+
+	g_assert_cmpint(H5Dwrite(dataset, H5T_NATIVE_INT, memspace, dataspace, H5P_DEFAULT, values), >=, 0);
+
+	for (guint i = 0; i < 5; i++)
+	{
+		data[points[i][0]][points[i][1]] = 100 + i;
+	}
+
+	g_assert_cmpint(H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read), >=, 0);
+
+	for (guint i = 0; i < 6; i++)
+	{
+		for (guint j = 0; j < 7; j++)
+		{
+			g_assert_cmpint(data_read[i][j], ==, data[i][j]);
+		}
+	}
+
+	H5Dclose(dataset);
+	H5Sclose(memspace);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_convert(void)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t file;
+
+	hsize_t dims[1] = { 100 };
+
+	gint32 data[100];
+	gint32 data_read[100];
+	gdouble data_read_double[100];
+
+	for (guint i = 0; i < 100; i++)
+	{
+		data[i] = GINT32_TO_BE((gint32)i - 50);
+	}
+
+	file = H5Fcreate("JULEA-convert.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dataset = H5Dcreate2(file, "ConvertDataset", H5T_NATIVE_INT32, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	// The buffer has a different byte order than the dataset
+	H5Dwrite(dataset, H5T_STD_I32BE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+	H5Dread(dataset, H5T_NATIVE_INT32, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read);
+
+	for (guint i = 0; i < 100; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, (gint32)i - 50);
+	}
+
+	// Reads are converted as well, including to larger datatypes
+	H5Dread(dataset, H5T_STD_I32BE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read);
+
+	for (guint i = 0; i < 100; i++)
+	{
+		g_assert_cmpint(GINT32_FROM_BE(data_read[i]), ==, (gint32)i - 50);
+	}
+
+	H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read_double);
+
+	for (guint i = 0; i < 100; i++)
+	{
+		g_assert_cmpfloat(data_read_double[i], ==, (gdouble)i - 50);
+	}
+
+	H5Dclose(dataset);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_convert_large(void)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t file;
+
+	// Larger than the plugin's conversion buffer, so that the data is converted in multiple rounds
+	hsize_t const count = 3 * 512 * 1024;
+	hsize_t dims[1] = { count };
+
+	g_autofree gint32* data = NULL;
+	g_autofree gint32* data_read = NULL;
+	g_autofree gint64* data_read_wide = NULL;
+
+	data = g_new(gint32, count);
+	data_read = g_new(gint32, count);
+	data_read_wide = g_new(gint64, count);
+
+	for (guint i = 0; i < count; i++)
+	{
+		data[i] = GINT32_TO_BE((gint32)i);
+	}
+
+	file = H5Fcreate("JULEA-convert-large.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dataset = H5Dcreate2(file, "ConvertLargeDataset", H5T_NATIVE_INT32, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	H5Dwrite(dataset, H5T_STD_I32BE, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+	H5Dread(dataset, H5T_NATIVE_INT32, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read);
+
+	for (guint i = 0; i < count; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, (gint32)i);
+	}
+
+	// Reads are converted in multiple rounds as well, the wider memory type needs more rounds
+	g_assert_cmpint(H5Dread(dataset, H5T_NATIVE_INT64, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read_wide), >=, 0);
+
+	for (guint i = 0; i < count; i++)
+	{
+		g_assert_cmpint(data_read_wide[i], ==, (gint64)i);
+	}
+
+	H5Dclose(dataset);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_compression(void)
+{
+	hid_t dataset;
+	hid_t dataset_reader;
+	hid_t dataspace;
+	hid_t dcpl;
+	hid_t file;
+	hid_t file_reader;
+	hid_t memspace;
+
+	hsize_t dims[1] = { 1000 };
+	hsize_t chunk_dims[1] = { 300 };
+	// Partially overwrites the first two chunks
+	hsize_t start[1] = { 250 };
+	hsize_t count[1] = { 100 };
+	guint cd_values[1] = { 3 };
+
+	int data[1000];
+	int data_update[100];
+	int data_read[1000];
+
+	for (guint i = 0; i < 1000; i++)
+	{
+		data[i] = i / 10;
+	}
+
+	for (guint i = 0; i < 100; i++)
+	{
+		data_update[i] = -1;
+	}
+
+	file = H5Fcreate("JULEA-compression.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 1, chunk_dims);
+	H5Pset_shuffle(dcpl);
+#ifdef HAVE_ZSTD
+	H5Pset_filter(dcpl, 32015, H5Z_FLAG_MANDATORY, 1, cd_values);
+#else
+	// Zstandard is optional, the data is stored uncompressed if the plugin has been built without it
+	H5Pset_filter(dcpl, 32015, H5Z_FLAG_OPTIONAL, 1, cd_values);
+#endif
+
+	dataset = H5Dcreate2(file, "CompressionDataset", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+	g_assert_cmpint(H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data), >=, 0);
+
+	memspace = H5Screate_simple(1, count, NULL);
+	H5Sselect_hyperslab(dataspace, H5S_SELECT_SET, start, NULL, count, NULL);
+	g_assert_cmpint(H5Dwrite(dataset, H5T_NATIVE_INT, memspace, dataspace, H5P_DEFAULT, data_update), >=, 0);
+
+	// The reader has to see the sizes of the rewritten chunks while the writer still has the dataset open
+	file_reader = H5Fopen("JULEA-compression.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+	dataset_reader = H5Dopen2(file_reader, "CompressionDataset", H5P_DEFAULT);
+
+#ifdef HAVE_ZSTD
+	g_assert_cmpuint(H5Dget_storage_size(dataset_reader), >, 0);
+	g_assert_cmpuint(H5Dget_storage_size(dataset_reader), <, sizeof(data));
+#else
+	g_assert_cmpuint(H5Dget_storage_size(dataset_reader), ==, sizeof(data));
+#endif
+
+	g_assert_cmpint(H5Dread(dataset_reader, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read), >=, 0);
+
+	for (guint i = 0; i < 1000; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, (i >= 250 && i < 350) ? -1 : data[i]);
+	}
+
+	H5Dclose(dataset_reader);
+	H5Fclose(file_reader);
+
+	H5Dclose(dataset);
+
+	dataset = H5Dopen2(file, "CompressionDataset", H5P_DEFAULT);
+	g_assert_cmpint(H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read), >=, 0);
+
+	for (guint i = 0; i < 1000; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, (i >= 250 && i < 350) ? -1 : data[i]);
+	}
+
+	H5Dclose(dataset);
+	H5Sclose(memspace);
+	H5Pclose(dcpl);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_query(void)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t dcpl;
+	hid_t file;
+	hid_t memspace;
+	hid_t selection;
+
+	hsize_t dims[1] = { 100 };
+	hsize_t chunk_dims[1] = { 10 };
+	hsize_t mem_dims[1];
+
+	int data[100];
+	int data_read[100];
+
+	for (guint i = 0; i < 100; i++)
+	{
+		data[i] = i + 1;
+	}
+
+	file = H5Fcreate("JULEA-query.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 1, chunk_dims);
+
+	dataset = H5Dcreate2(file, "QueryDataset", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+	H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+
+	// Only the last two chunks contain values greater than 85
+	selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_GT, 85.0);
+	g_assert_cmpint(selection, >=, 0);
+	g_assert_cmpint(H5Sget_select_npoints(selection), ==, 20);
+
+	mem_dims[0] = 20;
+	memspace = H5Screate_simple(1, mem_dims, NULL);
+	H5Dread(dataset, H5T_NATIVE_INT, memspace, selection, H5P_DEFAULT, data_read);
+
+	for (guint i = 0; i < 20; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, 81 + i);
+	}
+
+	H5Sclose(memspace);
+	H5Sclose(selection);
+
+	selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_EQ, 42.0);
+	g_assert_cmpint(H5Sget_select_npoints(selection), ==, 10);
+	H5Sclose(selection);
+
+	selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_LT, 5.0);
+	g_assert_cmpint(H5Sget_select_npoints(selection), ==, 10);
+	H5Sclose(selection);
+
+	selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_GT, 1000.0);
+	g_assert_cmpint(H5Sget_select_npoints(selection), ==, 0);
+	H5Sclose(selection);
+
+	H5Dclose(dataset);
+	H5Pclose(dcpl);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_query_shared(void)
+{
+	hid_t dataset;
+	hid_t dataset_reader;
+	hid_t dataspace;
+	hid_t dcpl;
+	hid_t file;
+	hid_t file_reader;
+	hid_t selection;
+
+	hsize_t dims[1] = { 100 };
+	hsize_t chunk_dims[1] = { 10 };
+
+	int data[100];
+
+	for (guint i = 0; i < 100; i++)
+	{
+		data[i] = i + 1;
+	}
+
+	file = H5Fcreate("JULEA-query-shared.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dcpl = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_chunk(dcpl, 1, chunk_dims);
+
+	dataset = H5Dcreate2(file, "QuerySharedDataset", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, dcpl, H5P_DEFAULT);
+
+	// The reader opens the dataset before any statistics have been stored
+	file_reader = H5Fopen("JULEA-query-shared.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+	dataset_reader = H5Dopen2(file_reader, "QuerySharedDataset", H5P_DEFAULT);
+
+	H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+
+	// Querying stores the writer's statistics
+	selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_GT, 85.0);
+	g_assert_cmpint(H5Sget_select_npoints(selection), ==, 20);
+	H5Sclose(selection);
+
+	selection = j_hdf5_dataset_query(dataset_reader, J_HDF5_QUERY_OPERATOR_GT, 85.0);
+	g_assert_cmpint(selection, >=, 0);
+	g_assert_cmpint(H5Sget_select_npoints(selection), ==, 20);
+	H5Sclose(selection);
+
+	// Closing the reader must not overwrite the writer's statistics
+	H5Dclose(dataset_reader);
+	H5Fclose(file_reader);
+
+	selection = j_hdf5_dataset_query(dataset, J_HDF5_QUERY_OPERATOR_LT, 5.0);
+	g_assert_cmpint(H5Sget_select_npoints(selection), ==, 10);
+	H5Sclose(selection);
+
+	H5Dclose(dataset);
+	H5Pclose(dcpl);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static hid_t
+write_statistics_dataset(hid_t file, const char* kernel, const char* type_name, hid_t type_id, gdouble const* values)
+{
+	g_autofree gchar* name = NULL;
+	hid_t dataset;
+	hid_t dataspace;
+
+	hsize_t dims[1] = { 37 };
+
+	guint8 buf[37 * sizeof(gdouble)];
+
+	name = g_strdup_printf("Statistics-%s-%s", kernel, type_name);
+
+	// The values are converted in place, the buffer is large enough for all types
+	memcpy(buf, values, sizeof(buf));
+	g_assert_cmpint(H5Tconvert(H5T_NATIVE_DOUBLE, type_id, 37, buf, NULL, H5P_DEFAULT), >=, 0);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dataset = H5Dcreate2(file, name, type_id, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	g_assert_cmpint(H5Dwrite(dataset, type_id, H5S_ALL, H5S_ALL, H5P_DEFAULT, buf), >=, 0);
+
+	H5Sclose(dataspace);
+
+	return dataset;
+}
+
+static hssize_t
+query_npoints(hid_t dataset, JHDF5QueryOperator op, gdouble value)
+{
+	hid_t selection;
+	hssize_t npoints;
+
+	selection = j_hdf5_dataset_query(dataset, op, value);
+	g_assert_cmpint(selection, >=, 0);
+
+	npoints = H5Sget_select_npoints(selection);
+	H5Sclose(selection);
+
+	return npoints;
+}
+
+// The dataset is not chunked, so the minimum and maximum are exact if the query selects all or none of its elements
+static void
+check_statistics(hid_t file, const char* kernel, const char* type_name, hid_t type_id, gdouble const* values, gdouble min, gdouble max)
+{
+	hid_t dataset;
+
+	dataset = write_statistics_dataset(file, kernel, type_name, type_id, values);
+
+	g_assert_cmpint(query_npoints(dataset, J_HDF5_QUERY_OPERATOR_GE, max), ==, 37);
+	g_assert_cmpint(query_npoints(dataset, J_HDF5_QUERY_OPERATOR_GT, max), ==, 0);
+	g_assert_cmpint(query_npoints(dataset, J_HDF5_QUERY_OPERATOR_LE, min), ==, 37);
+	g_assert_cmpint(query_npoints(dataset, J_HDF5_QUERY_OPERATOR_LT, min), ==, 0);
+
+	H5Dclose(dataset);
+}
+
+static void
+test_hdf_statistics(void)
+{
+	hid_t dataset;
+	hid_t file;
+
+	gchar const* kernels[] = { "scalar", "sse4.1", "avx2" };
+
+	// 37 elements leave five elements after the last full vector for every vector width
+	gdouble values[37];
+
+	file = H5Fcreate("JULEA-statistics.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	// Kernels that the CPU does not support fall back to the next smaller ones
+	for (guint k = 0; k < G_N_ELEMENTS(kernels); k++)
+	{
+		g_setenv("JULEA_HDF5_STATISTICS", kernels[k], TRUE);
+
+		// The extremes are part of the tail, the unsigned maximums do not fit into the signed types of the same size
+		for (guint i = 0; i < 37; i++)
+		{
+			values[i] = 100 + i;
+		}
+
+		values[33] = 1;
+		values[36] = 250;
+		check_statistics(file, kernels[k], "u8", H5T_NATIVE_UINT8, values, 1, 250);
+
+		values[36] = 65000;
+		check_statistics(file, kernels[k], "u16", H5T_NATIVE_UINT16, values, 1, 65000);
+
+		values[36] = 4000000000.0;
+		check_statistics(file, kernels[k], "u32", H5T_NATIVE_UINT32, values, 1, 4000000000.0);
+
+		values[33] = -120;
+		values[36] = 120;
+		check_statistics(file, kernels[k], "i8", H5T_NATIVE_INT8, values, -120, 120);
+
+		values[33] = -32000;
+		values[36] = 32000;
+		check_statistics(file, kernels[k], "i16", H5T_NATIVE_INT16, values, -32000, 32000);
+
+		values[33] = -2000000000.0;
+		values[36] = 2000000000.0;
+		check_statistics(file, kernels[k], "i32", H5T_NATIVE_INT32, values, -2000000000.0, 2000000000.0);
+
+		values[33] = -1e15;
+		values[36] = 1e15;
+		check_statistics(file, kernels[k], "i64", H5T_NATIVE_INT64, values, -1e15, 1e15);
+
+		// All values are negative, NaNs are ignored
+		for (guint i = 0; i < 37; i++)
+		{
+			values[i] = -0.25 * (i + 1);
+		}
+
+		values[0] = NAN;
+		values[33] = -1000.5;
+		values[36] = -0.125;
+		check_statistics(file, kernels[k], "f32", H5T_NATIVE_FLOAT, values, -1000.5, -0.125);
+		check_statistics(file, kernels[k], "f64", H5T_NATIVE_DOUBLE, values, -1000.5, -0.125);
+	}
+
+	g_unsetenv("JULEA_HDF5_STATISTICS");
+
+	for (guint i = 0; i < 37; i++)
+	{
+		values[i] = i;
+	}
+
+	// Without statistics for a foreign byte order, every element is a candidate
+	dataset = write_statistics_dataset(file, "foreign", "i32", (G_BYTE_ORDER == G_LITTLE_ENDIAN) ? H5T_STD_I32BE : H5T_STD_I32LE, values);
+	g_assert_cmpint(query_npoints(dataset, J_HDF5_QUERY_OPERATOR_GT, 1000.0), ==, 37);
+	H5Dclose(dataset);
+
+	H5Fclose(file);
+}
+
+struct AsyncNotification
+{
+	GThread* thread;
+	H5ES_status_t status;
+	guint calls;
+};
+
+typedef struct AsyncNotification AsyncNotification;
+
+static herr_t
+async_notify(void* ctx, H5ES_status_t status)
+{
+	AsyncNotification* notification = ctx;
+
+	notification->thread = g_thread_self();
+	notification->status = status;
+	notification->calls++;
+
+	return 0;
+}
+
+static void
+test_hdf_async(void)
+{
+	hid_t connector;
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t file;
+	H5ES_status_t status;
+	void* object;
+	void* request = NULL;
+
+	AsyncNotification notification = { NULL, H5ES_STATUS_IN_PROGRESS, 0 };
+
+	hsize_t dims[1] = { 1024 };
+
+	int data[1024];
+	int data_read[1024];
+
+	for (guint i = 0; i < 1024; i++)
+	{
+		data[i] = i * 3;
+	}
+
+	file = H5Fcreate("JULEA-async.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dataset = H5Dcreate2(file, "AsyncDataset", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	// HDF5 only passes requests to the connector for asynchronous operations, so the VOL layer is used directly
+	object = H5VLobject(dataset);
+	connector = H5VLget_connector_id(dataset);
+
+	g_assert_cmpint(H5VLdataset_write(object, connector, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DATASET_XFER_DEFAULT, data, &request), >=, 0);
+	g_assert_nonnull(request);
+
+	g_assert_cmpint(H5VLrequest_wait(request, connector, G_MAXUINT64, &status), >=, 0);
+	g_assert_cmpint(status, ==, H5ES_STATUS_SUCCEED);
+	H5VLrequest_free(request, connector);
+
+	request = NULL;
+	g_assert_cmpint(H5VLdataset_write(object, connector, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DATASET_XFER_DEFAULT, data, &request), >=, 0);
+	g_assert_nonnull(request);
+
+	// The notification is delivered on the application's thread, at the latest when waiting for the request
+	g_assert_cmpint(H5VLrequest_notify(request, connector, async_notify, &notification), >=, 0);
+	g_assert_cmpint(H5VLrequest_wait(request, connector, G_MAXUINT64, &status), >=, 0);
+	g_assert_cmpint(status, ==, H5ES_STATUS_SUCCEED);
+	g_assert_cmpuint(notification.calls, ==, 1);
+	g_assert_true(notification.thread == g_thread_self());
+	g_assert_cmpint(notification.status, ==, H5ES_STATUS_SUCCEED);
+
+	// Waiting again does not notify again
+	g_assert_cmpint(H5VLrequest_wait(request, connector, G_MAXUINT64, &status), >=, 0);
+	g_assert_cmpuint(notification.calls, ==, 1);
+	H5VLrequest_free(request, connector);
+
+	H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read);
+
+	for (guint i = 0; i < 1024; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, i * 3);
+	}
+
+	H5VLclose(connector);
+	H5Dclose(dataset);
+	H5Sclose(dataspace);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_reopen(void)
+{
+	hid_t file;
+
+	file = H5Fcreate("JULEA-reopen.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	write_dataset(file);
+	H5Fclose(file);
+
+	file = H5Fopen("JULEA-reopen.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+	read_dataset(file);
+	H5Fclose(file);
+}
+
+static void
+test_hdf_flush(void)
+{
+	hid_t attribute;
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t file;
+
+	hsize_t dims[1] = { 16 };
+
+	int data[16];
+	int data_read[16];
+	int value;
+	int value_read;
+
+	for (guint i = 0; i < 16; i++)
+	{
+		data[i] = i;
+	}
+
+	file = H5Fcreate("JULEA-flush.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	g_assert_cmpint(file, >=, 0);
+
+	dataspace = H5Screate_simple(1, dims, NULL);
+	dataset = H5Dcreate2(file, "FlushDataset", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	g_assert_cmpint(dataset, >=, 0);
+	H5Sclose(dataspace);
+
+	dataspace = H5Screate(H5S_SCALAR);
+	attribute = H5Acreate2(dataset, "FlushAttribute", H5T_NATIVE_INT, dataspace, H5P_DEFAULT, H5P_DEFAULT);
+	g_assert_cmpint(attribute, >=, 0);
+	H5Sclose(dataspace);
+
+	value = 42;
+	g_assert_cmpint(H5Awrite(attribute, H5T_NATIVE_INT, &value), >=, 0);
+
+	// The metadata has not been flushed yet and is read back from the pending puts
+	value_read = 0;
+	g_assert_cmpint(H5Aread(attribute, H5T_NATIVE_INT, &value_read), >=, 0);
+	g_assert_cmpint(value_read, ==, 42);
+
+	dataspace = H5Dget_space(dataset);
+	g_assert_cmpint(H5Sget_simple_extent_npoints(dataspace), ==, 16);
+	H5Sclose(dataspace);
+
+	g_assert_cmpint(H5Fflush(file, H5F_SCOPE_GLOBAL), >=, 0);
+
+	// Flushed values are read from the servers
+	value_read = 0;
+	g_assert_cmpint(H5Aread(attribute, H5T_NATIVE_INT, &value_read), >=, 0);
+	g_assert_cmpint(value_read, ==, 42);
+
+	// Values written after flushing are pending again
+	value = 23;
+	g_assert_cmpint(H5Awrite(attribute, H5T_NATIVE_INT, &value), >=, 0);
+
+	value_read = 0;
+	g_assert_cmpint(H5Aread(attribute, H5T_NATIVE_INT, &value_read), >=, 0);
+	g_assert_cmpint(value_read, ==, 23);
+
+	g_assert_cmpint(H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data), >=, 0);
+	g_assert_cmpint(H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read), >=, 0);
+
+	for (guint i = 0; i < 16; i++)
+	{
+		g_assert_cmpint(data_read[i], ==, i);
+	}
+
+	H5Aclose(attribute);
+	H5Dclose(dataset);
+	g_assert_cmpint(H5Fclose(file), >=, 0);
+
+	// Closing the file has stored the pending values
+	file = H5Fopen("JULEA-flush.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+	dataset = H5Dopen2(file, "FlushDataset", H5P_DEFAULT);
+	attribute = H5Aopen(dataset, "FlushAttribute", H5P_DEFAULT);
+
+	value_read = 0;
+	g_assert_cmpint(H5Aread(attribute, H5T_NATIVE_INT, &value_read), >=, 0);
+	g_assert_cmpint(value_read, ==, 23);
+
+	H5Aclose(attribute);
+	H5Dclose(dataset);
+	g_assert_cmpint(H5Fclose(file), >=, 0);
+}
+
+static void
+test_hdf_shared_metadata(void)
+{
+	hid_t dataset;
+	hid_t dataspace;
+	hid_t datatype;
+	hid_t file;
+	hid_t group;
+
+	hsize_t dims[1] = { 16 };
+
+	int data[16];
+	int data_read[16];
+
+	file = H5Fcreate("JULEA-shared-metadata.h5", H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	group = H5Gcreate2(file, "SharedGroup", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+
+	// All datasets use the same datatype and space, the IDs are closed while the datasets are still open
+	for (guint i = 0; i < 8; i++)
+	{
+		g_autofree gchar* name = g_strdup_printf("SharedDataset%u", i);
+
+		for (guint j = 0; j < 16; j++)
+		{
+			data[j] = i * 16 + j;
+		}
+
+		datatype = H5Tcopy(H5T_NATIVE_INT);
+		dataspace = H5Screate_simple(1, dims, NULL);
+		dataset = H5Dcreate2(group, name, datatype, dataspace, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+		H5Tclose(datatype);
+		H5Sclose(dataspace);
+
+		H5Dwrite(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data);
+		H5Dclose(dataset);
+	}
+
+	H5Gclose(group);
+	H5Fclose(file);
+
+	file = H5Fopen("JULEA-shared-metadata.h5", H5F_ACC_RDONLY, H5P_DEFAULT);
+
+	// Open every dataset twice, the second time around links, datatypes and spaces are already known
+	for (guint k = 0; k < 2; k++)
+	{
+		group = H5Gopen2(file, "SharedGroup", H5P_DEFAULT);
+
+		for (guint i = 0; i < 8; i++)
+		{
+			g_autofree gchar* name = g_strdup_printf("SharedDataset%u", i);
+
+			dataset = H5Dopen2(group, name, H5P_DEFAULT);
+
+			// Closing the returned IDs must not affect other datasets
+			datatype = H5Dget_type(dataset);
+			g_assert_true(H5Tget_class(datatype) == H5T_INTEGER);
+			H5Tclose(datatype);
+
+			dataspace = H5Dget_space(dataset);
+			g_assert_cmpint(H5Sget_simple_extent_npoints(dataspace), ==, 16);
+			H5Sclose(dataspace);
+
+			H5Dread(dataset, H5T_NATIVE_INT, H5S_ALL, H5S_ALL, H5P_DEFAULT, data_read);
+
+			for (guint j = 0; j < 16; j++)
+			{
+				g_assert_cmpint(data_read[j], ==, i * 16 + j);
+			}
+
+			H5Dclose(dataset);
+		}
+
+		H5Gclose(group);
+	}
+
+	H5Fclose(file);
+}
+
 #endif
 
 void
@@ -158,5 +1184,29 @@ test_hdf_hdf(void)
 	}
 
 	g_test_add_func("/hdf5/read_write", test_hdf_read_write);
+	g_test_add_func("/hdf5/reopen", test_hdf_reopen);
+	g_test_add_func("/hdf5/shared_metadata", test_hdf_shared_metadata);
+	g_test_add_func("/hdf5/chunked", test_hdf_chunked);
+	g_test_add_func("/hdf5/async", test_hdf_async);
+
+	if (g_strcmp0(g_getenv("HDF5_VOL_CONNECTOR"), "julea-db") == 0)
+	{
+		// Only the DB plugin supports partial I/O, type conversion, compression and queries
+		g_test_add_func("/hdf5/chunked_shared", test_hdf_chunked_shared);
+		g_test_add_func("/hdf5/hyperslab", test_hdf_hyperslab);
+		g_test_add_func("/hdf5/hyperslab_irregular", test_hdf_hyperslab_irregular);
+		g_test_add_func("/hdf5/points", test_hdf_points);
+		g_test_add_func("/hdf5/convert", test_hdf_convert);
+		g_test_add_func("/hdf5/convert_large", test_hdf_convert_large);
+		g_test_add_func("/hdf5/compression", test_hdf_compression);
+		g_test_add_func("/hdf5/query", test_hdf_query);
+		g_test_add_func("/hdf5/query_shared", test_hdf_query_shared);
+		g_test_add_func("/hdf5/statistics", test_hdf_statistics);
+	}
+	else
+	{
+		// Only the KV plugin defers metadata operations until the file is flushed
+		g_test_add_func("/hdf5/flush", test_hdf_flush);
+	}
 #endif
 }
@@ -0,0 +1,433 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <gmodule.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+/**
+ * Tests the memory backend directly, independent of the configured KV backend.
+ **/
+
+struct KVMemoryBackend
+{
+	GModule* module;
+
+	/**
+	 * A private copy of the module's backend.
+	 * The module's backend might already be used by the KV client.
+	 **/
+	JBackend backend;
+};
+
+typedef struct KVMemoryBackend KVMemoryBackend;
+
+/**
+ * Initializes the memory backend.
+ * Like the server's backend, it uses the options of the test configuration, including its memory limit.
+ **/
+static KVMemoryBackend*
+kv_memory_backend_new(void)
+{
+	KVMemoryBackend* memory_backend;
+	JBackend* backend = NULL;
+	gboolean ret;
+
+	memory_backend = g_new(KVMemoryBackend, 1);
+
+	ret = j_backend_load_server("memory", "server", J_BACKEND_TYPE_KV, &memory_backend->module, &backend);
+	g_assert_true(ret);
+	g_assert_nonnull(memory_backend->module);
+	g_assert_nonnull(backend);
+
+	memcpy(&memory_backend->backend, backend, sizeof(JBackend));
+
+	ret = j_backend_kv_init(&memory_backend->backend, "");
+	g_assert_true(ret);
+
+	return memory_backend;
+}
+
+static void
+kv_memory_backend_free(KVMemoryBackend* memory_backend)
+{
+	j_backend_kv_fini(&memory_backend->backend);
+	g_module_close(memory_backend->module);
+
+	g_free(memory_backend);
+}
+
+/**
+ * Returns the value of a statistic reported by the backend's statistics hook.
+ **/
+static guint64
+kv_memory_statistic(KVMemoryBackend* memory_backend, gchar const* name)
+{
+	g_autofree gchar* statistics = NULL;
+	g_auto(GStrv) lines = NULL;
+	g_autofree gchar* prefix = NULL;
+	gboolean ret;
+
+	ret = j_backend_kv_statistics(&memory_backend->backend, &statistics);
+	g_assert_true(ret);
+	g_assert_nonnull(statistics);
+
+	lines = g_strsplit(statistics, "\n", 0);
+	prefix = g_strdup_printf("%s: ", name);
+
+	for (guint i = 0; lines[i] != NULL; i++)
+	{
+		if (g_str_has_prefix(lines[i], prefix))
+		{
+			return g_ascii_strtoull(lines[i] + strlen(prefix), NULL, 10);
+		}
+	}
+
+	g_assert_not_reached();
+
+	return 0;
+}
+
+static gboolean
+kv_memory_put(KVMemoryBackend* memory_backend, gchar const* namespace, gchar const* key, gconstpointer value, guint32 len)
+{
+	gpointer batch = NULL;
+	gboolean ret;
+
+	ret = j_backend_kv_batch_start(&memory_backend->backend, namespace, NULL, &batch);
+	g_assert_true(ret);
+
+	ret = j_backend_kv_put(&memory_backend->backend, batch, key, value, len);
+	g_assert_true(j_backend_kv_batch_execute(&memory_backend->backend, batch));
+
+	return ret;
+}
+
+static gboolean
+kv_memory_delete(KVMemoryBackend* memory_backend, gchar const* namespace, gchar const* key)
+{
+	gpointer batch = NULL;
+	gboolean ret;
+
+	ret = j_backend_kv_batch_start(&memory_backend->backend, namespace, NULL, &batch);
+	g_assert_true(ret);
+
+	ret = j_backend_kv_delete(&memory_backend->backend, batch, key);
+	g_assert_true(j_backend_kv_batch_execute(&memory_backend->backend, batch));
+
+	return ret;
+}
+
+static void
+test_kv_memory_prefix(void)
+{
+	// More keys than stripes, so that every prefix is spread across all of them
+	guint const n = 1000;
+
+	g_autofree gchar* previous_key = NULL;
+	KVMemoryBackend* memory_backend;
+	gpointer iterator = NULL;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+	gboolean ret;
+	guint count;
+
+	memory_backend = kv_memory_backend_new();
+
+	// Insert the keys out of order
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* key_a = NULL;
+		g_autofree gchar* key_b = NULL;
+		guint64 j = (i * 7) % n;
+
+		key_a = g_strdup_printf("a/%04" G_GUINT64_FORMAT, j);
+		key_b = g_strdup_printf("b/%04" G_GUINT64_FORMAT, j);
+
+		ret = kv_memory_put(memory_backend, "test-ns", key_a, &j, sizeof(j));
+		g_assert_true(ret);
+
+		ret = kv_memory_put(memory_backend, "test-ns", key_b, &j, sizeof(j));
+		g_assert_true(ret);
+	}
+
+	// Other namespaces are not returned
+	ret = kv_memory_put(memory_backend, "test-ns-other", "a/other", "other", 6);
+	g_assert_true(ret);
+
+	ret = j_backend_kv_get_by_prefix(&memory_backend->backend, "test-ns", "a/", &iterator);
+	g_assert_true(ret);
+
+	count = 0;
+
+	while (j_backend_kv_iterate(&memory_backend->backend, iterator, &key, &value, &len))
+	{
+		g_autofree gchar* expected = NULL;
+
+		// Keys are returned in order, independent of their stripes
+		expected = g_strdup_printf("a/%04u", count);
+		g_assert_cmpstr(key, ==, expected);
+		g_assert_cmpuint(len, ==, sizeof(guint64));
+		g_assert_cmpuint(*(guint64 const*)value, ==, count);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n);
+
+	// Deleted keys are skipped
+	for (guint i = 0; i < n; i += 2)
+	{
+		g_autofree gchar* key_b = g_strdup_printf("b/%04u", i);
+
+		ret = kv_memory_delete(memory_backend, "test-ns", key_b);
+		g_assert_true(ret);
+	}
+
+	ret = j_backend_kv_get_by_prefix(&memory_backend->backend, "test-ns", "b/", &iterator);
+	g_assert_true(ret);
+
+	count = 0;
+
+	while (j_backend_kv_iterate(&memory_backend->backend, iterator, &key, &value, &len))
+	{
+		if (previous_key != NULL)
+		{
+			g_assert_cmpstr(previous_key, <, key);
+		}
+
+		g_free(previous_key);
+		previous_key = g_strdup(key);
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n / 2);
+
+	ret = j_backend_kv_get_all(&memory_backend->backend, "test-ns", &iterator);
+	g_assert_true(ret);
+
+	count = 0;
+
+	while (j_backend_kv_iterate(&memory_backend->backend, iterator, &key, &value, &len))
+	{
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n + n / 2);
+	g_assert_cmpuint(kv_memory_statistic(memory_backend, "memory.namespaces"), ==, 2);
+
+	kv_memory_backend_free(memory_backend);
+}
+
+static void
+test_kv_memory_limit(void)
+{
+	g_autofree gchar* value = NULL;
+	g_autofree gchar* large_value = NULL;
+	KVMemoryBackend* memory_backend;
+	gpointer batch = NULL;
+	gpointer result = NULL;
+	guint32 result_len = 0;
+	gboolean ret;
+	guint64 limit;
+	guint64 entry_size;
+	guint64 used;
+	guint32 value_len;
+	guint count;
+
+	limit = j_configuration_get_backend_option_uint64(j_configuration(), J_BACKEND_TYPE_KV, "memory-limit", 0);
+
+	// The limit has to fit at least 16 entries with values of 16 bytes
+	if (limit < 16 * 16)
+	{
+		g_test_skip("memory-limit is not configured or too small");
+		return;
+	}
+
+	memory_backend = kv_memory_backend_new();
+
+	g_assert_cmpuint(kv_memory_statistic(memory_backend, "memory.limit"), ==, limit);
+	g_assert_cmpuint(kv_memory_statistic(memory_backend, "memory.used"), ==, 0);
+
+	value_len = MIN(limit / 16, G_MAXUINT32 / 2);
+	value = g_malloc0(value_len);
+
+	// Keys and values both count towards the limit
+	entry_size = value_len + strlen("key-00") + 1;
+
+	// Fill the backend until the limit is reached
+	for (count = 0;; count++)
+	{
+		g_autofree gchar* key = g_strdup_printf("key-%02u", count);
+
+		if (!kv_memory_put(memory_backend, "test-ns", key, value, value_len))
+		{
+			break;
+		}
+
+		g_assert_cmpuint(count, <, 16);
+	}
+
+	g_assert_cmpuint(count, ==, limit / entry_size);
+
+	used = kv_memory_statistic(memory_backend, "memory.used");
+	g_assert_cmpuint(used, ==, count * entry_size);
+	g_assert_cmpuint(used, <=, limit);
+
+	// Failed puts do not change the stored values
+	ret = j_backend_kv_batch_start(&memory_backend->backend, "test-ns", NULL, &batch);
+	g_assert_true(ret);
+
+	ret = j_backend_kv_get(&memory_backend->backend, batch, "key-00", &result, &result_len);
+	g_assert_true(ret);
+	g_assert_cmpuint(result_len, ==, value_len);
+	g_free(result);
+
+	ret = j_backend_kv_batch_execute(&memory_backend->backend, batch);
+	g_assert_true(ret);
+
+	// Shrinking a value is always possible
+	ret = kv_memory_put(memory_backend, "test-ns", "key-00", value, 10);
+	g_assert_true(ret);
+	g_assert_cmpuint(kv_memory_statistic(memory_backend, "memory.used"), ==, used - (value_len - 10));
+
+	// Deleting a key frees its memory
+	ret = kv_memory_delete(memory_backend, "test-ns", "key-01");
+	g_assert_true(ret);
+
+	ret = kv_memory_put(memory_backend, "test-ns", "key-new", value, value_len);
+	g_assert_true(ret);
+
+	// Less than two entries fit into the remaining memory
+	large_value = g_malloc0(2 * value_len);
+
+	ret = kv_memory_put(memory_backend, "test-ns", "key-too-large", large_value, 2 * value_len);
+	g_assert_false(ret);
+
+	g_assert_cmpuint(kv_memory_statistic(memory_backend, "memory.used"), <=, limit);
+
+	kv_memory_backend_free(memory_backend);
+}
+
+struct KVMemoryThreadData
+{
+	KVMemoryBackend* memory_backend;
+	guint id;
+};
+
+typedef struct KVMemoryThreadData KVMemoryThreadData;
+
+static guint const kv_memory_threads = 8;
+static guint const kv_memory_keys = 1000;
+
+static gpointer
+kv_memory_thread(gpointer data)
+{
+	KVMemoryThreadData* thread_data = data;
+
+	for (guint i = 0; i < kv_memory_keys; i++)
+	{
+		g_autofree gchar* own_key = NULL;
+		g_autofree gchar* shared_key = NULL;
+		gchar const* value = "value";
+
+		own_key = g_strdup_printf("own/%02u/%04u", thread_data->id, i);
+		shared_key = g_strdup_printf("shared/%04u", i % 100);
+
+		g_assert_true(kv_memory_put(thread_data->memory_backend, "test-ns", own_key, value, strlen(value) + 1));
+
+		// All threads overwrite and delete the shared keys concurrently
+		kv_memory_put(thread_data->memory_backend, "test-ns", shared_key, &(thread_data->id), sizeof(thread_data->id));
+		kv_memory_delete(thread_data->memory_backend, "test-ns", shared_key);
+
+		// Every other own key is deleted again
+		if (i % 2 == 1)
+		{
+			g_assert_true(kv_memory_delete(thread_data->memory_backend, "test-ns", own_key));
+		}
+	}
+
+	return NULL;
+}
+
+static void
+test_kv_memory_concurrent(void)
+{
+	g_autofree GThread** threads = NULL;
+	g_autofree KVMemoryThreadData* thread_data = NULL;
+	KVMemoryBackend* memory_backend;
+	gpointer iterator = NULL;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+	guint64 expected_used = 0;
+	gboolean ret;
+	guint count = 0;
+
+	memory_backend = kv_memory_backend_new();
+
+	threads = g_new(GThread*, kv_memory_threads);
+	thread_data = g_new(KVMemoryThreadData, kv_memory_threads);
+
+	for (guint i = 0; i < kv_memory_threads; i++)
+	{
+		thread_data[i].memory_backend = memory_backend;
+		thread_data[i].id = i;
+		threads[i] = g_thread_new("test-kv-memory", kv_memory_thread, &thread_data[i]);
+	}
+
+	for (guint i = 0; i < kv_memory_threads; i++)
+	{
+		g_thread_join(threads[i]);
+	}
+
+	// The index and the stripes have to agree, shared keys might have survived in any order
+	ret = j_backend_kv_get_all(&memory_backend->backend, "test-ns", &iterator);
+	g_assert_true(ret);
+
+	while (j_backend_kv_iterate(&memory_backend->backend, iterator, &key, &value, &len))
+	{
+		if (g_str_has_prefix(key, "own/"))
+		{
+			count++;
+		}
+
+		expected_used += strlen(key) + 1 + len;
+	}
+
+	g_assert_cmpuint(count, ==, kv_memory_threads * kv_memory_keys / 2);
+	g_assert_cmpuint(kv_memory_statistic(memory_backend, "memory.used"), ==, expected_used);
+
+	kv_memory_backend_free(memory_backend);
+}
+
+void
+test_kv_kv_memory(void)
+{
+	g_test_add_func("/kv/memory/prefix", test_kv_memory_prefix);
+	g_test_add_func("/kv/memory/limit", test_kv_memory_limit);
+	g_test_add_func("/kv/memory/concurrent", test_kv_memory_concurrent);
+}
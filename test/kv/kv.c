@@ -213,6 +213,110 @@ test_kv_get_callback(void)
 	g_assert_cmpuint(num_callbacks, ==, 1);
 }
 
+static void
+test_kv_compare_and_swap(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autofree gchar* get_value = NULL;
+	guint32 get_len;
+	gboolean swapped;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	kv = j_kv_new("test", "test-kv-compare-and-swap");
+	g_assert_nonnull(kv);
+
+	j_kv_compare_and_swap(kv, NULL, 0, "first", strlen("first") + 1, &swapped, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_true(swapped);
+
+	j_kv_compare_and_swap(kv, NULL, 0, "second", strlen("second") + 1, &swapped, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_false(swapped);
+
+	j_kv_compare_and_swap(kv, "first", strlen("first") + 1, "second", strlen("second") + 1, &swapped, batch);
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_true(swapped);
+	g_assert_cmpstr(get_value, ==, "second");
+
+	j_kv_delete(kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_fetch_add(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	gint64 old_value = -1;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	kv = j_kv_new("test", "test-kv-fetch-add");
+	g_assert_nonnull(kv);
+
+	j_kv_fetch_add(kv, 5, &old_value, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpint(old_value, ==, 0);
+
+	j_kv_fetch_add(kv, -2, &old_value, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpint(old_value, ==, 5);
+
+	j_kv_fetch_add(kv, 0, &old_value, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpint(old_value, ==, 3);
+
+	j_kv_delete(kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_append(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autofree gchar* get_value = NULL;
+	guint32 get_len;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	kv = j_kv_new("test", "test-kv-append");
+	g_assert_nonnull(kv);
+
+	j_kv_append(kv, "kv-", strlen("kv-"), batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_kv_append(kv, "value", strlen("value") + 1, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(get_value, ==, "kv-value");
+	g_assert_cmpuint(get_len, ==, strlen("kv-value") + 1);
+
+	j_kv_delete(kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 void
 test_kv_kv(void)
 {
@@ -222,4 +326,7 @@ test_kv_kv(void)
 	g_test_add_func("/kv/kv/put_update", test_kv_put_update);
 	g_test_add_func("/kv/kv/get", test_kv_get);
 	g_test_add_func("/kv/kv/get_callback", test_kv_get_callback);
+	g_test_add_func("/kv/kv/compare_and_swap", test_kv_compare_and_swap);
+	g_test_add_func("/kv/kv/fetch_add", test_kv_fetch_add);
+	g_test_add_func("/kv/kv/append", test_kv_append);
 }
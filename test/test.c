@@ -58,6 +58,7 @@ main(int argc, char** argv)
 	// KV client
 	test_kv_kv();
 	test_kv_kv_iterator();
+	test_kv_kv_memory();
 
 	// DB client
 	test_db_db();
@@ -38,6 +38,7 @@ void test_object_object_iterator(void);
 
 void test_kv_kv(void);
 void test_kv_kv_iterator(void);
+void test_kv_kv_memory(void);
 
 void test_db_db(void);
 
@@ -125,6 +125,9 @@ main(int argc, char** argv)
 		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, value);
 		j_statistics_add(statistics_total, J_STATISTICS_BYTES_SENT, value);
 
+		// Backend statistics are reported by the key-value servers below
+		j_message_get_string(reply);
+
 		g_print("Data server %d\n", i);
 		print_statistics(statistics);
 
@@ -146,5 +149,35 @@ main(int argc, char** argv)
 
 	j_statistics_free(statistics_total);
 
+	for (guint i = 0; i < j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV); i++)
+	{
+		g_autoptr(JMessage) reply = NULL;
+		gchar const* backend_statistics;
+		gpointer connection;
+
+		connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, i);
+
+		j_message_send(message, connection);
+
+		reply = j_message_new_reply(message);
+		j_message_receive(reply, connection);
+
+		for (guint j = 0; j < 8; j++)
+		{
+			j_message_get_8(reply);
+		}
+
+		backend_statistics = j_message_get_string(reply);
+
+		if (backend_statistics[0] != '\0')
+		{
+			g_print("\n");
+			g_print("Key-value server %d\n", i);
+			g_print("%s\n", backend_statistics);
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_KV, i, connection);
+	}
+
 	return 0;
 }